@@ -1,9 +1,13 @@
 /*
  * Copyright 2023 wtcat
  */
+#include "basework/generic.h"
 #include "basework/rq.h"
 #include "basework/async_call.h"
 
+STATIC_ASSERT(sizeof(struct call_param) <= CONFIG_BASEWORK_RQ_INLINE_SIZE,
+    call_param_does_not_fit_the_rq_inline_payload);
+
 static void rq_async_execute(void *arg, size_t size) {
     struct call_param *cp = (struct call_param *)arg;
     (void) size;
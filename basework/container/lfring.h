@@ -0,0 +1,163 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Bounded lock-free ring of pointers (multi-producer/multi-consumer).
+ *
+ * Unlike rte_ring, the producer never waits for the tail update of other
+ * producers. Each slot carries its own sequence number, so a producer that
+ * is preempted (e.g. by an interrupt handler that also enqueues) between
+ * reserving and filling a slot can not dead-lock the others.
+ */
+#ifndef BASEWORK_CONTAINER_LFRING_H_
+#define BASEWORK_CONTAINER_LFRING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "basework/generic.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+struct lfring_slot {
+    uint32_t seq;
+    void *obj;
+};
+
+struct lfring {
+    uint32_t head __rte_cache_aligned; /* Enqueue position */
+    uint32_t tail __rte_cache_aligned; /* Dequeue position */
+    uint32_t mask;
+    struct lfring_slot *slots;
+};
+
+#define LFRING_SLOTS_DEFINE(_name, _size, _attr) \
+    struct lfring_slot _name[((_size) < 2 || ((_size) & ((_size) - 1)))? -1: (_size)] _attr
+
+/*
+ * lfring_init - Initialize lock-free ring
+ *
+ * @r: ring object
+ * @slots: slot buffer
+ * @size: the number of slot (must be power of 2)
+ * return 0 if success
+ */
+static inline int lfring_init(struct lfring *r, struct lfring_slot *slots,
+    uint32_t size) {
+    if (size < 2 || !rte_powerof2(size))
+        return -1;
+    for (uint32_t i = 0; i < size; i++)
+        slots[i].seq = i;
+    r->slots = slots;
+    r->mask = size - 1;
+    r->head = 0;
+    r->tail = 0;
+    return 0;
+}
+
+/*
+ * lfring_enqueue - Put an object into ring (Multi-producer safe)
+ *
+ * @r: ring object
+ * @obj: object pointer
+ * return true if success
+ */
+static inline bool lfring_enqueue(struct lfring *r, void *obj) {
+    struct lfring_slot *slot;
+    uint32_t pos, seq;
+    int32_t diff;
+
+    pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    for ( ; ; ) {
+        slot = &r->slots[pos & r->mask];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        }
+    }
+    slot->obj = obj;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * lfring_dequeue - Get an object from ring (Multi-consumer safe)
+ *
+ * @r: ring object
+ * return object pointer or NULL if ring is empty
+ */
+static inline void *lfring_dequeue(struct lfring *r) {
+    struct lfring_slot *slot;
+    uint32_t pos, seq;
+    int32_t diff;
+    void *obj;
+
+    pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    for ( ; ; ) {
+        slot = &r->slots[pos & r->mask];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+        }
+    }
+    obj = slot->obj;
+    __atomic_store_n(&slot->seq, pos + r->mask + 1, __ATOMIC_RELEASE);
+    return obj;
+}
+
+/*
+ * lfring_dequeue_burst - Get objects from ring as many as possible
+ *
+ * @r: ring object
+ * @objs: object table
+ * @n: the size of object table
+ * return the number of objects that have been dequeued
+ */
+static inline unsigned int lfring_dequeue_burst(struct lfring *r, void **objs,
+    unsigned int n) {
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        objs[i] = lfring_dequeue(r);
+        if (objs[i] == NULL)
+            break;
+    }
+    return i;
+}
+
+/*
+ * lfring_empty - Test whether the ring has no ready object
+ */
+static inline bool lfring_empty(struct lfring *r) {
+    uint32_t pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    struct lfring_slot *slot = &r->slots[pos & r->mask];
+    return (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (pos + 1)) < 0;
+}
+
+/*
+ * lfring_count - Get the approximate number of objects in ring
+ */
+static inline uint32_t lfring_count(struct lfring *r) {
+    return __atomic_load_n(&r->head, __ATOMIC_RELAXED) -
+        __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* BASEWORK_CONTAINER_LFRING_H_ */
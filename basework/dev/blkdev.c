@@ -4,7 +4,10 @@
  * The simple block device buffer implement
  */
 #define pr_fmt(fmt) "blkdev: "fmt
+#define LOG_MODULE_NAME blkdev
 #include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "basework/container/list.h"
@@ -16,6 +19,7 @@
 #include "basework/os/osapi_timer.h"
 #include "basework/os/osapi.h"
 
+LOG_MODULE_DEFINE(blkdev, LOGLEVEL_INFO);
 
 #ifndef CONFIG_BLKDEV_NR_BUFS
 #define CONFIG_BLKDEV_NR_BUFS 4
@@ -29,12 +33,34 @@
 #ifndef CONFIG_BLKDEV_HOLD_TIME
 #define CONFIG_BLKDEV_HOLD_TIME 10000 //Unit: ms
 #endif
+#ifndef CONFIG_BLKDEV_IO_BLKS
+#define CONFIG_BLKDEV_IO_BLKS 4
+#endif
+#ifndef CONFIG_BLKDEV_RA_BLKS
+#define CONFIG_BLKDEV_RA_BLKS 2
+#endif
+#ifndef CONFIG_BLKDEV_DIRTY_SOFT
+#define CONFIG_BLKDEV_DIRTY_SOFT 50 //Unit: percent
+#endif
+#ifndef CONFIG_BLKDEV_DIRTY_HARD
+#define CONFIG_BLKDEV_DIRTY_HARD 90 //Unit: percent
+#endif
 
 #define NR_BLKS CONFIG_BLKDEV_NR_BUFS
 
 #ifndef _WIN32
-_Static_assert(CONFIG_BLKDEV_NR_BUFS >= 1 && CONFIG_BLKDEV_NR_BUFS < 20, "");
+_Static_assert(CONFIG_BLKDEV_NR_BUFS >= 1, "");
+_Static_assert(CONFIG_BLKDEV_IO_BLKS >= 1, "");
+#endif
+
+/* The size of staging buffer that used to merge blocks into one request */
+#if CONFIG_BLKDEV_IO_BLKS > 1
+#define BH_IOBUF_SIZE (CONFIG_BLKDEV_IO_BLKS * CONFIG_BLKDEV_MAX_BLKSZ)
+#else
+#define BH_IOBUF_SIZE 0
 #endif
+#define BH_WBBUF_SIZE rte_max(BH_IOBUF_SIZE, CONFIG_BLKDEV_MAX_BLKSZ)
+
 enum bh_state {
     BH_STATE_INVALD = 0,
     BH_STATE_DIRTY,
@@ -43,31 +69,112 @@ enum bh_state {
 
 struct bh_desc {
     struct rte_list link;
+    struct rte_hnode hash; /* Hashed by (dd, blkno) */
     struct disk_device *dd;
     char *buffer;
     size_t blkno; /* block number */
     enum bh_state state;
     long hold;
+    uint32_t seq; /* Modification sequence */
+};
+
+struct bh_writeback {
+    os_completion_declare(wakeup)
+    os_completion_declare(exited)
+    os_thread_t thread;
+    char *buffer;
+    int soft_ratio;
+    int hard_ratio;
+    int soft;  /* Soft limit of dirty blocks */
+    int hard;  /* Hard limit of dirty blocks */
+    bool pending;
+    bool running;
 };
 
-struct bh_statitics {
-    long cache_hits;
-    long cache_missed;
+struct bh_readahead {
+    struct disk_device *dd;
+    uint32_t next; /* Expected block number of next sequential read */
 };
 
 #define MTX_LOCK()   os_mtx_lock(&bh_mtx)
 #define MTX_UNLOCK() os_mtx_unlock(&bh_mtx)
 #define MTX_LOCK_INIT() os_mtx_init(&bh_mtx, 0)
 
+/*
+ * The I/O lock serializes the write-back requests. The lock order is 
+ * bh_io_mtx -> bh_mtx
+ */
+#define IO_LOCK()   os_mtx_lock(&bh_io_mtx)
+#define IO_UNLOCK() os_mtx_unlock(&bh_io_mtx)
+#define IO_LOCK_INIT() os_mtx_init(&bh_io_mtx, 0)
+
 
 static os_mutex_t bh_mtx;
+static os_mutex_t bh_io_mtx;
 static os_timer_t bh_timer;
 static void *bh_buffer;
 static bool bh_initialized;
-static struct bh_statitics bh_statistics;
+static struct blkdev_stats bh_statistics;
+static struct rte_hlist *bh_hashtbl;
+static unsigned int bh_hashbits;
+static struct bh_desc **bh_flushv;
+static char *bh_iobuf;
+static struct bh_readahead bh_ra;
+static int bh_ndirty;
+static struct bh_writeback bh_wb = {
+    .soft_ratio = CONFIG_BLKDEV_DIRTY_SOFT,
+    .hard_ratio = CONFIG_BLKDEV_DIRTY_HARD
+};
 static RTE_LIST(cached_list);
 static RTE_LIST(dirty_list);
 
+static inline struct rte_hlist *bh_hash_head(struct disk_device *dd, 
+    uint32_t blkno) {
+    uint32_t key = blkno ^ (uint32_t)((uintptr_t)dd >> 4);
+    return &bh_hashtbl[(key * 0x9E3779B1u) >> (32 - bh_hashbits)];
+}
+
+static inline void bh_unhash(struct bh_desc *bh) {
+    rte_hlist_del_init(&bh->hash);
+}
+
+static struct bh_desc *bh_lookup_locked(struct disk_device *dd, uint32_t blkno) {
+    struct bh_desc *bh;
+
+    rte_hlist_foreach_entry(bh, bh_hash_head(dd, blkno), hash) {
+        if (bh->dd == dd && bh->blkno == blkno)
+            return bh;
+    }
+    return NULL;
+}
+
+/*
+ * The maximum number of blocks that can be transferred by one request
+ */
+static inline uint32_t bh_io_blocks(struct disk_device *dd) {
+    uint32_t n = BH_IOBUF_SIZE / dd->blk_size;
+    return n? n: 1;
+}
+
+static inline void bh_rehash(struct bh_desc *bh, struct disk_device *dd, 
+    uint32_t blkno) {
+    rte_hlist_del_init(&bh->hash);
+    bh->dd = dd;
+    bh->blkno = blkno;
+    rte_hlist_add_head(&bh->hash, bh_hash_head(dd, blkno));
+}
+
+static inline bool bh_linked(struct bh_desc *bh) {
+    return bh->link.next != NULL;
+}
+
+static void bh_set_dirty_limit(int soft_ratio, int hard_ratio) {
+    bh_wb.soft_ratio = soft_ratio;
+    bh_wb.hard_ratio = hard_ratio;
+    bh_wb.soft = rte_max(NR_BLKS * soft_ratio / 100, 1);
+    bh_wb.hard = rte_max(NR_BLKS * hard_ratio / 100, 1);
+}
+
 static inline void bh_enqueue_dirty(struct bh_desc *bh) {
     bh->hold = CONFIG_BLKDEV_HOLD_TIME;
     rte_list_add_tail(&bh->link, &dirty_list);
@@ -77,57 +184,238 @@ static inline void bh_enqueue_cached(struct bh_desc *bh) {
     rte_list_add_tail(&bh->link, &cached_list);
 }
 
+/*
+ * The invalid block has no content, so put it to the LRU head and it 
+ * will be reused firstly
+ */
+static inline void bh_enqueue_invalid(struct bh_desc *bh) {
+    rte_list_add(&bh->link, &cached_list);
+}
+
+static int bh_compare(const void *a, const void *b) {
+    const struct bh_desc *x = *(const struct bh_desc *const *)a;
+    const struct bh_desc *y = *(const struct bh_desc *const *)b;
+
+    if (x->dd != y->dd)
+        return (uintptr_t)x->dd < (uintptr_t)y->dd? -1: 1;
+    if (x->blkno != y->blkno)
+        return x->blkno < y->blkno? -1: 1;
+    return 0;
+}
+
+/*
+ * Write back the contiguous blocks with one erase and one write
+ */
+static int bh_writeback_locked(struct bh_desc **bhv, int n) {
+    struct disk_device *dd = bhv[0]->dd;
+    uint32_t ofs = dd->blk_size * bhv[0]->blkno;
+    size_t size = dd->blk_size * n;
+    const char *buf;
+    int err;
+
+    pr_dbg("writeback blkno(%d) offset(0x%x) nblks(%d)\n", 
+        (int)bhv[0]->blkno, ofs, n);
+    err = disk_device_erase(dd, ofs, size);
+    if (err) {
+        pr_err("erase disk failed(offset: 0x%x size:0x%x)\n", ofs, (int)size);
+        return err;
+    }
+
+    if (n > 1) {
+        for (int i = 0; i < n; i++)
+            memcpy(bh_iobuf + dd->blk_size * i, bhv[i]->buffer, dd->blk_size);
+        buf = bh_iobuf;
+    } else {
+        buf = bhv[0]->buffer;
+    }
+    err = disk_device_write(dd, buf, size, ofs);
+    if (err < 0) {
+        pr_err("write disk failed(offset: 0x%x size:0x%x)\n", ofs, (int)size);
+        return err;
+    }
+
+    bh_statistics.writeback_blks += n;
+    bh_statistics.writeback_reqs++;
+    return 0;
+}
+
 static int blkdev_sync_locked(long expired, int max_blks, bool invalid) {
     struct rte_list *pos, *next;
     struct disk_device *dd;
     struct bh_desc *bh;
-    uint32_t ofs;
+    int nblks = 0;
     int err = 0;
+    int n;
 
+    /* Collect the expired dirty blocks */
     rte_list_foreach_safe(pos, next, &dirty_list) {
         bh = rte_container_of(pos, struct bh_desc, link);
         if (bh->hold > expired) {
             bh->hold -= expired;
             continue;
         }
-        
-        max_blks--;
-        if (max_blks < 0)
+        if (nblks >= max_blks)
             break;
+        bh_flushv[nblks++] = bh;
+    }
+    if (nblks > 1)
+        qsort(bh_flushv, nblks, sizeof(bh_flushv[0]), bh_compare);
+
+    /* Merge the contiguous blocks into one disk request */
+    for (int i = 0; i < nblks; i += n) {
+        int max_merge;
+
+        dd = bh_flushv[i]->dd;
+        max_merge = (int)bh_io_blocks(dd);
+        for (n = 1; i + n < nblks && n < max_merge; n++) {
+            bh = bh_flushv[i + n];
+            if (bh->dd != dd || bh->blkno != bh_flushv[i]->blkno + n)
+                break;
+        }
 
-        dd = bh->dd;
-        ofs = bh->dd->blk_size * bh->blkno;
-		pr_dbg("blkdev_sync_locked(%ld) blkno(%d) offset(0x%x) size(%d)\n", expired, 
-			bh->blkno, ofs, dd->blk_size);
-        err = disk_device_erase(bh->dd, ofs, dd->blk_size);
-        if (err) {
-			pr_err("erase disk failed(offset: 0x%x size:0x%x)\n", ofs, dd->blk_size);
+        err = bh_writeback_locked(&bh_flushv[i], n);
+        if (err)
             break;
+
+        for (int j = i; j < i + n; j++) {
+            bh = bh_flushv[j];
+            bh_ndirty--;
+            rte_list_del(&bh->link);
+            if (rte_unlikely(invalid)) {
+                bh_unhash(bh);
+                bh->dd = NULL;
+                bh->state = BH_STATE_INVALD;
+                bh_enqueue_invalid(bh);
+            } else {
+                bh->state = BH_STATE_CACHED;
+                bh_enqueue_cached(bh);
+            }
         }
-        err = disk_device_write(bh->dd, bh->buffer, bh->dd->blk_size, ofs);
-        if (err < 0) {
-			pr_err("write disk failed(offset: 0x%x size:0x%x)\n", ofs, dd->blk_size);
-            break;
+    }
+
+    return err;
+}
+
+/*
+ * Write back the oldest dirty block and the contiguous dirty blocks that 
+ * follow it. The data is copied to the write-back buffer, so the disk request 
+ * is done without the cache lock and the blocks can be accessed meanwhile.
+ * If a block is modified during the request, it is kept dirty.
+ *
+ * Must be called with the I/O lock held.
+ * return the number of blocks that have been written back
+ */
+static int bh_writeback_once(int limit) {
+    struct bh_desc *bhv[CONFIG_BLKDEV_IO_BLKS];
+    uint32_t seqv[CONFIG_BLKDEV_IO_BLKS];
+    struct disk_device *dd;
+    struct bh_desc *bh;
+    uint32_t ofs, max_merge;
+    size_t size;
+    int n, err;
+
+    MTX_LOCK();
+    if (bh_ndirty < limit || rte_list_empty(&dirty_list)) {
+        MTX_UNLOCK();
+        return 0;
+    }
+
+    bh = rte_container_of(dirty_list.next, struct bh_desc, link);
+    dd = bh->dd;
+    max_merge = rte_min(bh_io_blocks(dd), (uint32_t)CONFIG_BLKDEV_IO_BLKS);
+    for (n = 0; n < (int)max_merge; n++) {
+        if (n > 0) {
+            bh = bh_lookup_locked(dd, bhv[0]->blkno + n);
+            if (!bh || bh->state != BH_STATE_DIRTY || !bh_linked(bh))
+                break;
         }
+        memcpy(bh_wb.buffer + dd->blk_size * n, bh->buffer, dd->blk_size);
+        seqv[n] = bh->seq;
+        bhv[n] = bh;
+    }
+    MTX_UNLOCK();
 
-        rte_list_del(&bh->link);
-        if (rte_unlikely(invalid)) {
-            bh->dd = NULL;
-            bh->state = BH_STATE_INVALD;
-        } else {
-            bh->state = BH_STATE_CACHED;
+    ofs = dd->blk_size * bhv[0]->blkno;
+    size = dd->blk_size * n;
+    err = disk_device_erase(dd, ofs, size);
+    if (!err) {
+        err = disk_device_write(dd, bh_wb.buffer, size, ofs);
+        if (err > 0)
+            err = 0;
+    }
+
+    MTX_LOCK();
+    if (err) {
+        MTX_UNLOCK();
+        pr_err("write back failed(offset: 0x%x size:0x%x)\n", ofs, (int)size);
+        return err;
+    }
+    for (int i = 0; i < n; i++) {
+        bh = bhv[i];
+        if (bh->state != BH_STATE_DIRTY || bh->seq != seqv[i])
+            continue;
+        bh->state = BH_STATE_CACHED;
+        bh_ndirty--;
+        /* The block that is being held will be enqueued by its owner */
+        if (bh_linked(bh)) {
+            rte_list_del(&bh->link);
+            bh_enqueue_cached(bh);
         }
-        bh_enqueue_cached(bh);
     }
+    bh_statistics.writeback_blks += n;
+    bh_statistics.writeback_reqs++;
+    MTX_UNLOCK();
 
-    return 0;
+    return n;
+}
+
+static void bh_writeback_thread(void *arg) {
+    (void) arg;
+    int n;
+
+    for ( ; ; ) {
+        os_completion_wait(bh_wb.wakeup);
+        MTX_LOCK();
+        bh_wb.pending = false;
+        MTX_UNLOCK();
+
+        /* Release the I/O lock between requests to let the writers go */
+        do {
+            IO_LOCK();
+            n = bh_wb.running? bh_writeback_once(bh_wb.soft): -1;
+            IO_UNLOCK();
+        } while (n > 0);
+
+        if (!bh_wb.running)
+            break;
+    }
+
+    /* blkdev_destroy() waits for it before freeing the buffers */
+    os_completed(bh_wb.exited);
+    os_thread_exit();
+}
+
+/*
+ * Throttle the writer if the dirty blocks reach the hard limit. The writer 
+ * has to write back the oldest blocks until it drops below the limit.
+ */
+static void bh_balance_dirty(void) {
+    if (rte_likely(bh_ndirty < bh_wb.hard))
+        return;
+
+    IO_LOCK();
+    bh_statistics.throttled++;
+    while (bh_writeback_once(bh_wb.hard) > 0);
+    IO_UNLOCK();
 }
 
 static void bh_check_cb(os_timer_t timer, void *arg) {
     (void) arg;
+    IO_LOCK();
     MTX_LOCK();
     int err = blkdev_sync_locked(CONFIG_BLKDEV_SWAP_PERIOD, 3, false);
     MTX_UNLOCK();
+    IO_UNLOCK();
     if (err) {
         pr_warn("flush data failed(%d)\n", err);
     }
@@ -135,8 +423,16 @@ static void bh_check_cb(os_timer_t timer, void *arg) {
 }
 
 static int bh_release_modified(struct bh_desc *bh) {
-    bh->state = BH_STATE_DIRTY;
+    if (bh->state != BH_STATE_DIRTY) {
+        bh->state = BH_STATE_DIRTY;
+        bh_ndirty++;
+    }
+    bh->seq++;
     bh_enqueue_dirty(bh);
+    if (bh_ndirty >= bh_wb.soft && bh_wb.running && !bh_wb.pending) {
+        bh_wb.pending = true;
+        os_completed(bh_wb.wakeup);
+    }
     MTX_UNLOCK();
     return 0;
 }
@@ -144,44 +440,53 @@ static int bh_release_modified(struct bh_desc *bh) {
 static int bh_release(struct bh_desc *bh) {
     if (bh->state == BH_STATE_DIRTY)
         bh_enqueue_dirty(bh);
-    else
+    else if (bh->state == BH_STATE_CACHED)
         bh_enqueue_cached(bh);
+    else
+        bh_enqueue_invalid(bh);
     MTX_UNLOCK();
     return 0;
 }
 
 /*
- * The cache block search use list is simplest but not fit lots of blocks
- * If so should use balance binrary tree
+ * Lookup the cache block through hash table. The block that has been hit 
+ * is removed from the list and it will be appended to the list tail when 
+ * it is released, so the head of cached_list is always the least recently 
+ * used block.
  */
 static struct bh_desc *bh_search_locked(struct disk_device *dd, uint32_t blkno) {
-    struct rte_list *pos, *next;
     struct bh_desc *bh;
 
-    rte_list_foreach_safe(pos, next, &cached_list) {
-        bh = rte_container_of(pos, struct bh_desc, link);
-        if (bh->dd == dd && bh->blkno == blkno) {
-            bh_statistics.cache_hits++;
-            rte_list_del(&bh->link);
-            return bh;
-        }
+    bh = bh_lookup_locked(dd, blkno);
+    if (bh) {
+        bh_statistics.cache_hits++;
+        rte_list_del(&bh->link);
+        return bh;
     }
-    rte_list_foreach_safe(pos, next, &dirty_list) {
-        bh = rte_container_of(pos, struct bh_desc, link);
-        if (bh->dd == dd && bh->blkno == blkno) {
-            bh_statistics.cache_hits++;
-            rte_list_del(&bh->link);
-            return bh;
-        }
+
+    /* 
+     * All blocks are dirty, so we write back the oldest ones. The I/O lock 
+     * must be acquired firstly, and the block may be loaded by others 
+     * when the cache lock is released.
+     */
+    if (rte_unlikely(rte_list_empty(&cached_list))) {
+        MTX_UNLOCK();
+        IO_LOCK();
+        MTX_LOCK();
+        if (rte_list_empty(&cached_list))
+            blkdev_sync_locked(CONFIG_BLKDEV_HOLD_TIME, CONFIG_BLKDEV_IO_BLKS, false);
+        IO_UNLOCK();
+        if (rte_list_empty(&cached_list))
+            return NULL;
+        return bh_search_locked(dd, blkno);
     }
-    if (rte_list_empty(&cached_list)) 
-        blkdev_sync_locked(CONFIG_BLKDEV_HOLD_TIME, 1, false);
     
     bh_statistics.cache_missed++;
     bh = rte_container_of(cached_list.next, struct bh_desc, link);
     rte_list_del(&bh->link);
-    bh->blkno = blkno;
-    bh->dd = dd;
+    if (bh->dd != NULL)
+        bh_statistics.cache_evicted++;
+    bh_rehash(bh, dd, blkno);
     bh->state = BH_STATE_INVALD;
     return bh;
 }
@@ -191,49 +496,163 @@ static int bh_get(struct disk_device *dd, uint32_t blkno, struct bh_desc **pbh)
 
     MTX_LOCK();
     bh = bh_search_locked(dd, blkno);
-    assert(bh != NULL);
+    if (rte_unlikely(bh == NULL)) {
+        MTX_UNLOCK();
+        pr_err("no free block buffer\n");
+        return -EIO;
+    }
     *pbh = bh;
     return 0;
 }
 
-static int bh_read(struct disk_device *dd, uint32_t blkno, struct bh_desc **pbh) {
+/*
+ * Read the block from disk. If @nahead is not zero, the following blocks
+ * that are not cached will be prefetched by the same request. The prefetch 
+ * only reuses the clean blocks and never writes back dirty data.
+ */
+static int bh_fill_locked(struct disk_device *dd, struct bh_desc *bh, 
+    uint32_t nahead) {
+    struct bh_desc *rav[CONFIG_BLKDEV_IO_BLKS];
+    struct bh_desc *p;
+    uint32_t ofs, nra = 0;
+    size_t size;
+    int err;
+
+    if (nahead > bh_io_blocks(dd) - 1)
+        nahead = bh_io_blocks(dd) - 1;
+    if (nahead > rte_array_size(rav))
+        nahead = rte_array_size(rav);
+
+    for (uint32_t i = 1; i <= nahead; i++) {
+        uint32_t blkno = bh->blkno + i;
+
+        if ((blkno + 1) * dd->blk_size > dd->len)
+            break;
+        if (bh_lookup_locked(dd, blkno))
+            break;
+        if (rte_list_empty(&cached_list))
+            break;
+        p = rte_container_of(cached_list.next, struct bh_desc, link);
+        rte_list_del(&p->link);
+        if (p->dd != NULL)
+            bh_statistics.cache_evicted++;
+        bh_rehash(p, dd, blkno);
+        p->state = BH_STATE_INVALD;
+        rav[nra++] = p;
+    }
+
+    ofs = dd->blk_size * bh->blkno;
+    size = dd->blk_size * (nra + 1);
+    err = disk_device_read(dd, nra? bh_iobuf: bh->buffer, size, ofs);
+    if (err < 0) {
+        for (uint32_t i = 0; i < nra; i++) {
+            bh_unhash(rav[i]);
+            rav[i]->dd = NULL;
+            bh_enqueue_invalid(rav[i]);
+        }
+        pr_err("Read disk failed(offset: 0x%x size: %d)\n", ofs, (int)size);
+        return err;
+    }
+
+    if (nra > 0) {
+        memcpy(bh->buffer, bh_iobuf, dd->blk_size);
+        for (uint32_t i = 0; i < nra; i++) {
+            p = rav[i];
+            memcpy(p->buffer, bh_iobuf + dd->blk_size * (i + 1), dd->blk_size);
+            p->state = BH_STATE_CACHED;
+            bh_enqueue_cached(p);
+        }
+        bh_statistics.readahead_blks += nra;
+    }
+
+    bh->state = BH_STATE_CACHED;
+    return 0;
+}
+
+static int bh_read(struct disk_device *dd, uint32_t blkno, uint32_t nahead,
+    struct bh_desc **pbh) {
     struct bh_desc *bh;
-    uint32_t ofs;
     int err;
 
     MTX_LOCK();
     bh = bh_search_locked(dd, blkno);
+    if (rte_unlikely(bh == NULL)) {
+        MTX_UNLOCK();
+        pr_err("no free block buffer\n");
+        return -EIO;
+    }
     if (bh->state != BH_STATE_INVALD) {
         *pbh = bh;
         return 0;
     }
 
-    ofs = dd->blk_size * bh->blkno;
-    err = disk_device_read(dd, bh->buffer, dd->blk_size, ofs);
+    err = bh_fill_locked(dd, bh, nahead);
     if (err < 0) {
         bh_release(bh);
-        pr_err("Read disk failed(offset: 0x%x size: %d)\n", ofs, dd->blk_size);
         return err;
     }
 
-    bh->state = BH_STATE_CACHED;
     *pbh = bh;
     return 0;
 }
 
 int blkdev_sync(void) {
+    IO_LOCK();
     MTX_LOCK();
     int err = blkdev_sync_locked(CONFIG_BLKDEV_HOLD_TIME, 
         INT32_MAX, false);
     MTX_UNLOCK();
+    IO_UNLOCK();
     return err;
 }
 
 int blkdev_sync_invalid(void) {
+    IO_LOCK();
     MTX_LOCK();
     int err = blkdev_sync_locked(CONFIG_BLKDEV_HOLD_TIME, 
         INT32_MAX, true);
     MTX_UNLOCK();
+    IO_UNLOCK();
+    return err;
+}
+
+int blkdev_set_dirty_ratio(int soft, int hard) {
+    if (soft <= 0 || soft > hard || hard > 100)
+        return -EINVAL;
+
+    if (!bh_initialized) {
+        bh_set_dirty_limit(soft, hard);
+        return 0;
+    }
+    MTX_LOCK();
+    bh_set_dirty_limit(soft, hard);
+    MTX_UNLOCK();
+    return 0;
+}
+
+int blkdev_writeback_start(void *stack, size_t size, int prio) {
+    int err;
+
+    if (!bh_initialized)
+        return -EINVAL;
+
+    MTX_LOCK();
+    if (bh_wb.running) {
+        MTX_UNLOCK();
+        return -EBUSY;
+    }
+    os_completion_reinit(bh_wb.wakeup);
+    os_completion_reinit(bh_wb.exited);
+    bh_wb.pending = false;
+    bh_wb.running = true;
+    MTX_UNLOCK();
+
+    err = os_thread_spawn(&bh_wb.thread, "blkdev-wb", stack, size, prio,
+        bh_writeback_thread, NULL);
+    if (err) {
+        bh_wb.running = false;
+        pr_err("create writeback thread failed(%d)\n", err);
+    }
     return err;
 }
 
@@ -254,7 +673,7 @@ ssize_t blkdev_write(struct disk_device *dd, const void *buf, size_t size,
         if (blkofs == 0 && remain >= dd->blk_size)
             err = bh_get(dd, blkno, &bh);
         else
-            err = bh_read(dd, blkno, &bh);
+            err = bh_read(dd, blkno, 0, &bh);
         if (err)
             return err;
 
@@ -264,6 +683,7 @@ ssize_t blkdev_write(struct disk_device *dd, const void *buf, size_t size,
 
         memcpy(bh->buffer + blkofs, src, bytes);
         bh_release_modified(bh);
+        bh_balance_dirty();
         remain -= bytes;
         src += bytes;
         blkofs = 0;
@@ -281,13 +701,25 @@ ssize_t blkdev_read(struct disk_device *dd, void *buf, size_t size,
     size_t bytes;
     uint32_t blkno;
     uint32_t blkofs;
+    uint32_t nblks, nahead;
+    bool sequential;
     int err;
 
     blkno = offset / dd->blk_size;
     blkofs = offset % dd->blk_size;
+    nblks = (blkofs + size + dd->blk_size - 1) / dd->blk_size;
+
+    /* 
+     * Sequential access detection. It is only a hint for read-ahead,
+     * so we don't care about the race of multiple readers
+     */
+    sequential = bh_ra.dd == dd && bh_ra.next == blkno;
 
     while (remain > 0) {
-        err = bh_read(dd, blkno, &bh);
+        nahead = --nblks;
+        if (sequential && nahead < CONFIG_BLKDEV_RA_BLKS)
+            nahead = CONFIG_BLKDEV_RA_BLKS;
+        err = bh_read(dd, blkno, nahead, &bh);
         if (err)
             return err;
         bytes = dd->blk_size - blkofs;
@@ -302,6 +734,8 @@ ssize_t blkdev_read(struct disk_device *dd, void *buf, size_t size,
         blkno++;
     }
 
+    bh_ra.dd = dd;
+    bh_ra.next = blkno;
     return size - remain;
 }
 
@@ -309,29 +743,54 @@ int blkdev_init(void) {
     int err;
     if (!bh_initialized) {
         struct bh_desc *bh;
-        size_t size;
-
-        size = CONFIG_BLKDEV_MAX_BLKSZ + sizeof(struct bh_desc);
-        bh = general_malloc(size * NR_BLKS);
-        assert(bh != NULL);
-        bh_buffer = bh;
+        size_t size, nhash;
+
+        /* The hash table has about two buckets per block */
+        bh_hashbits = 1;
+        while ((1u << bh_hashbits) < 2 * NR_BLKS)
+            bh_hashbits++;
+        nhash = (size_t)1 << bh_hashbits;
+
+        size = RTE_ALIGN(CONFIG_BLKDEV_MAX_BLKSZ + sizeof(struct bh_desc), 
+            sizeof(void *));
+        bh_hashtbl = general_malloc(nhash * sizeof(struct rte_hlist) + 
+            NR_BLKS * sizeof(struct bh_desc *) + size * NR_BLKS + BH_IOBUF_SIZE + 
+            BH_WBBUF_SIZE);
+        assert(bh_hashtbl != NULL);
+        for (size_t i = 0; i < nhash; i++)
+            bh_hashtbl[i].first = NULL;
+
+        bh_flushv = (struct bh_desc **)(bh_hashtbl + nhash);
+        bh = (struct bh_desc *)(bh_flushv + NR_BLKS);
+        bh_iobuf = BH_IOBUF_SIZE? (char *)bh + size * NR_BLKS: NULL;
+        bh_wb.buffer = (char *)bh + size * NR_BLKS + BH_IOBUF_SIZE;
+        bh_buffer = bh_hashtbl;
+        bh_ndirty = 0;
+        bh_set_dirty_limit(bh_wb.soft_ratio, bh_wb.hard_ratio);
         for (int i = 0; i < (int)NR_BLKS; i++) {
             bh->blkno = 0;
             bh->buffer = (char *)(bh + 1);
             bh->state = BH_STATE_INVALD;
             bh->dd = NULL;
+            bh->seq = 0;
+            RTE_INIT_HLIST_NODE(&bh->hash);
             rte_list_add(&bh->link, &cached_list);
             bh = (void *)((char *)bh + size);
         }
 
         err = os_timer_create(&bh_timer, bh_check_cb, NULL, false);
         if (err) {
-            general_free(bh);
+            general_free(bh_buffer);
             bh_buffer = NULL;
+            bh_hashtbl = NULL;
+            bh_flushv = NULL;
+            bh_iobuf = NULL;
+            RTE_INIT_LIST(&cached_list);
             pr_err("create timer failed(%d)\n", err);
             return err;
         }
         MTX_LOCK_INIT();
+        IO_LOCK_INIT();
         bh_initialized = true;
         err = os_timer_add(bh_timer, CONFIG_BLKDEV_SWAP_PERIOD);
         assert(err == 0);
@@ -341,27 +800,76 @@ int blkdev_init(void) {
 }
 
 int blkdev_destroy(void) {
+    bool running;
+
     if (!bh_initialized)
         return 0;
+
+    /* 
+     * Stop the write-back thread first, It may be writing a request 
+     * with the write-back buffer
+     */
     MTX_LOCK();
+    running = bh_wb.running;
+    if (running) {
+        bh_wb.running = false;
+        os_completed(bh_wb.wakeup);
+    }
+    MTX_UNLOCK();
+    if (running)
+        os_completion_wait(bh_wb.exited);
+
+    /* The timer callback takes the locks, it may be waited for here */
     os_timer_destroy(bh_timer);
+
+    IO_LOCK();
+    MTX_LOCK();
     RTE_INIT_LIST(&cached_list);
     RTE_INIT_LIST(&dirty_list);
     if (bh_buffer) {
         general_free(bh_buffer);
         bh_buffer = NULL;
+        bh_hashtbl = NULL;
+        bh_flushv = NULL;
+        bh_iobuf = NULL;
+        bh_wb.buffer = NULL;
     }
+    bh_ra.dd = NULL;
+    bh_ndirty = 0;
     bh_initialized = false;
     MTX_UNLOCK();
+    IO_UNLOCK();
     return 0;
 }
 
+void blkdev_get_stats(struct blkdev_stats *stats) {
+    MTX_LOCK();
+    *stats = bh_statistics;
+    MTX_UNLOCK();
+}
+
 void blkdev_print(void) {
-    struct bh_statitics *stat = &bh_statistics;
+    struct blkdev_stats *stat = &bh_statistics;
+    long total = stat->cache_hits + stat->cache_missed;
     pr_out("\n=========== Block Device Statistics ==========\n");
-    pr_out("Cache Hits: %ld\nCache Missed: %ld\nCache Hit-Rate: %ld%%\n\n",
+    pr_out("Cache Blocks: %d\nCache Hits: %ld\nCache Missed: %ld\n"
+        "Cache Evicted: %ld\nCache Hit-Rate: %ld%%\n",
+        (int)NR_BLKS,
         stat->cache_hits,
         stat->cache_missed,
-        (stat->cache_hits * 100) / (stat->cache_hits + stat->cache_missed)
+        stat->cache_evicted,
+        total? (stat->cache_hits * 100) / total: 0
+    );
+    pr_out("Read-ahead Blocks: %ld\nWriteback Blocks: %ld\n"
+        "Writeback Requests: %ld\n",
+        stat->readahead_blks,
+        stat->writeback_blks,
+        stat->writeback_reqs
+    );
+    pr_out("Dirty Blocks: %d (soft: %d%% hard: %d%%)\nWriter Throttled: %ld\n\n",
+        bh_ndirty,
+        bh_wb.soft_ratio,
+        bh_wb.hard_ratio,
+        stat->throttled
     );
 }
\ No newline at end of file
@@ -19,6 +19,16 @@ extern "C"{
 #endif
 struct disk_device;
 
+struct blkdev_stats {
+    long cache_hits;
+    long cache_missed;
+    long cache_evicted;
+    long readahead_blks; /* Blocks that prefetched by read-ahead */
+    long writeback_blks; /* Blocks that written back to disk */
+    long writeback_reqs; /* Disk requests of write-back */
+    long throttled;
+};
+
 /*
  * blkdev_write - Block device write 
  *
@@ -57,6 +67,31 @@ int blkdev_sync(void);
  */
 int blkdev_sync_invalid(void);
 
+/*
+ * blkdev_set_dirty_ratio - Set the dirty block thresholds
+ *
+ * @soft: the write-back thread is woken up when the percentage of dirty 
+ *        blocks reaches it
+ * @hard: the writer has to write back data by itself when the percentage
+ *        of dirty blocks reaches it
+ * return 0 if success
+ */
+int blkdev_set_dirty_ratio(int soft, int hard);
+
+/*
+ * blkdev_writeback_start - Create the background write-back thread
+ *
+ * The write-back requests are issued without the cache lock, So the disk
+ * driver may be called to read a block while another block is being 
+ * written back. The disk driver must be thread safe.
+ *
+ * @stack: thread stack address
+ * @size: thread stack size
+ * @prio: thread priority
+ * return 0 if success
+ */
+int blkdev_writeback_start(void *stack, size_t size, int prio);
+
 /*
  * blkdev_init - Initialize block device
  * return 0 if success
@@ -68,6 +103,13 @@ int blkdev_init(void);
  */
 void blkdev_print(void);
 
+/*
+ * blkdev_get_stats - Get block device statistics information
+ *
+ * @stats: statistics buffer
+ */
+void blkdev_get_stats(struct blkdev_stats *stats);
+
 /*
  * blkdev_destroy - Destroy block device
  * return 0 if success
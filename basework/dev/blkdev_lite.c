@@ -295,6 +295,9 @@ int blkdev_init(void) {
 }
 
 void blkdev_print(void) {}
+void blkdev_get_stats(struct blkdev_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
 int  blkdev_destroy(void) {
     return 0;
 }
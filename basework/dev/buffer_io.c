@@ -190,8 +190,21 @@ ssize_t buffered_write(struct buffered_io *bio, const void *buf, size_t size,
          * Write to whole eraseable block
          */
         if (rte_unlikely(blkin_ofs == 0 && size >= bio->size)) {
+            if (rte_likely(!bio->panic))
+                MTX_LOCK(&bio->mtx);
+
+            /* 
+             * The cached copy of this block is superseded, Drop it so that
+             * it will not be flushed over the new data later
+             */
+            if (bio->offset == offset) {
+                bio->dirty = false;
+                bio->offset = UINT32_MAX;
+            }
             ret = write_eraseable_block(bio->dd, pbuf, bio->size, 
                 offset);
+            if (rte_likely(!bio->panic))
+                MTX_UNLOCK(&bio->mtx);
             if (ret < 0)
                 goto _exit;
             
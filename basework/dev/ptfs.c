@@ -66,11 +66,22 @@ static inline uint32_t idx_to_offset(struct ptfs_context *ctx,
     return start;
 }
 
+/*
+ * Translate the file offset to device offset. The @end is extended to
+ * the end of extent (the following blocks that are contiguous on device)
+ */
 static uint32_t extofs_to_inofs(struct ptfs_context *ctx, struct ptfs_file *filp, 
     uint32_t offset, uint32_t *end) {
-    uint8_t idx = offset >> const_ilog2(CONFIG_PTFS_BLKSIZE);
+    const struct file_metadata *pmeta = filp->pmeta;
+    uint16_t idx = offset >> const_ilog2(CONFIG_PTFS_BLKSIZE);
     uint32_t ofs = offset & (CONFIG_PTFS_BLKSIZE - 1);
-    uint32_t start = idx_to_offset(ctx, IDX_CONVERT(filp->pmeta->i_frag[idx]), end);
+    uint32_t start = idx_to_offset(ctx, IDX_CONVERT(pmeta->i_frag[idx]), end);
+    uint16_t last = idx;
+
+    while (last + 1 < pmeta->i_count && 
+        pmeta->i_frag[last + 1] == pmeta->i_frag[last] + 1)
+        last++;
+    *end += (uint32_t)(last - idx) << const_ilog2(CONFIG_PTFS_BLKSIZE);
     pr_dbg("## extofs_to_inofs: idx(%d) start(%x) end(%x) offset(%d)\n", idx, start, *end, offset);
     return start + ofs;
 }
@@ -99,9 +110,45 @@ static int bitmap_free(uint32_t *bitmap, size_t n, int idx) {
     return 0;
 }
 
-static inline int inode_allocate(struct ptfs_inode *inode) {
-    return bitmap_allocate(inode->i_bitmap, 
-        rte_array_size(inode->i_bitmap));
+static inline bool inode_is_free(struct ptfs_inode *inode, int blk) {
+    return !(inode->i_bitmap[blk >> 5] & BIT(blk & 31));
+}
+
+/*
+ * Allocate a run of contiguous inodes (at most @n). The run that follows
+ * @prev is preferred so that the file can be extended in place, otherwise
+ * the first run that is large enough or the largest one.
+ *
+ * return the first inode index and @count is the length of run
+ */
+static int inode_allocate_extent(struct ptfs_inode *inode, int prev, 
+    int n, int *count) {
+    int best = -1, best_len = 0;
+    int blk, len;
+
+    if (prev != PTFS_INVALID_IDX && prev < PTFS_MAX_INODES && 
+        inode_is_free(inode, prev)) {
+        best = prev;
+    } else {
+        for (blk = 0; blk < PTFS_MAX_INODES; blk += len + 1) {
+            for (len = 0; blk + len < PTFS_MAX_INODES && 
+                inode_is_free(inode, blk + len); len++);
+            if (len > best_len) {
+                best = blk;
+                best_len = len;
+                if (len >= n)
+                    break;
+            }
+        }
+        if (best < 0)
+            return PTFS_INVALID_IDX;
+    }
+
+    for (len = 0; len < n && best + len < PTFS_MAX_INODES && 
+        inode_is_free(inode, best + len); len++)
+        inode->i_bitmap[(best + len) >> 5] |= BIT((best + len) & 31);
+    *count = len;
+    return best + 1;
 }
 
 static inline int inode_free(struct ptfs_inode *inode, int idx) {
@@ -154,24 +201,37 @@ static struct ptfs_file *ptfile_allocate(struct ptfs_context *ctx) {
     return filp;
 }
 
+/*
+ * Make sure that the space [offset, offset + size) has been allocated
+ */
 static int curr_avaliable_space(struct ptfs_context *ctx, 
-    struct ptfs_file *filp, uint32_t offset, 
-    uint32_t *start, uint32_t *end) {
+    struct ptfs_file *filp, uint32_t offset, size_t size) {
     struct file_metadata *pmeta = filp->pmeta;
-    uint16_t idx = offset >> const_ilog2(CONFIG_PTFS_BLKSIZE);
+    uint32_t nblks = (uint32_t)((offset + size + CONFIG_PTFS_BLKSIZE - 1) >> 
+        const_ilog2(CONFIG_PTFS_BLKSIZE));
+
+    if (nblks == 0)
+        nblks = 1;
+    if (nblks > PTFS_MAX_INODES) {
+        pr_err("file is too large\n");
+        return -ENODATA;
+    }
+    while (pmeta->i_count < nblks) {
+        int prev = pmeta->i_count? pmeta->i_frag[pmeta->i_count - 1]: 
+            PTFS_INVALID_IDX;
+        int count, newidx;
 
-    if (idx + 1 > pmeta->i_count) {
-        uint16_t newidx = (uint16_t)inode_allocate(&ctx->inode);
+        newidx = inode_allocate_extent(&ctx->inode, prev, 
+            nblks - pmeta->i_count, &count);
         if (!newidx) {
             pr_err("allocate inode failed\n");
             return -ENODATA;
         }
-        assert(pmeta->i_count < PTFS_MAX_INODES);
-        pmeta->i_frag[pmeta->i_count++] = newidx;
+        while (count-- > 0)
+            pmeta->i_frag[pmeta->i_count++] = (uint16_t)newidx++;
     }
-    *start = extofs_to_inofs(ctx, filp, offset, end);
-    pr_dbg("## curr_avaliable_space: idx(%d) offset(%d) i_count(%d) start(0x%x) end(0x%x)\n", 
-        idx, offset, pmeta->i_count, *start, *end);
+    pr_dbg("## curr_avaliable_space: offset(%d) size(%d) i_count(%d)\n", 
+        offset, (int)size, pmeta->i_count);
     return 0;
 }
 
@@ -237,21 +297,18 @@ ssize_t ptfile_ll_read(struct ptfs_context *ctx, struct ptfs_file *filp,
 
     offset = filp->rawofs;
     osize = size = rte_min_t(size_t, size, filp->pmeta->size - offset);
-    start = extofs_to_inofs(ctx, filp, offset, &end);
+
+    /* One device transfer per extent */
     while (size > 0) {
+        start = extofs_to_inofs(ctx, filp, offset, &end);
         size_t bytes = rte_min_t(size_t, end - start, size);
-        if (bytes > 0) {
-            ret = disk_device_read(ctx->dd, pbuffer, bytes, start);
-            if (ret < 0)
-                goto _unlock;
-
-            size -= bytes;
-            pbuffer += bytes;
-            start += bytes;
-            offset += bytes;
-        } else {
-            start = extofs_to_inofs(ctx, filp, offset, &end);
-        }
+        ret = disk_device_read(ctx->dd, pbuffer, bytes, start);
+        if (ret < 0)
+            goto _unlock;
+
+        size -= bytes;
+        pbuffer += bytes;
+        offset += bytes;
     }
     filp->rawofs = offset;
     ret = osize - size;
@@ -275,31 +332,21 @@ ssize_t ptfile_ll_write(struct ptfs_context *ctx, struct ptfs_file *filp,
     }
 
     offset = filp->rawofs;
-    ret = curr_avaliable_space(ctx, filp, offset, &start, &end);
+    ret = curr_avaliable_space(ctx, filp, offset, size);
     if (ret < 0)
-        goto _unlock;
+        goto _failed;
 
+    /* One device transfer per extent */
     while (size > 0) {
+        start = extofs_to_inofs(ctx, filp, offset, &end);
         size_t bytes = rte_min_t(size_t, end - start, size);
-        if (bytes > 0) {
-            ret = blkdev_write(ctx->dd, pbuffer, bytes, start);
-            if (ret < 0) {
-                filp->rawofs = 0;
-                file_metadata_clear_locked(ctx, filp->pmeta);
-                goto _unlock;
-            }
-            size -= bytes;
-            pbuffer += bytes;
-            start += bytes;
-            offset += bytes;
-        } else {
-            ret = curr_avaliable_space(ctx, filp, offset, &start, &end);
-            if (ret < 0) {
-                filp->rawofs = 0;
-                file_metadata_clear_locked(ctx, filp->pmeta);
-                goto _unlock;
-            }
-        }
+        ret = blkdev_write(ctx->dd, pbuffer, bytes, start);
+        if (ret < 0)
+            goto _failed;
+
+        size -= bytes;
+        pbuffer += bytes;
+        offset += bytes;
     }
     filp->pmeta->size = offset;
     filp->rawofs = offset;
@@ -312,6 +359,11 @@ ssize_t ptfile_ll_write(struct ptfs_context *ctx, struct ptfs_file *filp,
 _unlock:
     MTX_UNLOCK(ctx->mtx);
     return ret;
+
+_failed:
+    filp->rawofs = 0;
+    file_metadata_clear_locked(ctx, filp->pmeta);
+    goto _unlock;
 }
 
 int ptfile_ll_close(struct ptfs_context *ctx, struct ptfs_file *filp) {
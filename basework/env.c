@@ -8,6 +8,9 @@
 #include "basework/lib/env_core.h"
 #include "basework/env.h"
 #include "basework/log.h"
+#if defined(CONFIG_ENV_HASH) && !defined(CONFIG_BOOTLOADER)
+#include "basework/dev/partition.h"
+#endif
 
 struct env_ram {
     char *buffer;
@@ -45,6 +48,12 @@ void __rte_notrace env_reset(void) {
     _env_free(&sysenv);
 }
 
+#ifdef CONFIG_ENV_HASH
+int __rte_notrace env_compact(void) {
+    return _env_compact(&sysenv);
+}
+#endif
+
 bool __rte_notrace env_streq(const char *key, const char *s) {
     const char *env = env_get(key);
     if (env && s)
@@ -163,6 +172,180 @@ int __rte_notrace env_dump(void) {
     return env_flush(env_print, NULL);
 }
 
+#ifdef CONFIG_ENV_HASH
+int __rte_notrace env_commit(const struct env_journal *jn) {
+    return _env_commit(&sysenv, jn);
+}
+
+#ifndef CONFIG_BOOTLOADER
+/*
+ * The partition is split into two slots, each one holds a whole journal:
+ *
+ * | header | records ... |
+ *
+ * The full journal is rewritten to the other slot and its header is 
+ * written at last, So the old journal stays valid until the new one is 
+ * complete.
+ */
+struct env_disk_header {
+    uint32_t magic;
+#define ENV_DISK_MAGIC 0x6a766e65
+    uint32_t gen;
+};
+
+struct env_disk {
+    const struct disk_partition *part;
+    uint32_t size;    /* Slot size */
+    uint32_t slot;    /* Start of the active slot */
+    uint32_t offset;  /* The end of journal in slot */
+    uint32_t gen;     /* Generation of the active slot */
+    uint32_t old_slot;
+    uint32_t old_offset;
+};
+
+static struct env_disk env_disk;
+
+static int __rte_notrace env_disk_append(void *ctx, void *buffer, size_t size) {
+    struct env_disk *ed = (struct env_disk *)ctx;
+    int ret;
+
+    if (ed->offset + size > ed->size)
+        return -ENOSPC;
+    ret = disk_partition_write(ed->part, ed->slot + ed->offset, buffer, size);
+    if (ret < 0)
+        return ret;
+    ed->offset += size;
+    return 0;
+}
+
+static int __rte_notrace env_disk_reset(void *ctx) {
+    struct env_disk *ed = (struct env_disk *)ctx;
+    int ret;
+
+    /* Switch to the other slot, the active one is kept */
+    ed->old_slot = ed->slot;
+    ed->old_offset = ed->offset;
+    ed->slot = ed->slot? 0: ed->size;
+    ed->offset = sizeof(struct env_disk_header);
+    ret = disk_partition_erase(ed->part, ed->slot, ed->size);
+    return ret < 0? ret: 0;
+}
+
+static int __rte_notrace env_disk_swap(void *ctx, bool done) {
+    struct env_disk *ed = (struct env_disk *)ctx;
+    struct env_disk_header hdr;
+    int ret;
+
+    if (done) {
+        hdr.magic = ENV_DISK_MAGIC;
+        hdr.gen = ed->gen + 1;
+        ret = disk_partition_write(ed->part, ed->slot, &hdr, sizeof(hdr));
+        if (ret >= 0) {
+            ed->gen = hdr.gen;
+            return 0;
+        }
+    } else {
+        ret = 0;
+    }
+
+    /* Go back to the old journal */
+    ed->slot = ed->old_slot;
+    ed->offset = ed->old_offset;
+    return ret;
+}
+
+static int __rte_notrace env_disk_readline(void *ctx, void *buffer, size_t max_size) {
+    struct env_disk *ed = (struct env_disk *)ctx;
+    size_t remain = ed->size - ed->offset;
+    char *p;
+    int ret;
+
+    if (remain == 0)
+        return 0;
+    if (max_size > remain)
+        max_size = remain;
+    ret = disk_partition_read(ed->part, ed->slot + ed->offset, buffer, max_size);
+    if (ret < 0)
+        return ret;
+
+    /* The erased space is the end of journal */
+    p = memchr(buffer, '\n', max_size);
+    if (!p || *(uint8_t *)buffer == 0xff)
+        return 0;
+    ret = p - (char *)buffer + 1;
+    ed->offset += ret;
+    return ret;
+}
+
+int __rte_notrace env_load_disk(const char *partition) {
+    struct env_disk_header hdr[2];
+    size_t blksz;
+    uint8_t c;
+    int err;
+
+    env_disk.part = disk_partition_find(partition);
+    if (!env_disk.part)
+        return -ENODEV;
+    err = lgpt_get_block_size(env_disk.part, &blksz);
+    if (err)
+        return err;
+    env_disk.size = (env_disk.part->len / 2 / blksz) * blksz;
+    if (env_disk.size <= sizeof(hdr[0]))
+        return -EINVAL;
+
+    /* The valid slot with newer generation is active */
+    for (int i = 0; i < 2; i++) {
+        err = disk_partition_read(env_disk.part, i * env_disk.size, &hdr[i], 
+            sizeof(hdr[i]));
+        if (err < 0)
+            return err;
+    }
+    if (hdr[0].magic == ENV_DISK_MAGIC && (hdr[1].magic != ENV_DISK_MAGIC ||
+        (int32_t)(hdr[0].gen - hdr[1].gen) > 0)) {
+        env_disk.slot = 0;
+        env_disk.gen = hdr[0].gen;
+    } else if (hdr[1].magic == ENV_DISK_MAGIC) {
+        env_disk.slot = env_disk.size;
+        env_disk.gen = hdr[1].gen;
+    } else {
+        /* No journal yet, the first commit writes the slot 0 */
+        env_disk.slot = env_disk.size;
+        env_disk.offset = env_disk.size;
+        env_disk.gen = 0;
+        return 0;
+    }
+
+    env_disk.offset = sizeof(hdr[0]);
+    err = env_load(env_disk_readline, &env_disk);
+    if (err)
+        return err;
+
+    /*
+     * The last record is broken (e.g. power lost), the journal will be
+     * rewritten at next commit
+     */
+    if (env_disk.offset < env_disk.size &&
+        disk_partition_read(env_disk.part, env_disk.slot + env_disk.offset, 
+        &c, 1) >= 0 && c != 0xff)
+        env_disk.offset = env_disk.size;
+    return 0;
+}
+
+int __rte_notrace env_commit_disk(void) {
+    static const struct env_journal disk_journal = {
+        .append = env_disk_append,
+        .reset = env_disk_reset,
+        .ctx = &env_disk,
+        .swap = env_disk_swap
+    };
+
+    if (!env_disk.part)
+        return -ENODEV;
+    return env_commit(&disk_journal);
+}
+#endif /* CONFIG_BOOTLOADER */
+#endif /* CONFIG_ENV_HASH */
+
 int __rte_notrace env_init(void) {
 #ifndef CONFIG_BOOTLOADER
     os_mtx_init(&sysenv.mtx, 0);
@@ -1,8 +1,8 @@
 /*
  * Copyright 2022 wtcat
  */
-#ifndef BASEWORK_LIB_ENVCORE_H_
-#define BASEWORK_LIB_ENVCORE_H_
+#ifndef BASEWORK_ENV_H_
+#define BASEWORK_ENV_H_
 
 #include <stddef.h>
 #include <stdbool.h>
@@ -10,6 +10,7 @@
 #ifdef __cplusplus
 extern "C"{
 #endif
+struct env_journal;
 
 /*
  * env_set - Create or overwrite a environment variable 
@@ -32,6 +33,9 @@ int env_unset(const char *name);
 /*
  * env_get - Get a environment variable 
  *
+ * The string stays allocated until env_compact() or env_reset(), a later
+ * env_set() of the same variable may change its content.
+ *
  * @name: variable name
  * return a string if success else null
  */
@@ -124,6 +128,42 @@ int env_load_ram(void *input, size_t size);
  */
 int env_dump(void);
 
+/*
+ * env_commit - Append the changes since last commit to journal
+ * (CONFIG_ENV_HASH only)
+ *
+ * @jn: journal media
+ * return 0 if success
+ */
+int env_commit(const struct env_journal *jn);
+
+/*
+ * env_load_disk - Load environment variables from the journal on partition
+ * (CONFIG_ENV_HASH only)
+ *
+ * @partition: partition name
+ * return 0 if success
+ */
+int env_load_disk(const char *partition);
+
+/*
+ * env_commit_disk - Append the changes to the journal on partition. When it 
+ * is full the journal is rewritten to the other half of the partition, and 
+ * the old one stays valid until the new one is complete (CONFIG_ENV_HASH only)
+ *
+ * return 0 if success
+ */
+int env_commit_disk(void);
+
+/*
+ * env_compact - Reclaim the memory of deleted and replaced variables. The
+ * strings returned by env_get() before are invalid after it, so call it 
+ * where no one holds them, e.g. after env_load_disk() (CONFIG_ENV_HASH only)
+ *
+ * return 0 if success
+ */
+int env_compact(void);
+
 /*
  * env_init - Initialize environment variable
  *
@@ -134,4 +174,4 @@ int env_init(void);
 #ifdef __cplusplus
 }
 #endif
-#endif /* BASEWORK_LIB_ENVCORE_H_ */
+#endif /* BASEWORK_ENV_H_ */
@@ -0,0 +1,486 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Deferred binary log
+ *
+ * The producers reserve space from the ring by CAS on head and commit the
+ * record by writing its header, so that the log can be recorded from any
+ * context without lock. The consumer clears the consumed space before it
+ * moves the tail, so a zero header means the record is not committed yet.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "basework/os/osapi.h"
+#include "basework/lib/printer.h"
+#include "basework/lib/iovpr.h"
+#include "basework/lib/deflog.h"
+#include "basework/hook.h"
+
+#define DEFLOG_ALIGN(x) (((x) + 7) & ~7u)
+#define DEFLOG_SPEC_MAX 24
+
+enum deflog_arg {
+    DEFLOG_ARG_NONE,
+    DEFLOG_ARG_INT,
+    DEFLOG_ARG_LONG,
+    DEFLOG_ARG_LLONG,
+    DEFLOG_ARG_PTR,
+    DEFLOG_ARG_STR,
+    DEFLOG_ARG_DOUBLE,
+    DEFLOG_ARG_HEXDUMP
+};
+
+struct deflog_spec {
+    const char *start;
+    const char *end;
+    int nstar;
+    enum deflog_arg type;
+};
+
+struct deflog_line {
+    struct printer *output;
+    int ptr;
+    char buffer[128];
+};
+
+struct deflog_context {
+    uint32_t head __rte_cache_aligned;
+    uint32_t tail __rte_cache_aligned;
+    uint32_t mask;
+    uint32_t dropped;
+    int busy;
+    char *buffer;
+    struct printer *output;
+    uint32_t period;
+    os_thread_t thread;
+};
+
+static struct deflog_context deflog_context;
+
+uint32_t RTE_WEAKHOOK(_deflog_timestamp, void) {
+    return os_timer_gettime();
+}
+
+/*
+ * Parse the next conversion of format string. It accepts the same syntax
+ * as _IO_Vprintf()
+ */
+static const char *deflog_next_spec(const char *fmt, struct deflog_spec *spec) {
+    int lflag = 0;
+    char ch;
+
+    for ( ; ; ) {
+        while (*fmt != '%') {
+            if (*fmt == '\0')
+                return NULL;
+            fmt++;
+        }
+        spec->start = fmt++;
+        spec->nstar = 0;
+        lflag = 0;
+reswitch:
+        switch (ch = *fmt++) {
+        case '.': case '#': case '+': case '-': case ' ':
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            goto reswitch;
+        case '*':
+            spec->nstar++;
+            goto reswitch;
+        case 'h':
+            goto reswitch;
+        case 'l':
+            lflag++;
+            goto reswitch;
+        case 'j': case 'q': case 'L':
+            lflag = 2;
+            goto reswitch;
+        case 'z': case 't':
+            lflag = 1;
+            goto reswitch;
+        case 'c': case 'd': case 'i': case 'o':
+        case 'u': case 'x': case 'X': case 'y':
+            spec->type = lflag > 1? DEFLOG_ARG_LLONG:
+                (lflag? DEFLOG_ARG_LONG: DEFLOG_ARG_INT);
+            break;
+        case 'p':
+            spec->type = DEFLOG_ARG_PTR;
+            break;
+        case 's':
+            spec->type = DEFLOG_ARG_STR;
+            break;
+        case 'D':
+            spec->type = DEFLOG_ARG_HEXDUMP;
+            break;
+        case 'a': case 'A': case 'e': case 'E':
+        case 'f': case 'F': case 'g': case 'G':
+            spec->type = DEFLOG_ARG_DOUBLE;
+            break;
+        case '\0':
+            return NULL;
+        default:
+            spec->type = DEFLOG_ARG_NONE;
+            break;
+        }
+        spec->end = fmt;
+        return fmt;
+    }
+}
+
+static inline int deflog_spec_nargs(const struct deflog_spec *spec) {
+    if (spec->type == DEFLOG_ARG_HEXDUMP)
+        return spec->nstar + 2;
+    return spec->nstar + (spec->type != DEFLOG_ARG_NONE);
+}
+
+static void *deflog_reserve(struct deflog_context *ctx, uint32_t size) {
+    uint32_t head, tail, ofs, pad, need;
+    uint32_t capacity = ctx->mask + 1;
+
+    head = __atomic_load_n(&ctx->head, __ATOMIC_RELAXED);
+    do {
+        tail = __atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE);
+        ofs = head & ctx->mask;
+
+        /* The record must be continuous, fill the end of ring if no room */
+        pad = (ofs + size > capacity)? capacity - ofs: 0;
+        need = pad + size;
+        if (rte_unlikely(need > capacity - (head - tail))) {
+            __atomic_fetch_add(&ctx->dropped, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&ctx->head, &head, head + need,
+        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    if (pad) {
+        struct deflog_record *rec = (struct deflog_record *)(ctx->buffer + ofs);
+        __atomic_store_n(&rec->header, pad | DEFLOG_PADDING, __ATOMIC_RELEASE);
+    }
+    return ctx->buffer + ((head + pad) & ctx->mask);
+}
+
+static int deflog_format(void *context, const char *fmt, va_list ap) {
+    struct deflog_context *ctx = context;
+    uint64_t args[DEFLOG_MAX_ARGS];
+    const char *strs[DEFLOG_MAX_ARGS];
+    uint8_t slen[DEFLOG_MAX_ARGS];
+    struct deflog_record *rec;
+    struct deflog_spec spec;
+    const char *p = fmt;
+    uint32_t size, strsize = 0;
+    int nargs = 0, nstrs = 0;
+
+    /*
+     * Fetch the raw arguments according to format string
+     */
+    while ((p = deflog_next_spec(p, &spec)) != NULL) {
+        if (nargs + deflog_spec_nargs(&spec) > DEFLOG_MAX_ARGS)
+            break;
+        for (int i = 0; i < spec.nstar; i++)
+            args[nargs++] = (uint64_t)va_arg(ap, int);
+        switch (spec.type) {
+        case DEFLOG_ARG_NONE:
+            continue;
+        case DEFLOG_ARG_INT:
+            args[nargs] = (uint64_t)va_arg(ap, int);
+            break;
+        case DEFLOG_ARG_LONG:
+            args[nargs] = (uint64_t)va_arg(ap, long);
+            break;
+        case DEFLOG_ARG_LLONG:
+            args[nargs] = (uint64_t)va_arg(ap, long long);
+            break;
+        case DEFLOG_ARG_PTR:
+            args[nargs] = (uintptr_t)va_arg(ap, void *);
+            break;
+        case DEFLOG_ARG_HEXDUMP:
+            args[nargs++] = (uintptr_t)va_arg(ap, void *);
+            args[nargs] = (uintptr_t)va_arg(ap, void *);
+            break;
+        case DEFLOG_ARG_STR:
+            strs[nstrs] = va_arg(ap, const char *);
+            if (strs[nstrs] == NULL)
+                strs[nstrs] = "(null)";
+            slen[nstrs] = (uint8_t)strnlen(strs[nstrs], DEFLOG_MAX_STRING);
+            args[nargs] = slen[nstrs];
+            strsize += slen[nstrs];
+            nstrs++;
+            break;
+        case DEFLOG_ARG_DOUBLE: {
+            double v = va_arg(ap, double);
+            memcpy(&args[nargs], &v, sizeof(v));
+            break;
+        }
+        default:
+            break;
+        }
+        nargs++;
+    }
+
+    size = DEFLOG_ALIGN(sizeof(*rec) + nargs * sizeof(args[0]) + strsize);
+    rec = deflog_reserve(ctx, size);
+    if (rte_unlikely(rec == NULL))
+        return 0;
+
+    rec->stamp = _deflog_timestamp();
+    rec->fmt = fmt;
+    if (nargs > 0) {
+        char *s = (char *)&rec->args[nargs];
+        memcpy(rec->args, args, nargs * sizeof(args[0]));
+        for (int i = 0; i < nstrs; i++) {
+            memcpy(s, strs[i], slen[i]);
+            s += slen[i];
+        }
+    }
+
+    /* Commit */
+    __atomic_store_n(&rec->header, size | ((uint32_t)nargs << DEFLOG_NARGS_SHIFT),
+        __ATOMIC_RELEASE);
+    return (int)size;
+}
+
+/*
+ * Get the first committed record (Single consumer)
+ */
+static struct deflog_record *deflog_peek(struct deflog_context *ctx,
+    uint32_t *psize) {
+    struct deflog_record *rec;
+    uint32_t tail, header;
+
+    for ( ; ; ) {
+        tail = ctx->tail;
+        if (tail == __atomic_load_n(&ctx->head, __ATOMIC_ACQUIRE))
+            return NULL;
+        rec = (struct deflog_record *)(ctx->buffer + (tail & ctx->mask));
+        header = __atomic_load_n(&rec->header, __ATOMIC_ACQUIRE);
+        if (header == 0)
+            return NULL;
+        *psize = header & DEFLOG_SIZE_MASK;
+        if (!(header & DEFLOG_PADDING))
+            return rec;
+        memset(rec, 0, *psize);
+        __atomic_store_n(&ctx->tail, tail + *psize, __ATOMIC_RELEASE);
+    }
+}
+
+static void deflog_consume(struct deflog_context *ctx,
+    struct deflog_record *rec, uint32_t size) {
+    memset(rec, 0, size);
+    __atomic_store_n(&ctx->tail, ctx->tail + size, __ATOMIC_RELEASE);
+}
+
+static void deflog_put_char(int c, void *arg) {
+    struct deflog_line *line = arg;
+
+    line->buffer[line->ptr++] = (char)c;
+    if (line->ptr == (int)sizeof(line->buffer)) {
+        virt_format(line->output, "%.*s", line->ptr, line->buffer);
+        line->ptr = 0;
+    }
+}
+
+static void deflog_emit(struct deflog_line *line, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    _IO_Vprintf(deflog_put_char, line, fmt, ap);
+    va_end(ap);
+}
+
+/*
+ * Copy the conversion to @buf and replace '*' with the recorded value
+ */
+static int deflog_spec_copy(char *buf, const struct deflog_spec *spec,
+    const uint64_t *args) {
+    int n = 0;
+
+    for (const char *p = spec->start; p < spec->end; p++) {
+        if (n >= DEFLOG_SPEC_MAX - 12)
+            break;
+        if (*p == '*') {
+            char num[12];
+            int v = (int)*args++, k = 0;
+            if (v < 0) {
+                buf[n++] = '-';
+                v = -v;
+            }
+            do {
+                num[k++] = '0' + v % 10;
+                v /= 10;
+            } while (v);
+            while (k > 0)
+                buf[n++] = num[--k];
+            continue;
+        }
+        buf[n++] = *p;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+static void deflog_record_format(struct deflog_line *line,
+    const struct deflog_record *rec) {
+    const char *fmt = rec->fmt;
+    const char *str;
+    struct deflog_spec spec;
+    char sbuf[DEFLOG_SPEC_MAX];
+    char tmp[DEFLOG_MAX_STRING + 1];
+    int nargs, i = 0;
+
+    /* The arguments are followed by strings */
+    nargs = (rec->header & DEFLOG_NARGS_MASK) >> DEFLOG_NARGS_SHIFT;
+    str = (const char *)&rec->args[nargs];
+
+    deflog_emit(line, "[%u.%03u] ", rec->stamp / 1000, rec->stamp % 1000);
+    for ( ; ; ) {
+        const char *p = deflog_next_spec(fmt, &spec);
+        int n;
+
+        if (p == NULL) {
+            while (*fmt)
+                deflog_put_char(*fmt++, line);
+            break;
+        }
+        n = deflog_spec_nargs(&spec);
+        if (i + n > nargs) {
+            /* The remain arguments are truncated */
+            while (*fmt)
+                deflog_put_char(*fmt++, line);
+            break;
+        }
+        while (fmt < spec.start)
+            deflog_put_char(*fmt++, line);
+        fmt = p;
+
+        deflog_spec_copy(sbuf, &spec, &rec->args[i]);
+        i += spec.nstar;
+        switch (spec.type) {
+        case DEFLOG_ARG_INT:
+            deflog_emit(line, sbuf, (int)rec->args[i++]);
+            break;
+        case DEFLOG_ARG_LONG:
+            deflog_emit(line, sbuf, (long)rec->args[i++]);
+            break;
+        case DEFLOG_ARG_LLONG:
+            deflog_emit(line, sbuf, (long long)rec->args[i++]);
+            break;
+        case DEFLOG_ARG_PTR:
+            deflog_emit(line, sbuf, (void *)(uintptr_t)rec->args[i++]);
+            break;
+        case DEFLOG_ARG_HEXDUMP:
+            deflog_emit(line, sbuf, (void *)(uintptr_t)rec->args[i],
+                (void *)(uintptr_t)rec->args[i + 1]);
+            i += 2;
+            break;
+        case DEFLOG_ARG_STR: {
+            size_t len = (size_t)rec->args[i++];
+            memcpy(tmp, str, len);
+            tmp[len] = '\0';
+            str += len;
+            deflog_emit(line, sbuf, tmp);
+            break;
+        }
+        case DEFLOG_ARG_DOUBLE: {
+            double v;
+            memcpy(&v, &rec->args[i++], sizeof(v));
+            deflog_emit(line, sbuf, v);
+            break;
+        }
+        default:
+            deflog_emit(line, sbuf);
+            break;
+        }
+    }
+}
+
+size_t deflog_flush(size_t max) {
+    struct deflog_context *ctx = &deflog_context;
+    struct deflog_record *rec;
+    struct deflog_line line;
+    size_t count = 0;
+    uint32_t size;
+
+    if (ctx->buffer == NULL ||
+        __atomic_exchange_n(&ctx->busy, 1, __ATOMIC_ACQUIRE))
+        return 0;
+
+    line.output = ctx->output;
+    while ((rec = deflog_peek(ctx, &size)) != NULL) {
+        line.ptr = 0;
+        deflog_record_format(&line, rec);
+        deflog_consume(ctx, rec, size);
+        if (line.ptr > 0)
+            virt_format(line.output, "%.*s", line.ptr, line.buffer);
+        if (++count == max)
+            break;
+    }
+    __atomic_store_n(&ctx->busy, 0, __ATOMIC_RELEASE);
+    return count;
+}
+
+size_t deflog_read(bool (*output)(void *ctx, const struct deflog_record *rec,
+    size_t size), void *arg) {
+    struct deflog_context *ctx = &deflog_context;
+    struct deflog_record *rec;
+    size_t count = 0;
+    uint32_t size;
+
+    if (output == NULL || ctx->buffer == NULL ||
+        __atomic_exchange_n(&ctx->busy, 1, __ATOMIC_ACQUIRE))
+        return 0;
+
+    while ((rec = deflog_peek(ctx, &size)) != NULL) {
+        if (!output(arg, rec, size))
+            break;
+        deflog_consume(ctx, rec, size);
+        count++;
+    }
+    __atomic_store_n(&ctx->busy, 0, __ATOMIC_RELEASE);
+    return count;
+}
+
+uint32_t deflog_dropped(void) {
+    return __atomic_load_n(&deflog_context.dropped, __ATOMIC_RELAXED);
+}
+
+static void deflog_thread(void *arg) {
+    struct deflog_context *ctx = arg;
+
+    for ( ; ; ) {
+        deflog_flush(0);
+        os_thread_sleep(ctx->period);
+    }
+}
+
+int deflog_start(void *stack, size_t size, int prio, uint32_t period) {
+    struct deflog_context *ctx = &deflog_context;
+    int err;
+
+    if (ctx->buffer == NULL || period == 0)
+        return -EINVAL;
+    ctx->period = period;
+    err = os_thread_spawn(&ctx->thread, "deflog", stack, size, prio,
+        deflog_thread, ctx);
+    if (err)
+        virt_format(ctx->output, "create deflog thread failed(%d)\n", err);
+    return err;
+}
+
+void __rte_notrace deflog_format_init(struct printer *pr, struct printer *output,
+    void *buffer, size_t size) {
+    struct deflog_context *ctx = &deflog_context;
+
+    assert(pr != NULL);
+    assert(output != NULL && output->format != NULL);
+    assert(buffer != NULL && !((uintptr_t)buffer & 7));
+    assert(rte_powerof2(size) && size >= 256);
+    memset(buffer, 0, size);
+    ctx->buffer = buffer;
+    ctx->mask = (uint32_t)size - 1;
+    ctx->head = ctx->tail = 0;
+    ctx->dropped = 0;
+    ctx->output = output;
+    pr->format = deflog_format;
+    pr->context = ctx;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Deferred binary log. The printer only records the format string pointer,
+ * the raw arguments and a timestamp into a lock-free ring, the formatting is
+ * done later by deflog_flush() in a low priority thread. The raw records can
+ * also be read by deflog_read() and decoded offline with the ELF file.
+ *
+ * The pr_* macros become deferred after the printer is installed:
+ *
+ *   deflog_format_init(&pr, &stdio_pr, buffer, sizeof(buffer));
+ *   pr_log_init(&pr);
+ *   deflog_start(stack, stack_size, low_prio, 20);
+ *
+ * Note: The format string must be a constant and the %D argument must be
+ * valid until it has been flushed.
+ */
+#ifndef BASEWORK_LIB_DEFLOG_H_
+#define BASEWORK_LIB_DEFLOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+struct printer;
+
+#define DEFLOG_MAX_ARGS    16
+#define DEFLOG_MAX_STRING  64
+
+/*
+ * Record layout (8 bytes aligned):
+ *
+ * | header | stamp | fmt | args[nargs] | strings |
+ *
+ * The string argument is copied into record and the slot of args holds its
+ * length. A record with DEFLOG_PADDING flag only fills the end of ring.
+ */
+struct deflog_record {
+    uint32_t header;
+#define DEFLOG_SIZE_MASK   0x00ffffff
+#define DEFLOG_NARGS_MASK  0x7f000000
+#define DEFLOG_NARGS_SHIFT 24
+#define DEFLOG_PADDING     0x80000000
+    uint32_t stamp;  /* Timestamp (ms) */
+    const char *fmt;
+    uint64_t args[];
+};
+
+/*
+ * deflog_format_init - Initialize a deferred printer
+ *
+ * @pr: printer object
+ * @output: the printer that used to output formatted log
+ * @buffer: ring buffer (8 bytes aligned)
+ * @size: the size of ring buffer (must be power of 2)
+ */
+void deflog_format_init(struct printer *pr, struct printer *output,
+    void *buffer, size_t size);
+
+/*
+ * deflog_flush - Format the pending records to output printer
+ * (Single consumer)
+ *
+ * @max: the maximum number of records (0 means all)
+ * return the number of records that has been formatted
+ */
+size_t deflog_flush(size_t max);
+
+/*
+ * deflog_read - Pass the raw records to user callback (Single consumer)
+ *
+ * @output: user callback, the record is consumed if it return true
+ * @ctx: user parameter
+ * return the number of records that has been consumed
+ */
+size_t deflog_read(bool (*output)(void *ctx, const struct deflog_record *rec,
+    size_t size), void *ctx);
+
+/*
+ * deflog_start - Create a low priority thread to flush log periodically
+ *
+ * @stack: thread stack address
+ * @size: thread stack size
+ * @prio: thread priority
+ * @period: flush period (unit: ms)
+ * return 0 if success
+ */
+int deflog_start(void *stack, size_t size, int prio, uint32_t period);
+
+/*
+ * deflog_dropped - Get the number of records that dropped by ring overflow
+ */
+uint32_t deflog_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* BASEWORK_LIB_DEFLOG_H_ */
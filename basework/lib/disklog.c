@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <string.h>
 
 #include "basework/dev/disk.h"
 #include "basework/dev/partition.h"
@@ -14,16 +15,38 @@
 #include "basework/minmax.h"
 #include "basework/malloc.h"
 #include "basework/system.h"
+#ifdef CONFIG_DISKLOG_LZ4
+#include "basework/lib/lz4.h"
+#endif
+
+#ifndef CONFIG_DISKLOG_STAGING_SIZE
+#define CONFIG_DISKLOG_STAGING_SIZE 0
+#endif
+#ifndef CONFIG_DISKLOG_FLUSH_PERIOD
+#define CONFIG_DISKLOG_FLUSH_PERIOD 500
+#endif
+#ifndef CONFIG_DISKLOG_LZ4_RATIO
+#define CONFIG_DISKLOG_LZ4_RATIO 4
+#endif
+
+#define DISKLOG_STAGING (CONFIG_DISKLOG_STAGING_SIZE > 0)
 
 struct disk_log {
     uint32_t magic;
+#ifdef CONFIG_DISKLOG_LZ4
+#define DISKLOG_MAGIC 0xabdcec4b
+#else
 #define DISKLOG_MAGIC 0xabdcebcf
+#endif
     uint32_t start;
     uint32_t end;
     uint32_t size;
     uint32_t wr_ofs;
     uint32_t rd_ofs;
     uint32_t d_size;
+#ifdef CONFIG_DISKLOG_LZ4
+    uint32_t wr_seq; /* Sequence of the open block */
+#endif
 };
 
 struct disklog_ctx {
@@ -39,8 +62,53 @@ struct disklog_ctx {
     bool read_locked;
     bool log_dirty;
     bool panic;
+    bool initialized;
+#if DISKLOG_STAGING
+    uint32_t head __rte_cache_aligned;
+    uint32_t tail __rte_cache_aligned;
+    uint32_t swap_time;
+    uint32_t wr_blk;   /* Offset of the open block */
+    uint32_t blk_len;  /* Data length of the open block */
+    uint32_t blk_sync; /* Data length that has been written to disk */
+    char *blk;         /* Image of the open block */
+#ifdef CONFIG_DISKLOG_LZ4
+    char *raw;         /* Uncompressed data of the open block */
+    uint32_t raw_cap;
+#endif
+#endif /* DISKLOG_STAGING */
 };
 
+#if DISKLOG_STAGING
+/*
+ * Staging record: | header | data | (4 bytes aligned)
+ *
+ * The producers reserve space by CAS on head and commit the record by
+ * writing its header. A zero header means the record is not committed
+ * yet, so the flusher clears the consumed space before it moves tail.
+ */
+#define STAGING_MASK     (CONFIG_DISKLOG_STAGING_SIZE - 1)
+#define STAGING_PADDING  0x80000000u
+#define STAGING_ALIGN(x) (((x) + 3) & ~3u)
+#define STAGING_RECORD_MAX (CONFIG_DISKLOG_STAGING_SIZE / 8)
+
+#ifdef CONFIG_DISKLOG_LZ4
+/*
+ * Each block of compressed log holds one LZ4 frame
+ */
+struct disklog_frame {
+    uint32_t magic;
+#define DISKLOG_FRAME_MAGIC 0x347a6c64
+    uint32_t csize;
+    uint32_t rsize;
+    uint32_t seq;
+};
+#endif
+
+_Static_assert((CONFIG_DISKLOG_STAGING_SIZE & STAGING_MASK) == 0,
+    "CONFIG_DISKLOG_STAGING_SIZE must be power of 2");
+static uint32_t disklog_staging[CONFIG_DISKLOG_STAGING_SIZE / 4];
+#endif /* DISKLOG_STAGING */
+
 
 #ifndef MIN
 #define MIN(a, b) ((a) < (b)? (a): (b))
@@ -56,6 +124,272 @@ struct disklog_ctx {
 
 static struct disklog_ctx logctx;
 
+#if DISKLOG_STAGING
+static void disklog_append_locked(const char *buf, size_t size);
+
+static inline uint32_t disklog_next_block(uint32_t ofs) {
+    ofs += logctx.blksz;
+    return ofs >= logctx.file.end? logctx.file.start: ofs;
+}
+
+static void *disklog_reserve(uint32_t size) {
+    uint32_t head, tail, ofs, pad, need;
+
+    head = __atomic_load_n(&logctx.head, __ATOMIC_RELAXED);
+    do {
+        tail = __atomic_load_n(&logctx.tail, __ATOMIC_ACQUIRE);
+        ofs = head & STAGING_MASK;
+
+        /* The record must be continuous, fill the end of ring if no room */
+        pad = (ofs + size > CONFIG_DISKLOG_STAGING_SIZE)?
+            CONFIG_DISKLOG_STAGING_SIZE - ofs: 0;
+        need = pad + size;
+        if (rte_unlikely(need > CONFIG_DISKLOG_STAGING_SIZE - (head - tail)))
+            return NULL;
+    } while (!__atomic_compare_exchange_n(&logctx.head, &head, head + need,
+        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    if (pad) {
+        uint32_t *rec = (uint32_t *)((char *)disklog_staging + ofs);
+        __atomic_store_n(rec, pad | STAGING_PADDING, __ATOMIC_RELEASE);
+    }
+    return (char *)disklog_staging + ((head + pad) & STAGING_MASK);
+}
+
+/*
+ * Move the committed records from staging ring to the open block
+ */
+static void disklog_drain_locked(void) {
+    uint32_t tail, header, size;
+    uint32_t *rec;
+
+    for ( ; ; ) {
+        tail = logctx.tail;
+        if (tail == __atomic_load_n(&logctx.head, __ATOMIC_ACQUIRE))
+            break;
+        rec = (uint32_t *)((char *)disklog_staging + (tail & STAGING_MASK));
+        header = __atomic_load_n(rec, __ATOMIC_ACQUIRE);
+        if (header == 0)
+            break;
+        if (header & STAGING_PADDING) {
+            size = header & ~STAGING_PADDING;
+        } else {
+            size = STAGING_ALIGN(sizeof(*rec) + header);
+            disklog_append_locked((const char *)(rec + 1), header);
+        }
+        memset(rec, 0, size);
+        __atomic_store_n(&logctx.tail, tail + size, __ATOMIC_RELEASE);
+    }
+}
+
+static inline uint32_t disklog_staging_used(void) {
+    return __atomic_load_n(&logctx.head, __ATOMIC_RELAXED) -
+        __atomic_load_n(&logctx.tail, __ATOMIC_RELAXED);
+}
+
+/*
+ * The whole block is written to disk directly and bypass the cache of
+ * buffered_io. buffered_write() drops the cached partial copy of the 
+ * same block, So it can not be flushed over the whole block later.
+ */
+static int disklog_write_block(void) {
+    int ret = buffered_write(logctx.bio, logctx.blk, logctx.blksz,
+        logctx.offset + logctx.wr_blk);
+    return ret < 0? ret: 0;
+}
+
+#ifdef CONFIG_DISKLOG_LZ4
+/*
+ * Compress the data of open block as much as possible and write it to disk.
+ * The block is sealed if @seal is true or the data can not fit in the block.
+ * return true if all data has been written to the open block
+ */
+static bool disklog_pack_locked(bool seal) {
+    struct disklog_frame *frame = (struct disklog_frame *)logctx.blk;
+    struct disk_log *filp = &logctx.file;
+    int rsize = (int)logctx.blk_len;
+    int csize;
+
+    csize = LZ4_compress_destSize(logctx.raw, (char *)(frame + 1), &rsize,
+        (int)(logctx.blksz - sizeof(*frame)));
+    if (rte_unlikely(csize <= 0)) {
+        logctx.blk_len = logctx.blk_sync = 0;
+        return true;
+    }
+
+    frame->magic = DISKLOG_FRAME_MAGIC;
+    frame->csize = (uint32_t)csize;
+    frame->rsize = (uint32_t)rsize;
+    frame->seq = filp->wr_seq;
+    memset((char *)(frame + 1) + csize, 0xff,
+        logctx.blksz - sizeof(*frame) - csize);
+    disklog_write_block();
+    if (!seal && (uint32_t)rsize == logctx.blk_len)
+        return true;
+
+    /* Move the remain data to the next block */
+    logctx.blk_len -= rsize;
+    logctx.blk_sync = 0;
+    memmove(logctx.raw, logctx.raw + rsize, logctx.blk_len);
+    logctx.wr_blk = disklog_next_block(logctx.wr_blk);
+
+    /* The sealed blocks are counted, and the open block is not */
+    filp->wr_ofs = logctx.wr_blk;
+    filp->wr_seq++;
+    filp->d_size += logctx.blksz;
+    if (filp->d_size > filp->size - logctx.blksz) {
+        filp->d_size -= logctx.blksz;
+        filp->rd_ofs = disklog_next_block(filp->rd_ofs);
+    }
+    return false;
+}
+
+static void disklog_append_locked(const char *buf, size_t size) {
+    uint32_t bytes;
+
+    while (size > 0) {
+        bytes = MIN(logctx.raw_cap - logctx.blk_len, size);
+        memcpy(logctx.raw + logctx.blk_len, buf, bytes);
+        logctx.blk_len += bytes;
+        buf += bytes;
+        size -= bytes;
+        if (logctx.blk_len == logctx.raw_cap)
+            disklog_pack_locked(true);
+    }
+    logctx.log_dirty = true;
+}
+
+/*
+ * disklog_commit_locked - Write the open block to disk
+ *
+ * @seal: seal the open block, so that all data can be read from
+ *        the sealed blocks.
+ */
+static void disklog_commit_locked(bool seal) {
+    if (seal) {
+        while (logctx.blk_len > 0)
+            disklog_pack_locked(true);
+    } else if (logctx.blk_len != logctx.blk_sync) {
+        while (logctx.blk_len > 0 && !disklog_pack_locked(false));
+        logctx.blk_sync = logctx.blk_len;
+    }
+}
+
+/*
+ * Decompress a sealed block to @raw
+ * return the size of raw data (0 for broken block)
+ */
+static int disklog_unpack_locked(uint32_t ofs, char *raw) {
+    struct disklog_frame *frame = (struct disklog_frame *)logctx.blk;
+    int ret;
+
+    ret = buffered_read(logctx.bio, frame, logctx.blksz, logctx.offset + ofs);
+    if (ret <= 0)
+        return ret;
+    if (frame->magic != DISKLOG_FRAME_MAGIC ||
+        frame->csize > logctx.blksz - sizeof(*frame) ||
+        frame->rsize > logctx.raw_cap)
+        return 0;
+    ret = LZ4_decompress_safe((const char *)(frame + 1), raw,
+        (int)frame->csize, (int)logctx.raw_cap);
+    return ret == (int)frame->rsize? ret: 0;
+}
+
+#else /* !CONFIG_DISKLOG_LZ4 */
+static void disklog_append_locked(const char *buf, size_t size) {
+    struct disk_log *filp = &logctx.file;
+    uint32_t bytes;
+
+    while (size > 0) {
+        bytes = MIN(logctx.blksz - logctx.blk_len, size);
+        memcpy(logctx.blk + logctx.blk_len, buf, bytes);
+        logctx.blk_len += bytes;
+        filp->d_size += bytes;
+        buf += bytes;
+        size -= bytes;
+        if (logctx.blk_len == logctx.blksz) {
+            disklog_write_block();
+            logctx.wr_blk = disklog_next_block(logctx.wr_blk);
+            logctx.blk_len = logctx.blk_sync = 0;
+        }
+    }
+
+    filp->wr_ofs = logctx.wr_blk + logctx.blk_len;
+    if (filp->d_size > filp->size) {
+        filp->d_size = filp->size;
+        filp->rd_ofs = filp->wr_ofs;
+    }
+    logctx.log_dirty = true;
+}
+
+static void disklog_commit_locked(bool seal) {
+    (void) seal;
+    if (logctx.blk_len > logctx.blk_sync) {
+        buffered_write(logctx.bio, logctx.blk + logctx.blk_sync,
+            logctx.blk_len - logctx.blk_sync,
+            logctx.offset + logctx.wr_blk + logctx.blk_sync);
+        logctx.blk_sync = logctx.blk_len;
+    }
+}
+#endif /* CONFIG_DISKLOG_LZ4 */
+
+/*
+ * Reload the open block after reboot
+ */
+static int disklog_staging_setup_locked(void) {
+    struct disk_log *filp = &logctx.file;
+
+    if (logctx.blk == NULL) {
+        logctx.blk = general_malloc(logctx.blksz);
+        if (logctx.blk == NULL)
+            return -ENOMEM;
+#ifdef CONFIG_DISKLOG_LZ4
+        /* One more byte for the '\0' of the upload callback */
+        logctx.raw_cap = logctx.blksz * CONFIG_DISKLOG_LZ4_RATIO;
+        logctx.raw = general_malloc(logctx.raw_cap + 1);
+        if (logctx.raw == NULL) {
+            general_free(logctx.blk);
+            logctx.blk = NULL;
+            return -ENOMEM;
+        }
+#endif
+    }
+
+#ifdef CONFIG_DISKLOG_LZ4
+    int ret;
+
+    /* 
+     * The block may still hold a frame of the previous lap, It is the 
+     * open block only if the sequence matches
+     */
+    logctx.wr_blk = filp->wr_ofs;
+    ret = disklog_unpack_locked(logctx.wr_blk, logctx.raw);
+    if (ret > 0 && ((struct disklog_frame *)logctx.blk)->seq != filp->wr_seq)
+        ret = 0;
+    logctx.blk_len = logctx.blk_sync = ret > 0? (uint32_t)ret: 0;
+#else
+    logctx.wr_blk = filp->start + 
+        ((filp->wr_ofs - filp->start) / logctx.blksz) * logctx.blksz;
+    logctx.blk_len = logctx.blk_sync = filp->wr_ofs - logctx.wr_blk;
+    if (logctx.blk_len > 0) {
+        int ret = buffered_read(logctx.bio, logctx.blk, logctx.blk_len,
+            logctx.offset + logctx.wr_blk);
+        if (ret < 0)
+            return ret;
+    }
+#endif
+    return 0;
+}
+#endif /* DISKLOG_STAGING */
+
+static inline bool disklog_pending(void) {
+#if DISKLOG_STAGING
+    if (disklog_staging_used() > 0)
+        return true;
+#endif
+    return logctx.log_dirty;
+}
+
 static void disklog_reset_locked(void) {
     struct disk_log *filp = &logctx.file;
     size_t blksz = logctx.blksz;
@@ -67,10 +401,18 @@ static void disklog_reset_locked(void) {
     filp->rd_ofs = filp->start;
     filp->wr_ofs = filp->start;
     filp->d_size = 0;
+#ifdef CONFIG_DISKLOG_LZ4
+    /* Never reuse a sequence that may be found in the old frames */
+    filp->wr_seq++;
+#endif
+#if DISKLOG_STAGING
+    logctx.wr_blk = filp->start;
+    logctx.blk_len = logctx.blk_sync = 0;
+#endif
 }
 
 static void disklog_sync(bool wait) {
-    if (logctx.log_dirty) {
+    if (disklog_pending()) {
     	int err;
     
 	    if (wait){
@@ -80,9 +422,9 @@ static void disklog_sync(bool wait) {
 		}
 
 		if (err == 0) {
-	        if (logctx.log_dirty) {
-	            logctx.log_dirty = false;
+	        if (disklog_pending()) {
 	            disklog_flush();
+	            logctx.log_dirty = false;
 	        }
 	        MTX_UNLOCK();
 	    }
@@ -98,21 +440,48 @@ static int disklog_sync_listen(struct observer_base *nb,
     return 0;
 }
 
+#if DISKLOG_STAGING
+/*
+ * The flusher writes the sealed blocks periodically, and the
+ * header is updated every DISLOG_SWAP_PERIOD
+ */
+static void disklog_swap(os_timer_t timer, void *arg) {
+    (void) arg;
+    if (!logctx.upload_pending && MTX_TRYLOCK() == 0) {
+        disklog_drain_locked();
+        MTX_UNLOCK();
+    }
+    logctx.swap_time += CONFIG_DISKLOG_FLUSH_PERIOD;
+    if (logctx.swap_time >= DISLOG_SWAP_PERIOD) {
+        logctx.swap_time = 0;
+        disklog_sync(false);
+    }
+    os_timer_mod(timer, CONFIG_DISKLOG_FLUSH_PERIOD);
+}
+#else
 static void disklog_swap(os_timer_t timer, void *arg) {
     (void) arg;
     disklog_sync(false);
     os_timer_mod(timer, DISLOG_SWAP_PERIOD);
 }
+#endif /* DISKLOG_STAGING */
 
 void disklog_reset(void) {
     MTX_LOCK();
     logctx.read_locked = false;
+#if DISKLOG_STAGING
+    disklog_drain_locked();
+#endif
     disklog_reset_locked();
     MTX_UNLOCK();
 }
 
 void disklog_flush(void) {
 	assert(logctx.bio != NULL);
+#if DISKLOG_STAGING
+    disklog_drain_locked();
+    disklog_commit_locked(false);
+#endif
 	if (logctx.bio->panic) {
 		buffered_flush_locked(logctx.bio);
 		disk_device_erase(logctx.bio->dd, logctx.offset, logctx.blksz);
@@ -130,10 +499,9 @@ void disklog_flush(void) {
 int disklog_init(void) {
     const struct disk_partition *dp_dev;
     struct disk_device *dd;
-    static bool initialized;
     int ret;
 
-    if (initialized)
+    if (logctx.initialized)
         return 0;
 
     MTX_INIT();
@@ -159,6 +527,15 @@ int disklog_init(void) {
     if (logctx.file.magic != DISKLOG_MAGIC)
         disklog_reset_locked();
 
+#if DISKLOG_STAGING
+    ret = disklog_staging_setup_locked();
+    if (ret) {
+        MTX_UNLOCK();
+        pr_err("setup disklog staging failed(%d)\n", ret);
+        return ret;
+    }
+#endif
+
     os_timer_create(&logctx.timer, disklog_swap, 
         NULL, false);
     
@@ -168,15 +545,89 @@ int disklog_init(void) {
     system_add_observer(&logctx.obs);
 
 	logctx.log_dirty = false;
-    initialized = true;
+    logctx.initialized = true;
     ret = 0;
+#if DISKLOG_STAGING
+    os_timer_add(logctx.timer, CONFIG_DISKLOG_FLUSH_PERIOD);
+#else
     os_timer_add(logctx.timer, DISLOG_SWAP_PERIOD);
+#endif
 
 _unlock:
     MTX_UNLOCK();
     return ret;
 }
 
+void disklog_deinit(void) {
+    if (!logctx.initialized)
+        return;
+
+    os_timer_destroy(logctx.timer);
+    system_remove_observer(&logctx.obs);
+
+    MTX_LOCK();
+    disklog_flush();
+    logctx.log_dirty = false;
+    buffered_iodestroy(logctx.bio);
+    logctx.bio = NULL;
+#if DISKLOG_STAGING
+    general_free(logctx.blk);
+    logctx.blk = NULL;
+#ifdef CONFIG_DISKLOG_LZ4
+    general_free(logctx.raw);
+    logctx.raw = NULL;
+#endif
+#endif
+    logctx.initialized = false;
+    MTX_UNLOCK();
+}
+
+#if DISKLOG_STAGING
+int disklog_input(const char *buf, size_t size) {
+    uint32_t *rec;
+    uint32_t bytes;
+
+    if (buf == NULL || size == 0)
+        return -EINVAL;
+
+    if (logctx.read_locked)
+        return -EBUSY;
+
+    /* Write to disk directly when system panic */
+    if (rte_unlikely(logctx.bio != NULL && logctx.bio->panic)) {
+        /* The open block is missing if disklog_init() failed */
+        if (logctx.blk == NULL)
+            return -ENODEV;
+        disklog_drain_locked();
+        disklog_append_locked(buf, size);
+        return 0;
+    }
+
+    while (size > 0) {
+        bytes = MIN(size, STAGING_RECORD_MAX);
+        rec = disklog_reserve(STAGING_ALIGN(sizeof(*rec) + bytes));
+        if (rte_unlikely(rec == NULL))
+            return -ENOSPC;
+        memcpy(rec + 1, buf, bytes);
+        __atomic_store_n(rec, bytes, __ATOMIC_RELEASE);
+        buf += bytes;
+        size -= bytes;
+    }
+
+    /* Help the flusher if the staging ring is filling up */
+    if (disklog_staging_used() > CONFIG_DISKLOG_STAGING_SIZE / 2 &&
+        logctx.blk != NULL && !logctx.upload_pending && !os_in_isr()) {
+        if (MTX_TRYLOCK() == 0) {
+            /* Check it again, disklog_deinit() may have freed it */
+            if (logctx.blk != NULL)
+                disklog_drain_locked();
+            MTX_UNLOCK();
+        }
+    }
+    return 0;
+}
+
+#else /* !DISKLOG_STAGING */
 int disklog_input(const char *buf, size_t size) {
     struct buffered_io *bio;
     size_t remain = size;
@@ -229,7 +680,126 @@ _next:
     	MTX_UNLOCK();
     return ret;
 }
+#endif /* DISKLOG_STAGING */
 
+#ifdef CONFIG_DISKLOG_LZ4
+int disklog_ouput(bool (*output)(void *ctx, char *buf, size_t size), 
+    void *ctx, size_t maxsize) {
+#define LOG_SIZE 1024
+    struct disk_log *filp = &logctx.file;
+    uint32_t rd_ofs, remain, bytes;
+    int ret;
+
+    if (output == NULL)
+        return -EINVAL;
+
+    if (logctx.upload_pending)
+        return -EBUSY;
+
+    if (maxsize == 0)
+        maxsize = LOG_SIZE;
+
+    logctx.upload_pending = true;
+    MTX_LOCK();
+    disklog_drain_locked();
+    disklog_commit_locked(true);
+
+    /* The raw buffer is free after the open block has been sealed */
+    remain = filp->d_size;
+    rd_ofs = filp->rd_ofs;
+    while (remain > 0) {
+        ret = disklog_unpack_locked(rd_ofs, logctx.raw);
+        if (ret < 0)
+            goto _next;
+
+        /* 
+         * The callback may terminate the data with '\0', So the byte
+         * behind the chunk is restored after that
+         */
+        for (int i = 0; i < ret; i += bytes) {
+            char *chunk = logctx.raw + i;
+            char saved;
+
+            bytes = MIN((uint32_t)(ret - i), maxsize);
+            saved = chunk[bytes];
+            if (!output(ctx, chunk, bytes)) {
+                ret = -EIO;
+                goto _next;
+            }
+            chunk[bytes] = saved;
+        }
+
+        remain -= logctx.blksz;
+        rd_ofs = disklog_next_block(rd_ofs);
+    }
+
+    filp->rd_ofs = rd_ofs;
+    filp->d_size = 0;
+    ret = 0;
+_next:
+    MTX_UNLOCK();
+    logctx.upload_pending = false;
+    return ret;
+}
+
+ssize_t disklog_read(char *buffer, size_t maxlen, bool first) {
+    static struct disk_log rdlog;
+    static char *rdraw;
+    static uint32_t rdlen, rdpos;
+    uint32_t bytes;
+    ssize_t copied = 0;
+    int ret;
+
+    if (!buffer || !maxlen)
+        return -EINVAL;
+
+    ret = MTX_TRYLOCK();
+    if (ret) {
+        if (logctx.upload_pending)
+            return -EBUSY;
+        MTX_LOCK();
+    }
+
+    if (first) {
+        if (rdraw == NULL) {
+            rdraw = general_malloc(logctx.raw_cap);
+            if (rdraw == NULL) {
+                copied = -ENOMEM;
+                goto _next;
+            }
+        }
+        disklog_drain_locked();
+        disklog_commit_locked(true);
+        rdlog = logctx.file;
+        rdlen = rdpos = 0;
+    }
+
+    while ((size_t)copied < maxlen) {
+        if (rdpos == rdlen) {
+            if (rdlog.d_size == 0)
+                break;
+            ret = disklog_unpack_locked(rdlog.rd_ofs, rdraw);
+            if (ret < 0) {
+                copied = ret;
+                goto _next;
+            }
+            rdlen = (uint32_t)ret;
+            rdpos = 0;
+            rdlog.d_size -= logctx.blksz;
+            rdlog.rd_ofs = disklog_next_block(rdlog.rd_ofs);
+            continue;
+        }
+        bytes = MIN(rdlen - rdpos, maxlen - copied);
+        memcpy(buffer + copied, rdraw + rdpos, bytes);
+        rdpos += bytes;
+        copied += bytes;
+    }
+_next:
+    MTX_UNLOCK();
+    return copied;
+}
+
+#else /* !CONFIG_DISKLOG_LZ4 */
 int disklog_ouput(bool (*output)(void *ctx, char *buf, size_t size), 
     void *ctx, size_t maxsize) {
 #define LOG_SIZE 1024
@@ -252,6 +822,10 @@ int disklog_ouput(bool (*output)(void *ctx, char *buf, size_t size),
 
     logctx.upload_pending = true;
     MTX_LOCK();
+#if DISKLOG_STAGING
+    disklog_drain_locked();
+    disklog_commit_locked(true);
+#endif
     struct disk_log *filp = &logctx.file;
     size_t size = filp->d_size;
     size_t remain = size;
@@ -288,7 +862,8 @@ _next:
 ssize_t disklog_read(char *buffer, size_t maxlen, bool first) {
     static struct disk_log rdlog;
     uint32_t rd_ofs, bytes;
-    int ret = 0;
+    ssize_t copied = 0;
+    int ret;
 
     if (!buffer || !maxlen)
         return -EINVAL;
@@ -300,19 +875,27 @@ ssize_t disklog_read(char *buffer, size_t maxlen, bool first) {
         MTX_LOCK();
     }
 
-    if (first)
+    if (first) {
+#if DISKLOG_STAGING
+        disklog_drain_locked();
+        disklog_commit_locked(true);
+#endif
         rdlog = logctx.file;
+    }
 
     size_t size = rdlog.d_size;
     size_t remain = MIN(maxlen, size);
     rd_ofs = rdlog.rd_ofs;
     while (remain > 0) {
         bytes = MIN(rdlog.end - rd_ofs, remain);
-        ret = buffered_read(logctx.bio, buffer, bytes, 
+        ret = buffered_read(logctx.bio, buffer + copied, bytes, 
             logctx.offset + rd_ofs);
-        if (ret <= 0)
+        if (ret < 0) {
+            copied = ret;
             goto _next;
+        }
 
+        copied += bytes;
         remain -= bytes;
         rd_ofs += bytes;
         size -= bytes;
@@ -323,9 +906,11 @@ ssize_t disklog_read(char *buffer, size_t maxlen, bool first) {
     rdlog.d_size = size;
 _next:
     MTX_UNLOCK();
-    return ret;   
+    return copied;
 }
 
+#endif /* CONFIG_DISKLOG_LZ4 */
+
 void disklog_upload_cb(struct log_upload_class *luc) {
     if (!luc || !luc->upload)
         return;
@@ -31,6 +31,12 @@ struct log_upload_class {
  */
 int disklog_init(void);
 
+/*
+ * disklog_deinit - Flush disk log and release all resources
+ * The log can be reloaded from disk by disklog_init()
+ */
+void disklog_deinit(void);
+
 /*
  * disklog_reset - Reset disk log(clear all)
  * return 0 if success
@@ -48,6 +54,10 @@ void disklog_flush(void);
 /*
  * disklog_input - Write log to disk
  * 
+ * If CONFIG_DISKLOG_STAGING_SIZE is not zero, the log is only appended to
+ * the staging ring (no lock), and it is written to disk in whole blocks
+ * later. -ENOSPC is returned if the ring is full.
+ *
  * @buf: log buffer pointer
  * @size: log size
  * return 0 if success
@@ -6,6 +6,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "basework/os/osapi.h"
 
@@ -19,6 +20,54 @@ extern "C"{
 
 #define ENV_MAX  1024
 
+/*
+ * The media to store environment variables with append-only log
+ *
+ * @append: append a record at the end of log, return -ENOSPC if it is full
+ * @reset: start a new log. Without @swap the old records are erased
+ * @swap: optional, called after the new log is written. It makes the new 
+ *        log active if @done is true, otherwise drops it and keeps the old 
+ *        one. Without it a failed rewrite leaves a partial log.
+ */
+struct env_journal {
+    int (*append)(void *ctx, void *buffer, size_t size);
+    int (*reset)(void *ctx);
+    void *ctx;
+    int (*swap)(void *ctx, bool done);
+};
+
+#ifdef CONFIG_ENV_HASH
+struct env_node;
+struct env_chunk;
+
+struct env_reent {
+    struct env_node **table;   /* Hash index */
+    uint32_t mask;
+    uint32_t count;
+    struct env_chunk *chunks;  /* String arena */
+    size_t arena_size;
+    size_t garbage;
+    struct env_node **changes; /* Changes that is not committed */
+    uint32_t nchanges;
+    uint32_t changes_cap;
+    bool tracking;
+    void *(*alloc)(size_t);
+    void *(*realloc)(void *, size_t);
+    void (*free)(void *);
+#ifndef CONFIG_BOOTLOADER
+    os_mutex_t mtx;
+#endif
+};
+
+#define _ENV_DEFINE(_name, _malloc, _realloc, _free) \
+    struct env_reent _name = {\
+        .tracking = true, \
+        .alloc = _malloc, \
+        .realloc = _realloc, \
+        .free = _free \
+    }
+
+#else /* !CONFIG_ENV_HASH */
 struct env_reent {
     char *intial_env[1];
     char **environ;
@@ -42,6 +91,7 @@ struct env_reent {
         .free = _free, \
         .alloced = false \
     }
+#endif /* CONFIG_ENV_HASH */
 
 char *_env_get(struct env_reent *reent_ptr, const char *name);
 int _env_unset(struct env_reent *reent_ptr, const char *name);
@@ -55,6 +105,20 @@ int _env_flush(struct env_reent *reent_ptr,
     void *ctx);
 void _env_free(struct env_reent *reent_ptr);
 
+#ifdef CONFIG_ENV_HASH
+/*
+ * _env_commit - Append the changes since last commit to journal. The journal
+ * is rewritten with all variables if it is full.
+ */
+int _env_commit(struct env_reent *reent_ptr, const struct env_journal *jn);
+
+/*
+ * _env_compact - Reclaim the space of the deleted and replaced variables.
+ * The strings returned by _env_get() before are invalid after it.
+ */
+int _env_compact(struct env_reent *reent_ptr);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,607 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Environment variables with hash index
+ *
+ * The "name=value" strings are allocated from an arena, and indexed by an
+ * open-addressing hash table (linear probing), so that the lookup does not
+ * scan all variables. The changes are queued until _env_commit() appends
+ * them to the journal, and the journal is compacted only when it is full.
+ *
+ * The string returned by _env_get() stays valid like the one of env_core:
+ * the arena is never moved by _env_set()/_env_unset(), the garbage is only
+ * reclaimed by _env_compact() and _env_free().
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "basework/compiler.h"
+#include "basework/lib/env_core.h"
+#include "basework/malloc.h"
+
+#ifndef CONFIG_BOOTLOADER
+ # define ENV_LOCK   os_mtx_lock(&reent_ptr->mtx);
+ # define ENV_UNLOCK os_mtx_unlock(&reent_ptr->mtx);
+#else
+ # define ENV_LOCK
+ # define ENV_UNLOCK
+ #endif /* CONFIG_BOOTLOADER */
+
+#define ENV_ARENA_CHUNK  1024
+#define ENV_TABLE_MIN    16
+#define ENV_NODE_MAX     (UINT16_MAX - sizeof(void *))
+#define ENV_ALIGN(x)     (((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+struct env_node {
+    uint32_t hash;
+    uint16_t size;  /* Node size in arena */
+    uint8_t  klen;  /* Name length */
+    uint8_t  flags;
+#define ENV_DIRTY   0x01  /* In the change queue */
+#define ENV_DELETED 0x02  /* Unset, but not committed */
+#define ENV_DEAD    0x04  /* Replaced before committed */
+    char str[];     /* name=value */
+};
+
+struct env_chunk {
+    struct env_chunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+static inline void *__rte_notrace env_malloc(struct env_reent *reent_ptr, size_t size) {
+    if (reent_ptr->alloc)
+        return reent_ptr->alloc(size);
+    return general_malloc(size);
+}
+
+static inline void *__rte_notrace env_realloc(struct env_reent *reent_ptr, void *ptr,
+    size_t size) {
+    if (reent_ptr->realloc)
+        return reent_ptr->realloc(ptr, size);
+    return general_realloc(ptr, size);
+}
+
+static inline void __rte_notrace env_free(struct env_reent *reent_ptr, void *ptr) {
+    if (reent_ptr->free)
+        reent_ptr->free(ptr);
+    else
+        general_free(ptr);
+}
+
+static inline uint32_t __rte_notrace env_hash(const char *name, size_t *plen) {
+    const char *p = name;
+    uint32_t hash = 2166136261u;
+
+    /* FNV-1a */
+    while (*p && *p != '=') {
+        hash ^= (uint8_t)*p++;
+        hash *= 16777619u;
+    }
+    *plen = p - name;
+    return hash;
+}
+
+static inline char *env_value(struct env_node *node) {
+    return node->str + node->klen + 1;
+}
+
+static uint32_t __rte_notrace env_lookup_locked(struct env_reent *reent_ptr,
+    const char *name, size_t len, uint32_t hash) {
+    uint32_t i = hash & reent_ptr->mask;
+    struct env_node *node;
+
+    while ((node = reent_ptr->table[i]) != NULL) {
+        if (node->hash == hash && node->klen == len &&
+            !memcmp(node->str, name, len))
+            break;
+        i = (i + 1) & reent_ptr->mask;
+    }
+    return i;
+}
+
+static int __rte_notrace env_table_resize(struct env_reent *reent_ptr,
+    uint32_t size) {
+    struct env_node **old = reent_ptr->table;
+    uint32_t old_size = old? reent_ptr->mask + 1: 0;
+    struct env_node **table;
+
+    table = env_malloc(reent_ptr, size * sizeof(*table));
+    if (!table)
+        return -ENOMEM;
+
+    memset(table, 0, size * sizeof(*table));
+    reent_ptr->table = table;
+    reent_ptr->mask = size - 1;
+    for (uint32_t i = 0; i < old_size; i++) {
+        struct env_node *node = old[i];
+        if (node) {
+            uint32_t k = node->hash & reent_ptr->mask;
+            while (table[k])
+                k = (k + 1) & reent_ptr->mask;
+            table[k] = node;
+        }
+    }
+    if (old)
+        env_free(reent_ptr, old);
+    return 0;
+}
+
+/*
+ * Remove slot @i and shift the following nodes back (No tombstone)
+ */
+static void __rte_notrace env_table_remove(struct env_reent *reent_ptr, uint32_t i) {
+    struct env_node **table = reent_ptr->table;
+    uint32_t mask = reent_ptr->mask;
+    uint32_t j = i;
+
+    for ( ; ; ) {
+        uint32_t k;
+
+        table[i] = NULL;
+        for ( ; ; ) {
+            j = (j + 1) & mask;
+            if (!table[j])
+                return;
+            k = table[j]->hash & mask;
+
+            /* Stop if the home slot @k is cyclically in (i, j] */
+            if (i <= j? (i < k && k <= j): (i < k || k <= j))
+                continue;
+            break;
+        }
+        table[i] = table[j];
+        i = j;
+    }
+}
+
+static struct env_chunk *__rte_notrace env_chunk_new(struct env_reent *reent_ptr,
+    size_t size) {
+    struct env_chunk *chunk;
+
+    if (size < ENV_ARENA_CHUNK)
+        size = ENV_ARENA_CHUNK;
+    chunk = env_malloc(reent_ptr, sizeof(*chunk) + size);
+    if (chunk) {
+        chunk->size = size;
+        chunk->used = 0;
+        chunk->next = reent_ptr->chunks;
+        reent_ptr->chunks = chunk;
+        reent_ptr->arena_size += size;
+    }
+    return chunk;
+}
+
+static void __rte_notrace env_arena_release(struct env_reent *reent_ptr,
+    struct env_chunk *chunk) {
+    while (chunk) {
+        struct env_chunk *next = chunk->next;
+        env_free(reent_ptr, chunk);
+        chunk = next;
+    }
+}
+
+static struct env_node *__rte_notrace env_node_move(struct env_chunk *chunk,
+    struct env_node *node) {
+    struct env_node *dst = (struct env_node *)(chunk->data + chunk->used);
+
+    memcpy(dst, node, node->size);
+    chunk->used += node->size;
+    return dst;
+}
+
+/*
+ * Copy the live nodes and the uncommitted deletions to new chunks
+ */
+static int __rte_notrace env_arena_compact(struct env_reent *reent_ptr) {
+    struct env_chunk *old = reent_ptr->chunks;
+    size_t arena_size = reent_ptr->arena_size;
+    size_t garbage = reent_ptr->garbage;
+    struct env_chunk *chunk;
+    uint32_t n = 0;
+
+    reent_ptr->chunks = NULL;
+    reent_ptr->arena_size = 0;
+    reent_ptr->garbage = 0;
+    chunk = env_chunk_new(reent_ptr, arena_size - garbage);
+    if (!chunk) {
+        reent_ptr->chunks = old;
+        reent_ptr->arena_size = arena_size;
+        reent_ptr->garbage = garbage;
+        return -ENOMEM;
+    }
+
+    for (uint32_t i = 0; i <= reent_ptr->mask && reent_ptr->table; i++) {
+        if (reent_ptr->table[i])
+            reent_ptr->table[i] = env_node_move(chunk, reent_ptr->table[i]);
+    }
+    for (uint32_t i = 0; i < reent_ptr->nchanges; i++) {
+        struct env_node *node = reent_ptr->changes[i];
+        if (node->flags & ENV_DEAD)
+            continue;
+        if (node->flags & ENV_DELETED)
+            node = env_node_move(chunk, node);
+        else
+            node = reent_ptr->table[env_lookup_locked(reent_ptr, node->str,
+                node->klen, node->hash)];
+        reent_ptr->changes[n++] = node;
+    }
+    reent_ptr->nchanges = n;
+    env_arena_release(reent_ptr, old);
+    return 0;
+}
+
+static struct env_node *__rte_notrace env_node_alloc(struct env_reent *reent_ptr,
+    size_t size) {
+    struct env_chunk *chunk = reent_ptr->chunks;
+    struct env_node *node;
+
+    size = ENV_ALIGN(size);
+    if (!chunk || chunk->size - chunk->used < size) {
+        chunk = env_chunk_new(reent_ptr, size);
+        if (!chunk)
+            return NULL;
+    }
+
+    node = (struct env_node *)(chunk->data + chunk->used);
+    chunk->used += size;
+    node->size = (uint16_t)size;
+    return node;
+}
+
+static void __rte_notrace env_node_drop(struct env_reent *reent_ptr,
+    struct env_node *node, uint8_t flag) {
+    if (node->flags & ENV_DIRTY) {
+        node->flags |= flag;
+
+        /* The deletion is kept until it has been committed */
+        if (flag == ENV_DELETED)
+            return;
+    }
+    reent_ptr->garbage += node->size;
+}
+
+static int __rte_notrace env_track_locked(struct env_reent *reent_ptr,
+    struct env_node *node) {
+    if (!reent_ptr->tracking || (node->flags & ENV_DIRTY))
+        return 0;
+
+    if (reent_ptr->nchanges == reent_ptr->changes_cap) {
+        uint32_t cap = reent_ptr->changes_cap? reent_ptr->changes_cap * 2: 8;
+        struct env_node **p = env_realloc(reent_ptr, reent_ptr->changes,
+            cap * sizeof(*p));
+        if (!p)
+            return -ENOMEM;
+        reent_ptr->changes = p;
+        reent_ptr->changes_cap = cap;
+    }
+    node->flags |= ENV_DIRTY;
+    reent_ptr->changes[reent_ptr->nchanges++] = node;
+    return 0;
+}
+
+static int __rte_notrace env_set_locked(struct env_reent *reent_ptr, const char *name,
+	const char *value, int rewrite) {
+    struct env_node *node, *old;
+    size_t klen, vlen;
+    uint32_t hash, i;
+
+    if (strchr(name, '=') || !name[0]) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    hash = env_hash(name, &klen);
+    if (klen > UINT8_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    vlen = strlen(value);
+    if (sizeof(*node) + klen + vlen + 2 > ENV_NODE_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!reent_ptr->table && env_table_resize(reent_ptr, ENV_TABLE_MIN))
+        return -1;
+
+    i = env_lookup_locked(reent_ptr, name, klen, hash);
+    old = reent_ptr->table[i];
+    if (old) {
+        if (!rewrite)
+            return 0;
+
+        /* Overwrite in place if the old is larger */
+        if (old->size >= sizeof(*old) + klen + vlen + 2) {
+            memcpy(env_value(old), value, vlen + 1);
+            return env_track_locked(reent_ptr, old);
+        }
+    } else if ((reent_ptr->count + 1) * 4 > (reent_ptr->mask + 1) * 3) {
+        if (env_table_resize(reent_ptr, (reent_ptr->mask + 1) * 2))
+            return -1;
+        i = env_lookup_locked(reent_ptr, name, klen, hash);
+    }
+
+    node = env_node_alloc(reent_ptr, sizeof(*node) + klen + vlen + 2);
+    if (!node)
+        return -1;
+
+    node->hash = hash;
+    node->klen = (uint8_t)klen;
+    node->flags = 0;
+    memcpy(node->str, name, klen);
+    node->str[klen] = '=';
+    memcpy(env_value(node), value, vlen + 1);
+    if (old)
+        env_node_drop(reent_ptr, old, ENV_DEAD);
+    else
+        reent_ptr->count++;
+    reent_ptr->table[i] = node;
+    return env_track_locked(reent_ptr, node);
+}
+
+int __rte_notrace _env_set(struct env_reent *reent_ptr, const char *name,
+	const char *value, int rewrite) {
+    int err;
+
+    ENV_LOCK
+    err = env_set_locked(reent_ptr, name, value, rewrite);
+    ENV_UNLOCK
+
+    return err;
+}
+
+static void __rte_notrace env_unset_locked(struct env_reent *reent_ptr,
+    const char *name) {
+    struct env_node *node;
+    size_t klen;
+    uint32_t hash, i;
+
+    if (!reent_ptr->table)
+        return;
+
+    hash = env_hash(name, &klen);
+    i = env_lookup_locked(reent_ptr, name, klen, hash);
+    node = reent_ptr->table[i];
+    if (node) {
+        env_table_remove(reent_ptr, i);
+        reent_ptr->count--;
+        if (node->flags & ENV_DIRTY) {
+            env_node_drop(reent_ptr, node, ENV_DELETED);
+        } else if (reent_ptr->tracking) {
+            /* Queue the deletion */
+            node->flags |= ENV_DELETED;
+            if (env_track_locked(reent_ptr, node))
+                reent_ptr->garbage += node->size;
+        } else {
+            reent_ptr->garbage += node->size;
+        }
+    }
+}
+
+int __rte_notrace _env_unset(struct env_reent *reent_ptr, const char *name) {
+    /* Name cannot be NULL, empty, or contain an equal sign.  */
+    if (name == NULL || name[0] == '\0' || strchr(name, '=')) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ENV_LOCK
+    env_unset_locked(reent_ptr, name);
+    ENV_UNLOCK
+    return 0;
+}
+
+char *__rte_notrace _env_get(struct env_reent *reent_ptr, const char *name) {
+    struct env_node *node = NULL;
+    size_t klen;
+    uint32_t hash;
+
+    hash = env_hash(name, &klen);
+    if (name[klen] == '=')
+        return NULL;
+
+    ENV_LOCK
+    if (reent_ptr->table)
+        node = reent_ptr->table[env_lookup_locked(reent_ptr, name, klen, hash)];
+    ENV_UNLOCK
+
+    return node? env_value(node): NULL;
+}
+
+int __rte_notrace _env_compact(struct env_reent *reent_ptr) {
+    int err = 0;
+
+    ENV_LOCK
+    if (reent_ptr->garbage > 0)
+        err = env_arena_compact(reent_ptr);
+    ENV_UNLOCK
+    return err;
+}
+
+/*
+ * The journal is a sequence of lines: "name=value\n" sets a variable and
+ * "!name\n" deletes it, the later line overrides the earlier.
+ */
+int __rte_notrace _env_load(struct env_reent *reent_ptr,
+    int (*readline_cb)(void *ctx, void *buffer, size_t max_size),
+    void *ctx) {
+    char *buffer, *pval;
+    bool tracking;
+    int err = 0, ret;
+
+    if (!readline_cb)
+        return -EINVAL;
+
+    ENV_LOCK
+
+    buffer = env_malloc(reent_ptr, ENV_MAX);
+    if (!buffer) {
+        ENV_UNLOCK
+        return -EINVAL;
+    }
+
+    /* The loaded variables are not changes */
+    tracking = reent_ptr->tracking;
+    reent_ptr->tracking = false;
+    while ((ret = readline_cb(ctx, buffer, ENV_MAX - 1)) > 0) {
+        buffer[ret] = '\0';
+        if (buffer[ret - 1] == '\n')
+            buffer[ret - 1] = '\0';
+        if (buffer[0] == '!') {
+            env_unset_locked(reent_ptr, buffer + 1);
+            continue;
+        }
+        pval = strchr(buffer, '=');
+        if (!pval)
+            continue;
+        *pval++ = '\0';
+        err = env_set_locked(reent_ptr, buffer, pval, 1);
+        if (err)
+            break;
+    }
+    reent_ptr->tracking = tracking;
+
+    env_free(reent_ptr, buffer);
+    ENV_UNLOCK
+    return err;
+}
+
+static int __rte_notrace env_write_node(struct env_node *node, char *buffer,
+    int (*write_cb)(void *ctx, void *buffer, size_t size), void *ctx) {
+    size_t len;
+
+    if (node->flags & ENV_DELETED) {
+        buffer[0] = '!';
+        memcpy(buffer + 1, node->str, node->klen);
+        len = node->klen + 1;
+    } else {
+        len = strlen(node->str);
+        if (len >= ENV_MAX)
+            return 0;
+        memcpy(buffer, node->str, len);
+    }
+    buffer[len++] = '\n';
+    return write_cb(ctx, buffer, len);
+}
+
+static int __rte_notrace env_flush_locked(struct env_reent *reent_ptr, char *buffer,
+    int (*write_cb)(void *ctx, void *buffer, size_t size), void *ctx) {
+    int ret = 0;
+
+    for (uint32_t i = 0; i <= reent_ptr->mask && reent_ptr->table; i++) {
+        if (reent_ptr->table[i]) {
+            ret = env_write_node(reent_ptr->table[i], buffer, write_cb, ctx);
+            if (ret < 0)
+                break;
+        }
+    }
+    return ret;
+}
+
+int __rte_notrace _env_flush(struct env_reent *reent_ptr,
+    int (*write_cb)(void *ctx, void *buffer, size_t size),
+    void *ctx) {
+    char *buffer;
+    int ret;
+
+    if (!write_cb)
+        return -EINVAL;
+
+    ENV_LOCK
+
+    buffer = env_malloc(reent_ptr, ENV_MAX);
+    if (!buffer) {
+        ENV_UNLOCK
+        return -EINVAL;
+    }
+
+    ret = env_flush_locked(reent_ptr, buffer, write_cb, ctx);
+    env_free(reent_ptr, buffer);
+    ENV_UNLOCK
+    return ret;
+}
+
+static void __rte_notrace env_changes_clear(struct env_reent *reent_ptr) {
+    for (uint32_t i = 0; i < reent_ptr->nchanges; i++) {
+        struct env_node *node = reent_ptr->changes[i];
+        if (node->flags & ENV_DELETED)
+            reent_ptr->garbage += node->size;
+        node->flags = 0;
+    }
+    reent_ptr->nchanges = 0;
+}
+
+int __rte_notrace _env_commit(struct env_reent *reent_ptr,
+    const struct env_journal *jn) {
+    char *buffer;
+    int ret = 0;
+
+    if (!jn || !jn->append || !jn->reset)
+        return -EINVAL;
+
+    ENV_LOCK
+
+    if (!reent_ptr->nchanges)
+        goto _unlock;
+
+    buffer = env_malloc(reent_ptr, ENV_MAX);
+    if (!buffer) {
+        ret = -ENOMEM;
+        goto _unlock;
+    }
+
+    for (uint32_t i = 0; i < reent_ptr->nchanges; i++) {
+        struct env_node *node = reent_ptr->changes[i];
+        if (node->flags & ENV_DEAD)
+            continue;
+        ret = env_write_node(node, buffer, jn->append, jn->ctx);
+        if (ret < 0)
+            break;
+    }
+
+    /* 
+     * The journal is full, rewrite it with all variables. The journal that 
+     * supports swap keeps the old image until the new one is complete.
+     */
+    if (ret == -ENOSPC) {
+        ret = jn->reset(jn->ctx);
+        if (!ret)
+            ret = env_flush_locked(reent_ptr, buffer, jn->append, jn->ctx);
+        if (jn->swap) {
+            int err = jn->swap(jn->ctx, ret >= 0);
+            if (ret >= 0)
+                ret = err;
+        }
+    }
+    if (ret >= 0) {
+        env_changes_clear(reent_ptr);
+        ret = 0;
+    }
+    env_free(reent_ptr, buffer);
+_unlock:
+    ENV_UNLOCK
+    return ret;
+}
+
+void __rte_notrace _env_free(struct env_reent *reent_ptr) {
+    ENV_LOCK
+
+    env_arena_release(reent_ptr, reent_ptr->chunks);
+    if (reent_ptr->table)
+        env_free(reent_ptr, reent_ptr->table);
+    if (reent_ptr->changes)
+        env_free(reent_ptr, reent_ptr->changes);
+    reent_ptr->chunks = NULL;
+    reent_ptr->table = NULL;
+    reent_ptr->changes = NULL;
+    reent_ptr->mask = 0;
+    reent_ptr->count = 0;
+    reent_ptr->nchanges = 0;
+    reent_ptr->changes_cap = 0;
+    reent_ptr->arena_size = 0;
+    reent_ptr->garbage = 0;
+
+    ENV_UNLOCK
+}
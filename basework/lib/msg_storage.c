@@ -17,8 +17,8 @@
 #include "basework/bitops.h"
 
 #define MESSAGE_CHECK_PERIOD   (60 * 1000)
-#define MESSAGE_STATE_OFFSET   4096
-#define MESSAGE_CONTENT_OFFSET 8192
+#define MESSAGE_AREA_ALIGN     4096
+#define MESSAGE_BATCH_GAP      4 /* The maximum unused slots in a batch read */
 #define NULL_NODE UINT16_MAX
 #define INVALID_TYPE 0
 #define MESSAGE_BITMAP_SIZE ((MAX_MESSAGES + 31) / 32)
@@ -34,6 +34,18 @@ struct msg_database {
 	uint32_t m_offset; /* The offset of content */
 };
 
+/*
+ * The database header is the on-flash index of messages (slot bitmap and
+ * time-ordered list). The state and content areas follow it on 4KB
+ * boundaries, so the default capacity keeps the old layout (4096/8192)
+ * and a larger capacity only moves them backward.
+ */
+#define MESSAGE_STATE_OFFSET \
+    rte_roundup(sizeof(struct msg_database), MESSAGE_AREA_ALIGN)
+#define MESSAGE_CONTENT_OFFSET \
+    (MESSAGE_STATE_OFFSET + \
+    rte_roundup(sizeof(struct msg_notifstate), MESSAGE_AREA_ALIGN))
+
 struct msg_notifstate {
 #define MESSAGE_STATE_MAGIC 0x1eebcaa0
     uint32_t magic;
@@ -42,9 +54,25 @@ struct msg_notifstate {
     uint32_t bitvect; /* User private data */
 };
 
+/*
+ * Per-type secondary index (time order). It only lives in memory and is
+ * rebuilt from the message list when the database is opened.
+ */
+struct msg_typeidx {
+    uint16_t t_next[MAX_MESSAGES];
+    uint16_t t_prev[MAX_MESSAGES];
+    uint16_t t_first[MAX_MESSAGE_TYPES];
+    uint16_t t_last[MAX_MESSAGE_TYPES];
+    uint16_t t_count[MAX_MESSAGE_TYPES];
+    uint16_t count;
+};
+
+STATIC_ASSERT(MAX_MESSAGES < NULL_NODE, "");
+
 struct msg_context {
     struct msg_database db; /* message database */
     struct msg_notifstate state;
+    struct msg_typeidx tidx;
     const struct msg_fops *f_ops;
     struct observer_base obs;
     os_mutex_t lock;
@@ -56,6 +84,8 @@ struct msg_context {
     bool dirty; /* mean to the message database has been modified */
     bool state_dirty;
     uint16_t new_idx;
+    uint16_t dirty_min; /* The range of modified nodes */
+    uint16_t dirty_max;
 };
 
 #define MTX_LOCK()   (void)os_mtx_lock(&msg_context.lock)
@@ -135,13 +165,51 @@ static void msg_mark_dirty(struct msg_context *ctx) {
     ctx->dirty = true;
 }
 
+static inline void msg_mark_node(struct msg_context *ctx, uint16_t idx) {
+    if (idx == NULL_NODE)
+        return;
+    if (idx < ctx->dirty_min)
+        ctx->dirty_min = idx;
+    if (idx > ctx->dirty_max)
+        ctx->dirty_max = idx;
+}
+
 static int msg_header_write(struct msg_context *ctx) {
-    int ret = fmsg_write(ctx, &ctx->db, sizeof(ctx->db), 0);
-    if (ret < 0) {
-        pr_err("write message header failed(%d)\n", ret);
-        return ret;
+    struct msg_database *mdb = &ctx->db;
+    uint16_t min = ctx->dirty_min;
+    uint16_t max = ctx->dirty_max;
+    size_t size;
+    int ret;
+
+    ctx->dirty_min = NULL_NODE;
+    ctx->dirty_max = 0;
+
+    /*
+     * Only the modified nodes are written back if that saves enough
+     * I/O (large capacity), otherwise the whole header.
+     */
+    size = (max - min + 1) * sizeof(struct msg_node);
+    if (min <= max && size + 512 < sizeof(*mdb)) {
+        ret = fmsg_write(ctx, mdb, offsetof(struct msg_database, m_node), 0);
+        if (ret < 0)
+            goto _failed;
+        ret = fmsg_write(ctx, &mdb->m_node[min], size, 
+            offsetof(struct msg_database, m_node) + min * sizeof(struct msg_node));
+        if (ret < 0)
+            goto _failed;
+        ret = fmsg_write(ctx, &mdb->m_first, 
+            sizeof(*mdb) - offsetof(struct msg_database, m_first),
+            offsetof(struct msg_database, m_first));
+    } else {
+        ret = fmsg_write(ctx, mdb, sizeof(*mdb), 0);
     }
+    if (ret < 0)
+        goto _failed;
     return 0;
+
+_failed:
+    pr_err("write message header failed(%d)\n", ret);
+    return ret;
 }
 
 static int msg_state_write(struct msg_context *ctx) {
@@ -174,7 +242,8 @@ _out:
 }
 
 static void msg_reset_locked(struct msg_database *mdb, bool force) {
-    if (force || mdb->m_magic != MESSAGE_MAGIC) {
+    if (force || mdb->m_magic != MESSAGE_MAGIC ||
+        mdb->m_offset != MESSAGE_CONTENT_OFFSET) {
         memset(mdb->m_bitmap, 0, sizeof(mdb->m_bitmap));
         for (int i = 0; i < MAX_MESSAGES; i++) 
             msg_node_init(&mdb->m_node[i]);
@@ -193,9 +262,58 @@ static void msg_state_reset_locked(struct msg_notifstate *state, bool force) {
     }
 }
 
-static void msg_remove_node(struct msg_database *mdb, int idx) {
+static void msg_type_link(struct msg_typeidx *ti, int type, uint16_t idx) {
+    ti->count++;
+    if (type >= MAX_MESSAGE_TYPES)
+        return;
+    ti->t_next[idx] = NULL_NODE;
+    ti->t_prev[idx] = ti->t_last[type];
+    if (ti->t_last[type] != NULL_NODE)
+        ti->t_next[ti->t_last[type]] = idx;
+    else
+        ti->t_first[type] = idx;
+    ti->t_last[type] = idx;
+    ti->t_count[type]++;
+}
+
+static void msg_type_unlink(struct msg_typeidx *ti, int type, uint16_t idx) {
+    ti->count--;
+    if (type >= MAX_MESSAGE_TYPES)
+        return;
+    if (ti->t_next[idx] != NULL_NODE)
+        ti->t_prev[ti->t_next[idx]] = ti->t_prev[idx];
+    else
+        ti->t_last[type] = ti->t_prev[idx];
+    if (ti->t_prev[idx] != NULL_NODE)
+        ti->t_next[ti->t_prev[idx]] = ti->t_next[idx];
+    else
+        ti->t_first[type] = ti->t_next[idx];
+    ti->t_next[idx] = NULL_NODE;
+    ti->t_prev[idx] = NULL_NODE;
+    ti->t_count[type]--;
+}
+
+static void msg_index_rebuild_locked(struct msg_context *ctx) {
+    struct msg_database *mdb = &ctx->db;
+    struct msg_typeidx *ti = &ctx->tidx;
+    uint16_t idx = mdb->m_first;
+
+    memset(ti, 0, sizeof(*ti));
+    memset(ti->t_first, 0xff, sizeof(ti->t_first));
+    memset(ti->t_last, 0xff, sizeof(ti->t_last));
+    while (idx < MAX_MESSAGES && ti->count < MAX_MESSAGES) {
+        msg_type_link(ti, mdb->m_node[idx].type, idx);
+        idx = mdb->m_node[idx].n_index;
+    }
+}
+
+static void msg_remove_node(struct msg_context *ctx, int idx) {
+    struct msg_database *mdb = &ctx->db;
     struct msg_node *node = &mdb->m_node[idx];
 
+    if (node->index == NULL_NODE)
+        return;
+
     /* Remove from message list */
     if (node->n_index != NULL_NODE) 
         mdb->m_node[node->n_index].p_index = node->p_index;
@@ -205,12 +323,17 @@ static void msg_remove_node(struct msg_database *mdb, int idx) {
         mdb->m_first = mdb->m_node[idx].n_index;
     if (mdb->m_last == idx)
         mdb->m_last = mdb->m_node[idx].p_index;
+    msg_type_unlink(&ctx->tidx, node->type, (uint16_t)idx);
+    msg_mark_node(ctx, node->n_index);
+    msg_mark_node(ctx, node->p_index);
+    msg_mark_node(ctx, (uint16_t)idx);
     
     /* Make node invalid */
     msg_node_init(&mdb->m_node[idx]);
 }
 
-static int msg_slot_allocate(struct msg_database *mdb) {
+static int msg_slot_allocate(struct msg_context *ctx) {
+    struct msg_database *mdb = &ctx->db;
     int index = 0;
     for (int i = 0; i < (int)rte_array_size(mdb->m_bitmap); i++) {
         uint32_t mask = mdb->m_bitmap[i];
@@ -228,7 +351,7 @@ static int msg_slot_allocate(struct msg_database *mdb) {
 
     /* If the message slot is full then remove the first one */
 	index = mdb->m_first;
-    msg_remove_node(mdb, mdb->m_first);
+    msg_remove_node(ctx, mdb->m_first);
     pr_dbg("replace idx %d\n", index);
     return index;
 }
@@ -247,7 +370,7 @@ static int msg_slot_free(struct msg_context *ctx, int index) {
     /* Remove from bitmap */
     mdb->m_bitmap[idx >> 5] &= ~BIT((idx & 31));
 
-    msg_remove_node(mdb, idx);
+    msg_remove_node(ctx, idx);
     msg_mark_dirty(ctx);
     return 0;
 }
@@ -259,7 +382,7 @@ static int msg_content_write(struct msg_context *ctx,
     int index, ret;
 
     /* Allocate free message slot */
-    index = msg_slot_allocate(mdb);
+    index = msg_slot_allocate(ctx);
     assert(index >= 0 && index < MAX_MESSAGES);
     node = &mdb->m_node[index];
     node->type = content->type;
@@ -270,12 +393,15 @@ static int msg_content_write(struct msg_context *ctx,
         struct msg_node *pnode = &mdb->m_node[mdb->m_last];
         pnode->n_index = node->index;
         node->p_index = pnode->index;
+        msg_mark_node(ctx, pnode->index);
     } else {
         mdb->m_first = node->index;
         node->p_index = NULL_NODE;
     }
     mdb->m_last = node->index;
     node->n_index = NULL_NODE;
+    msg_mark_node(ctx, node->index);
+    msg_type_link(&ctx->tidx, node->type, node->index);
 
     /* Write message to disk */
     uint32_t offset = fmsg_offset(mdb, node->index);
@@ -320,17 +446,118 @@ static int msg_flush_locked(void) {
     return err;
 }
 
+static int msg_read_batch_locked(struct msg_context *ctx, int type, int *id,
+    struct msg_payload *payloads, int *ids, size_t n) {
+    struct msg_database *mdb = &ctx->db;
+    struct msg_typeidx *ti = &ctx->tidx;
+    size_t count = 0;
+    uint16_t idx;
+    int ret;
+
+    if (*id < 0 || *id >= MAX_MESSAGES)
+        return -EINVAL;
+    idx = (uint16_t)*id;
+    if (mdb->m_node[idx].index == NULL_NODE ||
+        (type >= 0 && mdb->m_node[idx].type != type)) {
+        pr_err("invalid message id(%d)\n", *id);
+        return -EINVAL;
+    }
+
+#define MSG_NEXT(_idx) \
+    ((type < 0)? mdb->m_node[_idx].n_index: ti->t_next[_idx])
+
+    /*
+     * Slots are allocated in ascending order and the oldest one is
+     * replaced when full, so the messages of time order mostly occupy
+     * ascending slots. Every run of ascending slots with small holes
+     * (other types) is read at once into the free part of the buffer
+     * and then the holes are squeezed out.
+     */
+    while (idx != NULL_NODE && count < n) {
+        uint16_t start = idx;
+        uint16_t last;
+        size_t len = 0;
+
+        do {
+            last = idx;
+            len++;
+            idx = MSG_NEXT(idx);
+        } while (idx != NULL_NODE && idx > last && 
+            idx - last <= MESSAGE_BATCH_GAP &&
+            (size_t)(idx - start) < n - count &&
+            count + len < n);
+
+        ret = fmsg_read(ctx, &payloads[count], 
+            (last - start + 1) * sizeof(*payloads), 
+            fmsg_offset(mdb, start));
+        if (ret < 0) {
+            pr_err("read message failed (index:%d count:%d)\n", start, (int)len);
+            return ret;
+        }
+        last = start;
+        for (size_t k = 0; k < len; k++, last = MSG_NEXT(last)) {
+            struct msg_payload *src = &payloads[count + last - start];
+            if (ids)
+                ids[count + k] = last;
+            if (src != &payloads[count + k])
+                memcpy(&payloads[count + k], src, sizeof(*payloads));
+        }
+        count += len;
+    }
+#undef MSG_NEXT
+
+    *id = (idx != NULL_NODE)? idx: -EINVAL;
+    return (int)count;
+}
+
 size_t msg_storage_numbers(void) {
-    size_t n = 0;
+    size_t n;
     MTX_LOCK();
-    MSG_STORAGE_FOREACH(idx) {
-        n++;
-    }
+    n = msg_context.tidx.count;
     MTX_UNLOCK();
     pr_dbg("message numbers: %d\n", n);
     return n;
 }
 
+size_t msg_storage_type_numbers(int type) {
+    size_t n;
+    if (type < 0 || type >= MAX_MESSAGE_TYPES)
+        return 0;
+    MTX_LOCK();
+    n = msg_context.tidx.t_count[type];
+    MTX_UNLOCK();
+    return n;
+}
+
+int msg_storage_read_batch(int *id, struct msg_payload *payloads, 
+    int *ids, size_t n) {
+    int ret;
+
+    if (id == NULL || payloads == NULL) {
+        pr_err("invalid paramters\n");
+        return -EINVAL;
+    }
+    MTX_LOCK();
+    ret = msg_read_batch_locked(&msg_context, -1, id, payloads, ids, n);
+    MTX_UNLOCK();
+    return ret;
+}
+
+int msg_storage_type_read_batch(int type, int *id, 
+    struct msg_payload *payloads, int *ids, size_t n) {
+    int ret;
+
+    if (id == NULL || payloads == NULL || 
+        type < 0 || type >= MAX_MESSAGE_TYPES) {
+        pr_err("invalid paramters\n");
+        return -EINVAL;
+    }
+    MTX_LOCK();
+    ret = msg_read_batch_locked(&msg_context, type, id, payloads, ids, n);
+    MTX_UNLOCK();
+    return ret;
+}
+
 int msg_storage_read(int id, struct msg_payload *payload) {
     struct msg_context *ctx;
     uint32_t offset;
@@ -341,7 +568,7 @@ int msg_storage_read(int id, struct msg_payload *payload) {
         pr_err("invalid paramters\n");
         return -EINVAL;
     }
-    if (idx > MAX_MESSAGES || idx == NULL_NODE) {
+    if (idx >= MAX_MESSAGES) {
         pr_err("invalid message id(%d)\n", id);
         return -EINVAL;
     }
@@ -384,6 +611,27 @@ int msg_storage_next(int id) {
     return -EINVAL;
 }
 
+int msg_storage_type_first(int type) {
+    uint16_t idx;
+    if (type < 0 || type >= MAX_MESSAGE_TYPES)
+        return -EINVAL;
+    idx = msg_context.tidx.t_first[type];
+    if (idx == NULL_NODE)
+        return -EINVAL;
+    return idx;
+}
+
+int msg_storage_type_next(int id) {
+    if (id < 0 || id >= MAX_MESSAGES) {
+        pr_warn("invalid message id(%d)\n", id);
+        return -EINVAL;
+    }
+    int idx = msg_context.tidx.t_next[id];
+    if (idx == NULL_NODE)
+        return -EINVAL;
+    return idx;
+}
+
 int msg_storage_remove(int id) {
     assert(id >= 0);
     MTX_LOCK();
@@ -467,6 +715,7 @@ int msg_storage_clean(void) {
         err = fmsg_open(ctx, MSG_FILENAME);
         assert(err == 0);
         msg_reset_locked(&ctx->db, true);
+        msg_index_rebuild_locked(ctx);
         pr_dbg("clear msgfile.db success\n");
     }
     MTX_UNLOCK();
@@ -588,6 +837,9 @@ int __rte_notrace msg_storage_init(void) {
     MTX_LOCK();
     msg_reset_locked(mdb, false);
     msg_state_reset_locked(sta, false);
+    msg_index_rebuild_locked(ctx);
+    ctx->dirty_min = NULL_NODE;
+    ctx->dirty_max = 0;
     err = os_timer_create(&ctx->timer, msg_check_cb, 
         ctx, false);
     if (err)
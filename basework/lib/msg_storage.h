@@ -72,6 +72,14 @@ struct msg_node {
         _id >= 0; \
         _id = msg_storage_next(_id))
 
+/*
+ * Walk around messages of the type by time order
+ */
+#define MSG_STORAGE_TYPE_FOREACH(_type, _id) \
+    for (int _id = msg_storage_type_first(_type); \
+        _id >= 0; \
+        _id = msg_storage_type_next(_id))
+
 /*
  * msg_storage_numbers - Get the number of messages
  *
@@ -79,6 +87,14 @@ struct msg_node {
  */
 size_t msg_storage_numbers(void);
 
+/*
+ * msg_storage_type_numbers - Get the number of messages of the type
+ *
+ * @type: message type
+ * return the numbers of message 
+ */
+size_t msg_storage_type_numbers(int type);
+
 /*
  * msg_storage_clean - Clean all messages
  *
@@ -101,6 +117,22 @@ int msg_storage_first(void);
  */
 int msg_storage_next(int id);
 
+/*
+ * msg_storage_type_first - Get the first message ID of the type
+ *
+ * @type: message type
+ * return the ID if success (id >= 0)
+ */
+int msg_storage_type_first(int type);
+
+/*
+ * msg_storage_type_next - Get the next message ID that has the same type
+ *
+ * @id: message id
+ * return the next id if success (id >= 0)
+ */
+int msg_storage_type_next(int id);
+
 /*
  * msg_storage_remove - Delete a message by message id
  *
@@ -118,6 +150,35 @@ int msg_storage_remove(int id);
  */
 int msg_storage_read(int id, struct msg_payload *payload);
 
+/*
+ * msg_storage_read_batch - Read messages by time order
+ *
+ * The messages in adjacent slots are read by one I/O request.
+ *
+ * @id: the first message id (msg_storage_first()), it is updated to the
+ *      id of the next unread message (< 0 if no more)
+ * @payloads: message content buffer
+ * @ids: the id of each message that has been read (can be NULL)
+ * @n: the number of @payloads
+ * return the number of messages that has been read if success
+ */
+int msg_storage_read_batch(int *id, struct msg_payload *payloads, 
+    int *ids, size_t n);
+
+/*
+ * msg_storage_type_read_batch - Read messages of the type by time order
+ *
+ * @type: message type
+ * @id: the first message id (msg_storage_type_first()), it is updated to 
+ *      the id of the next unread message (< 0 if no more)
+ * @payloads: message content buffer
+ * @ids: the id of each message that has been read (can be NULL)
+ * @n: the number of @payloads
+ * return the number of messages that has been read if success
+ */
+int msg_storage_type_read_batch(int type, int *id, 
+    struct msg_payload *payloads, int *ids, size_t n);
+
 /*
  * msg_storage_read - Write message content to database
  *
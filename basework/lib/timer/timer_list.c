@@ -2,9 +2,11 @@
  * CopyRight 2022 wtcat
  *
  * The software timer implemention that base on double-list
+ * (or hierarchical timing wheel if CONFIG_BASEWORK_TIMER_WHEEL is enabled)
  */
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "basework/os/osapi.h"
 #include "basework/lib/timer/timer_list.h"
@@ -16,6 +18,213 @@
 #define TIMER_LIST(ptr) rte_container_of(ptr, struct timer_list, node)
 
 os_critical_global_declare
+
+#ifdef CONFIG_BASEWORK_TIMER_WHEEL
+/*
+ * Cascading timing wheel. The first level has 256 slots of one tick, each
+ * slot of the upper levels covers the whole range of the level below it.
+ * The timer is hashed into a slot by its absolute expiration time and moved
+ * down one level when the lower level wraps around, so that both insert and
+ * delete are O(1). timer->expires holds the absolute expiration time.
+ */
+#define TW_L0_BITS   8
+#define TW_LN_BITS   6
+#define TW_LEVELS    4
+#define TW_L0_SIZE   (1 << TW_L0_BITS)
+#define TW_LN_SIZE   (1 << TW_LN_BITS)
+#define TW_L0_MASK   (TW_L0_SIZE - 1)
+#define TW_LN_MASK   (TW_LN_SIZE - 1)
+#define TW_SLOTS     (TW_L0_SIZE + (TW_LEVELS - 1) * TW_LN_SIZE)
+#define TW_SHIFT(n)  (TW_L0_BITS + (n) * TW_LN_BITS)
+#define TW_MAX_TICKS ((1ul << TW_SHIFT(TW_LEVELS - 1)) - 1)
+#define TW_SLOT(n, t) \
+	(TW_L0_SIZE + (n) * TW_LN_SIZE + (((t) >> TW_SHIFT(n)) & TW_LN_MASK))
+
+static struct rte_list tw_vec[TW_SLOTS];
+static uint32_t tw_pending[TW_L0_SIZE / 32]; /* Non-empty slots of level 0 */
+static unsigned long tw_next; /* The next tick to be processed */
+static size_t tw_count;
+static bool tw_ready;
+
+static void tw_setup_locked(void) {
+	if (rte_likely(tw_ready))
+		return;
+	for (int i = 0; i < TW_SLOTS; i++)
+		RTE_INIT_LIST(&tw_vec[i]);
+	tw_ready = true;
+}
+
+/* Find the first pending slot of level 0 that starts from @index */
+static int tw_find_pending(int index) {
+	int word = index >> 5;
+	uint32_t bits = tw_pending[word] & (~0u << (index & 31));
+
+	for ( ; ; ) {
+		if (bits)
+			return (word << 5) + __builtin_ctz(bits);
+		if (++word == TW_L0_SIZE / 32)
+			return TW_L0_SIZE;
+		bits = tw_pending[word];
+	}
+}
+
+static void tw_enqueue_locked(struct timer_list *timer) {
+	unsigned long expires = (unsigned long)timer->expires;
+	unsigned long idx = expires - tw_next;
+	int slot;
+
+	if (idx < TW_L0_SIZE) {
+		slot = expires & TW_L0_MASK;
+	} else if (idx < (1ul << TW_SHIFT(1))) {
+		slot = TW_SLOT(0, expires);
+	} else if (idx < (1ul << TW_SHIFT(2))) {
+		slot = TW_SLOT(1, expires);
+	} else if ((long)idx < 0) {
+		/* Already expired, put it to the next tick */
+		slot = tw_next & TW_L0_MASK;
+	} else {
+		/* Far timer is re-hashed until it comes into range */
+		if (idx > TW_MAX_TICKS)
+			expires = tw_next + TW_MAX_TICKS;
+		slot = TW_SLOT(2, expires);
+	}
+	rte_list_add_tail(&timer->node, &tw_vec[slot]);
+	if (slot < TW_L0_SIZE)
+		tw_pending[slot >> 5] |= 1u << (slot & 31);
+}
+
+/* Move the timers of current slot in level @n to the lower levels */
+static int tw_cascade_locked(int n) {
+	int index = (tw_next >> TW_SHIFT(n)) & TW_LN_MASK;
+	struct rte_list *head = &tw_vec[TW_L0_SIZE + n * TW_LN_SIZE + index];
+	RTE_LIST(work);
+
+	rte_list_splice_init(head, &work);
+	while (!rte_list_empty(&work)) {
+		struct timer_list *timer = TIMER_LIST(work.next);
+		rte_list_del(&timer->node);
+		tw_enqueue_locked(timer);
+	}
+	return index;
+}
+
+static void tw_cascade_all_locked(void) {
+	if (!tw_cascade_locked(0) && !tw_cascade_locked(1))
+		tw_cascade_locked(2);
+}
+
+static int timer_add_locked(struct timer_list *timer,
+	long expires) {
+	if (rte_unlikely(timer->state != TIMER_STATE_IDLE))
+		return -EBUSY;
+	tw_setup_locked();
+	if (expires < 1)
+		expires = 1;
+	timer->expires = (long)(tw_next - 1 + (unsigned long)expires);
+	tw_enqueue_locked(timer);
+	timer->state = TIMER_STATE_ACTIVED;
+	tw_count++;
+	return 0;
+}
+
+static int timer_remove_locked(struct timer_list *timer) {
+	struct rte_list *next;
+
+	if (timer->state == TIMER_STATE_IDLE)
+		return 0;
+
+	/*
+	 * Clear the pending bit if the timer is the last one of level 0 slot
+	 */
+	next = timer->node.next;
+	if (next == timer->node.prev && 
+		next >= &tw_vec[0] && next < &tw_vec[TW_L0_SIZE]) {
+		int slot = (int)(next - tw_vec);
+		tw_pending[slot >> 5] &= ~(1u << (slot & 31));
+	}
+	rte_list_del(&timer->node);
+	timer->state = TIMER_STATE_IDLE;
+	tw_count--;
+	return 1;
+}
+
+/*
+ * Run the expired timers and return the ticks to the next pending slot of
+ * level 0 or the next cascade point, whichever is sooner. So the result may be
+ * earlier than the real expiration time of the nearest timer.
+ */
+long timer_schedule(long expires) {
+	TIMER_LOCK_DECLARE
+	unsigned long target;
+	long next_expired;
+	int index, slot;
+	RTE_LIST(work);
+
+	TIMER_LOCK();
+	tw_setup_locked();
+	target = tw_next - 1 + (unsigned long)expires;
+	if (rte_unlikely(tw_count == 0)) {
+		tw_next = target + 1;
+		next_expired = 0;
+		goto _unlock;
+	}
+
+	while ((long)(target - tw_next) >= 0) {
+		index = tw_next & TW_L0_MASK;
+		if (!index)
+			tw_cascade_all_locked();
+
+		/* Skip the empty slots */
+		slot = tw_find_pending(index);
+		if ((unsigned long)(slot - index) > target - tw_next) {
+			tw_next = target + 1;
+			break;
+		}
+		tw_next += slot - index;
+		if (slot == TW_L0_SIZE)
+			continue;
+
+		tw_next++;
+		rte_list_splice_init(&tw_vec[slot], &work);
+		tw_pending[slot >> 5] &= ~(1u << (slot & 31));
+		while (!rte_list_empty(&work)) {
+			void (*fn)(struct timer_list*, void *);
+			struct timer_list *timer = TIMER_LIST(work.next);
+			rte_list_del(&timer->node);
+			fn = timer->expired_fn;
+			timer->state = TIMER_STATE_IDLE;
+			tw_count--;
+			TIMER_UNLOCK();
+			fn(timer, timer->arg);
+			TIMER_LOCK();
+		}
+	}
+
+	if (tw_count > 0) {
+		index = tw_next & TW_L0_MASK;
+		if (!index)
+			tw_cascade_all_locked();
+		next_expired = tw_find_pending(index) - index + 1;
+	} else {
+		next_expired = 0;
+	}
+
+_unlock:
+	TIMER_UNLOCK();
+	return next_expired;
+}
+
+static void timer_visit_locked(void (*visitor)(struct timer_list *)) {
+	struct rte_list *node;
+
+	tw_setup_locked();
+	for (int i = 0; i < TW_SLOTS; i++) {
+		rte_list_foreach(node, &tw_vec[i])
+			visitor(TIMER_LIST(node));
+	}
+}
+
+#else /* !CONFIG_BASEWORK_TIMER_WHEEL */
 static RTE_LIST(timer_list);
 
 #ifdef TIMER_DEBUG
@@ -134,6 +343,15 @@ _unlock:
 	return next_expired;
 }
 
+static void timer_visit_locked(void (*visitor)(struct timer_list *)) {
+	struct rte_list *node;
+
+	rte_list_foreach(node, &timer_list) {
+		visitor(TIMER_LIST(node));
+	}
+}
+#endif /* CONFIG_BASEWORK_TIMER_WHEEL */
+
 void timer_init(struct timer_list *timer, 
     void (*expired_fn)(struct timer_list *, void *), void *arg) {
     timer->expired_fn = expired_fn;
@@ -169,13 +387,10 @@ int timer_del(struct timer_list *timer) {
 
 int timer_visit(void (*visitor)(struct timer_list *)) {
     TIMER_LOCK_DECLARE
-    struct rte_list *node;
     if (visitor == NULL)
         return -EINVAL;
     TIMER_LOCK();
-	rte_list_foreach(node, &timer_list) {
-        visitor(TIMER_LIST(node));
-	}
+    timer_visit_locked(visitor);
     TIMER_UNLOCK();
     return 0;
 }
@@ -37,7 +37,8 @@ int timer_visit(void (*iterator)(struct timer_list *));
  * timer_schedule - called by hardware interrupt service
  * @expires: expired time
  *
- * Return the next exipiration time 
+ * Return the next exipiration time (0 if there is no pending timer).
+ * The timing wheel may return an earlier time than the real one.
  */
 long timer_schedule(long expires);
 
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Runtime log level of modules
+ */
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "basework/os/osapi.h"
+#include "basework/log.h"
+#include "basework/env.h"
+
+#ifndef CONFIG_LOG_MAX_PENDING
+#define CONFIG_LOG_MAX_PENDING 8
+#endif
+
+#define LOG_NAME_MAX 16
+
+/*
+ * The level that set before module has been registered
+ */
+struct log_pending {
+    char name[LOG_NAME_MAX];
+    unsigned char level;
+};
+
+os_critical_global_declare
+static struct log_module *log_modules;
+static struct log_pending log_pendings[CONFIG_LOG_MAX_PENDING];
+static int log_all_level = -1;
+
+static struct log_module *log_module_find_locked(const char *name) {
+    for (struct log_module *mod = log_modules; mod; mod = mod->next) {
+        if (!strcmp(mod->name, name))
+            return mod;
+    }
+    return NULL;
+}
+
+static struct log_pending *log_pending_find_locked(const char *name) {
+    for (int i = 0; i < CONFIG_LOG_MAX_PENDING; i++) {
+        if (!strncmp(log_pendings[i].name, name, LOG_NAME_MAX))
+            return &log_pendings[i];
+    }
+    return NULL;
+}
+
+int __log_module_setup(struct log_module *mod, int level) {
+    os_critical_declare
+    struct log_pending *pending;
+
+    os_critical_lock
+    if (mod->level == LOG_MODULE_UNINIT) {
+        pending = log_pending_find_locked(mod->name);
+        if (pending) {
+            mod->level = pending->level;
+            pending->name[0] = '\0';
+        } else if (log_all_level >= 0) {
+            mod->level = (unsigned char)log_all_level;
+        } else {
+            mod->level = mod->deflevel;
+        }
+        mod->next = log_modules;
+        log_modules = mod;
+    }
+    os_critical_unlock
+    return level <= mod->level;
+}
+
+int log_module_set_level(const char *name, int level) {
+    os_critical_declare
+    struct log_module *mod;
+    struct log_pending *pending;
+    int err = 0;
+
+    if (name == NULL || level < LOGLEVEL_EMERG || level > LOGLEVEL_DEBUG)
+        return -EINVAL;
+
+    os_critical_lock
+    if (!strcmp(name, "*")) {
+        for (mod = log_modules; mod; mod = mod->next)
+            mod->level = (unsigned char)level;
+        log_all_level = level;
+        goto _unlock;
+    }
+
+    mod = log_module_find_locked(name);
+    if (mod) {
+        mod->level = (unsigned char)level;
+        goto _unlock;
+    }
+
+    if (strlen(name) >= LOG_NAME_MAX) {
+        err = -EINVAL;
+        goto _unlock;
+    }
+    pending = log_pending_find_locked(name);
+    if (!pending)
+        pending = log_pending_find_locked("");
+    if (pending) {
+        strcpy(pending->name, name);
+        pending->level = (unsigned char)level;
+    } else {
+        err = -ENOMEM;
+    }
+
+_unlock:
+    os_critical_unlock
+    return err;
+}
+
+int log_module_get_level(const char *name) {
+    os_critical_declare
+    struct log_module *mod;
+    int level = -ENOENT;
+
+    if (name == NULL)
+        return -EINVAL;
+
+    os_critical_lock
+    mod = log_module_find_locked(name);
+    if (mod)
+        level = mod->level;
+    os_critical_unlock
+    return level;
+}
+
+void log_module_foreach(bool (*iterator)(const struct log_module *, void *),
+    void *arg) {
+    struct log_module *mod;
+
+    if (iterator == NULL)
+        return;
+
+    /* The module is never removed from list, so we can walk it without lock */
+    for (mod = log_modules; mod; mod = mod->next) {
+        if (!iterator(mod, arg))
+            break;
+    }
+}
+
+int log_module_parse(const char *str) {
+    char name[LOG_NAME_MAX];
+    const char *p;
+    char *end;
+    size_t len;
+    long level;
+    int err;
+
+    if (str == NULL)
+        return -EINVAL;
+
+    while (*str) {
+        p = strchr(str, '=');
+        if (p == NULL)
+            return -EINVAL;
+        len = p - str;
+        if (len == 0 || len >= sizeof(name))
+            return -EINVAL;
+        memcpy(name, str, len);
+        name[len] = '\0';
+        level = strtol(p + 1, &end, 10);
+        if (end == p + 1 || (*end != ',' && *end != '\0'))
+            return -EINVAL;
+        err = log_module_set_level(name, (int)level);
+        if (err)
+            return err;
+        str = *end? end + 1: end;
+    }
+    return 0;
+}
+
+int log_module_load(void) {
+    const char *str = env_get("loglevel");
+    if (str == NULL)
+        return -ENOENT;
+    return log_module_parse(str);
+}
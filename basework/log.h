@@ -6,6 +6,8 @@
 #ifndef BASEWORK_LOG_H_
 #define BASEWORK_LOG_H_
 
+#include <stdbool.h>
+
 #include "basework/lib/printer.h"
 #ifdef __cplusplus
 extern "C"{
@@ -26,6 +28,14 @@ extern "C"{
 #define CONFIG_GLOBAL_LOGLEVEL CONFIG_LOGLEVEL
 #endif
 
+/*
+ * The messages that less important than CONFIG_LOG_FLOOR are removed at
+ * compile time, include the registered modules.
+ */
+#ifndef CONFIG_LOG_FLOOR
+#define CONFIG_LOG_FLOOR  LOGLEVEL_DEBUG
+#endif
+
 #ifndef pr_fmt
 #define pr_fmt(fmt) fmt
 #endif
@@ -36,6 +46,50 @@ extern struct printer *__log_disk_printer;
 #define PRINTER_NAME(name) __log_##name##_printer
 #define get_printer(name) PRINTER_NAME(name)
 
+/*
+ * Log module with runtime log level
+ *
+ * The source file defines LOG_MODULE_NAME before including this file, and 
+ * one of them defines the module object:
+ *
+ *   #define LOG_MODULE_NAME blkdev
+ *   #include "basework/log.h"
+ *   LOG_MODULE_DEFINE(blkdev, LOGLEVEL_INFO);
+ *
+ * Then the pr_* macros of these files are filtered by the module level 
+ * instead of CONFIG_GLOBAL_LOGLEVEL. The module is registered when it output
+ * message at the first time.
+ */
+struct log_module {
+    unsigned char level;
+#define LOG_MODULE_UNINIT 0xff
+    unsigned char deflevel;
+    const char *name;
+    struct log_module *next;
+};
+
+#define LOG_MODULE_DEFINE(_name, _level) \
+    struct log_module __log_module_##_name = { \
+        LOG_MODULE_UNINIT, _level, #_name, NULL \
+    }
+
+int __log_module_setup(struct log_module *mod, int level);
+
+#ifdef LOG_MODULE_NAME
+#define __LOG_MODULE(name) ___LOG_MODULE(name)
+#define ___LOG_MODULE(name) __log_module_##name
+extern struct log_module __LOG_MODULE(LOG_MODULE_NAME);
+
+#define __log_enabled(_lvl) \
+    (CONFIG_LOG_FLOOR >= (_lvl) && \
+    (_lvl) <= __LOG_MODULE(LOG_MODULE_NAME).level && \
+    (rte_likely(__LOG_MODULE(LOG_MODULE_NAME).level != LOG_MODULE_UNINIT) || \
+    __log_module_setup(&__LOG_MODULE(LOG_MODULE_NAME), (_lvl))))
+#else
+#define __log_enabled(_lvl) \
+    (CONFIG_LOG_FLOOR >= (_lvl) && CONFIG_GLOBAL_LOGLEVEL >= (_lvl))
+#endif /* LOG_MODULE_NAME */
+
 /**
  * pr_out - Print an generic message without log-level and pr_fmt 
  * @fmt: format string
@@ -60,14 +114,14 @@ extern struct printer *__log_disk_printer;
 #ifndef _MSC_VER
 #define ___pr_generic(printer, level, fmt, ...) \
 ({ \
-    (CONFIG_GLOBAL_LOGLEVEL >= (level))? \
+    __log_enabled(level)? \
 	    virt_format((printer), fmt, ##__VA_ARGS__): 0;\
 })
 
 #else /* _MSC_VER */
 #define ___pr_generic(printer, level, fmt, ...) \
-    (CONFIG_GLOBAL_LOGLEVEL >= (level))? \
-	    virt_format((printer), pr_fmt(fmt), ##__VA_ARGS__): 0;\
+    (__log_enabled(level)? \
+	    virt_format((printer), fmt, ##__VA_ARGS__): 0)
 
 #endif /* !_MSC_VER */
 
@@ -189,6 +243,47 @@ static inline int pr_disklog_init(struct printer *pr) {
     return -1;
 }
 
+/*
+ * log_module_set_level - Set the runtime log level of module
+ *
+ * @name: module name ("*" means all modules)
+ * @level: log level
+ * return 0 if success. If the module is not registered yet, the level is 
+ * saved and applied at registration
+ */
+int log_module_set_level(const char *name, int level);
+
+/*
+ * log_module_get_level - Get the runtime log level of module
+ *
+ * @name: module name
+ * return log level if success else less than 0
+ */
+int log_module_get_level(const char *name);
+
+/*
+ * log_module_foreach - Iterate the registered modules
+ *
+ * @iterator: callback function (return false to stop)
+ * @arg: user parameter
+ */
+void log_module_foreach(bool (*iterator)(const struct log_module *, void *),
+    void *arg);
+
+/*
+ * log_module_parse - Set the module levels from a string
+ *
+ * @str: the list of "name=level" that separated by ',' (e.g. "blkdev=5,rq=1")
+ * return 0 if success
+ */
+int log_module_parse(const char *str);
+
+/*
+ * log_module_load - Load module levels from environment variable "loglevel"
+ * return 0 if success
+ */
+int log_module_load(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -39,6 +39,19 @@ extern "C"{
 #define os_critical_unlock
 #endif
 
+/*
+ * Object lock. It falls back to the critical lock when the platform has
+ * no lighter one, So it must not be nested and the caller must declare
+ * 'os_critical_declare'.
+ */
+#ifndef os_objlock_declare
+#define os_objlock_global_declare os_critical_global_declare
+#define os_objlock_declare(_lk)
+#define os_objlock_init(_lk) (void)0
+#define os_objlock_lock(_lk)   os_critical_lock
+#define os_objlock_unlock(_lk) os_critical_unlock
+#endif
+
 /* */
 #ifndef os_completion_declare
 #define os_completion_declare(_proc)  
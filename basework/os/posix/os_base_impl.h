@@ -26,6 +26,13 @@ extern "C"{
 #define os_critical_lock   pthread_mutex_lock(&__mutex);
 #define os_critical_unlock pthread_mutex_unlock(&__mutex);
 
+/* Object lock */
+#define os_objlock_global_declare
+#define os_objlock_declare(_lk) pthread_mutex_t _lk;
+#define os_objlock_init(_lk)    pthread_mutex_init(&(_lk), NULL)
+#define os_objlock_lock(_lk)    pthread_mutex_lock(&(_lk));
+#define os_objlock_unlock(_lk)  pthread_mutex_unlock(&(_lk));
+
 /* Completion */
 #define os_completion_declare(_cp) sem_t _cp;
 #define os_completion_reinit(_cp)  sem_init(&(_cp), 0, 0)
@@ -10,34 +10,321 @@
 #include <assert.h>
 #include <string.h>
 #include <signal.h>
+#include <pthread.h>
 
 #include "basework/os/osapi_config.h"
 #include "basework/os/osapi_timer.h"
 #include "basework/log.h"
 #include "basework/rq.h"
 
+#ifdef CONFIG_OS_TIMER_SERVICE
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
 
+#define TIMER_BATCH 16
+
+/*
+ * All timers are kept in a min-heap that ordered by expiration time, and one
+ * service thread sleeps on a timerfd that armed with the earliest one.
+ */
+struct os_timer {
+    uint64_t expires; /* Absolute expiration time (ns) */
+    int index;        /* Position in heap (-1 if not pending) */
+    bool isr_context;
+    void (*task)(os_timer_t, void *);
+    void *arg;
+    int firing;       /* Expirations whose callback has not returned */
+    pthread_t runner; /* Thread that is running the callback */
+    bool running;
+    bool dead;        /* Destroyed, the pending callbacks are dropped */
+    bool orphan;      /* The last pending callback frees the timer */
+};
+
+#else /* !CONFIG_OS_TIMER_SERVICE */
 struct os_timer {
     struct sigevent sig;
     struct itimerspec time;
     timer_t id;
     void (*task)(os_timer_t, void *);
     void *arg;
+    int firing;
+    pthread_t runner;
+    bool running;
+    bool dead;
+    bool orphan;
 };
+#endif /* CONFIG_OS_TIMER_SERVICE */
 
 static struct os_timer timer_objs[CONFIG_OS_MAX_TIMERS];
 static struct os_robj timer_robj;
+static pthread_mutex_t timer_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Run the callback of an expired timer. The callback is dropped if the
+ * timer has been destroyed after it expired.
+ */
+static void timer_fire(struct os_timer *timer) {
+    pthread_mutex_lock(&timer_mtx);
+    if (!timer->dead) {
+        timer->running = true;
+        timer->runner = pthread_self();
+        pthread_mutex_unlock(&timer_mtx);
+        timer->task(timer, timer->arg);
+        pthread_mutex_lock(&timer_mtx);
+        timer->running = false;
+        pthread_cond_broadcast(&timer_cond);
+    }
+    if (--timer->firing == 0 && timer->orphan)
+        os_obj_free(&timer_robj, timer);
+    pthread_mutex_unlock(&timer_mtx);
+}
+
+/*
+ * Wait for the running callback unless it is the caller itself, then 
+ * free the timer or leave it to the last pending callback.
+ */
+static void timer_release_locked(struct os_timer *timer) {
+    timer->dead = true;
+    while (timer->running && !pthread_equal(timer->runner, pthread_self()))
+        pthread_cond_wait(&timer_cond, &timer_mtx);
+    if (timer->firing == 0)
+        os_obj_free(&timer_robj, timer);
+    else
+        timer->orphan = true;
+}
 
 static void timer_task_wrapper(void *arg) {
     struct os_timer *timer = arg;
     pr_dbg("timer task call: %p timer->task(%p) arg(%p)\n", timer, timer->task, arg);
     assert(timer->task != NULL);
-    timer->task(timer, timer->arg);
+    timer_fire(timer);
+}
+
+#ifdef CONFIG_OS_TIMER_SERVICE
+static struct os_timer *timer_heap[CONFIG_OS_MAX_TIMERS];
+static int timer_heap_size;
+static int timer_fd = -1;
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+
+static uint64_t timer_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void timer_heap_set(int i, struct os_timer *p) {
+    timer_heap[i] = p;
+    p->index = i;
+}
+
+static void timer_heap_up(int i, struct os_timer *p) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (timer_heap[parent]->expires <= p->expires)
+            break;
+        timer_heap_set(i, timer_heap[parent]);
+        i = parent;
+    }
+    timer_heap_set(i, p);
+}
+
+static void timer_heap_down(int i, struct os_timer *p) {
+    for ( ; ; ) {
+        int child = 2 * i + 1;
+        if (child >= timer_heap_size)
+            break;
+        if (child + 1 < timer_heap_size && 
+            timer_heap[child + 1]->expires < timer_heap[child]->expires)
+            child++;
+        if (p->expires <= timer_heap[child]->expires)
+            break;
+        timer_heap_set(i, timer_heap[child]);
+        i = child;
+    }
+    timer_heap_set(i, p);
+}
+
+static void timer_heap_remove_locked(struct os_timer *p) {
+    struct os_timer *last = timer_heap[--timer_heap_size];
+    int i = p->index;
+
+    p->index = -1;
+    if (last == p)
+        return;
+    if (i > 0 && last->expires < timer_heap[(i - 1) / 2]->expires)
+        timer_heap_up(i, last);
+    else
+        timer_heap_down(i, last);
+}
+
+/* Program the timerfd with the earliest expiration time (disarm if empty) */
+static void timer_service_arm_locked(void) {
+    struct itimerspec its = {0};
+
+    if (timer_heap_size > 0) {
+        uint64_t expires = timer_heap[0]->expires;
+        its.it_value.tv_sec = expires / 1000000000ull;
+        its.it_value.tv_nsec = expires % 1000000000ull;
+    }
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void *timer_service_thread(void *arg) {
+    struct os_timer *batch[TIMER_BATCH];
+    uint64_t count;
+    (void) arg;
+
+    for ( ; ; ) {
+        if (read(timer_fd, &count, sizeof(count)) < 0 && errno != EINTR) {
+            pr_err("read timerfd failed (%d)\n", errno);
+            break;
+        }
+
+        /*
+         * The expirations are counted with lock, so os_timer_destroy() can 
+         * drop or wait for their callbacks. The isr-context callbacks are 
+         * called in batches after the lock is released.
+         */
+        for ( ; ; ) {
+            uint64_t now = timer_now_ns();
+            int n = 0;
+
+            pthread_mutex_lock(&timer_mtx);
+            while (timer_heap_size > 0 && n < TIMER_BATCH) {
+                struct os_timer *p = timer_heap[0];
+                if (p->expires > now)
+                    break;
+                timer_heap_remove_locked(p);
+                if (p->isr_context) {
+                    p->firing++;
+                    batch[n++] = p;
+                } else if (rq_submit(timer_task_wrapper, p) == 0) {
+                    p->firing++;
+                }
+            }
+            if (n == 0) {
+                timer_service_arm_locked();
+                pthread_mutex_unlock(&timer_mtx);
+                break;
+            }
+            pthread_mutex_unlock(&timer_mtx);
+
+            for (int i = 0; i < n; i++)
+                timer_fire(batch[i]);
+        }
+    }
+    return NULL;
+}
+
+static void timer_service_start(void) {
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer_fd < 0) {
+        pr_err("Create timerfd failed (%d)\n", errno);
+        os_panic();
+        return;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, timer_service_thread, NULL)) {
+        pr_err("Create timer service failed\n");
+        os_panic();
+    }
+    pthread_attr_destroy(&attr);
+    pthread_setname_np(thread, "os_timer");
+}
+
+int __os_timer_create(os_timer_t *timer, 
+    void (*timeout_cb)(os_timer_t, void *), 
+    void *arg, 
+    bool isr_context) {
+    struct os_timer *p;
+
+    if (!timer || !timeout_cb)
+        return -EINVAL;
+    pthread_once(&timer_once, timer_service_start);
+    pthread_mutex_lock(&timer_mtx);
+    if (!os_obj_ready(&timer_robj)) {
+        int err = os_obj_initialize(&timer_robj, timer_objs, 
+            sizeof(timer_objs), sizeof(timer_objs[0]));
+        if (err) {
+            pthread_mutex_unlock(&timer_mtx);
+            pr_err("Initialize timer object failed (%d)\n", err);
+            os_panic();
+            return err;
+        }
+    }
+    p = os_obj_allocate(&timer_robj);
+    pthread_mutex_unlock(&timer_mtx);
+    if (!p) {
+        pr_err("Allocate timer object failed\n");
+        return -ENOMEM;
+    }
+
+    *p = (struct os_timer){ 0 };
+    p->index = -1;
+    p->isr_context = isr_context;
+    p->arg = arg;
+    p->task = timeout_cb;
+    *timer = p;
+    return 0;
 }
 
+int __os_timer_mod(os_timer_t timer, long expires) {
+    assert(timer != NULL);
+    struct os_timer *p = timer;
+
+    pthread_mutex_lock(&timer_mtx);
+    if (p->index >= 0)
+        timer_heap_remove_locked(p);
+
+    /* 
+     * Zero timeout disarms the timer, the same as timer_settime() of 
+     * the SIGEV_THREAD backend. And the callback can not re-arm the 
+     * timer that has been destroyed.
+     */
+    if (expires <= 0 || p->dead) {
+        pthread_mutex_unlock(&timer_mtx);
+        return 0;
+    }
+    p->expires = timer_now_ns() + (uint64_t)expires * 1000000ull;
+    timer_heap_size++;
+    timer_heap_up(timer_heap_size - 1, p);
+    if (p->index == 0)
+        timer_service_arm_locked();
+    pthread_mutex_unlock(&timer_mtx);
+    return 0;
+}
+
+int __os_timer_add(os_timer_t timer, long expires) {
+    assert(timer != NULL);
+    os_timer_mod(timer, expires);
+    return 0;
+}
+
+int __os_timer_del(os_timer_t timer) {
+    assert(timer != NULL);
+    struct os_timer *p = timer;
+
+    pthread_mutex_lock(&timer_mtx);
+    if (p->index >= 0)
+        timer_heap_remove_locked(p);
+    pthread_mutex_unlock(&timer_mtx);
+    return 0;
+}
+
+#else /* !CONFIG_OS_TIMER_SERVICE */
 static void timer_signal_cb(__sigval_t val) {
     struct os_timer *timer = val.sival_ptr;
-    rq_submit(timer_task_wrapper, timer);
+
+    pthread_mutex_lock(&timer_mtx);
+    if (!timer->dead && rq_submit(timer_task_wrapper, timer) == 0)
+        timer->firing++;
+    pthread_mutex_unlock(&timer_mtx);
 }
 
 int __os_timer_create(os_timer_t *timer, 
@@ -58,7 +345,9 @@ int __os_timer_create(os_timer_t *timer,
             return err;
         }
     }
+    pthread_mutex_lock(&timer_mtx);
     p = os_obj_allocate(&timer_robj);
+    pthread_mutex_unlock(&timer_mtx);
     if (!p) {
         pr_err("Allocate timer object failed\n");
         return -ENOMEM;
@@ -106,11 +395,36 @@ int __os_timer_del(os_timer_t timer) {
     os_timer_mod(timer, 0);
     return 0;
 }
+#endif /* CONFIG_OS_TIMER_SERVICE */
+
+unsigned int __os_timer_gettime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned int)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+#ifdef CONFIG_BASEWORK_RQ_STATS
+uint32_t _rq_timestamp_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+#endif
 
 int __os_timer_destroy(os_timer_t timer) {
     assert(timer != NULL);
     struct os_timer *p = timer;
+#ifdef CONFIG_OS_TIMER_SERVICE
+    pthread_mutex_lock(&timer_mtx);
+    if (p->index >= 0)
+        timer_heap_remove_locked(p);
+    timer_release_locked(p);
+    pthread_mutex_unlock(&timer_mtx);
+#else
     timer_delete(p->id);
-    os_obj_free(&timer_robj, p);
+    pthread_mutex_lock(&timer_mtx);
+    timer_release_locked(p);
+    pthread_mutex_unlock(&timer_mtx);
+#endif
     return 0;
 }
@@ -26,25 +26,33 @@ static uint32_t old_timestamp __rte_section(".ram.noinit");
 static int rq_curr_priority __rte_section(".ram.noinit");
 
 static void _rq_param_update(struct rq_context *rq) {
-    if (unlikely(rq->nr > RQ_HIGH_CRITICAL)) {
+    size_t nr = _rq_get_nodes(rq);
+
+    if (unlikely(nr > RQ_HIGH_CRITICAL)) {
         if (rq_curr_priority != RQ_HIGHEST_PRIORITY) {
             k_thread_priority_set(k_current_get(), RQ_HIGHEST_PRIORITY);
             rq_curr_priority = RQ_HIGHEST_PRIORITY;
         }
         pr_dbg("RunQueue task priority boost to %d (QueuedCount: %d)\n", 
-            rq_curr_priority, rq->nr);
+            rq_curr_priority, (int)nr);
         return;
     }
     if (rq_curr_priority != CONFIG_BASEWORK_RQ_PRIORITY) {
-        if (rq->nr < RQ_LOW_CRITICAL) {
+        if (nr < RQ_LOW_CRITICAL) {
             k_thread_priority_set(k_current_get(), CONFIG_BASEWORK_RQ_PRIORITY);
             rq_curr_priority = CONFIG_BASEWORK_RQ_PRIORITY;
         }
         pr_dbg("RunQueue task priority restore to %d (QueuedCount: %d)\n", 
-            rq_curr_priority, rq->nr);
+            rq_curr_priority, (int)nr);
     }
 }
 
+#ifdef CONFIG_BASEWORK_RQ_STATS
+uint32_t _rq_timestamp_us(void) {
+    return k_cyc_to_us_near32(k_cycle_get_32());
+}
+#endif
+
 void _rq_execute_prepare(struct rq_context *rq) {
     _rq_param_update(rq);
     sys_wake_lock_ext(PARTIAL_WAKE_LOCK, 
@@ -1,10 +1,12 @@
 /*
  * Copyright 2023 wtcat
  */
+#include <stdlib.h>
 #include <shell/shell.h>
 
 #include "basework/dev/partition.h"
 #include "basework/system.h"
+#include "basework/log.h"
 
 static int __rte_notrace shell_filesystem_format(const struct shell *shell,
     size_t argc, char **argv) {
@@ -23,8 +25,29 @@ static int __rte_notrace shell_filesystem_format(const struct shell *shell,
     return -EIO;
 }
 
+static bool shell_loglevel_show(const struct log_module *mod, void *arg) {
+    const struct shell *shell = (const struct shell *)arg;
+    shell_print(shell, "%-16s %d", mod->name, mod->level);
+    return true;
+}
+
+static int __rte_notrace shell_loglevel(const struct shell *shell,
+    size_t argc, char **argv) {
+    if (argc == 1) {
+        log_module_foreach(shell_loglevel_show, (void *)shell);
+        return 0;
+    }
+    if (argc == 2)
+        return log_module_parse(argv[1]);
+    if (argc == 3)
+        return log_module_set_level(argv[1], (int)strtol(argv[2], NULL, 10));
+    return -EINVAL;
+}
+
 SHELL_STATIC_SUBCMD_SET_CREATE(cmd_list,
     SHELL_CMD(format, NULL, "filesystem format" , shell_filesystem_format),
+    SHELL_CMD(loglevel, NULL, "loglevel [module|*] [level] | [mod=level,...]",
+        shell_loglevel),
     SHELL_SUBCMD_SET_END
 );
 
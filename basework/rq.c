@@ -5,8 +5,10 @@
  */
 #include "basework/os/osapi.h"
 #define pr_fmt(fmt) "<rq>: "fmt
+#define LOG_MODULE_NAME rq
 
 #include <errno.h>
+#include <stdio.h>
 #include <ctype.h>
 #include <assert.h>
 #include <string.h>
@@ -18,6 +20,8 @@
 #include "basework/malloc.h"
 #include "basework/log.h"
 
+LOG_MODULE_DEFINE(rq, LOGLEVEL_INFO);
+
 struct iter_param {
     int idx;
 };
@@ -34,15 +38,15 @@ do { \
     os_panic(); \
 } while (0)
 
-#define BUFFER_HDR_SIZE(sz) ((sz) + sizeof(struct buffer_hdr))
-
-struct buffer_hdr {
-    struct rq_context *rq;
-    void (*cb)(void *arg, size_t);
-    size_t len;
-    char data[];
-};
+#define BUFFER_HDR_SIZE(sz) ((sz) + sizeof(struct rq_buffer_hdr))
 
+#ifdef CONFIG_BASEWORK_RQ_STATS
+#define RQ_STAMP(_rn)     (_rn)->stamp = _rq_timestamp_us()
+#define RQ_STAMP_GET(_rn) (_rn)->stamp
+#else
+#define RQ_STAMP(_rn)     (void)(_rn)
+#define RQ_STAMP_GET(_rn) 0
+#endif
 
 os_critical_global_declare
 struct rq_context *_system_rq;
@@ -55,6 +59,84 @@ void RTE_WEAKHOOK(_rq_execute_post, struct rq_context *rq) {
     (void) rq;
 }
 
+#ifdef CONFIG_BASEWORK_RQ_STATS
+uint32_t RTE_WEAKHOOK(_rq_timestamp_us, void) {
+    return (uint32_t)os_timer_gettime() * 1000;
+}
+
+static inline void rq_hist_add(struct rq_hist *h, uint32_t us) {
+    int idx = us? 32 - __builtin_clz(us): 0;
+    if (idx >= RQ_HIST_BUCKETS)
+        idx = RQ_HIST_BUCKETS - 1;
+    h->bucket[idx]++;
+    if (us > h->max_us)
+        h->max_us = us;
+}
+
+static void rq_stats_exec(struct rq_stats *st, rq_exec_t fn, uint32_t us) {
+    const size_t n = CONFIG_BASEWORK_RQ_STATS_FNS;
+    size_t idx = ((uintptr_t)fn >> 2) % n;
+
+    for (size_t i = 0; i < n; i++) {
+        struct rq_fn_stats *fs = &st->fns[idx];
+        if (fs->fn == NULL) {
+            fs->fn = fn;
+            st->nfns++;
+        }
+        if (fs->fn == fn) {
+            fs->count++;
+            fs->total_us += us;
+            rq_hist_add(&fs->exec, us);
+            return;
+        }
+        idx = (idx + 1) % n;
+    }
+    st->overflow++;
+}
+
+static void __rte_notrace rq_hist_dump(const char *name, struct rq_hist *h) {
+    char buf[256];
+    int len = 0;
+
+    for (int i = 0; i < RQ_HIST_BUCKETS; i++) {
+        if (!h->bucket[i])
+            continue;
+        len += snprintf(buf + len, sizeof(buf) - len, " <%uus:%u",
+            i? (1u << i): 1u, (unsigned)h->bucket[i]);
+        if (len >= (int)sizeof(buf))
+            break;
+    }
+    buf[sizeof(buf) - 1] = '\0';
+    pr_notice("%s max(%uus):%s\n", name, (unsigned)h->max_us, len? buf: " none");
+}
+
+static void __rte_notrace rq_stats_dump(struct rq_stats *st) {
+    pr_notice("queue depth high-water mark: %u\n", st->nr_max);
+    rq_hist_dump("latency", &st->latency);
+    for (int i = 0; i < CONFIG_BASEWORK_RQ_STATS_FNS; i++) {
+        struct rq_fn_stats *fs = &st->fns[i];
+        char name[32];
+
+        if (!fs->fn)
+            continue;
+        snprintf(name, sizeof(name), "exec<%p>", fs->fn);
+        pr_notice("%s count(%u) avg(%uus)\n", name, (unsigned)fs->count, 
+            (unsigned)(fs->total_us / fs->count));
+        rq_hist_dump(name, &fs->exec);
+    }
+    if (st->overflow)
+        pr_notice("untracked executions: %u\n", (unsigned)st->overflow);
+}
+
+void _rq_stats_reset(struct rq_context *rq) {
+    os_critical_declare
+
+    os_critical_lock
+    memset(&rq->stats, 0, sizeof(rq->stats));
+    os_critical_unlock
+}
+#endif /* CONFIG_BASEWORK_RQ_STATS */
+
 static void _rq_dump_iterator(struct rq_node *n, void *arg) {
     struct iter_param *param = arg;
 #ifdef USE_RQ_DEBUG
@@ -74,38 +156,69 @@ static void _rq_dump_iterator(struct rq_node *n, void *arg) {
 }
 
 static void exec_adaptor_cb(void *arg) {
-    struct buffer_hdr *bh = (struct buffer_hdr *)arg;
+    struct rq_buffer_hdr *bh = (struct rq_buffer_hdr *)arg;
     _rq_set_executing(bh->rq, bh->cb);
     bh->cb(bh->data, bh->len);
     pr_dbg("free buffer: %p\n", bh);
     general_free(bh);
 }
 
+static void exec_inline_cb(void *arg) {
+    struct rq_buffer_hdr *bh = (struct rq_buffer_hdr *)arg;
+    _rq_set_executing(bh->rq, bh->cb);
+    bh->cb(bh->data, bh->len);
+}
+
+static inline void rq_buffer_fill(struct rq_buffer_hdr *bh, struct rq_context *rq,
+    void (*exec)(void *, size_t), void *data, size_t size) {
+    memcpy(bh->data, data, size);
+    bh->rq = rq;
+    bh->cb = exec;
+    bh->len = size;
+}
+
+static void rq_lf_init(struct rq_lfq *lfq) {
+    lfring_init(&lfq->submit, lfq->submit.slots, lfq->nq);
+    lfring_init(&lfq->frees, lfq->frees.slots, lfq->nq);
+    for (int i = 0; i < lfq->nq; i++)
+        lfring_enqueue(&lfq->frees, &lfq->nodes[i]);
+    lfq->sleeping = 0;
+}
+
 void _rq_static_init(struct rq_context *rq) {
     struct rq_node *p = (struct rq_node *)rq->buffer;
+    size_t nsize = RQ_NODE_SIZE(rq->isize);
 
     RTE_INIT_LIST(&rq->frees);
     RTE_INIT_LIST(&rq->pending);
     os_completion_reinit(rq->completion);
     for (int i = 0; i < rq->nq; i++) {
         rte_list_add_tail(&p->node, &rq->frees);
-        p = (struct rq_node *)((char *)p + sizeof(struct rq_node));
+        p = (struct rq_node *)((char *)p + nsize);
     }
+    if (rq->lfq)
+        rq_lf_init(rq->lfq);
 }
 
-int _rq_init(struct rq_context *rq, void *buffer, size_t size) {
-    if (!rq || !buffer || ((uintptr_t)buffer & 3))
+int _rq_init_inline(struct rq_context *rq, void *buffer, size_t size, 
+    size_t isize) {
+    if (!rq || !buffer || ((uintptr_t)buffer & (sizeof(void *) - 1)))
         return -EINVAL;
 
-    if (size < sizeof(struct rq_node))
+    if (isize > UINT16_MAX || size < RQ_NODE_SIZE(isize))
         return -EINVAL;
 
-    rq->nq = (uint16_t)(size / sizeof(struct rq_node));
+    rq->isize = (uint16_t)isize;
+    rq->nq = (uint16_t)(size / RQ_NODE_SIZE(isize));
     rq->buffer = buffer;
     _rq_static_init(rq);
     return 0;
 }
 
+int _rq_init(struct rq_context *rq, void *buffer, size_t size) {
+    return _rq_init_inline(rq, buffer, size, 0);
+}
+
 static inline void rq_put_locked(struct rq_context *rq, 
     struct rq_node *rn) {
     rte_list_add(&rn->node, &rq->frees);
@@ -133,6 +246,11 @@ static void rq_add_node_locked(struct rq_context *rq, struct rq_node *rn,
     else
         rte_list_add_tail(&rn->node, &rq->pending);
     rq->nr++;
+    RQ_STAMP(rn);
+#ifdef CONFIG_BASEWORK_RQ_STATS
+    if (rq->nr > rq->stats.nr_max)
+        rq->stats.nr_max = rq->nr;
+#endif
     /* We will wake up the schedule queue if necessary */
     if (need_wakeup)
         os_completed(rq->completion);
@@ -148,20 +266,25 @@ int _rq_submit_with_copy(struct rq_context *rq, void (*exec)(void *, size_t),
     assert(rq != NULL);
     assert(exec != NULL);
     os_critical_declare
-    struct buffer_hdr *bh;
+    struct rq_buffer_hdr *bh = NULL;
     struct rq_node *rn;
+    bool inlined;
 
-    pr_dbg("allocate %d bytes\n", BUFFER_HDR_SIZE(size));
-    bh = general_malloc(BUFFER_HDR_SIZE(size));
-    if (rte_unlikely(!bh)) {
-        RQ_PANIC(rq, "*** no more memory! ***");
-        return -ENOMEM;
+    /* 
+     * Only the oversized payload need to be allocated from heap. The small 
+     * payload will be copied into the inline area of rq-node
+     */
+    inlined = size <= rq->isize;
+    if (!inlined) {
+        pr_dbg("allocate %d bytes\n", BUFFER_HDR_SIZE(size));
+        bh = general_malloc(BUFFER_HDR_SIZE(size));
+        if (rte_unlikely(!bh)) {
+            RQ_PANIC(rq, "*** no more memory! ***");
+            return -ENOMEM;
+        }
+        pr_dbg("allocated buffer: %p\n", bh);
+        rq_buffer_fill(bh, rq, exec, data, size);
     }
-    pr_dbg("allocated buffer: %p\n", bh);
-    memcpy(bh->data, data, size);
-    bh->rq = rq;
-    bh->cb = exec;
-    bh->len = size;
 
     os_critical_lock
 
@@ -169,12 +292,19 @@ int _rq_submit_with_copy(struct rq_context *rq, void (*exec)(void *, size_t),
     rn = rq_get_first_locked(&rq->frees);
     if (rte_unlikely(!rn)) {
         os_critical_unlock
-        general_free(bh);
+        if (bh)
+            general_free(bh);
         RQ_PANIC(rq, "*** rq-scheduler queue is full! ***");
         return -EBUSY;
     }
 
-    rn->exec = exec_adaptor_cb;
+    if (inlined) {
+        bh = RQ_NODE_PAYLOAD(rn);
+        rq_buffer_fill(bh, rq, exec, data, size);
+        rn->exec = exec_inline_cb;
+    } else {
+        rn->exec = exec_adaptor_cb;
+    }
     rn->arg = bh;
     rn->refp = NULL;
     rn->dofree = true;
@@ -278,6 +408,49 @@ int _rq_submit_ext(struct rq_context *rq, void (*exec)(void *), void *arg,
     return 0;
 }
 
+int _rq_submit_lf(struct rq_context *rq, void (*exec)(void *), void *arg) {
+    assert(rq != NULL);
+    assert(exec != NULL);
+    struct rq_lfq *lfq = rq->lfq;
+    struct rq_node *rn;
+
+    if (rte_unlikely(!lfq)) {
+#ifdef USE_RQ_DEBUG
+        return _rq_submit(rq, exec, arg, false, (const void *)exec);
+#else
+        return _rq_submit(rq, exec, arg, false);
+#endif
+    }
+
+    /* Allocate a new rq-node from free ring */
+    rn = lfring_dequeue(&lfq->frees);
+    if (rte_unlikely(!rn))
+        return -EBUSY;
+
+    rn->exec = exec;
+    rn->arg = arg;
+    rn->refp = NULL;
+    rn->dofree = true;
+    RQ_STAMP(rn);
+#ifdef USE_RQ_DEBUG
+    rn->pfn = (const void *)exec;
+#endif
+
+    /* 
+     * The submit ring has the same capacity as the free ring, So this 
+     * never fails 
+     */
+    lfring_enqueue(&lfq->submit, rn);
+
+    /* Wake up the run-queue thread if it is sleeping */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&lfq->sleeping, __ATOMIC_RELAXED) &&
+        __atomic_exchange_n(&lfq->sleeping, 0, __ATOMIC_ACQ_REL))
+        os_completed(rq->completion);
+
+    return 0;
+}
+
 void _rq_node_delete(struct rq_context *rq, struct rq_node *pnode) {
     os_critical_declare
 
@@ -293,16 +466,78 @@ void _rq_node_delete(struct rq_context *rq, struct rq_node *pnode) {
     pr_dbg("_rq_node_delete: %p caller(%p)\n", pnode, __builtin_return_address(0));
 }
 
+static inline void rq_execute(struct rq_context *rq, rq_exec_t fn, void *arg,
+    uint32_t stamp) {
+#ifdef CONFIG_BASEWORK_RQ_STATS
+    uint32_t start = _rq_timestamp_us();
+    rq_hist_add(&rq->stats.latency, start - stamp);
+#else
+    (void) stamp;
+#endif
+    _rq_execute_prepare(rq);
+    _rq_set_executing(rq, fn);
+    fn(arg);
+#ifdef CONFIG_BASEWORK_RQ_STATS
+    /* The by-value adaptor replaces the executing function with user's */
+    rq_stats_exec(&rq->stats, (rq_exec_t)_rq_current_executing(rq), 
+        _rq_timestamp_us() - start);
+#endif
+    _rq_execute_post(rq);
+    _rq_set_executing(rq, NULL);
+}
+
+/*
+ * Execute a batch of work that submitted through lock-free queue
+ */
+static void rq_lf_schedule(struct rq_context *rq) {
+    struct rq_lfq *lfq = rq->lfq;
+    void *batch[RQ_LF_BATCH];
+    unsigned int n;
+
+    n = lfring_dequeue_burst(&lfq->submit, batch, RQ_LF_BATCH);
+    for (unsigned int i = 0; i < n; i++) {
+        struct rq_node *rn = batch[i];
+        rq_exec_t fn = rn->exec;
+        void *arg = rn->arg;
+        uint32_t stamp = RQ_STAMP_GET(rn);
+
+        lfring_enqueue(&lfq->frees, rn);
+        rq_execute(rq, fn, arg, stamp);
+    }
+}
+
+static void rq_wait(struct rq_context *rq) {
+    struct rq_lfq *lfq = rq->lfq;
+
+    if (lfq) {
+        __atomic_store_n(&lfq->sleeping, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!lfring_empty(&lfq->submit)) {
+            __atomic_store_n(&lfq->sleeping, 0, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    os_completion_wait(rq->completion);
+}
+
 void _rq_schedule(struct rq_context *rq) {
     os_critical_declare
     struct rq_node *rn;
     rq_exec_t fn;
     void *arg;
+    uint32_t stamp;
     bool dofree;
 
     os_critical_lock
 
     for ( ; ; ) {
+        /* Drain a batch from lock-free queue */
+        if (rq->lfq && !lfring_empty(&rq->lfq->submit)) {
+            os_critical_unlock
+            rq_lf_schedule(rq);
+            os_critical_lock
+        }
+
         /* Get the first rq-node from pending list */
         rn = rq_get_first_locked(&rq->pending);
         if (rte_unlikely(!rn)) {
@@ -311,7 +546,7 @@ void _rq_schedule(struct rq_context *rq) {
              * Now, The queue is empty and we have no more work to do, So we
              * trigger task schedule and switch to other task.
              */
-            os_completion_wait(rq->completion);
+            rq_wait(rq);
             os_critical_lock
             continue;
         }
@@ -322,18 +557,15 @@ void _rq_schedule(struct rq_context *rq) {
         }
         fn = rn->exec;
         arg = rn->arg;
+        stamp = RQ_STAMP_GET(rn);
         dofree = rn->dofree;
         os_critical_unlock
 
         /* Executing user function */ 
-        _rq_execute_prepare(rq);
-        _rq_set_executing(rq, fn);
-        fn(arg);
-        _rq_execute_post(rq);
-        _rq_set_executing(rq, NULL);
+        rq_execute(rq, fn, arg, stamp);
 
         os_critical_lock
-   
+
         /* Free rn-node to free list */
         if (rte_likely(dofree))
             rq_put_locked(rq, rn);
@@ -407,5 +639,10 @@ void __rte_notrace _rq_visitor(struct rq_context *rq,
 void __rte_notrace _rq_dump(struct rq_context *rq) {
     struct iter_param __param = {0};
     pr_err("rq_executing(%p)\n", rq->fn_executing);
+    if (rq->lfq)
+        pr_err("lock-free queued(%u)\n", lfring_count(&rq->lfq->submit));
+#ifdef CONFIG_BASEWORK_RQ_STATS
+    rq_stats_dump(&rq->stats);
+#endif
     _rq_visitor(rq, _rq_dump_iterator, &__param);
 }
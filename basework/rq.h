@@ -6,6 +6,7 @@
 
 #include "basework/os/osapi.h"
 #include "basework/container/list.h"
+#include "basework/container/lfring.h"
 
 #ifdef __cplusplus
 extern "C"{
@@ -15,6 +16,40 @@ extern "C"{
 
 typedef void (*rq_exec_t)(void *);
 
+struct rq_lfq;
+
+#ifdef CONFIG_BASEWORK_RQ_STATS
+#ifndef CONFIG_BASEWORK_RQ_STATS_FNS
+#define CONFIG_BASEWORK_RQ_STATS_FNS 16
+#endif
+
+/*
+ * Histogram with log2 buckets in microseconds. (bucket[0]: 0us, 
+ * bucket[n]: [2^(n-1), 2^n)us, the last bucket holds all the rest)
+ */
+#define RQ_HIST_BUCKETS 16
+
+struct rq_hist {
+    uint32_t bucket[RQ_HIST_BUCKETS];
+    uint32_t max_us;
+};
+
+struct rq_fn_stats {
+    rq_exec_t fn;      /* NULL: the functions that overflow the table */
+    uint32_t count;
+    uint64_t total_us;
+    struct rq_hist exec;
+};
+
+struct rq_stats {
+    uint16_t nr_max;   /* Queue-depth high-water mark */
+    uint16_t nfns;
+    uint32_t overflow; /* Executions that not tracked by function */
+    struct rq_hist latency; /* Enqueue to start */
+    struct rq_fn_stats fns[CONFIG_BASEWORK_RQ_STATS_FNS];
+};
+#endif /* CONFIG_BASEWORK_RQ_STATS */
+
 struct rq_context {
     struct rte_list frees;   /* Free list */
     struct rte_list pending; /* Pending list */
@@ -23,7 +58,12 @@ struct rq_context {
     rq_exec_t fn_executing;
     uint16_t nq;
     uint16_t nr; /* queued count */
+    uint16_t isize; /* Inline payload size of each node */
     os_thread_t thread;
+    struct rq_lfq *lfq; /* Lock-free submission queue (optional) */
+#ifdef CONFIG_BASEWORK_RQ_STATS
+    struct rq_stats stats;
+#endif
 };
 
 struct rq_node {
@@ -31,6 +71,9 @@ struct rq_node {
     rq_exec_t exec; /* User function */
     void *arg;
     void **refp;
+#ifdef CONFIG_BASEWORK_RQ_STATS
+    uint32_t stamp; /* Enqueue timestamp (microseconds) */
+#endif
 #ifdef USE_RQ_DEBUG
 	union {
 		const char *name;
@@ -38,13 +81,57 @@ struct rq_node {
 	};
 #endif
     bool dofree;
+    uint8_t owner; /* Worker that queued the node (rq_pool only) */
+};
+
+/*
+ * Lock-free submission queue. The nodes are taken from an atomic free ring 
+ * and pushed into a multi-producer ring that is drained in batches by the 
+ * run-queue thread, so the submitter never take the critical lock.
+ */
+struct rq_lfq {
+    struct lfring submit; /* Submitted nodes */
+    struct lfring frees;  /* Free nodes */
+    struct rq_node *nodes;
+    uint16_t nq;
+    int sleeping;         /* The run-queue thread is waiting for work */
 };
 
-#define RQ_BUFFER_SIZE(_nitem, _itemsize) \
-    ((_nitem) * rte_roundup(sizeof(struct rq_node) + (_itemsize), 4))
+#define RQ_LF_BATCH 16
 
-#define RQ_BUFFER_DEFINE(_name, _nitem, _attr) \
-    char _name[RQ_BUFFER_SIZE(_nitem, sizeof(struct rq_node))] __rte_aligned(4) _attr; \
+/*
+ * The header of by-value payload (rq_submit_cp). It is placed in the
+ * inline area of rq_node if the payload is small enough, otherwise it
+ * will be allocated from heap.
+ */
+struct rq_buffer_hdr {
+    struct rq_context *rq;
+    void (*cb)(void *arg, size_t);
+    size_t len;
+    char data[];
+};
+
+/*
+ * The default inline payload size of each node, it is the size of
+ * struct call_param (8 pointers). Kconfig selects it with 0
+ */
+#if !defined(CONFIG_BASEWORK_RQ_INLINE_SIZE) || (CONFIG_BASEWORK_RQ_INLINE_SIZE == 0)
+#undef CONFIG_BASEWORK_RQ_INLINE_SIZE
+#define CONFIG_BASEWORK_RQ_INLINE_SIZE (8 * sizeof(void *))
+#endif
+
+#define RQ_NODE_SIZE(_isize) \
+    rte_roundup(sizeof(struct rq_node) + \
+        ((_isize)? sizeof(struct rq_buffer_hdr) + (_isize): 0), sizeof(void *))
+
+#define RQ_NODE_PAYLOAD(_rn) \
+    ((struct rq_buffer_hdr *)((struct rq_node *)(_rn) + 1))
+
+#define RQ_BUFFER_SIZE(_nitem, _isize) \
+    ((_nitem) * RQ_NODE_SIZE(_isize))
+
+#define RQ_BUFFER_DEFINE(_name, _nitem, _isize, _attr) \
+    char _name[RQ_BUFFER_SIZE(_nitem, _isize)] __rte_aligned(sizeof(void *)) _attr; \
 
 #define RQ_NODE_DEFINE(_name, _fn, _arg) \
     struct rq_node _name = {\
@@ -53,20 +140,58 @@ struct rq_node {
     }
 
 /*
- * RQ_DEFINE - Define a runqueue context
+ * RQ_DEFINE_INLINE - Define a runqueue context with inline payload area
  *
  * @_name: Object name
  * @_nitem: The maximum length of queue
- * @_itemsize: The maximum size of queue-item
+ * @_isize: The inline payload size of each node (0: always use heap)
  * @_attr: variable attribute
  */
-#define RQ_DEFINE(_name, _nitem, _attr) \
-    static RQ_BUFFER_DEFINE(_name ## _buffer, _nitem, _attr); \
+#define RQ_DEFINE_INLINE(_name, _nitem, _isize, _attr) \
+    static RQ_BUFFER_DEFINE(_name ## _buffer, _nitem, _isize, _attr); \
     struct rq_context _name __rte_used _attr = {    \
         .buffer = _name ## _buffer,   \
         .nq = _nitem,  \
+        .isize = _isize, \
     }
 
+/*
+ * RQ_DEFINE_LOCKFREE - Define a runqueue context with lock-free submission queue
+ *
+ * @_name: Object name
+ * @_nitem: The maximum length of queue
+ * @_nlf: The maximum length of lock-free queue (must be power of 2)
+ * @_attr: variable attribute
+ */
+#define RQ_DEFINE_LOCKFREE(_name, _nitem, _nlf, _attr) \
+    static RQ_BUFFER_DEFINE(_name ## _buffer, _nitem, \
+        CONFIG_BASEWORK_RQ_INLINE_SIZE, _attr); \
+    static LFRING_SLOTS_DEFINE(_name ## _lf_submit, _nlf, _attr); \
+    static LFRING_SLOTS_DEFINE(_name ## _lf_frees, _nlf, _attr); \
+    static struct rq_node _name ## _lf_nodes[_nlf] _attr; \
+    static struct rq_lfq _name ## _lfq _attr = { \
+        .submit = {.slots = _name ## _lf_submit}, \
+        .frees = {.slots = _name ## _lf_frees}, \
+        .nodes = _name ## _lf_nodes, \
+        .nq = _nlf, \
+    }; \
+    struct rq_context _name __rte_used _attr = {    \
+        .buffer = _name ## _buffer,   \
+        .nq = _nitem,  \
+        .isize = CONFIG_BASEWORK_RQ_INLINE_SIZE, \
+        .lfq = &_name ## _lfq, \
+    }
+
+/*
+ * RQ_DEFINE - Define a runqueue context
+ *
+ * @_name: Object name
+ * @_nitem: The maximum length of queue
+ * @_attr: variable attribute
+ */
+#define RQ_DEFINE(_name, _nitem, _attr) \
+    RQ_DEFINE_INLINE(_name, _nitem, CONFIG_BASEWORK_RQ_INLINE_SIZE, _attr)
+
 extern struct rq_context *_system_rq;
 
 /*
@@ -85,6 +210,18 @@ void _rq_static_init(struct rq_context *rq);
  * return 0 if success
  */
 int _rq_init(struct rq_context *rq, void *buffer, size_t size);
+
+/*
+ * _rq_init_inline - Initialze run-queue context with inline payload area
+ *
+ * @rq: Run-queue context
+ * @buffer: Queue buffer
+ * @size: The size of queue buffer
+ * @isize: The inline payload size of each node (see RQ_NODE_SIZE())
+ * return 0 if success
+ */
+int _rq_init_inline(struct rq_context *rq, void *buffer, size_t size, 
+    size_t isize);
     
 /*
  * _rq_node_delete - Delete runq node (just only for timer component)
@@ -140,7 +277,8 @@ int _rq_submit_ext(struct rq_context *rq, void (*exec)(void *), void *arg,
 #endif
 
 /*
- * _rq_submit_with_copy - Submit a work and copy buffer
+ * _rq_submit_with_copy - Submit a work and copy buffer. The buffer is copied 
+ * into the inline area of node if it fits, otherwise it is allocated from heap
  *
  * @rq: Run-queue context
  * @exec: user function
@@ -158,6 +296,18 @@ int _rq_submit_with_copy(struct rq_context *rq, void (*exec)(void *, size_t),
 #endif
 
 
+/*
+ * _rq_submit_lf - Submit a user-work through the lock-free queue. It is safe 
+ * to be called from interrupt context. The work is always appended and can 
+ * not be canceled. (Fallback to _rq_submit() if the queue has no lock-free queue)
+ *
+ * @rq: Run-queue context
+ * @exec: user function
+ * @data: user parameter
+ * return 0 if success
+ */
+int _rq_submit_lf(struct rq_context *rq, void (*exec)(void *), void *arg);
+
 /*
  * _rq_schedule - Schedule run-queue (Asynchronous execute user function).
  * This should be called in a task context
@@ -211,6 +361,15 @@ void _rq_visitor(struct rq_context *rq,
  */
 void _rq_dump(struct rq_context *rq);
 
+#ifdef CONFIG_BASEWORK_RQ_STATS
+/*
+ * _rq_stats_reset - Clear the statistics of run-queue
+ *
+ * @rq: run queue context
+ */
+void _rq_stats_reset(struct rq_context *rq);
+#endif
+
 /*
  * Default run-queue public interface
  */
@@ -274,6 +433,9 @@ static inline int rq_init(struct rq_context *rq) {
 
 #endif /* USE_RQ_DEBUG */
 
+#define rq_submit_lf(_exec, _data) \
+    _rq_submit_lf(_system_rq, _exec, _data)
+
 #define rq_submit_entry(_rn) \
     _rq_submit_entry(_system_rq, _rn, false)
 #define rq_submit_entry_urgent(_rn) \
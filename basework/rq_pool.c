@@ -0,0 +1,345 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Multi-worker run-queue. Each worker owns a local queue and steals the
+ * shared work from other workers when it is idle. The work that pinned to
+ * a worker is never stolen, so it keeps the submission order.
+ *
+ * Each worker has its own lock for the local and pinned queues and the free
+ * list has another one, The locks are never nested. The idle bitmap and the
+ * counters are updated with atomic operations.
+ */
+#include "basework/os/osapi.h"
+#define pr_fmt(fmt) "<rq_pool>: "fmt
+
+#include <errno.h>
+#include <assert.h>
+#include <string.h>
+
+#include "basework/rq_pool.h"
+#include "basework/bitops.h"
+#include "basework/container/list.h"
+#include "basework/log.h"
+
+os_objlock_global_declare
+
+#define RQ_WORKER_BIT(_w) (1u << (_w)->id)
+
+static struct rq_node *rq_get_first_locked(struct rte_list *head) {
+    if (!rte_list_empty(head)) {
+        struct rq_node *rn = rte_container_of(head->next, struct rq_node, node);
+        rte_list_del(&rn->node);
+        return rn;
+    }
+    return NULL;
+}
+
+static struct rq_node *rq_get_last_locked(struct rte_list *head) {
+    if (!rte_list_empty(head)) {
+        struct rq_node *rn = rte_container_of(head->prev, struct rq_node, node);
+        rte_list_del(&rn->node);
+        return rn;
+    }
+    return NULL;
+}
+
+static struct rq_node *rq_pool_get_free(struct rq_pool *pool) {
+    os_critical_declare
+    struct rq_node *rn;
+
+    os_objlock_lock(pool->lock)
+    rn = rq_get_first_locked(&pool->frees);
+    os_objlock_unlock(pool->lock)
+    return rn;
+}
+
+static void rq_pool_put_free(struct rq_pool *pool, struct rq_node *rn) {
+    os_critical_declare
+
+    os_objlock_lock(pool->lock)
+    rte_list_add(&rn->node, &pool->frees);
+    os_objlock_unlock(pool->lock)
+}
+
+/*
+ * Only the one that clears the idle bit posts the completion, So the
+ * worker is waked up once for each sleep.
+ */
+static inline void rq_worker_wakeup(struct rq_pool *pool,
+    struct rq_worker *w) {
+    uint32_t bit = RQ_WORKER_BIT(w);
+    if (__atomic_fetch_and(&pool->idle, ~bit, __ATOMIC_SEQ_CST) & bit)
+        os_completed(w->completion);
+}
+
+/*
+ * The node must be removed with the lock of worker that holds it
+ */
+static inline void rq_node_detach_locked(struct rq_node *rn) {
+    if (rn->refp) {
+        *rn->refp = NULL;
+        rn->refp = NULL;
+    }
+}
+
+/*
+ * Steal the newest shared work from other workers
+ */
+static struct rq_node *rq_pool_steal(struct rq_pool *pool,
+    struct rq_worker *self) {
+    os_critical_declare
+    struct rq_node *rn;
+
+    for (uint16_t i = 1; i < pool->nworkers; i++) {
+        struct rq_worker *victim = &pool->workers[(self->id + i) % pool->nworkers];
+        os_objlock_lock(victim->lock)
+        rn = rq_get_last_locked(&victim->local);
+        if (rn)
+            rq_node_detach_locked(rn);
+        os_objlock_unlock(victim->lock)
+        if (rn) {
+            pr_dbg("worker%d steal work(%p) from worker%d\n",
+                self->id, rn->exec, victim->id);
+            return rn;
+        }
+    }
+    return NULL;
+}
+
+static struct rq_node *rq_worker_next(struct rq_worker *w) {
+    os_critical_declare
+    struct rq_node *rn;
+
+    os_objlock_lock(w->lock)
+    rn = rq_get_first_locked(&w->pinned);
+    if (!rn)
+        rn = rq_get_first_locked(&w->local);
+    if (rn)
+        rq_node_detach_locked(rn);
+    os_objlock_unlock(w->lock)
+    if (!rn)
+        rn = rq_pool_steal(w->pool, w);
+    return rn;
+}
+
+void _rq_pool_static_init(struct rq_pool *pool) {
+    struct rq_node *p = (struct rq_node *)pool->buffer;
+    size_t nsize = RQ_NODE_SIZE(0);
+
+    assert(pool->nworkers > 0 && pool->nworkers <= RQ_POOL_MAX_WORKERS);
+    RTE_INIT_LIST(&pool->frees);
+    os_objlock_init(pool->lock);
+    for (int i = 0; i < pool->nq; i++) {
+        rte_list_add_tail(&p->node, &pool->frees);
+        p = (struct rq_node *)((char *)p + nsize);
+    }
+    for (uint16_t i = 0; i < pool->nworkers; i++) {
+        struct rq_worker *w = &pool->workers[i];
+        RTE_INIT_LIST(&w->local);
+        RTE_INIT_LIST(&w->pinned);
+        os_completion_reinit(w->completion);
+        os_objlock_init(w->lock);
+        w->pool = pool;
+        w->fn_executing = NULL;
+        w->id = i;
+    }
+    pool->idle = 0;
+    pool->nr = 0;
+    pool->next = 0;
+}
+
+int _rq_pool_init(struct rq_pool *pool, struct rq_worker *workers,
+    size_t nworkers, void *buffer, size_t size) {
+    if (!pool || !workers || !buffer || ((uintptr_t)buffer & (sizeof(void *) - 1)))
+        return -EINVAL;
+
+    if (!nworkers || nworkers > RQ_POOL_MAX_WORKERS)
+        return -EINVAL;
+
+    if (size < RQ_NODE_SIZE(0))
+        return -EINVAL;
+
+    pool->workers = workers;
+    pool->nworkers = (uint16_t)nworkers;
+    pool->nq = (uint16_t)(size / RQ_NODE_SIZE(0));
+    pool->buffer = buffer;
+    _rq_pool_static_init(pool);
+    return 0;
+}
+
+int _rq_pool_submit_to(struct rq_pool *pool, int worker, void (*exec)(void *),
+    void *arg, bool prepend, void **pnode) {
+    assert(pool != NULL);
+    assert(exec != NULL);
+    os_critical_declare
+    struct rq_worker *w;
+    struct rte_list *head;
+    struct rq_node *rn;
+    uint32_t idle;
+
+    if (worker >= (int)pool->nworkers)
+        return -EINVAL;
+
+    /* Allocate a new rq-node from free list */
+    rn = rq_pool_get_free(pool);
+    if (rte_unlikely(!rn)) {
+        pr_err("*** rq-pool queue is full! caller(%p) ***\n",
+            __builtin_return_address(0));
+        return -EBUSY;
+    }
+
+    rn->exec = exec;
+    rn->arg = arg;
+    rn->dofree = true;
+    rn->refp = pnode;
+
+    if (worker == RQ_POOL_ANY_WORKER) {
+        w = &pool->workers[__atomic_fetch_add(&pool->next, 1,
+            __ATOMIC_RELAXED) % pool->nworkers];
+        head = &w->local;
+    } else {
+        w = &pool->workers[worker];
+        head = &w->pinned;
+    }
+    rn->owner = (uint8_t)w->id;
+
+    os_objlock_lock(w->lock)
+    if (pnode)
+        *pnode = rn;
+    if (prepend)
+        rte_list_add(&rn->node, head);
+    else
+        rte_list_add_tail(&rn->node, head);
+    os_objlock_unlock(w->lock)
+    __atomic_fetch_add(&pool->nr, 1, __ATOMIC_RELAXED);
+
+    /*
+     * Wake up the target worker if it is sleeping. Otherwise the shared
+     * work can be stolen, so we try to wake up an idle worker. The fence
+     * pairs with the one in rq_worker_schedule(), Either the worker sees
+     * the new node or we see its idle bit.
+     */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    idle = __atomic_load_n(&pool->idle, __ATOMIC_RELAXED);
+    if (idle & RQ_WORKER_BIT(w))
+        rq_worker_wakeup(pool, w);
+    else if (head == &w->local && idle)
+        rq_worker_wakeup(pool, &pool->workers[ffs(idle) - 1]);
+
+    return 0;
+}
+
+void _rq_pool_node_delete(struct rq_pool *pool, struct rq_node *pnode) {
+    os_critical_declare
+    struct rq_worker *w = &pool->workers[pnode->owner];
+    bool deleted = false;
+
+    os_objlock_lock(w->lock)
+    if (pnode->refp) {
+        rq_node_detach_locked(pnode);
+        rte_list_del(&pnode->node);
+        deleted = true;
+    }
+    os_objlock_unlock(w->lock)
+
+    if (deleted) {
+        __atomic_fetch_sub(&pool->nr, 1, __ATOMIC_RELAXED);
+        rq_pool_put_free(pool, pnode);
+    }
+}
+
+static void rq_worker_schedule(struct rq_worker *w) {
+    struct rq_pool *pool = w->pool;
+    uint32_t bit = RQ_WORKER_BIT(w);
+    struct rq_node *rn;
+    rq_exec_t fn;
+    void *arg;
+    bool dofree;
+
+    for ( ; ; ) {
+        rn = rq_worker_next(w);
+        if (rte_unlikely(!rn)) {
+            /*
+             * Publish the idle bit before checking the queues again, So
+             * the work that submitted in the meantime is not missed.
+             */
+            __atomic_fetch_or(&pool->idle, bit, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            rn = rq_worker_next(w);
+            if (!rn) {
+                os_completion_wait(w->completion);
+                continue;
+            }
+
+            /*
+             * If the submitter has cleared the bit, The extra completion
+             * only causes a spurious wakeup.
+             */
+            __atomic_fetch_and(&pool->idle, ~bit, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_sub(&pool->nr, 1, __ATOMIC_RELAXED);
+        fn = rn->exec;
+        arg = rn->arg;
+        dofree = rn->dofree;
+
+        /* Executing user function */
+        w->fn_executing = fn;
+        fn(arg);
+        w->fn_executing = NULL;
+
+        /* Free rn-node to free list */
+        if (rte_likely(dofree))
+            rq_pool_put_free(pool, rn);
+    }
+}
+
+/*
+ * The service thread of run-queue worker
+ */
+static void rq_worker_thread(void *arg) {
+    struct rq_worker *w = arg;
+
+    rq_worker_schedule(w);
+
+    os_thread_exit();
+}
+
+int _rq_pool_start(struct rq_pool *pool, void *stack, size_t size, int prio) {
+    size_t stksize;
+    int err;
+
+    if (!pool || !pool->buffer || !pool->nq || !pool->workers)
+        return -EINVAL;
+
+    _rq_pool_static_init(pool);
+    stksize = size / pool->nworkers;
+    for (uint16_t i = 0; i < pool->nworkers; i++) {
+        void *stk = stack? (char *)stack + stksize * i: NULL;
+        err = os_thread_spawn(&pool->workers[i].thread, "RqWorker", stk,
+            stksize, prio, rq_worker_thread, &pool->workers[i]);
+        if (err)
+            return err;
+    }
+    return 0;
+}
+
+void __rte_notrace _rq_pool_dump(struct rq_pool *pool) {
+    os_critical_declare
+    struct rte_list *p;
+
+    pr_notice("queued(%d) idle(0x%x)\n",
+        __atomic_load_n(&pool->nr, __ATOMIC_RELAXED),
+        __atomic_load_n(&pool->idle, __ATOMIC_RELAXED));
+    for (uint16_t i = 0; i < pool->nworkers; i++) {
+        struct rq_worker *w = &pool->workers[i];
+        int nlocal = 0, npinned = 0;
+        os_objlock_lock(w->lock)
+        rte_list_foreach(p, &w->local)
+            nlocal++;
+        rte_list_foreach(p, &w->pinned)
+            npinned++;
+        os_objlock_unlock(w->lock)
+        pr_notice("worker%d: executing(%p) local(%d) pinned(%d)\n",
+            i, w->fn_executing, nlocal, npinned);
+    }
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2024 wtcat
+ *
+ * Multi-worker run-queue with work stealing
+ */
+#ifndef BASEWORK_RQ_POOL_H_
+#define BASEWORK_RQ_POOL_H_
+
+#include "basework/rq.h"
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#define RQ_POOL_MAX_WORKERS 32
+#define RQ_POOL_ANY_WORKER  -1
+
+struct rq_pool;
+
+struct rq_worker {
+    struct rte_list local;  /* Shared work (can be stolen by other worker) */
+    struct rte_list pinned; /* Work bound to this worker */
+    os_completion_declare(completion)
+    os_objlock_declare(lock) /* Protects local and pinned */
+    struct rq_pool *pool;
+    rq_exec_t fn_executing;
+    uint16_t id;
+    os_thread_t thread;
+};
+
+struct rq_pool {
+    struct rte_list frees; /* Free list */
+    os_objlock_declare(lock) /* Protects frees */
+    struct rq_worker *workers;
+    void *buffer;
+    uint32_t idle;   /* Bitmap of sleeping workers */
+    uint16_t nq;
+    uint16_t nr;     /* queued count */
+    uint16_t nworkers;
+    uint16_t next;   /* Round-robin cursor for shared work */
+};
+
+/*
+ * RQ_POOL_DEFINE - Define a multi-worker run-queue
+ *
+ * @_name: Object name
+ * @_nworkers: The number of worker thread
+ * @_nitem: The maximum length of queue (shared by all workers)
+ * @_attr: variable attribute
+ */
+#define RQ_POOL_DEFINE(_name, _nworkers, _nitem, _attr) \
+    static RQ_BUFFER_DEFINE(_name ## _buffer, _nitem, 0, _attr); \
+    static struct rq_worker _name ## _workers[_nworkers] _attr; \
+    struct rq_pool _name __rte_used _attr = { \
+        .workers = _name ## _workers, \
+        .buffer = _name ## _buffer, \
+        .nq = _nitem, \
+        .nworkers = _nworkers, \
+    }
+
+/*
+ * _rq_pool_static_init - Initialize pool that defined by macro 'RQ_POOL_DEFINE()'
+ *
+ * @pool: run-queue pool
+ */
+void _rq_pool_static_init(struct rq_pool *pool);
+
+/*
+ * _rq_pool_init - Initialize pool that defined by user
+ *
+ * @pool: run-queue pool
+ * @workers: worker array
+ * @nworkers: the number of worker
+ * @buffer: Queue buffer
+ * @size: The size of queue buffer
+ * return 0 if success
+ */
+int _rq_pool_init(struct rq_pool *pool, struct rq_worker *workers,
+    size_t nworkers, void *buffer, size_t size);
+
+/*
+ * _rq_pool_submit_to - Submit a user-work to run-queue pool
+ *
+ * @pool: run-queue pool
+ * @worker: worker index that the work is pinned to (RQ_POOL_ANY_WORKER:
+ *          the work can be executed by any worker)
+ * @exec: user function
+ * @arg: user parameter
+ * @prepend: urgent call
+ * @pnode: queue node reference (optional, see _rq_pool_node_delete())
+ * return 0 if success
+ */
+int _rq_pool_submit_to(struct rq_pool *pool, int worker, void (*exec)(void *),
+    void *arg, bool prepend, void **pnode);
+
+/*
+ * _rq_pool_node_delete - Cancel a pending work that submitted with reference
+ *
+ * @pool: run-queue pool
+ * @pnode: queue node
+ */
+void _rq_pool_node_delete(struct rq_pool *pool, struct rq_node *pnode);
+
+/*
+ * _rq_pool_start - Create worker threads for run-queue pool
+ *
+ * @pool: run-queue pool
+ * @stack: thread stack address (Split equally by all workers)
+ * @size: thread stack size
+ * @prio: thread priority
+ * return 0 if success
+ */
+int _rq_pool_start(struct rq_pool *pool, void *stack, size_t size, int prio);
+
+/*
+ * _rq_pool_dump - Dump run-queue pool information
+ *
+ * @pool: run-queue pool
+ */
+void _rq_pool_dump(struct rq_pool *pool);
+
+static inline int _rq_pool_submit(struct rq_pool *pool, void (*exec)(void *),
+    void *arg, bool prepend) {
+    return _rq_pool_submit_to(pool, RQ_POOL_ANY_WORKER, exec, arg, prepend, NULL);
+}
+
+static inline int _rq_pool_submit_ext(struct rq_pool *pool, void (*exec)(void *),
+    void *arg, bool prepend, void **pnode) {
+    return _rq_pool_submit_to(pool, RQ_POOL_ANY_WORKER, exec, arg, prepend, pnode);
+}
+
+/*
+ * Run-queue pool public interface
+ */
+#define rq_pool_submit(_pool, _exec, _data) \
+    _rq_pool_submit(_pool, _exec, _data, false)
+#define rq_pool_submit_urgent(_pool, _exec, _data) \
+    _rq_pool_submit(_pool, _exec, _data, true)
+#define rq_pool_submit_ext(_pool, _exec, _data, _pnode) \
+    _rq_pool_submit_ext(_pool, _exec, _data, false, &(_pnode))
+#define rq_pool_submit_ext_urgent(_pool, _exec, _data, _pnode) \
+    _rq_pool_submit_ext(_pool, _exec, _data, true, &(_pnode))
+#define rq_pool_submit_pinned(_pool, _worker, _exec, _data) \
+    _rq_pool_submit_to(_pool, _worker, _exec, _data, false, NULL)
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* BASEWORK_RQ_POOL_H_ */
@@ -1,6 +1,7 @@
 /*
  * Copyright 2022 wtcat
  */
+#include <errno.h>
 #include <string.h>
 
 #include "basework/dev/blkdev.h"
@@ -169,6 +170,112 @@ TEST_F(cc_blkdev_test, blkdev_rw) {
     blkdev_print();
 }
 
+TEST_F(cc_blkdev_test, blkdev_lru) {
+    struct disk_device *dd = get_disk();
+    const uint32_t offset = 4 * 1024 * 1024;
+    const size_t nblks = 64;
+    ASSERT_NE(dd, nullptr);
+
+    /* The working set is larger than cache buffer */
+    size_t size = nblks * dd->blk_size;
+    char *wbuf = new char[size];
+    char *rbuf = new char[size];
+    for (size_t i = 0; i < size; i++)
+        wbuf[i] = (char)(i * 31 + i / dd->blk_size);
+
+    ASSERT_EQ(blkdev_write(dd, wbuf, size, offset), (ssize_t)size);
+    for (int loop = 0; loop < 2; loop++) {
+        memset(rbuf, 0, size);
+        ASSERT_EQ(blkdev_read(dd, rbuf, size, offset), (ssize_t)size);
+        ASSERT_EQ(memcmp(wbuf, rbuf, size), 0);
+    }
+    ASSERT_EQ(blkdev_sync(), 0);
+    memset(rbuf, 0, size);
+    ASSERT_EQ(disk_device_read(dd, rbuf, size, offset), (int)size);
+    ASSERT_EQ(memcmp(wbuf, rbuf, size), 0);
+    blkdev_print();
+
+    delete[] wbuf;
+    delete[] rbuf;
+}
+
+TEST_F(cc_blkdev_test, blkdev_writeback) {
+    struct disk_device *dd = get_disk();
+    const uint32_t offset = 4 * 1024 * 1024;
+    const size_t nblks = 32;
+    ASSERT_NE(dd, nullptr);
+
+    ASSERT_NE(blkdev_set_dirty_ratio(0, 50), 0);
+    ASSERT_NE(blkdev_set_dirty_ratio(60, 50), 0);
+    ASSERT_EQ(blkdev_set_dirty_ratio(25, 50), 0);
+    int err = blkdev_writeback_start(NULL, 4096, 0);
+    ASSERT_TRUE(err == 0 || err == -EBUSY);
+
+    size_t size = nblks * dd->blk_size;
+    char *wbuf = new char[size];
+    char *rbuf = new char[size];
+    for (size_t i = 0; i < size; i++)
+        wbuf[i] = (char)(i * 7 + i / dd->blk_size);
+
+    /* Write block by block, the writer is throttled at the hard limit */
+    for (size_t i = 0; i < nblks; i++) {
+        ASSERT_EQ(blkdev_write(dd, wbuf + i * dd->blk_size, dd->blk_size,
+            offset + i * dd->blk_size), (ssize_t)dd->blk_size);
+    }
+    ASSERT_EQ(blkdev_read(dd, rbuf, size, offset), (ssize_t)size);
+    ASSERT_EQ(memcmp(wbuf, rbuf, size), 0);
+    ASSERT_EQ(blkdev_sync(), 0);
+    ASSERT_EQ(disk_device_read(dd, rbuf, size, offset), (int)size);
+    ASSERT_EQ(memcmp(wbuf, rbuf, size), 0);
+    blkdev_print();
+
+    ASSERT_EQ(blkdev_set_dirty_ratio(50, 90), 0);
+    delete[] wbuf;
+    delete[] rbuf;
+}
+
+#if !defined(CONFIG_BLKDEV_IO_BLKS) || \
+    (CONFIG_BLKDEV_IO_BLKS > 1 && CONFIG_BLKDEV_RA_BLKS > 0)
+TEST_F(cc_blkdev_test, blkdev_merged_io) {
+    struct disk_device *dd = get_disk();
+    const uint32_t offset = 2 * 1024 * 1024;
+    const size_t nblks = 16;
+    struct blkdev_stats before, after;
+    ASSERT_NE(dd, nullptr);
+
+    size_t size = nblks * dd->blk_size;
+    char *wbuf = new char[size];
+    char *rbuf = new char[size];
+    for (size_t i = 0; i < size; i++)
+        wbuf[i] = (char)(i * 13 + i / dd->blk_size);
+
+    /* The contiguous dirty blocks are written back by merged requests */
+    blkdev_get_stats(&before);
+    ASSERT_EQ(blkdev_write(dd, wbuf, size, offset), (ssize_t)size);
+    ASSERT_EQ(blkdev_sync(), 0);
+    blkdev_get_stats(&after);
+    ASSERT_GE(after.writeback_blks - before.writeback_blks, (long)nblks);
+    ASSERT_LT(after.writeback_reqs - before.writeback_reqs,
+        after.writeback_blks - before.writeback_blks);
+
+    /* The sequential reads prefetch the following blocks */
+    ASSERT_EQ(blkdev_sync_invalid(), 0);
+    blkdev_get_stats(&before);
+    for (size_t i = 0; i < nblks; i++) {
+        ASSERT_EQ(blkdev_read(dd, rbuf + i * dd->blk_size, dd->blk_size,
+            offset + i * dd->blk_size), (ssize_t)dd->blk_size);
+    }
+    blkdev_get_stats(&after);
+    ASSERT_GT(after.readahead_blks, before.readahead_blks);
+    ASSERT_LT(after.cache_missed - before.cache_missed, (long)nblks);
+    ASSERT_EQ(memcmp(wbuf, rbuf, size), 0);
+    blkdev_print();
+
+    delete[] wbuf;
+    delete[] rbuf;
+}
+#endif /* CONFIG_BLKDEV_IO_BLKS > 1 */
+
 
 struct log_context {
     int ofs;
@@ -192,19 +299,160 @@ TEST_F(cc_blkdev_test, disklog) {
 
     disklog_reset();
     npr_info(disk, "%s", copyright);
-    ctx.ofs = 0;
-    ASSERT_EQ(disklog_ouput(log_output, &ctx, 0), 0);
-    blkdev_print();
 
-    int offset = 0;
+    /* The log is still there after disklog_read() */
+    int offset = 0, len;
     bool first = true;
     memset(str_buffer, 0, sizeof(str_buffer));
     
     do {
-        offset = disklog_read(str_buffer + offset, sizeof(str_buffer) - offset, first);
-        ASSERT_GE(offset, 0);
+        len = disklog_read(str_buffer + offset, sizeof(str_buffer) - 1 - offset, first);
+        ASSERT_GE(len, 0);
+        offset += len;
         first = false;
-    } while (offset > 0);
+    } while (len > 0);
     ASSERT_STREQ(copyright, str_buffer);
 
+    ctx.ofs = 0;
+    ASSERT_EQ(disklog_ouput(log_output, &ctx, 0), 0);
+    ASSERT_EQ(ctx.ofs, offset);
+    blkdev_print();
+}
+
+#if CONFIG_DISKLOG_STAGING_SIZE > 0
+#include <string>
+#include "basework/os/osapi.h"
+
+static void disklog_put_lines(unsigned int first, unsigned int count) {
+    char line[32];
+    for (unsigned int i = first; i < first + count; i++) {
+        int len = snprintf(line, sizeof(line), "seq %08u\n", i);
+        /* Wait for the flusher if the staging ring is full */
+        while (disklog_input(line, len) == -ENOSPC)
+            os_thread_sleep(1);
+    }
+}
+
+static bool disklog_collect(void *ctx, char *buf, size_t size) {
+    static_cast<std::string *>(ctx)->append(buf, size);
+    return true;
+}
+
+static std::string disklog_upload_all(void) {
+    std::string log;
+    EXPECT_EQ(disklog_ouput(disklog_collect, &log, 0), 0);
+    return log;
+}
+
+static std::string disklog_read_all(void) {
+    std::string log;
+    char buf[700];
+    ssize_t len;
+    bool first = true;
+    while ((len = disklog_read(buf, sizeof(buf), first)) > 0) {
+        log.append(buf, len);
+        first = false;
+    }
+    EXPECT_EQ(len, 0);
+    return log;
+}
+
+/*
+ * The log must hold continuous lines from @first to @last. If @first is
+ * negative, the log is wrapped and the first line may be truncated.
+ * return the number of lines or -1 if failed
+ */
+static int disklog_check_lines(const std::string &log, long first,
+    unsigned int last) {
+    unsigned int seq, expect = 0;
+    size_t pos = 0, nl;
+    int lines = 0;
+
+    if (first < 0) {
+        pos = log.find('\n');
+        if (pos == std::string::npos)
+            return -1;
+        pos++;
+    } else {
+        expect = (unsigned int)first;
+    }
+    while (pos < log.size()) {
+        nl = log.find('\n', pos);
+        if (nl == std::string::npos)
+            return -1;
+        if (sscanf(log.c_str() + pos, "seq %08u", &seq) != 1)
+            return -1;
+        if ((lines > 0 || first >= 0) && seq != expect)
+            return -1;
+        expect = seq + 1;
+        lines++;
+        pos = nl + 1;
+    }
+    return (lines > 0 && expect == last + 1)? lines: -1;
+}
+
+TEST_F(cc_blkdev_test, disklog_staging_reset) {
+    ASSERT_EQ(disklog_init(), 0);
+    disklog_reset();
+    ASSERT_TRUE(disklog_upload_all().empty());
+
+    disklog_put_lines(0, 100);
+    disklog_reset();
+    ASSERT_TRUE(disklog_read_all().empty());
+    ASSERT_TRUE(disklog_upload_all().empty());
+
+    ASSERT_EQ(disklog_input("hello\n", 6), 0);
+    ASSERT_EQ(disklog_read_all(), "hello\n");
+    ASSERT_EQ(disklog_upload_all(), "hello\n");
+}
+
+TEST_F(cc_blkdev_test, disklog_staging_order) {
+    ASSERT_EQ(disklog_init(), 0);
+    disklog_reset();
+    disklog_put_lines(0, 2000);
+
+    /* disklog_read() does not consume the log */
+    std::string rdlog = disklog_read_all();
+    ASSERT_EQ(disklog_check_lines(rdlog, 0, 1999), 2000);
+    ASSERT_EQ(disklog_read_all(), rdlog);
+    ASSERT_EQ(disklog_upload_all(), rdlog);
+    ASSERT_TRUE(disklog_upload_all().empty());
+
+    disklog_put_lines(2000, 10);
+    ASSERT_EQ(disklog_check_lines(disklog_upload_all(), 2000, 2009), 10);
+}
+
+TEST_F(cc_blkdev_test, disklog_staging_reboot) {
+    ASSERT_EQ(disklog_init(), 0);
+    disklog_reset();
+    disklog_put_lines(0, 1000);
+
+    /* The open block must be reloaded from disk */
+    disklog_deinit();
+    ASSERT_EQ(disklog_init(), 0);
+    disklog_put_lines(1000, 1000);
+    ASSERT_EQ(disklog_check_lines(disklog_read_all(), 0, 1999), 2000);
+
+    disklog_deinit();
+    ASSERT_EQ(disklog_init(), 0);
+    ASSERT_EQ(disklog_check_lines(disklog_upload_all(), 0, 1999), 2000);
+}
+
+TEST_F(cc_blkdev_test, disklog_staging_wrap) {
+    const unsigned int nlines = 100000;
+    ASSERT_EQ(disklog_init(), 0);
+    disklog_reset();
+    disklog_put_lines(0, nlines);
+
+    std::string rdlog = disklog_read_all();
+    int lines = disklog_check_lines(rdlog, -1, nlines - 1);
+    ASSERT_GT(lines, 0);
+    ASSERT_LT(lines, (int)nlines);
+
+    /* The log is still continuous after reboot */
+    disklog_deinit();
+    ASSERT_EQ(disklog_init(), 0);
+    ASSERT_EQ(disklog_read_all(), rdlog);
+    ASSERT_EQ(disklog_upload_all(), rdlog);
 }
+#endif /* CONFIG_DISKLOG_STAGING_SIZE > 0 */
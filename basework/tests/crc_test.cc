@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 wtcat
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "basework/lib/crc.h"
+#include "gtest/gtest.h"
+
+extern "C" {
+
+static uint32_t crc32_ref_tab[256];
+static uint16_t crc16_ref_tab[256];
+
+static void crc_ref_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c32 = n;
+        uint16_t c16 = (uint16_t)(n << 8);
+        for (int k = 0; k < 8; k++) {
+            c32 = (c32 >> 1) ^ ((c32 & 1)? 0xedb88320: 0);
+            c16 = (uint16_t)((c16 & 0x8000)? (c16 << 1) ^ 0x1021: c16 << 1);
+        }
+        crc32_ref_tab[n] = c32;
+        crc16_ref_tab[n] = c16;
+    }
+}
+
+/* One byte per table lookup (the original implementation) */
+static uint32_t crc32_ref(const uint8_t *src, size_t len, uint32_t crc) {
+    for (size_t i = 0; i < len; i++)
+        crc = crc32_ref_tab[(crc & 0xff) ^ src[i]] ^ (crc >> 8);
+    return crc;
+}
+
+static uint16_t crc16_ref(const uint8_t *src, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++)
+        crc = crc16_ref_tab[((crc >> 8) & 0xff) ^ src[i]] ^ (uint16_t)(crc << 8);
+    return crc;
+}
+
+static double crc_elapsed_us(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e6 +
+        (now.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+}
+
+TEST(crc, bit_exact) {
+    static uint8_t buffer[4096 + 64];
+
+    crc_ref_init();
+    for (size_t i = 0; i < sizeof(buffer); i++)
+        buffer[i] = (uint8_t)rand();
+
+    ASSERT_EQ(lib_crc32((const uint8_t *)"123456789", 9),
+        crc32_ref((const uint8_t *)"123456789", 9, 0));
+    ASSERT_EQ(lib_crc16((const uint8_t *)"123456789", 9), 0x31c3);
+
+    for (int i = 0; i < 20000; i++) {
+        size_t ofs = rand() % 64;
+        size_t len = (i < 1000)? (size_t)i % 300: rand() % 4096;
+        uint32_t c32 = (uint32_t)rand() * 2654435761u;
+        uint16_t c16 = (uint16_t)rand();
+
+        ASSERT_EQ(lib_crc32part(buffer + ofs, len, c32),
+            crc32_ref(buffer + ofs, len, c32));
+        ASSERT_EQ(lib_crc16part(buffer + ofs, len, c16),
+            crc16_ref(buffer + ofs, len, c16));
+    }
+
+    /* Split into parts */
+    uint32_t c32 = 0;
+    uint16_t c16 = 0;
+    for (size_t ofs = 0, len; ofs < 4096; ofs += len) {
+        len = rand() % 200;
+        if (len > 4096 - ofs)
+            len = 4096 - ofs;
+        c32 = lib_crc32part(buffer + ofs, len, c32);
+        c16 = lib_crc16part(buffer + ofs, len, c16);
+    }
+    ASSERT_EQ(c32, crc32_ref(buffer, 4096, 0));
+    ASSERT_EQ(c16, crc16_ref(buffer, 4096, 0));
+}
+
+TEST(crc, throughput) {
+    const size_t max_size = 4 * 1024 * 1024;
+    uint8_t *buffer = (uint8_t *)malloc(max_size);
+    volatile uint32_t sink = 0;
+
+    ASSERT_NE(buffer, nullptr);
+    crc_ref_init();
+    for (size_t i = 0; i < max_size; i++)
+        buffer[i] = (uint8_t)rand();
+
+    printf("%10s %12s %12s %12s %12s\n", "size", "crc32-ref", "crc32",
+        "crc16-ref", "crc16");
+    for (size_t size = 4096; size <= max_size; size *= 4) {
+        size_t loops = (16 * 1024 * 1024) / size;
+        struct timespec start;
+        double us[4];
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < loops; i++)
+            sink += crc32_ref(buffer, size, 0);
+        us[0] = crc_elapsed_us(&start);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < loops; i++)
+            sink += lib_crc32(buffer, size);
+        us[1] = crc_elapsed_us(&start);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < loops; i++)
+            sink += crc16_ref(buffer, size, 0);
+        us[2] = crc_elapsed_us(&start);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < loops; i++)
+            sink += lib_crc16(buffer, size);
+        us[3] = crc_elapsed_us(&start);
+
+        /* MB/s */
+        printf("%10zu", size);
+        for (int k = 0; k < 4; k++)
+            printf(" %7.0f MB/s", (double)size * loops / us[k]);
+        printf("\n");
+    }
+    free(buffer);
+}
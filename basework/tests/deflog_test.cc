@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 wtcat
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "basework/lib/printer.h"
+#include "basework/lib/deflog.h"
+#include "gtest/gtest.h"
+
+static char deflog_output[512];
+static size_t deflog_outlen;
+
+static int deflog_capture(void *context, const char *fmt, va_list ap) {
+    (void) context;
+    int len = vsnprintf(deflog_output + deflog_outlen,
+        sizeof(deflog_output) - deflog_outlen, fmt, ap);
+    deflog_outlen += len;
+    return len;
+}
+
+static bool deflog_count(void *ctx, const struct deflog_record *rec,
+    size_t size) {
+    (void) rec;
+    (void) size;
+    (*(int *)ctx)++;
+    return true;
+}
+
+TEST(deflog, format) {
+    static uint64_t buffer[128];
+    static struct printer capture = {deflog_capture, NULL};
+    struct printer pr;
+    char name[16];
+    const char *p;
+    int count;
+
+    deflog_format_init(&pr, &capture, buffer, sizeof(buffer));
+    strcpy(name, "temp");
+    virt_format(&pr, "%s=%d|%5x|%-3s|%*d|%lld%%\n", name, -12, 0xab, "a",
+        4, 7, (long long)1 << 40);
+
+    /* The string argument has been copied */
+    strcpy(name, "XXXX");
+    EXPECT_EQ(deflog_outlen, 0u);
+    EXPECT_EQ(deflog_flush(0), 1u);
+    p = strchr(deflog_output, ' ');
+    ASSERT_NE(p, nullptr);
+    EXPECT_STREQ(p + 1, "temp=-12|   ab|a  |   7|1099511627776%\n");
+
+    /* Ring overflow */
+    count = 0;
+    while (virt_format(&pr, "overflow %d\n", count) > 0)
+        count++;
+    EXPECT_GT(count, 0);
+    EXPECT_EQ(deflog_dropped(), 1u);
+
+    int records = 0;
+    EXPECT_EQ(deflog_read(deflog_count, &records), (size_t)count);
+    EXPECT_EQ(records, count);
+    EXPECT_EQ(deflog_flush(0), 0u);
+}
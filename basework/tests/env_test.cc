@@ -81,4 +81,153 @@ TEST(environment_var, ram) {
     ASSERT_STREQ(env_get("ip"), "192.168.1.1");   
     ASSERT_STREQ(env_get("runtime"), "20");
     ASSERT_STREQ(env_get("update"), "yes");
-}
\ No newline at end of file
+}
+#ifdef CONFIG_ENV_HASH
+#include "basework/lib/env_core.h"
+
+struct ram_journal {
+    char buffer[128];
+    size_t offset;
+    int resets;
+};
+
+static int journal_append(void *ctx, void *buffer, size_t size) {
+    struct ram_journal *rj = (struct ram_journal *)ctx;
+    if (rj->offset + size > sizeof(rj->buffer))
+        return -ENOSPC;
+    memcpy(rj->buffer + rj->offset, buffer, size);
+    rj->offset += size;
+    return 0;
+}
+
+static int journal_reset(void *ctx) {
+    struct ram_journal *rj = (struct ram_journal *)ctx;
+    memset(rj->buffer, 0, sizeof(rj->buffer));
+    rj->offset = 0;
+    rj->resets++;
+    return 0;
+}
+
+TEST(environment_var, journal) {
+    static struct ram_journal rj;
+    struct env_journal jn = {journal_append, journal_reset, &rj};
+    char name[16];
+
+    env_reset();
+    ASSERT_EQ(env_set("os", "posix", 1), 0);
+    ASSERT_EQ(env_set("runtime", "20", 1), 0);
+    ASSERT_EQ(env_commit(&jn), 0);
+    ASSERT_EQ(rj.offset, strlen("os=posix\nruntime=20\n"));
+
+    /* Only the changes are appended */
+    ASSERT_EQ(env_set("runtime", "21", 1), 0);
+    ASSERT_EQ(env_unset("os"), 0);
+    ASSERT_EQ(env_commit(&jn), 0);
+    ASSERT_EQ(memcmp(rj.buffer + 20, "runtime=21\n!os\n", 15), 0);
+    ASSERT_EQ(rj.resets, 0);
+
+    /* Compact the journal when it is full */
+    for (int i = 0; i < 20; i++)
+        ASSERT_EQ(env_setint("runtime", 100 + i, 10), 0);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(env_setint("runtime", 1000 + i, 10), 0);
+        ASSERT_EQ(env_commit(&jn), 0);
+    }
+    ASSERT_GT(rj.resets, 0);
+    ASSERT_STREQ(env_get("runtime"), "1009");
+
+    /* Replay */
+    env_reset();
+    ASSERT_EQ(env_load_ram(rj.buffer, sizeof(rj.buffer)), 0);
+    ASSERT_STREQ(env_get("runtime"), "1009");
+    ASSERT_EQ(env_get("os"), nullptr);
+
+    /* Hash index */
+    for (int i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "key%d", i);
+        ASSERT_EQ(env_setint(name, i, 10), 0);
+    }
+    for (int i = 0; i < 500; i += 2) {
+        snprintf(name, sizeof(name), "key%d", i);
+        ASSERT_EQ(env_unset(name), 0);
+    }
+    for (int i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "key%d", i);
+        if (i & 1)
+            ASSERT_EQ(env_getl(name, 10), i);
+        else
+            ASSERT_EQ(env_get(name), nullptr);
+    }
+    env_reset();
+}
+
+/*
+ * The rewrite goes to the spare image, and the old one is kept if failed
+ */
+struct swap_journal {
+    struct ram_journal img[2];
+    int active;
+    int writing;
+    size_t limit;
+};
+
+static int swap_journal_append(void *ctx, void *buffer, size_t size) {
+    struct swap_journal *sj = (struct swap_journal *)ctx;
+    struct ram_journal *rj = &sj->img[sj->writing];
+    if (rj->offset + size > sj->limit)
+        return -ENOSPC;
+    return journal_append(rj, buffer, size);
+}
+
+static int swap_journal_reset(void *ctx) {
+    struct swap_journal *sj = (struct swap_journal *)ctx;
+    sj->writing = !sj->active;
+    return journal_reset(&sj->img[sj->writing]);
+}
+
+static int swap_journal_swap(void *ctx, bool done) {
+    struct swap_journal *sj = (struct swap_journal *)ctx;
+    if (done)
+        sj->active = sj->writing;
+    sj->writing = sj->active;
+    return 0;
+}
+
+TEST(environment_var, journal_swap) {
+    static struct swap_journal sj;
+    struct env_journal jn = {swap_journal_append, swap_journal_reset, &sj, 
+        swap_journal_swap};
+    const char *value;
+
+    env_reset();
+    sj.limit = 32;
+    ASSERT_EQ(env_set("os", "posix", 1), 0);
+    ASSERT_EQ(env_set("runtime", "20", 1), 0);
+    ASSERT_EQ(env_commit(&jn), 0);
+    value = env_get("os");
+
+    /* All variables do not fit, the old image is kept */
+    ASSERT_EQ(env_set("path", "/home/user/workspace", 1), 0);
+    ASSERT_EQ(env_commit(&jn), -ENOSPC);
+    ASSERT_EQ(sj.active, 0);
+    ASSERT_EQ(memcmp(sj.img[0].buffer, "os=posix\nruntime=20\n", 20), 0);
+
+    /* The change is committed later */
+    sj.limit = sizeof(sj.img[0].buffer);
+    ASSERT_EQ(env_commit(&jn), 0);
+    ASSERT_EQ(sj.active, 0);
+    ASSERT_NE(strstr(sj.img[0].buffer, "path=/home/user/workspace\n"), nullptr);
+
+    /* The returned string is not moved by later changes */
+    for (int i = 0; i < 200; i++) {
+        ASSERT_EQ(env_setint("runtime", 100000 * i, 10), 0);
+        ASSERT_EQ(env_unset("path"), 0);
+        ASSERT_EQ(env_set("path", "/home/user/workspace", 1), 0);
+    }
+    ASSERT_STREQ(value, "posix");
+    ASSERT_EQ(env_compact(), 0);
+    ASSERT_STREQ(env_get("os"), "posix");
+    ASSERT_STREQ(env_get("path"), "/home/user/workspace");
+    env_reset();
+}
+#endif /* CONFIG_ENV_HASH */
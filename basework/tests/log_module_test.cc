@@ -0,0 +1,57 @@
+/*
+ * Copyright 2024 wtcat
+ */
+#define LOG_MODULE_NAME logtest
+#include <string.h>
+
+#include "basework/log.h"
+#include "gtest/gtest.h"
+
+LOG_MODULE_DEFINE(logtest, LOGLEVEL_WARNING);
+
+static int log_test_count;
+
+static int log_test_format(void *context, const char *fmt, va_list ap) {
+    (void) context;
+    (void) fmt;
+    (void) ap;
+    return ++log_test_count;
+}
+
+static bool log_test_visit(const struct log_module *mod, void *arg) {
+    if (!strcmp(mod->name, "logtest")) {
+        *(int *)arg = mod->level;
+        return false;
+    }
+    return true;
+}
+
+TEST(log, module_level) {
+    static struct printer pr = {log_test_format, NULL};
+    struct printer *old = __log_default_printer;
+    int level = -1;
+
+    __log_default_printer = &pr;
+    EXPECT_EQ(log_module_get_level("logtest"), -ENOENT);
+
+    /* Default level of module */
+    pr_info("info\n");
+    pr_warn("warn\n");
+    EXPECT_EQ(log_test_count, 1);
+    EXPECT_EQ(log_module_get_level("logtest"), LOGLEVEL_WARNING);
+    log_module_foreach(log_test_visit, &level);
+    EXPECT_EQ(level, LOGLEVEL_WARNING);
+
+    /* Change level at runtime */
+    EXPECT_EQ(log_module_set_level("logtest", LOGLEVEL_DEBUG), 0);
+    pr_dbg("debug\n");
+    EXPECT_EQ(log_test_count, 2);
+    EXPECT_EQ(log_module_parse("logtest=1,unknown=5"), 0);
+    pr_warn("warn\n");
+    pr_err("error\n");
+    EXPECT_EQ(log_test_count, 3);
+
+    EXPECT_EQ(log_module_parse("logtest"), -EINVAL);
+    EXPECT_EQ(log_module_set_level("logtest", 9), -EINVAL);
+    __log_default_printer = old;
+}
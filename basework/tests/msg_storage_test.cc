@@ -84,3 +84,73 @@ TEST(msg_storage, save) {
     ASSERT_TRUE(msg_storage_clean() == 0);
     ASSERT_TRUE(msg_storage_deinit() == 0);
 }
+
+static void message_check(int id, const struct msg_payload *msg) {
+    struct msg_payload tmp = {0};
+    ASSERT_TRUE(msg_storage_read(id, &tmp) == 0);
+    ASSERT_TRUE(memcmp(&tmp, msg, sizeof(tmp)) == 0);
+}
+
+TEST(msg_storage, batch_read) {
+    static struct msg_payload msgs[MAX_MESSAGES];
+    int ids[MAX_MESSAGES];
+    int id, n, count;
+
+    ASSERT_TRUE(msg_file_backend_init() == 0);
+    ASSERT_TRUE(msg_storage_clean() == 0);
+    ASSERT_TRUE(msg_storage_first() < 0);
+    for (int i = 0; i < MAX_MESSAGES * 2 + 3; i++) {
+        struct msg_payload msg = {0};
+        msg.id = i;
+        msg.type = i % 3 + 1;
+        msg.m_len = snprintf(msg.buffer, sizeof(msg.buffer), "message %d", i);
+        ASSERT_TRUE(msg_storage_write(&msg) == 0);
+    }
+    msg_storage_remove(msg_storage_next(msg_storage_first()));
+    ASSERT_EQ(msg_storage_numbers(), (size_t)MAX_MESSAGES - 1);
+    ASSERT_EQ(msg_storage_type_numbers(1) + msg_storage_type_numbers(2) + 
+        msg_storage_type_numbers(3), (size_t)MAX_MESSAGES - 1);
+
+    for (int pass = 0; pass < 2; pass++) {
+        /* All messages in small batches */
+        count = 0;
+        id = msg_storage_first();
+        MSG_STORAGE_FOREACH(i) {
+            if (count % 4 == 0) {
+                ASSERT_EQ(id, i);
+                n = msg_storage_read_batch(&id, msgs, ids, 4);
+                ASSERT_GT(n, 0);
+            }
+            ASSERT_EQ(ids[count % 4], i);
+            message_check(i, &msgs[count % 4]);
+            count++;
+        }
+        ASSERT_LT(id, 0);
+        ASSERT_EQ((size_t)count, msg_storage_numbers());
+
+        /* Messages of each type in one batch */
+        for (int type = 1; type <= 3; type++) {
+            count = 0;
+            id = msg_storage_type_first(type);
+            n = msg_storage_type_read_batch(type, &id, msgs, ids, MAX_MESSAGES);
+            ASSERT_EQ((size_t)n, msg_storage_type_numbers(type));
+            ASSERT_LT(id, 0);
+            MSG_STORAGE_TYPE_FOREACH(type, i) {
+                ASSERT_EQ(ids[count], i);
+                ASSERT_EQ(msgs[count].type, type);
+                message_check(i, &msgs[count]);
+                count++;
+            }
+            ASSERT_EQ(count, n);
+        }
+
+        /* The type index is rebuilt after reopen */
+        ASSERT_TRUE(msg_storage_deinit() == 0);
+        ASSERT_TRUE(msg_storage_init() == 0);
+    }
+
+    ASSERT_TRUE(msg_storage_clean() == 0);
+    ASSERT_EQ(msg_storage_numbers(), 0u);
+    ASSERT_TRUE(msg_storage_type_first(1) < 0);
+    ASSERT_TRUE(msg_storage_deinit() == 0);
+}
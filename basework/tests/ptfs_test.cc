@@ -2,6 +2,7 @@
  * Copyright 2022 wtcat
  */
 #include "basework/os/osapi_fs.h"
+#include "basework/dev/ptfs.h"
 #include "gtest/gtest.h"
 
 #define FILE_NAME(path) "/PTFS:" path
@@ -44,4 +45,34 @@ TEST(ptfs, readwrite) {
 
     ASSERT_EQ(vfs_unlink(FILE_NAME("/test-2.txt")), 0);
     ASSERT_NE(vfs_open(&fd, FILE_NAME("/test-2.txt"), VFS_O_RDWR), 0);
-}
\ No newline at end of file
+}
+
+TEST(ptfs, extent) {
+    static char wbuf[CONFIG_PTFS_BLKSIZE * 2 + 100];
+    static char rbuf[sizeof(wbuf)];
+    struct vfs_stat st;
+    os_file_t fd;
+
+    vfs_unlink(FILE_NAME("/test-1.txt"));
+    vfs_unlink(FILE_NAME("/test-3.txt"));
+    for (size_t i = 0; i < sizeof(wbuf); i++)
+        wbuf[i] = (char)(i * 7 + 1);
+
+    /* Multiple blocks in one write */
+    ASSERT_EQ(vfs_open(&fd, FILE_NAME("/large.bin"), VFS_O_CREAT | VFS_O_RDWR), 0);
+    ASSERT_EQ(vfs_write(fd, wbuf, sizeof(wbuf)), (ssize_t)sizeof(wbuf));
+    ASSERT_EQ(vfs_close(fd), 0);
+    ASSERT_EQ(vfs_stat(FILE_NAME("/large.bin"), &st), 0);
+    ASSERT_EQ(st.st_size, sizeof(wbuf));
+    ASSERT_EQ(st.st_blocks, 3ul);
+
+    /* Read across the blocks */
+    ASSERT_EQ(vfs_open(&fd, FILE_NAME("/large.bin"), VFS_O_RDONLY), 0);
+    ASSERT_EQ(vfs_read(fd, rbuf, sizeof(rbuf)), (ssize_t)sizeof(rbuf));
+    ASSERT_EQ(memcmp(rbuf, wbuf, sizeof(wbuf)), 0);
+    ASSERT_EQ(vfs_lseek(fd, CONFIG_PTFS_BLKSIZE - 10, VFS_SEEK_SET), 0);
+    ASSERT_EQ(vfs_read(fd, rbuf, CONFIG_PTFS_BLKSIZE + 20), (ssize_t)CONFIG_PTFS_BLKSIZE + 20);
+    ASSERT_EQ(memcmp(rbuf, wbuf + CONFIG_PTFS_BLKSIZE - 10, CONFIG_PTFS_BLKSIZE + 20), 0);
+    ASSERT_EQ(vfs_close(fd), 0);
+    ASSERT_EQ(vfs_unlink(FILE_NAME("/large.bin")), 0);
+}
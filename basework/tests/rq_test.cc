@@ -3,6 +3,14 @@
  */
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #if defined(__ZEPHYR__)
 #define restrict
 #include <posix/unistd.h>
@@ -12,6 +20,7 @@
 #endif /* __ZEPHYR__ */
 
 #include "basework/rq.h"
+#include "basework/rq_pool.h"
 #include "basework/malloc.h"
 #include "gtest/gtest.h"
 
@@ -81,3 +90,269 @@ TEST(runqueue, submit_cp) {
         usleep(50000);
     }
 }
+
+/*
+ * Cancel a queued node from the node that is executed before it
+ */
+RQ_DEFINE(cancel_rq, 8, );
+
+static void *cancel_ref;
+static int cancel_result;
+
+static void cancel_block_work(void *arg) {
+    sem_wait((sem_t *)arg);
+}
+
+static void cancel_first_work(void *arg) {
+    void *ref = cancel_ref;
+
+    ASSERT_NE(ref, nullptr);
+    _rq_node_delete(&cancel_rq, (struct rq_node *)ref);
+    cancel_result = cancel_ref == NULL;
+}
+
+static void cancel_never_work(void *arg) {
+    ADD_FAILURE() << "canceled work is executed";
+}
+
+static void cancel_done_work(void *arg) {
+    sem_post((sem_t *)arg);
+}
+
+TEST(runqueue, cancel_from_work) {
+    sem_t block, done;
+
+    sem_init(&block, 0, 0);
+    sem_init(&done, 0, 0);
+    ASSERT_EQ(_rq_new_thread(&cancel_rq, NULL, 0, 5), 0);
+
+    /* Hold the run-queue thread, so the next nodes stay queued */
+    ASSERT_EQ(_rq_submit(&cancel_rq, cancel_block_work, &block, false), 0);
+    usleep(10000);
+    ASSERT_EQ(_rq_submit(&cancel_rq, cancel_first_work, NULL, false), 0);
+    ASSERT_EQ(_rq_submit_ext(&cancel_rq, cancel_never_work, NULL, false, 
+        &cancel_ref), 0);
+    ASSERT_EQ(_rq_submit(&cancel_rq, cancel_done_work, &done, false), 0);
+    sem_post(&block);
+    sem_wait(&done);
+
+    ASSERT_EQ(cancel_result, 1);
+    ASSERT_EQ(cancel_ref, nullptr);
+    usleep(10000);
+    ASSERT_EQ(_rq_get_nodes(&cancel_rq), 0u);
+}
+
+/*
+ * Benchmark: by-value submission with inline payload vs heap payload
+ */
+#define RQ_BENCH_NODES   128
+#define RQ_BENCH_BATCH   (RQ_BENCH_NODES / 2)
+#define RQ_BENCH_ROUNDS  200
+
+struct bench_param {
+    uintptr_t args[8];
+};
+
+RQ_DEFINE_INLINE(bench_heap_rq, RQ_BENCH_NODES, 0, );
+RQ_DEFINE_INLINE(bench_inline_rq, RQ_BENCH_NODES, sizeof(struct bench_param), );
+
+static void bench_work(void *data, size_t size) {
+    struct bench_param *bp = (struct bench_param *)data;
+    if (bp->args[0] == RQ_BENCH_BATCH - 1)
+        sem_post((sem_t *)bp->args[1]);
+}
+
+static void rq_copy_benchmark(const char *name, struct rq_context *rq) {
+    std::vector<uint64_t> lat;
+    struct bench_param bp = {0};
+    struct timespec t0, t1, start, end;
+    sem_t done;
+
+    sem_init(&done, 0, 0);
+    lat.reserve(RQ_BENCH_BATCH * RQ_BENCH_ROUNDS);
+    bp.args[1] = (uintptr_t)&done;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < RQ_BENCH_ROUNDS; r++) {
+        for (int i = 0; i < RQ_BENCH_BATCH; i++) {
+            bp.args[0] = i;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            _rq_submit_with_copy(rq, bench_work, &bp, sizeof(bp), false);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            lat.push_back((t1.tv_sec - t0.tv_sec) * 1000000000ull + 
+                t1.tv_nsec - t0.tv_nsec);
+        }
+        sem_wait(&done);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint64_t total = (end.tv_sec - start.tv_sec) * 1000000000ull + 
+        end.tv_nsec - start.tv_nsec;
+    std::sort(lat.begin(), lat.end());
+    printf("[%s] %.0f ops/sec submit-p50(%llu ns) submit-p99(%llu ns)\n", name, 
+        (double)lat.size() * 1000000000.0 / total,
+        (unsigned long long)lat[lat.size() / 2],
+        (unsigned long long)lat[(lat.size() * 99) / 100]);
+}
+
+TEST(runqueue, submit_cp_benchmark) {
+    ASSERT_EQ(_rq_new_thread(&bench_heap_rq, NULL, 0, 5), 0);
+    ASSERT_EQ(_rq_new_thread(&bench_inline_rq, NULL, 0, 5), 0);
+    rq_copy_benchmark("heap", &bench_heap_rq);
+    rq_copy_benchmark("inline", &bench_inline_rq);
+}
+
+/*
+ * Multi-worker run-queue
+ */
+RQ_POOL_DEFINE(test_pool, 4, 64, );
+
+static std::atomic<int> pool_counter;
+static int pinned_order[32];
+static int pinned_idx;
+static sem_t pinned_sync;
+
+static void pool_work(void *arg) {
+    if (pool_counter.fetch_add(1) == 999)
+        sem_post((sem_t *)arg);
+}
+
+static void pool_pinned_work(void *arg) {
+    /* Record the submission index in execution order */
+    pinned_order[pinned_idx] = (int)(uintptr_t)arg;
+    if (++pinned_idx == 32)
+        sem_post(&pinned_sync);
+}
+
+static void pool_block_work(void *arg) {
+    sem_wait((sem_t *)arg);
+}
+
+static void pool_never_work(void *arg) {
+    ADD_FAILURE() << "canceled work is executed";
+}
+
+TEST(runqueue, pool) {
+    void *ref = NULL;
+    sem_t sync;
+
+    sem_init(&sync, 0, 0);
+    ASSERT_EQ(_rq_pool_start(&test_pool, NULL, 0, 5), 0);
+
+    for (int i = 0; i < 1000; i++) {
+        while (rq_pool_submit(&test_pool, pool_work, &sync) == -EBUSY)
+            usleep(100);
+    }
+    sem_wait(&sync);
+    ASSERT_EQ(pool_counter.load(), 1000);
+
+    /* The pinned work must be executed in order */
+    sem_init(&pinned_sync, 0, 0);
+    for (int i = 0; i < 32; i++) {
+        ASSERT_EQ(rq_pool_submit_pinned(&test_pool, 1, pool_pinned_work, 
+            (void *)(uintptr_t)i), 0);
+    }
+    sem_wait(&pinned_sync);
+    for (int i = 0; i < 32; i++)
+        ASSERT_EQ(pinned_order[i], i);
+
+    /* Cancel a pending work while the worker is busy */
+    ASSERT_EQ(rq_pool_submit_pinned(&test_pool, 2, pool_block_work, &sync), 0);
+    ASSERT_EQ(_rq_pool_submit_to(&test_pool, 2, pool_never_work, NULL, 
+        false, &ref), 0);
+    ASSERT_NE(ref, nullptr);
+    _rq_pool_node_delete(&test_pool, (struct rq_node *)ref);
+    ASSERT_EQ(ref, nullptr);
+    sem_post(&sync);
+    usleep(20000);
+}
+
+/*
+ * Benchmark: submission contention of locked queue vs lock-free queue
+ */
+#define RQ_CONTENTION_THREADS 4
+#define RQ_CONTENTION_ITEMS   1000
+
+RQ_DEFINE_INLINE(bench_locked_rq, 4096, 0, );
+RQ_DEFINE_LOCKFREE(bench_lf_rq, 16, 4096, );
+
+static int contention_counter;
+
+static void contention_work(void *arg) {
+    if (++contention_counter == RQ_CONTENTION_THREADS * RQ_CONTENTION_ITEMS) {
+        contention_counter = 0;
+        sem_post((sem_t *)arg);
+    }
+}
+
+static void rq_contention_benchmark(const char *name, struct rq_context *rq, 
+    bool lockfree) {
+    std::vector<std::thread> producers;
+    sem_t done;
+
+    sem_init(&done, 0, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RQ_CONTENTION_THREADS; i++) {
+        producers.emplace_back([=, &done] {
+            for (int j = 0; j < RQ_CONTENTION_ITEMS; j++) {
+                if (lockfree) {
+                    while (_rq_submit_lf(rq, contention_work, &done))
+                        std::this_thread::yield();
+                } else {
+                    _rq_submit(rq, contention_work, &done, false);
+                }
+            }
+        });
+    }
+    for (auto &t : producers)
+        t.join();
+    sem_wait(&done);
+    auto end = std::chrono::steady_clock::now();
+
+    double sec = std::chrono::duration<double>(end - start).count();
+    printf("[%s] %d producers: %.0f ops/sec\n", name, RQ_CONTENTION_THREADS,
+        RQ_CONTENTION_THREADS * RQ_CONTENTION_ITEMS / sec);
+}
+
+TEST(runqueue, submit_contention_benchmark) {
+    ASSERT_EQ(_rq_new_thread(&bench_locked_rq, NULL, 0, 5), 0);
+    ASSERT_EQ(_rq_new_thread(&bench_lf_rq, NULL, 0, 5), 0);
+    for (int i = 0; i < 3; i++) {
+        rq_contention_benchmark("locked", &bench_locked_rq, false);
+        rq_contention_benchmark("lock-free", &bench_lf_rq, true);
+    }
+}
+
+#ifdef CONFIG_BASEWORK_RQ_STATS
+/*
+ * Run-queue statistics
+ */
+RQ_DEFINE(stats_rq, 32, );
+
+static void stats_work(void *arg) {
+    usleep(100);
+}
+
+static void stats_done(void *arg) {
+    sem_post((sem_t *)arg);
+}
+
+TEST(runqueue, stats) {
+    sem_t sync;
+    uint32_t n = 0;
+
+    sem_init(&sync, 0, 0);
+    ASSERT_EQ(_rq_new_thread(&stats_rq, NULL, 0, 5), 0);
+    _rq_stats_reset(&stats_rq);
+    for (int i = 0; i < 20; i++)
+        ASSERT_EQ(_rq_submit(&stats_rq, stats_work, NULL, false), 0);
+    ASSERT_EQ(_rq_submit(&stats_rq, stats_done, &sync, false), 0);
+    sem_wait(&sync);
+
+    ASSERT_GE(stats_rq.stats.nr_max, 1);
+    for (int i = 0; i < RQ_HIST_BUCKETS; i++)
+        n += stats_rq.stats.latency.bucket[i];
+    ASSERT_EQ(n, 21u);
+    ASSERT_EQ(stats_rq.stats.nfns, 2);
+    _rq_dump(&stats_rq);
+}
+#endif /* CONFIG_BASEWORK_RQ_STATS */
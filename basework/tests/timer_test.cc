@@ -14,7 +14,13 @@
 #include <thread>
 #endif
 
+#include <errno.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
 #include "basework/os/osapi_timer.h"
+#include "basework/lib/timer/timer_list.h"
 #include "gtest/gtest.h"
 
 static volatile int timer_cb_1_counter;
@@ -59,3 +65,150 @@ TEST(timer, run) {
 
     os_timer_destroy(timer);
 }
+
+static std::atomic<int> timer_batch_counter;
+
+static void timer_batch_cb(os_timer_t timer, void *arg) {
+    (void) timer;
+    (void) arg;
+    timer_batch_counter++;
+}
+
+TEST(timer, batch) {
+    os_timer_t timers[40];
+    int err;
+
+    timer_batch_counter = 0;
+    for (int i = 0; i < 40; i++) {
+        err = os_timer_create(&timers[i], timer_batch_cb, NULL, false);
+        ASSERT_EQ(err, 0);
+        os_timer_add(timers[i], 10 + (i * 37) % 200);
+    }
+    for (int i = 0; i < 40; i += 4)
+        os_timer_del(timers[i]);
+    for (int i = 1; i < 40; i += 4)
+        os_timer_mod(timers[i], 20);
+
+#ifdef _WIN32
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+#else
+    usleep(500000);
+#endif
+    EXPECT_EQ(timer_batch_counter, 30);
+    for (int i = 0; i < 40; i++)
+        os_timer_destroy(timers[i]);
+}
+
+static std::atomic<int> timer_destroy_counter;
+
+static void timer_destroy_cb(os_timer_t timer, void *arg) {
+    (void) timer;
+    (void) arg;
+#ifdef _WIN32
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+#else
+    usleep(2000);
+#endif
+    timer_destroy_counter++;
+}
+
+static void timer_self_destroy_cb(os_timer_t timer, void *arg) {
+    os_timer_destroy(timer);
+    sem_post((sem_t *)arg);
+}
+
+TEST(timer, destroy) {
+    os_timer_t timers[16];
+    os_timer_t timer;
+    sem_t sem;
+    int fired;
+
+    timer_destroy_counter = 0;
+    for (int i = 0; i < 16; i++) {
+        ASSERT_EQ(os_timer_create(&timers[i], timer_destroy_cb, NULL, i & 1), 0);
+        os_timer_add(timers[i], 1);
+    }
+#ifdef _WIN32
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+#else
+    usleep(3000);
+#endif
+
+    /* The expired callbacks are done or dropped after destroyed */
+    for (int i = 0; i < 16; i++)
+        os_timer_destroy(timers[i]);
+    fired = timer_destroy_counter;
+#ifdef _WIN32
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+#else
+    usleep(50000);
+#endif
+    EXPECT_EQ(timer_destroy_counter, fired);
+
+    /* The timer can be destroyed by its callback */
+    sem_init(&sem, 0, 0);
+    ASSERT_EQ(os_timer_create(&timer, timer_self_destroy_cb, &sem, false), 0);
+    os_timer_add(timer, 1);
+    EXPECT_EQ(sem_wait(&sem), 0);
+}
+
+static int timer_list_order[8];
+static int timer_list_fired;
+
+static void timer_list_cb(struct timer_list *timer, void *arg) {
+    (void) timer;
+    timer_list_order[timer_list_fired++] = (int)(intptr_t)arg;
+}
+
+TEST(timer_list, order) {
+    static const long expires[] = {30, 5, 300, 5, 70000, 1};
+    struct timer_list timers[6];
+    long ticks;
+
+    timer_list_fired = 0;
+    for (int i = 0; i < 6; i++) {
+        timer_init(&timers[i], timer_list_cb, (void *)(intptr_t)i);
+        ASSERT_EQ(timer_add(&timers[i], expires[i]), 0);
+    }
+    ASSERT_EQ(timer_add(&timers[0], 10), -EBUSY);
+    ASSERT_EQ(timer_del(&timers[2]), 1);
+    ASSERT_EQ(timer_del(&timers[2]), 0);
+
+    timer_schedule(4);
+    ASSERT_EQ(timer_list_fired, 1);
+    timer_schedule(1);
+    ASSERT_EQ(timer_list_fired, 3);
+    for (ticks = 5; ticks + 100 < 70000; ticks += 100)
+        timer_schedule(100);
+    ASSERT_EQ(timer_list_fired, 4);
+    timer_schedule(100);
+    ASSERT_EQ(timer_list_fired, 5);
+    EXPECT_EQ(timer_schedule(1), 0);
+
+    EXPECT_EQ(timer_list_order[0], 5);
+    EXPECT_EQ(timer_list_order[1], 1);
+    EXPECT_EQ(timer_list_order[2], 3);
+    EXPECT_EQ(timer_list_order[3], 0);
+    EXPECT_EQ(timer_list_order[4], 4);
+}
+
+TEST(timer_list, benchmark) {
+    static struct timer_list timers[10000];
+    const int n = sizeof(timers) / sizeof(timers[0]);
+
+    for (int i = 0; i < n; i++)
+        timer_init(&timers[i], timer_list_cb, NULL);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        timer_add(&timers[i], 1 + (i * 7919) % 60000);
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+        timer_del(&timers[i]);
+    auto end = std::chrono::steady_clock::now();
+
+    printf("timer_list: insert %lld ns/op, cancel %lld ns/op\n",
+        (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count() / n,
+        (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count() / n);
+    EXPECT_EQ(timer_schedule(1), 0);
+}
@@ -154,6 +154,11 @@ typedef unsigned long long                      ALIGN_TYPE;
 /* Override the free block marker for byte pools to be a 64-bit constant.   */
 
 #define TX_BYTE_BLOCK_FREE                      ((ALIGN_TYPE) 0xFFFFEEEEFFFFEEEE)
+
+/* A pointer doesn't fit in the ULONG entry input of threads and timers, enable the
+   extension pointer macros of tx_api.h.  */
+
+#define TX_64_BIT
 #endif
 
 /* Define automated coverage test extensions...  These are required for the
@@ -534,6 +539,28 @@ VOID   _tx_thread_interrupt_restore(UINT previous_posture);
 #define tx_linux_sem_wait(p)                sem_wait(p)
 
 
+/* Define the scheduler wakeup macro. With TX_LINUX_EVENT_IDLE_ENABLE, the idle scheduler
+   sleeps on a condition variable instead of polling, so the simulated ISR must wake it
+   up when a thread is ready. The Linux mutex must be held by the caller.  */
+
+#ifdef TX_LINUX_EVENT_IDLE_ENABLE
+#define tx_linux_scheduler_wakeup()         pthread_cond_signal(&_tx_linux_scheduler_condition)
+#else
+#define tx_linux_scheduler_wakeup()
+#endif /* TX_LINUX_EVENT_IDLE_ENABLE */
+
+
+/* Define the timer wakeup macro. With TX_LINUX_TICKLESS_ENABLE, the timer thread stops the
+   periodic tick while the system is idle, so the simulated ISR must wake it up when a thread
+   is ready. The Linux mutex must be held by the caller.  */
+
+#ifdef TX_LINUX_TICKLESS_ENABLE
+#define tx_linux_timer_wakeup()             _tx_linux_timer_wakeup()
+#else
+#define tx_linux_timer_wakeup()
+#endif /* TX_LINUX_TICKLESS_ENABLE */
+
+
 /* Define the interrupt lockout macros for each ThreadX object.  */
 
 #define TX_BLOCK_POOL_DISABLE               TX_DISABLE
@@ -559,6 +586,9 @@ extern  CHAR                    _tx_version_id[];
 extern pthread_mutex_t                          _tx_linux_mutex;
 extern sem_t                                    _tx_linux_semaphore;
 extern sem_t                                    _tx_linux_semaphore_no_idle;
+#ifdef TX_LINUX_EVENT_IDLE_ENABLE
+extern pthread_cond_t                           _tx_linux_scheduler_condition;
+#endif /* TX_LINUX_EVENT_IDLE_ENABLE */
 extern ULONG                                    _tx_linux_global_int_disabled_flag;
 extern struct timespec                          _tx_linux_time_stamp;
 extern __thread int                             _tx_linux_threadx_thread;
@@ -567,6 +597,9 @@ extern __thread int                             _tx_linux_threadx_thread;
 void    _tx_linux_thread_suspend(pthread_t thread_id);
 void    _tx_linux_thread_resume(pthread_t thread_id);
 void    _tx_linux_thread_init(void);
+#ifdef TX_LINUX_TICKLESS_ENABLE
+void    _tx_linux_timer_wakeup(void);
+#endif /* TX_LINUX_TICKLESS_ENABLE */
 
 #ifndef TX_LINUX_MEMORY_SIZE
 #define TX_LINUX_MEMORY_SIZE                    (512 * 1024)
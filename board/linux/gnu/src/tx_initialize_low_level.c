@@ -27,6 +27,8 @@
 /* Include necessary system files.  */
 
 #include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_timer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -40,6 +42,9 @@
 pthread_mutex_t     _tx_linux_mutex;
 sem_t               _tx_linux_semaphore;
 sem_t               _tx_linux_semaphore_no_idle;
+#ifdef TX_LINUX_EVENT_IDLE_ENABLE
+pthread_cond_t      _tx_linux_scheduler_condition;
+#endif /* TX_LINUX_EVENT_IDLE_ENABLE */
 ULONG               _tx_linux_global_int_disabled_flag;
 struct timespec     _tx_linux_time_stamp;
 __thread int        _tx_linux_threadx_thread = 0;
@@ -68,12 +73,6 @@ void    _tx_linux_thread_suspend(pthread_t thread_id);
 
 #ifdef TX_LINUX_DEBUG_ENABLE
 
-extern ULONG        _tx_thread_system_state;
-extern UINT         _tx_thread_preempt_disable;
-extern TX_THREAD    *_tx_thread_current_ptr;
-extern TX_THREAD    *_tx_thread_execute_ptr;
-
-
 /* Define debug log in order to debug Linux issues with this port.  */
 
 typedef struct TX_LINUX_DEBUG_ENTRY_STRUCT
@@ -271,6 +270,9 @@ cpu_set_t mask;
 #ifdef TX_LINUX_NO_IDLE_ENABLE
     sem_init(&_tx_linux_semaphore_no_idle, 0, 0);
 #endif /* TX_LINUX_NO_IDLE_ENABLE */
+#ifdef TX_LINUX_EVENT_IDLE_ENABLE
+    pthread_cond_init(&_tx_linux_scheduler_condition, NULL);
+#endif /* TX_LINUX_EVENT_IDLE_ENABLE */
 
     /* Initialize the global interrupt disabled flag.  */
     _tx_linux_global_int_disabled_flag =  TX_FALSE;
@@ -315,6 +317,225 @@ void    _tx_initialize_start_interrupts(void)
 }
 
 
+#ifdef TX_LINUX_TICKLESS_ENABLE
+
+/* Define the tickless support of the timer interrupt.  While no thread is ready, nothing
+   but the timer list can make progress, so the timer thread sleeps until the next
+   expiration instead of ticking, and catches up _tx_timer_system_clock on wakeup.  */
+
+static UINT     _tx_linux_timer_idle;
+
+
+/* Return the number of ticks until the next timer list or time-slice event, or zero if
+   there is none.  The Linux mutex must be held by the caller.  */
+
+static ULONG    _tx_linux_timer_next_event(void)
+{
+TX_TIMER_INTERNAL   **timer_list;
+ULONG               ticks;
+
+    /* A timer in the list entry at distance n from the current entry expires on tick n + 1.  */
+    timer_list =  _tx_timer_current_ptr;
+    for (ticks = 1; ticks <= TX_TIMER_ENTRIES; ticks++)
+    {
+        if (*timer_list != TX_NULL)
+            break;
+        timer_list++;
+        if (timer_list == _tx_timer_list_end)
+            timer_list =  _tx_timer_list_start;
+    }
+    if (ticks > TX_TIMER_ENTRIES)
+        ticks =  0;
+
+    /* The time-slice expires when it is decremented to zero.  */
+    if ((_tx_timer_time_slice) && ((ticks == 0) || (_tx_timer_time_slice < ticks)))
+        ticks =  _tx_timer_time_slice;
+    return(ticks);
+}
+
+
+/* Advance the timer state by ticks that are known to expire nothing.  This is what
+   _tx_timer_interrupt would do for each of these ticks.  The Linux mutex must be held
+   by the caller.  */
+
+static VOID     _tx_linux_timer_advance(ULONG ticks)
+{
+
+    _tx_timer_system_clock +=  ticks;
+    if (_tx_timer_time_slice)
+        _tx_timer_time_slice -=  ticks;
+    _tx_timer_current_ptr =  _tx_timer_list_start +
+        ((ULONG)(_tx_timer_current_ptr - _tx_timer_list_start) + ticks) % TX_TIMER_ENTRIES;
+}
+
+
+/* Restart the periodic tick because a simulated ISR readied a thread while the timer
+   thread is sleeping for the next timer event.  The Linux mutex must be held by the
+   caller.  */
+
+void    _tx_linux_timer_wakeup(void)
+{
+
+    if (_tx_linux_timer_idle)
+    {
+        _tx_linux_timer_idle =  TX_FALSE;
+        sem_post(&_tx_linux_timer_semaphore);
+    }
+}
+
+
+static long long    _tx_linux_timer_now(void)
+{
+struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return((long long)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+
+/* Define the ThreadX system timer interrupt.  Other interrupts may be simulated
+   in a similar way.  */
+
+void    *_tx_linux_timer_interrupt(void *p)
+{
+struct timespec ts;
+long long       tick_time;
+long long       now;
+long            timer_periodic_nsec;
+ULONG           ticks;
+ULONG           skip;
+UINT            pending;
+int             err;
+
+    (VOID)p;
+
+    /* Calculate periodic timer. */
+    timer_periodic_nsec = 1000000000 / TX_TIMER_TICKS_PER_SECOND;
+    nice(10);
+
+    /* Wait startup semaphore. */
+    tx_linux_sem_wait(&_tx_linux_timer_semaphore);
+
+    /* Ticks are counted from this point, so a late wakeup does not cause drift.  */
+    tick_time =  _tx_linux_timer_now();
+
+    while(1)
+    {
+
+        /* Tick periodically while any thread is ready, otherwise sleep until the
+           next timer event.  */
+        tx_linux_mutex_lock(_tx_linux_mutex);
+        if ((_tx_thread_current_ptr == TX_NULL) && (_tx_thread_execute_ptr == TX_NULL))
+        {
+            ticks =  _tx_linux_timer_next_event();
+            _tx_linux_timer_idle =  TX_TRUE;
+        }
+        else
+        {
+            ticks =  1;
+            _tx_linux_timer_idle =  TX_FALSE;
+        }
+        tx_linux_mutex_unlock(_tx_linux_mutex);
+
+        if (ticks == 0)
+        {
+
+            /* No timer is active, wait for a simulated ISR to ready a thread.  */
+            while (sem_wait(&_tx_linux_timer_semaphore) != 0)
+            {
+            }
+        }
+        else
+        {
+            now =  tick_time + (long long)ticks * timer_periodic_nsec;
+            ts.tv_sec =  now / 1000000000;
+            ts.tv_nsec =  now % 1000000000;
+            do
+            {
+                if (sem_timedwait(&_tx_linux_timer_semaphore, &ts) == 0)
+                {
+                    break;
+                }
+                err = errno;
+            } while (err != ETIMEDOUT);
+        }
+
+        /* Calculate the elapsed ticks.  A wakeup within the current tick only
+           re-evaluates the sleep time.  */
+        now =  _tx_linux_timer_now();
+        if (now - tick_time < timer_periodic_nsec)
+        {
+            continue;
+        }
+        ticks =  (ULONG)((now - tick_time) / timer_periodic_nsec);
+        tick_time +=  (long long)ticks * timer_periodic_nsec;
+
+        /* Skip the ticks before the next timer event without interrupting the
+           running thread.  */
+        tx_linux_mutex_lock(_tx_linux_mutex);
+        _tx_linux_timer_idle =  TX_FALSE;
+        skip =  _tx_linux_timer_next_event();
+        skip =  ((skip == 0) || (skip > ticks)) ? ticks : skip - 1;
+        _tx_linux_timer_advance(skip);
+        tx_linux_mutex_unlock(_tx_linux_mutex);
+        ticks -=  skip;
+
+        /* Deliver the remaining ticks one simulated interrupt each.  A tick that
+           expires a timer leaves the timer list pointer on the expired entry for
+           the timer thread, so no further tick is delivered until it has run.  */
+        while (ticks)
+        {
+            tx_linux_mutex_lock(_tx_linux_mutex);
+            pending =  _tx_timer_expired;
+            tx_linux_mutex_unlock(_tx_linux_mutex);
+            if (pending)
+            {
+                break;
+            }
+
+            /* Call ThreadX context save for interrupt preparation.  */
+            _tx_thread_context_save();
+
+            /* Call trace ISR enter event insert.  */
+            _tx_trace_isr_enter_insert(0);
+
+            /* Call the ThreadX system timer interrupt processing.  */
+            _tx_timer_interrupt();
+
+            /* Call trace ISR exit event insert.  */
+            _tx_trace_isr_exit_insert(0);
+
+            /* Call ThreadX context restore for interrupt completion.  */
+            _tx_thread_context_restore();
+            ticks--;
+        }
+
+        /* Keep the undelivered ticks pending and give the timer thread a moment to
+           process the expiration.  They are counted again on the next pass.  */
+        if (ticks)
+        {
+            tick_time -=  (long long)ticks * timer_periodic_nsec;
+            ts.tv_sec =  0;
+            ts.tv_nsec =  timer_periodic_nsec / 20;
+            nanosleep(&ts, TX_NULL);
+        }
+
+#ifdef TX_LINUX_NO_IDLE_ENABLE
+        tx_linux_mutex_lock(_tx_linux_mutex);
+
+        /* Make sure semaphore is 0. */
+        while(!sem_trywait(&_tx_linux_semaphore_no_idle));
+
+        /* Wakeup the system thread by setting the system semaphore.  */
+        tx_linux_sem_post(&_tx_linux_semaphore_no_idle);
+
+        tx_linux_mutex_unlock(_tx_linux_mutex);
+#endif /* TX_LINUX_NO_IDLE_ENABLE */
+    }
+}
+
+#else
+
 /* Define the ThreadX system timer interrupt.  Other interrupts may be simulated
    in a similar way.  */
 
@@ -381,6 +602,8 @@ int err;
     } 
 }
 
+#endif /* TX_LINUX_TICKLESS_ENABLE */
+
 /* Define functions for linux thread. */
 void    _tx_linux_thread_resume_handler(int sig)
 {
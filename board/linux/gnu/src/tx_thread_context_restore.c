@@ -65,6 +65,8 @@ UINT _tx_linux_timer_waiting = 0;
 /*    tx_linux_sem_post                                                   */ 
 /*    tx_linux_sem_wait                                                   */ 
 /*    _tx_linux_thread_resume                                             */ 
+/*    tx_linux_scheduler_wakeup                                           */
+/*    tx_linux_timer_wakeup                                               */
 /*    tx_linux_mutex_recursive_unlock                                     */ 
 /*                                                                        */ 
 /*  CALLED BY                                                             */ 
@@ -122,9 +124,6 @@ VOID   _tx_thread_context_restore(VOID)
             /* Make sure semaphore is 0. */
             while(!sem_trywait(&_tx_linux_semaphore));
 
-            /* Indicate it is in timer ISR. */
-            _tx_linux_timer_waiting = 1;
-
             /* Wakeup the system thread by setting the system semaphore.  */
             tx_linux_sem_post(&_tx_linux_semaphore);
 
@@ -133,6 +132,11 @@ VOID   _tx_thread_context_restore(VOID)
                 if(_tx_thread_execute_ptr -> tx_thread_linux_suspension_type == 0)
                 {
 
+                    /* Indicate it is in ISR. This is a count, since the driver ISRs
+                       may wait here together with the timer ISR, the scheduler
+                       posts the ISR semaphore once for each of them.  */
+                    _tx_linux_timer_waiting++;
+
                     /* Unlock linux mutex. */
                     tx_linux_mutex_recursive_unlock(_tx_linux_mutex);
 
@@ -140,14 +144,8 @@ VOID   _tx_thread_context_restore(VOID)
                     tx_linux_sem_wait(&_tx_linux_isr_semaphore);
 
                     tx_linux_mutex_lock(_tx_linux_mutex);
-
-                    /* Make sure semaphore is 0. */
-                    while(!sem_trywait(&_tx_linux_isr_semaphore));
                 }
             }
-
-            /* Indicate it is not in timer ISR. */
-            _tx_linux_timer_waiting = 0;
         }
         else
         {
@@ -156,6 +154,14 @@ VOID   _tx_thread_context_restore(VOID)
             _tx_linux_thread_resume(_tx_thread_current_ptr -> tx_thread_linux_thread_id);
         }
     }
+    else if ((!_tx_thread_system_state) && (_tx_thread_execute_ptr))
+    {
+
+        /* The system was idle and the ISR made a thread ready, wake up the scheduler
+           and restart the periodic tick.  */
+        tx_linux_scheduler_wakeup();
+        tx_linux_timer_wakeup();
+    }
 
     /* Unlock linux mutex. */
     tx_linux_mutex_recursive_unlock(_tx_linux_mutex);
@@ -69,6 +69,7 @@ extern pthread_t _tx_linux_timer_id;
 /*    tx_linux_sem_post                                                   */
 /*    sem_trywait                                                         */
 /*    tx_linux_sem_wait                                                   */
+/*    pthread_cond_wait                                                   */
 /*                                                                        */
 /*  CALLED BY                                                             */
 /*                                                                        */
@@ -83,11 +84,13 @@ extern pthread_t _tx_linux_timer_id;
 /**************************************************************************/
 VOID   _tx_thread_schedule(VOID)
 {
+#ifndef TX_LINUX_EVENT_IDLE_ENABLE
 struct timespec ts;
 
     /* Set timer. */
     ts.tv_sec = 0;
     ts.tv_nsec = 200000;
+#endif /* TX_LINUX_EVENT_IDLE_ENABLE */
 
     /* Loop forever.  */
     while(1)
@@ -111,6 +114,17 @@ struct timespec ts;
             else
             {
 
+#ifdef TX_LINUX_EVENT_IDLE_ENABLE
+
+                /* Sleep until a simulated ISR makes a thread ready. The Linux mutex
+                   is released while waiting, and the ISR wakes us up in
+                   _tx_thread_context_restore.  */
+                pthread_cond_wait(&_tx_linux_scheduler_condition, &_tx_linux_mutex);
+
+                /* Unlock linux mutex. */
+                tx_linux_mutex_unlock(_tx_linux_mutex);
+#else
+
                 /* Unlock linux mutex. */
                 tx_linux_mutex_unlock(_tx_linux_mutex);
 
@@ -131,6 +145,7 @@ struct timespec ts;
 #else                
                 nanosleep(&ts, &ts);
 #endif /* TX_LINUX_NO_IDLE_ENABLE */                
+#endif /* TX_LINUX_EVENT_IDLE_ENABLE */
             }
         }
 
@@ -156,6 +171,13 @@ struct timespec ts;
             /* Pseudo interrupt suspension.  The thread is not waiting on
                its run semaphore.  */
             _tx_linux_thread_resume(_tx_thread_current_ptr -> tx_thread_linux_thread_id);
+
+            /* Wake up the ISRs waiting for a thread to run.  */
+            while(_tx_linux_timer_waiting)
+            {
+                _tx_linux_timer_waiting--;
+                tx_linux_sem_post_nolock(&_tx_linux_isr_semaphore);
+            }
         }
         else
         {
@@ -177,8 +199,12 @@ struct timespec ts;
                 /* Let ThreadX thread wake up first. */
                 tx_linux_sem_wait(&_tx_linux_semaphore);
 
-                /* Wake up timer ISR. */
-                tx_linux_sem_post_nolock(&_tx_linux_isr_semaphore);
+                /* Wake up timer ISR and the other ISRs waiting with it. */
+                while(_tx_linux_timer_waiting)
+                {
+                    _tx_linux_timer_waiting--;
+                    tx_linux_sem_post_nolock(&_tx_linux_isr_semaphore);
+                }
             }
             else
             {
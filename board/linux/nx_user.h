@@ -437,9 +437,7 @@
 
 /* This define specifies the number of TCP packets to receive before sending an ACK. */
 /* The default value is 2: ack every 2 packets.                                      */
-/*
 #define NX_TCP_ACK_EVERY_N_PACKETS  2
-*/
 
 /* Automatically define NX_TCP_ACK_EVERY_N_PACKETS to 1 if NX_TCP_IMMEDIATE_ACK is defined.
    This is needed for backward compatibility. */
@@ -478,6 +476,37 @@
 #define NX_ENABLE_TCP_WINDOW_SCALING
 */
 
+/* Defined, this option enables TCP selective acknowledgements (RFC 2018). The SACK-permitted option is
+   negotiated on connection setup, ACKs report the out-of-order data held in the receive queue and fast
+   recovery retransmits only the ranges the peer is missing. Default disabled.  */
+/*
+#define NX_ENABLE_TCP_SACK
+*/
+
+/* Defined, this option adds the CUBIC congestion control algorithm (RFC 8312), which a TCP socket
+   selects with nx_tcp_socket_congestion_control_set(socket_ptr, &_nx_tcp_congestion_control_cubic).
+   CUBIC grows the window as a function of the time since the last loss instead of once per round
+   trip, so links with a large bandwidth-delay product are filled much sooner. Sockets use Reno
+   unless told otherwise. Default disabled.  */
+/*
+#define NX_ENABLE_TCP_CUBIC
+*/
+
+/* Defined, this option lets TCP send an IPv4 packet larger than the MSS as one super-segment of up to
+   NX_TCP_LARGE_SEND_SIZE bytes. It is cut into MSS segments just before the driver, or by a driver
+   that advertises NX_INTERFACE_CAPABILITY_TCP_SEGMENTATION, so IP and TCP run once per super-segment
+   instead of once per segment. Requires NX_ENABLE_INTERFACE_CAPABILITY. Default disabled.  */
+/*
+#define NX_ENABLE_TCP_LARGE_SEND
+*/
+
+/* Defined, this option merges the in-order data segments of a connection waiting in the TCP queue of
+   the IP thread into one packet, up to NX_TCP_RECEIVE_COALESCING_SEGMENTS, before TCP processes them.
+   Received TCP packets are always deferred to the IP thread when this is defined. Default disabled.  */
+/*
+#define NX_ENABLE_TCP_RECEIVE_COALESCING
+*/
+
 /* Defined, this option disables the reset processing during disconnect when the timeout value is
    specified as NX_NO_WAIT.  */
 /*
@@ -771,9 +800,5 @@
 #define NX_ENABLE_TCPIP_OFFLOAD
 */
 
-#if defined(__x86_64__) && __x86_64__
-#define NX_THREAD_EXTENSION_PTR_GET(a, b, c)  (a) = (b *)(0x0000555500000000ULL | (c)); 
-#endif
-
 #endif
 
@@ -157,6 +157,12 @@ extern   "C" {
 #endif /* NX_ENABLE_INTERFACE_CAPABILITY */
 #endif /* NX_ENABLE_TCPIP_OFFLOAD */
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+#ifndef NX_ENABLE_INTERFACE_CAPABILITY
+#error "NX_ENABLE_INTERFACE_CAPABILITY must be defined to enable TCP large send"
+#endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
 /* Define symbols for compatibility before and after ThreadX 5.8. */
 #if (((THREADX_MAJOR_VERSION << 8) | THREADX_MINOR_VERSION) >= 0x0508)
 #define NX_CLEANUP_PARAMETER , ULONG suspension_sequence
@@ -1219,6 +1225,36 @@ typedef struct NX_IPV6_DEFAULT_ROUTER_ENTRY_STRUCT
 #define NX_MAX_LISTEN_REQUESTS                     10
 #endif
 
+/* Define the number of selectively acknowledged ranges a TCP socket keeps track of.
+   This is only used when NX_ENABLE_TCP_SACK is defined.  */
+
+#ifndef NX_TCP_SACK_SCOREBOARD_SIZE
+#define NX_TCP_SACK_SCOREBOARD_SIZE                8
+#endif
+
+/* Define the number of ULONGs a TCP socket reserves for the private state of its congestion
+   control algorithm.  */
+
+#ifndef NX_TCP_CONGESTION_STATE_SIZE
+#define NX_TCP_CONGESTION_STATE_SIZE               8
+#endif
+
+/* Define the largest payload of a TCP super-segment. A super-segment is cut into MSS sized
+   segments by the IP layer, or by a driver that supports TCP segmentation offload.
+   This is only used when NX_ENABLE_TCP_LARGE_SEND is defined.  */
+
+#ifndef NX_TCP_LARGE_SEND_SIZE
+#define NX_TCP_LARGE_SEND_SIZE                     65000
+#endif
+
+/* Define the maximum number of in-order segments of a TCP connection that are merged into
+   one packet before TCP processing. This is only used when NX_ENABLE_TCP_RECEIVE_COALESCING
+   is defined.  */
+
+#ifndef NX_TCP_RECEIVE_COALESCING_SEGMENTS
+#define NX_TCP_RECEIVE_COALESCING_SEGMENTS         16
+#endif
+
 /* Define the max length of username and password for HTTP Proxy authentication.  */
 
 /* Define the max length of username.  */
@@ -1394,6 +1430,7 @@ typedef struct NX_IPV6_DEFAULT_ROUTER_ENTRY_STRUCT
 #define NX_INTERFACE_CAPABILITY_IGMP_RX_CHECKSUM   0x00000800
 #define NX_INTERFACE_CAPABILITY_PTP_TIMESTAMP      0x00001000
 #define NX_INTERFACE_CAPABILITY_TCPIP_OFFLOAD      0x00002000
+#define NX_INTERFACE_CAPABILITY_TCP_SEGMENTATION   0x00004000
 #define NX_INTERFACE_CAPABILITY_CHECKSUM_ALL       (NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM | \
                                                     NX_INTERFACE_CAPABILITY_IPV4_RX_CHECKSUM | \
                                                     NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM | \
@@ -1629,6 +1666,12 @@ typedef  struct NX_PACKET_STRUCT
     ULONG       nx_packet_interface_capability_flag;
 #endif /* NX_ENABLE_INTERFACE_CAPABILITY */
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+    /* Define the payload size of the segments a TCP super-segment is cut into.
+       It is zero for all other packets.  */
+    ULONG       nx_packet_tcp_segment_size;
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
 #ifdef NX_IPSEC_ENABLE
     VOID        *nx_packet_ipsec_sa_ptr;
 
@@ -1879,6 +1922,40 @@ typedef struct NX_UDP_SOCKET_STRUCT
 #endif
 
 
+/* Define the TCP congestion control operations.  A socket runs the Reno algorithm unless
+   another table is installed with nx_tcp_socket_congestion_control_set.  The operations
+   are called with the IP protection mutex held and may only change the slow start
+   threshold, the congestion window and the private state of the socket.  Fast recovery
+   itself (window inflation and deflation, RFC 6582) is handled by the TCP layer.  */
+
+struct NX_TCP_SOCKET_STRUCT;
+
+typedef struct NX_TCP_CONGESTION_CONTROL_STRUCT
+{
+
+    /* Define the name of the algorithm.  */
+    CHAR        *nx_tcp_congestion_control_name;
+
+    /* Called when the connection is established, after the initial window is set.  */
+    VOID        (*nx_tcp_congestion_control_init)(struct NX_TCP_SOCKET_STRUCT *socket_ptr);
+
+    /* Called for an ACK of new data outside fast recovery, grows the congestion window.  */
+    VOID        (*nx_tcp_congestion_control_on_ack)(struct NX_TCP_SOCKET_STRUCT *socket_ptr, ULONG acked_bytes);
+
+    /* Called when fast retransmit starts, sets the slow start threshold.  The congestion
+       window is then set to the threshold plus three segments by the caller.  */
+    VOID        (*nx_tcp_congestion_control_on_loss)(struct NX_TCP_SOCKET_STRUCT *socket_ptr);
+
+    /* Called on a retransmission timeout, sets the slow start threshold.  The congestion
+       window is then set to one segment by the caller.  */
+    VOID        (*nx_tcp_congestion_control_on_rto)(struct NX_TCP_SOCKET_STRUCT *socket_ptr);
+
+    /* Returns the rate in bytes per second the socket should be paced at, or zero if
+       there is no estimate yet.  */
+    ULONG       (*nx_tcp_congestion_control_pacing_rate)(struct NX_TCP_SOCKET_STRUCT *socket_ptr);
+} NX_TCP_CONGESTION_CONTROL;
+
+
 /* Define the basic TCP socket structure.  This structure is used to manage all information
    necessary to manage TCP transmission and reception.  */
 
@@ -1946,6 +2023,18 @@ typedef struct NX_TCP_SOCKET_STRUCT
     /* Counter for duplicated ACK  */
     UINT        nx_tcp_socket_duplicated_ack_received;
 
+    /* Define the congestion control algorithm and its private per connection state.  */
+    const NX_TCP_CONGESTION_CONTROL
+                *nx_tcp_socket_congestion_control;
+    ULONG       nx_tcp_socket_congestion_state[NX_TCP_CONGESTION_STATE_SIZE];
+
+    /* Define the round trip time measurement.  One segment is timed at a time, the smoothed
+       round trip time is in timer ticks scaled by 8 and zero until the first sample.  */
+    ULONG       nx_tcp_socket_rtt_smoothed;
+    ULONG       nx_tcp_socket_rtt_sequence;
+    ULONG       nx_tcp_socket_rtt_time;
+    ULONG       nx_tcp_socket_rtt_timing;
+
     /* Define the window size fields of the TCP socket structure.  */
     ULONG       nx_tcp_socket_rx_window_default;
     ULONG       nx_tcp_socket_rx_window_current;
@@ -2038,6 +2127,26 @@ typedef struct NX_TCP_SOCKET_STRUCT
     ULONG       nx_tcp_snd_win_scale_value;
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
 
+#ifdef NX_ENABLE_TCP_SACK
+    /* Set when the peer offered the SACK-permitted option in its SYN. */
+    ULONG       nx_tcp_socket_sack_permitted;
+
+    /* Start of the most recently received out-of-order segment, reported in the first SACK block. */
+    ULONG       nx_tcp_socket_sack_recent;
+
+    /* End of the data retransmitted so far in the current fast recovery. */
+    ULONG       nx_tcp_socket_sack_high_retransmit;
+
+    /* Ranges of outstanding data the peer has selectively acknowledged. */
+    ULONG       nx_tcp_socket_sack_count;
+    ULONG       nx_tcp_socket_sack_begin[NX_TCP_SACK_SCOREBOARD_SIZE];
+    ULONG       nx_tcp_socket_sack_end[NX_TCP_SACK_SCOREBOARD_SIZE];
+
+    /* Span of the ranges that did not fit in the scoreboard, empty when begin equals end. */
+    ULONG       nx_tcp_socket_sack_unknown_begin;
+    ULONG       nx_tcp_socket_sack_unknown_end;
+#endif /* NX_ENABLE_TCP_SACK */
+
     /* Define the TCP keepalive timer parameters.  If enabled with NX_ENABLE_TCP_KEEPALIVE,
        these parameters are used to implement the keepalive timer.  */
 #ifdef NX_ENABLE_TCP_KEEPALIVE
@@ -2164,6 +2273,14 @@ typedef struct NX_TCP_SOCKET_STRUCT
 } NX_TCP_SOCKET;
 
 
+/* Define the congestion control algorithms that come with NetX Duo.  */
+
+extern const NX_TCP_CONGESTION_CONTROL  _nx_tcp_congestion_control_reno;
+#ifdef NX_ENABLE_TCP_CUBIC
+extern const NX_TCP_CONGESTION_CONTROL  _nx_tcp_congestion_control_cubic;
+#endif /* NX_ENABLE_TCP_CUBIC */
+
+
 /* Define the basic TCP listen request structure.  This structure is used to indicate
    which, if any, TCP ports are allowing a client connection.  */
 
@@ -2232,6 +2349,10 @@ typedef struct NX_TCP_LISTEN_STRUCT
 #ifndef NX_DISABLE_FRAGMENTATION
 #error "IP fragmentation is not supported if packet chain is disabled."
 #endif /* NX_DISABLE_FRAGMENTATION */
+
+#if defined(NX_ENABLE_TCP_LARGE_SEND) || defined(NX_ENABLE_TCP_RECEIVE_COALESCING)
+#error "TCP large send and receive coalescing are not supported if packet chain is disabled."
+#endif /* NX_ENABLE_TCP_LARGE_SEND || NX_ENABLE_TCP_RECEIVE_COALESCING */
 #endif /* NX_DISABLE_PACKET_CHAIN */
 
 struct NX_IP_DRIVER_STRUCT;
@@ -3272,6 +3393,7 @@ typedef struct NX_IP_DRIVER_STRUCT
 #define nx_tcp_server_socket_unaccept                   _nx_tcp_server_socket_unaccept
 #define nx_tcp_server_socket_unlisten                   _nx_tcp_server_socket_unlisten
 #define nx_tcp_socket_bytes_available                   _nx_tcp_socket_bytes_available
+#define nx_tcp_socket_congestion_control_set            _nx_tcp_socket_congestion_control_set
 #define nx_tcp_socket_create                            _nx_tcp_socket_create
 #define nx_tcp_socket_delete                            _nx_tcp_socket_delete
 #define nx_tcp_socket_disconnect                        _nx_tcp_socket_disconnect
@@ -3281,6 +3403,7 @@ typedef struct NX_IP_DRIVER_STRUCT
 #define nx_tcp_socket_mss_get                           _nx_tcp_socket_mss_get
 #define nx_tcp_socket_mss_peer_get                      _nx_tcp_socket_mss_peer_get
 #define nx_tcp_socket_mss_set                           _nx_tcp_socket_mss_set
+#define nx_tcp_socket_pacing_rate_get                   _nx_tcp_socket_pacing_rate_get
 #define nx_tcp_socket_peer_info_get                     _nx_tcp_socket_peer_info_get
 #define nx_tcp_socket_queue_depth_notify_set            _nx_tcp_socket_queue_depth_notify_set
 #define nx_tcp_socket_receive                           _nx_tcp_socket_receive
@@ -3461,6 +3584,7 @@ typedef struct NX_IP_DRIVER_STRUCT
 #define nx_tcp_server_socket_unaccept                   _nxe_tcp_server_socket_unaccept
 #define nx_tcp_server_socket_unlisten                   _nxe_tcp_server_socket_unlisten
 #define nx_tcp_socket_bytes_available                   _nxe_tcp_socket_bytes_available
+#define nx_tcp_socket_congestion_control_set            _nxe_tcp_socket_congestion_control_set
 #define nx_tcp_socket_create(i, s, n, t, f, l, w, u, d) _nxe_tcp_socket_create(i, s, n, t, f, l, w, u, d, sizeof(NX_TCP_SOCKET))
 #define nx_tcp_socket_delete                            _nxe_tcp_socket_delete
 #define nx_tcp_socket_disconnect                        _nxe_tcp_socket_disconnect
@@ -3470,6 +3594,7 @@ typedef struct NX_IP_DRIVER_STRUCT
 #define nx_tcp_socket_mss_get                           _nxe_tcp_socket_mss_get
 #define nx_tcp_socket_mss_peer_get                      _nxe_tcp_socket_mss_peer_get
 #define nx_tcp_socket_mss_set                           _nxe_tcp_socket_mss_set
+#define nx_tcp_socket_pacing_rate_get                   _nxe_tcp_socket_pacing_rate_get
 #define nx_tcp_socket_peer_info_get                     _nxe_tcp_socket_peer_info_get
 #define nx_tcp_socket_queue_depth_notify_set            _nxe_tcp_socket_queue_depth_notify_set
 #define nx_tcp_socket_receive                           _nxe_tcp_socket_receive
@@ -3735,6 +3860,7 @@ UINT nx_tcp_server_socket_relisten(NX_IP *ip_ptr, UINT port, NX_TCP_SOCKET *sock
 UINT nx_tcp_server_socket_unaccept(NX_TCP_SOCKET *socket_ptr);
 UINT nx_tcp_server_socket_unlisten(NX_IP *ip_ptr, UINT port);
 UINT nx_tcp_socket_bytes_available(NX_TCP_SOCKET *socket_ptr, ULONG *bytes_available);
+UINT nx_tcp_socket_congestion_control_set(NX_TCP_SOCKET *socket_ptr, const NX_TCP_CONGESTION_CONTROL *control_ptr);
 #ifndef NX_DISABLE_ERROR_CHECKING
 UINT _nxe_tcp_socket_create(NX_IP *ip_ptr, NX_TCP_SOCKET *socket_ptr, CHAR *name,
                             ULONG type_of_service, ULONG fragment, UINT time_to_live, ULONG window_size,
@@ -3762,6 +3888,7 @@ UINT nx_tcp_socket_info_get(NX_TCP_SOCKET *socket_ptr, ULONG *tcp_packets_sent,
 UINT nx_tcp_socket_mss_get(NX_TCP_SOCKET *socket_ptr, ULONG *mss);
 UINT nx_tcp_socket_mss_peer_get(NX_TCP_SOCKET *socket_ptr, ULONG *peer_mss);
 UINT nx_tcp_socket_mss_set(NX_TCP_SOCKET *socket_ptr, ULONG mss);
+UINT nx_tcp_socket_pacing_rate_get(NX_TCP_SOCKET *socket_ptr, ULONG *pacing_rate);
 UINT nx_tcp_socket_peer_info_get(NX_TCP_SOCKET *socket_ptr, ULONG *peer_ip_address, ULONG *peer_port);
 UINT nx_tcp_socket_queue_depth_notify_set(NX_TCP_SOCKET *socket_ptr,
                                           VOID (*tcp_socket_queue_depth_notify)(NX_TCP_SOCKET *));
@@ -110,6 +110,7 @@
 UINT   _nx_ip_auxiliary_packet_pool_set(NX_IP *ip_ptr, NX_PACKET_POOL *auxiliary_pool);
 USHORT _nx_ip_checksum_compute(NX_PACKET *packet_ptr, ULONG protocol, UINT data_length,
                                ULONG *_src_ip_addr, ULONG *_dest_ip_addr);
+ULONG  _nx_ip_checksum_partial_compute(UCHAR *data_ptr, UINT length);
 UINT   _nx_ip_interface_address_mapping_configure(NX_IP *ip_ptr, UINT interface_index, UINT mapping_needed);
 UINT   _nx_ip_interface_capability_get(NX_IP *ip_ptr, UINT interface_index, ULONG *interface_capability_flag);
 UINT   _nx_ip_interface_capability_set(NX_IP *ip_ptr, UINT interface_index, ULONG interface_capability_flag);
@@ -174,6 +175,9 @@ VOID _nx_ip_fragment_assembly(NX_IP *ip_ptr);
 #ifdef NX_ENABLE_INTERFACE_CAPABILITY
 VOID _nx_ip_packet_checksum_compute(NX_PACKET *packet_ptr);
 #endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+VOID _nx_ip_segment_packet(struct NX_IP_DRIVER_STRUCT *driver_req_ptr);
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
 
 
 /* Define error checking shells for API services.  These are only referenced by the
@@ -98,6 +98,13 @@
 #ifdef NX_ENABLE_TCP_WINDOW_SCALING
 #define NX_TCP_RWIN_KIND                0x03                /* RWIN option kind             */
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
+#ifdef NX_ENABLE_TCP_SACK
+#define NX_TCP_SACK_PERMIT_OPTION       ((ULONG)0x01010402) /* NOP, NOP, SACK permitted     */
+#define NX_TCP_SACK_PERMIT_KIND         0x04                /* SACK permitted option kind   */
+#define NX_TCP_SACK_KIND                0x05                /* SACK option kind             */
+#define NX_TCP_SACK_MAX_BLOCKS          4                   /* Blocks that fit in 40 bytes  */
+#define NX_TCP_SACK_OPTION_SIZE         (4 + (NX_TCP_SACK_MAX_BLOCKS << 3))
+#endif /* NX_ENABLE_TCP_SACK */
 
 
 /* Define constants for the optional TCP keepalive Timer.  To enable this
@@ -271,6 +278,8 @@ UINT _nx_tcp_socket_info_get(NX_TCP_SOCKET *socket_ptr, ULONG *tcp_packets_sent,
 UINT _nx_tcp_socket_mss_get(NX_TCP_SOCKET *socket_ptr, ULONG *mss);
 UINT _nx_tcp_socket_mss_peer_get(NX_TCP_SOCKET *socket_ptr, ULONG *peer_mss);
 UINT _nx_tcp_socket_mss_set(NX_TCP_SOCKET *socket_ptr, ULONG mss);
+UINT _nx_tcp_socket_congestion_control_set(NX_TCP_SOCKET *socket_ptr, const NX_TCP_CONGESTION_CONTROL *control_ptr);
+UINT _nx_tcp_socket_pacing_rate_get(NX_TCP_SOCKET *socket_ptr, ULONG *pacing_rate);
 UINT _nx_tcp_socket_receive(NX_TCP_SOCKET *socket_ptr, NX_PACKET **packet_ptr, ULONG wait_option);
 UINT _nx_tcp_socket_receive_notify(NX_TCP_SOCKET *socket_ptr,
                                    VOID (*tcp_receive_notify)(NX_TCP_SOCKET *socket_ptr));
@@ -301,15 +310,32 @@ VOID _nx_tcp_client_bind_cleanup(TX_THREAD *thread_ptr NX_CLEANUP_PARAMETER);
 VOID _nx_tcp_deferred_cleanup_check(NX_IP *ip_ptr);
 VOID _nx_tcp_fast_periodic_processing(NX_IP *ip_ptr);
 VOID _nx_tcp_socket_retransmit(NX_IP *ip_ptr, NX_TCP_SOCKET *socket_ptr, UINT need_fast_retransmit);
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+VOID _nx_tcp_socket_large_send_split(NX_TCP_SOCKET *socket_ptr);
+ULONG _nx_tcp_socket_large_send_trim(NX_TCP_SOCKET *socket_ptr, NX_PACKET *packet_ptr, ULONG acknowledgment_number);
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
 VOID _nx_tcp_connect_cleanup(TX_THREAD *thread_ptr NX_CLEANUP_PARAMETER);
+VOID _nx_tcp_congestion_reno_init(NX_TCP_SOCKET *socket_ptr);
+VOID _nx_tcp_congestion_reno_ack(NX_TCP_SOCKET *socket_ptr, ULONG acked_bytes);
+VOID _nx_tcp_congestion_reno_loss(NX_TCP_SOCKET *socket_ptr);
+ULONG _nx_tcp_congestion_reno_pacing_rate(NX_TCP_SOCKET *socket_ptr);
 VOID _nx_tcp_disconnect_cleanup(TX_THREAD *thread_ptr NX_CLEANUP_PARAMETER);
 VOID _nx_tcp_initialize(VOID);
 UINT _nx_tcp_mss_option_get(UCHAR *option_ptr, ULONG option_area_size, ULONG *mss);
 #ifdef NX_ENABLE_TCP_WINDOW_SCALING
 UINT _nx_tcp_window_scaling_option_get(UCHAR *option_ptr, ULONG option_area_size, ULONG *window_scale);
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
+#ifdef NX_ENABLE_TCP_SACK
+UINT _nx_tcp_sack_permitted_option_get(UCHAR *option_ptr, ULONG option_area_size, ULONG *sack_permitted);
+ULONG _nx_tcp_sack_option_build(NX_TCP_SOCKET *socket_ptr, UCHAR *option_ptr);
+VOID _nx_tcp_sack_scoreboard_update(NX_TCP_SOCKET *socket_ptr, UCHAR *option_ptr,
+                                    ULONG option_area_size, ULONG ack_number);
+#endif /* NX_ENABLE_TCP_SACK */
 VOID _nx_tcp_no_connection_reset(NX_IP *ip_ptr, NX_PACKET *packet_ptr, NX_TCP_HEADER *tcp_header_ptr);
 VOID _nx_tcp_packet_process(NX_IP *ip_ptr, NX_PACKET *packet_ptr);
+#ifdef NX_ENABLE_TCP_RECEIVE_COALESCING
+NX_PACKET *_nx_tcp_packet_coalesce(NX_PACKET *packet_ptr, NX_PACKET *next_ptr);
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
 VOID _nx_tcp_packet_receive(NX_IP *ip_ptr, NX_PACKET *packet_ptr);
 VOID _nx_tcp_packet_send_ack(NX_TCP_SOCKET *socket_ptr, ULONG tx_sequence);
 VOID _nx_tcp_packet_send_fin(NX_TCP_SOCKET *socket_ptr, ULONG tx_sequence);
@@ -386,6 +412,8 @@ UINT _nxe_tcp_socket_info_get(NX_TCP_SOCKET *socket_ptr, ULONG *tcp_packets_sent
 UINT _nxe_tcp_socket_mss_get(NX_TCP_SOCKET *socket_ptr, ULONG *mss);
 UINT _nxe_tcp_socket_mss_peer_get(NX_TCP_SOCKET *socket_ptr, ULONG *peer_mss);
 UINT _nxe_tcp_socket_mss_set(NX_TCP_SOCKET *socket_ptr, ULONG mss);
+UINT _nxe_tcp_socket_congestion_control_set(NX_TCP_SOCKET *socket_ptr, const NX_TCP_CONGESTION_CONTROL *control_ptr);
+UINT _nxe_tcp_socket_pacing_rate_get(NX_TCP_SOCKET *socket_ptr, ULONG *pacing_rate);
 UINT _nxe_tcp_socket_peer_info_get(NX_TCP_SOCKET *socket_ptr, ULONG *peer_ip_address, ULONG *peer_port);
 UINT _nxe_tcp_socket_receive(NX_TCP_SOCKET *socket_ptr, NX_PACKET **packet_ptr, ULONG wait_option);
 UINT _nxe_tcp_socket_receive_notify(NX_TCP_SOCKET *socket_ptr,
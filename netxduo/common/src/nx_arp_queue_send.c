@@ -58,6 +58,7 @@
 /*                                                                        */
 /*    _nx_packet_transmit_release           Release ARP queued packet     */
 /*    (nx_ip_fragment_processing)           Fragment processing           */
+/*    _nx_ip_segment_packet                 Send TCP super-segment        */
 /*    (ip_interface_link_driver_entry)      User supplied link driver     */
 /*                                                                        */
 /*  CALLED BY                                                             */
@@ -126,6 +127,18 @@ NX_IP_DRIVER driver_request;
         driver_request.nx_ip_driver_packet               =  packet_ptr;
         driver_request.nx_ip_driver_interface            =  packet_ptr -> nx_packet_address.nx_packet_interface_ptr;
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+        /* Determine if this is a TCP super-segment.  */
+        if (packet_ptr -> nx_packet_tcp_segment_size)
+        {
+
+            /* Yes, cut it into segments or let the driver do so.  */
+            _nx_ip_segment_packet(&driver_request);
+            continue;
+        }
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
         /* Determine if fragmentation is needed.  */
         if (packet_ptr -> nx_packet_length > packet_ptr -> nx_packet_address.nx_packet_interface_ptr -> nx_interface_ip_mtu_size)
         {
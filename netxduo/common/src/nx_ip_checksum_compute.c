@@ -62,7 +62,7 @@
 /*                                                                        */
 /*  CALLS                                                                 */
 /*                                                                        */
-/*    None                                                                */
+/*    _nx_ip_checksum_partial_compute       Sum the payload words         */
 /*                                                                        */
 /*  CALLED BY                                                             */
 /*                                                                        */
@@ -91,6 +91,7 @@ ULONG      packet_size;
 #endif /* NX_DISABLE_PACKET_CHAIN */
 NX_PACKET *current_packet;
 ALIGN_TYPE end_ptr;
+UINT       words;
 #ifdef FEATURE_NX_IPV6
 UINT       i;
 #endif
@@ -200,14 +201,12 @@ UINT       i;
             /*lint -e{923} suppress cast of pointer to ULONG.  */
             data_length -= (UINT)(((end_ptr + 3) & (ALIGN_TYPE)(~3llu)) - (ALIGN_TYPE)long_ptr);
 
-            /* Loop to calculate the packet's checksum.  */
-            /*lint -e{946} suppress pointer subtraction, since it is necessary. */
-            while ((ALIGN_TYPE)long_ptr < end_ptr)
-            {
-                checksum += (*long_ptr & NX_LOWER_16_MASK);
-                checksum += (*long_ptr >> NX_SHIFT_BY_16);
-                long_ptr++;
-            }
+            /* Calculate the packet's checksum over the same 32-bit words.  */
+            /*lint -e{923} suppress cast of pointer to ULONG.  */
+            words = (UINT)((end_ptr - (ALIGN_TYPE)long_ptr + 3) >> 2);
+            /*lint -e{927} suppress cast of pointer to pointer, since it is necessary  */
+            checksum += _nx_ip_checksum_partial_compute((UCHAR *)long_ptr, words << 2);
+            long_ptr += words;
         }
 #ifndef NX_DISABLE_PACKET_CHAIN
 
@@ -0,0 +1,321 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Internet Protocol Checksum Computation                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_ip.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#include <immintrin.h>
+#define NX_IP_CHECKSUM_SSE2
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NX_IP_CHECKSUM_NEON
+#endif
+
+
+/* Define the vector path thresholds. Every 32-bit lane of the vector
+   accumulators takes at most four 16-bit values per 64 bytes, so they are
+   flushed into the 64-bit sum every NX_IP_CHECKSUM_VECTOR_CHUNK bytes
+   long before they can overflow.  */
+
+#define NX_IP_CHECKSUM_VECTOR_MIN       64
+#define NX_IP_CHECKSUM_VECTOR_CHUNK     32768
+
+
+/* Add a value to the 64-bit ones-complement sum with end-around carry.  */
+
+#define NX_IP_CHECKSUM_ADD64(sum, value)    \
+    do                                      \
+    {                                       \
+        (sum) += (value);                   \
+        (sum) += ((sum) < (value));         \
+    } while (0)
+
+
+#ifdef NX_IP_CHECKSUM_SSE2
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_ip_checksum_sse2                                PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function sums 64 bytes per iteration with SSE2. The low and    */
+/*    high 16-bit halves of each 32-bit lane are accumulated separately.  */
+/*                                                                        */
+/**************************************************************************/
+static unsigned long long _nx_ip_checksum_sse2(UCHAR *data_ptr, UINT length)
+{
+
+__m128i             mask = _mm_set1_epi32(0xFFFF);
+__m128i             low = _mm_setzero_si128();
+__m128i             high = _mm_setzero_si128();
+__m128i             v0, v1, v2, v3;
+ULONG               lanes[4];
+unsigned long long  sum = 0;
+UINT                i;
+
+    while (length >= 64)
+    {
+        for (i = 0; (i < NX_IP_CHECKSUM_VECTOR_CHUNK) && (length >= 64); i += 64)
+        {
+            v0 = _mm_loadu_si128((__m128i *)(data_ptr + 0));
+            v1 = _mm_loadu_si128((__m128i *)(data_ptr + 16));
+            v2 = _mm_loadu_si128((__m128i *)(data_ptr + 32));
+            v3 = _mm_loadu_si128((__m128i *)(data_ptr + 48));
+            low = _mm_add_epi32(low, _mm_add_epi32(_mm_and_si128(v0, mask), _mm_and_si128(v1, mask)));
+            low = _mm_add_epi32(low, _mm_add_epi32(_mm_and_si128(v2, mask), _mm_and_si128(v3, mask)));
+            high = _mm_add_epi32(high, _mm_add_epi32(_mm_srli_epi32(v0, 16), _mm_srli_epi32(v1, 16)));
+            high = _mm_add_epi32(high, _mm_add_epi32(_mm_srli_epi32(v2, 16), _mm_srli_epi32(v3, 16)));
+            data_ptr += 64;
+            length -= 64;
+        }
+
+        /* Flush the lanes.  */
+        _mm_storeu_si128((__m128i *)lanes, _mm_add_epi32(low, high));
+        sum += (unsigned long long)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        low = _mm_setzero_si128();
+        high = _mm_setzero_si128();
+    }
+
+    return(sum);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_ip_checksum_avx2                                PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is the AVX2 version of _nx_ip_checksum_sse2. It is    */
+/*    only called if the CPU supports AVX2.                               */
+/*                                                                        */
+/**************************************************************************/
+__attribute__((target("avx2")))
+static unsigned long long _nx_ip_checksum_avx2(UCHAR *data_ptr, UINT length)
+{
+
+__m256i             mask = _mm256_set1_epi32(0xFFFF);
+__m256i             low = _mm256_setzero_si256();
+__m256i             high = _mm256_setzero_si256();
+__m256i             v0, v1;
+ULONG               lanes[8];
+unsigned long long  sum = 0;
+UINT                i;
+
+    while (length >= 64)
+    {
+        for (i = 0; (i < NX_IP_CHECKSUM_VECTOR_CHUNK) && (length >= 64); i += 64)
+        {
+            v0 = _mm256_loadu_si256((__m256i *)(data_ptr + 0));
+            v1 = _mm256_loadu_si256((__m256i *)(data_ptr + 32));
+            low = _mm256_add_epi32(low, _mm256_add_epi32(_mm256_and_si256(v0, mask), _mm256_and_si256(v1, mask)));
+            high = _mm256_add_epi32(high, _mm256_add_epi32(_mm256_srli_epi32(v0, 16), _mm256_srli_epi32(v1, 16)));
+            data_ptr += 64;
+            length -= 64;
+        }
+
+        /* Flush the lanes.  */
+        _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi32(low, high));
+        for (i = 0; i < 8; i++)
+        {
+            sum += lanes[i];
+        }
+        low = _mm256_setzero_si256();
+        high = _mm256_setzero_si256();
+    }
+
+    return(sum);
+}
+
+
+static UINT _nx_ip_checksum_avx2_supported(VOID)
+{
+
+static INT  supported = -1;
+
+    if (supported < 0)
+    {
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+
+    return((UINT)supported);
+}
+#endif /* NX_IP_CHECKSUM_SSE2 */
+
+
+#ifdef NX_IP_CHECKSUM_NEON
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_ip_checksum_neon                                PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function sums 64 bytes per iteration with NEON pairwise        */
+/*    add-accumulate (16-bit into 32-bit lanes).                          */
+/*                                                                        */
+/**************************************************************************/
+static unsigned long long _nx_ip_checksum_neon(UCHAR *data_ptr, UINT length)
+{
+
+uint32x4_t          acc0, acc1;
+uint64x2_t          total;
+unsigned long long  sum = 0;
+UINT                i;
+
+    while (length >= 64)
+    {
+        acc0 = vdupq_n_u32(0);
+        acc1 = vdupq_n_u32(0);
+        for (i = 0; (i < NX_IP_CHECKSUM_VECTOR_CHUNK) && (length >= 64); i += 64)
+        {
+            acc0 = vpadalq_u16(acc0, vreinterpretq_u16_u8(vld1q_u8(data_ptr + 0)));
+            acc1 = vpadalq_u16(acc1, vreinterpretq_u16_u8(vld1q_u8(data_ptr + 16)));
+            acc0 = vpadalq_u16(acc0, vreinterpretq_u16_u8(vld1q_u8(data_ptr + 32)));
+            acc1 = vpadalq_u16(acc1, vreinterpretq_u16_u8(vld1q_u8(data_ptr + 48)));
+            data_ptr += 64;
+            length -= 64;
+        }
+
+        /* Flush the lanes.  */
+        total = vaddq_u64(vpaddlq_u32(acc0), vpaddlq_u32(acc1));
+        sum += vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1);
+    }
+
+    return(sum);
+}
+#endif /* NX_IP_CHECKSUM_NEON */
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_ip_checksum_partial_compute                     PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function computes the ones-complement sum of the 16-bit words  */
+/*    in the buffer, in host byte order like the 32-bit word loop of      */
+/*    _nx_ip_checksum_compute. Large buffers are summed by SSE2, AVX2 or  */
+/*    NEON where available, and the rest 8 bytes at a time.               */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    data_ptr                              Pointer to data (no alignment */
+/*                                            requirement)                */
+/*    length                                Size of data, it must be a    */
+/*                                            multiple of 2               */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    The sum folded into 16 bits, it is zero only if all the words are   */
+/*    zero, so folding it again gives the same result as the word loop.  */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_ip_checksum_compute               Compute IP checksum           */
+/*                                                                        */
+/**************************************************************************/
+ULONG  _nx_ip_checksum_partial_compute(UCHAR *data_ptr, UINT length)
+{
+
+unsigned long long  sum = 0;
+unsigned long long  value64;
+ULONG               value32;
+USHORT              value16;
+UINT                bytes;
+
+#if defined(NX_IP_CHECKSUM_SSE2) || defined(NX_IP_CHECKSUM_NEON)
+    if (length >= NX_IP_CHECKSUM_VECTOR_MIN)
+    {
+        bytes = length & ~63u;
+#ifdef NX_IP_CHECKSUM_SSE2
+        if (_nx_ip_checksum_avx2_supported())
+        {
+            sum = _nx_ip_checksum_avx2(data_ptr, bytes);
+        }
+        else
+        {
+            sum = _nx_ip_checksum_sse2(data_ptr, bytes);
+        }
+#else
+        sum = _nx_ip_checksum_neon(data_ptr, bytes);
+#endif /* NX_IP_CHECKSUM_SSE2 */
+        data_ptr += bytes;
+        length -= bytes;
+    }
+#endif /* NX_IP_CHECKSUM_SSE2 || NX_IP_CHECKSUM_NEON */
+
+    /* Sum 8 bytes at a time. Since 2^16 mod 0xFFFF is 1, the 64-bit sum
+       folds into the same 16-bit ones-complement sum.  */
+    while (length >= 8)
+    {
+        memcpy(&value64, data_ptr, sizeof(value64)); /* Use case of memcpy is verified. */
+        NX_IP_CHECKSUM_ADD64(sum, value64);
+        data_ptr += 8;
+        length -= 8;
+    }
+
+    if (length >= 4)
+    {
+        memcpy(&value32, data_ptr, sizeof(value32)); /* Use case of memcpy is verified. */
+        NX_IP_CHECKSUM_ADD64(sum, (unsigned long long)value32);
+        data_ptr += 4;
+        length -= 4;
+    }
+
+    if (length >= 2)
+    {
+        memcpy(&value16, data_ptr, sizeof(value16)); /* Use case of memcpy is verified. */
+        NX_IP_CHECKSUM_ADD64(sum, (unsigned long long)value16);
+    }
+
+    /* Fold into 16 bits.  */
+    sum = (sum >> 32) + (sum & 0xFFFFFFFFull);
+    sum = (sum >> 32) + (sum & 0xFFFFFFFFull);
+    while (sum >> 16)
+    {
+        sum = (sum >> 16) + (sum & 0xFFFF);
+    }
+
+    return((ULONG)sum);
+}
@@ -64,6 +64,7 @@
 /*    _nx_packet_copy                       Copy packet to input packet   */
 /*    _nx_packet_transmit_release           Release transmit packet       */
 /*    (nx_ip_fragment_processing)           Fragment processing           */
+/*    _nx_ip_segment_packet                 Send TCP super-segment        */
 /*    (ip_link_driver)                      User supplied link driver     */
 /*    _nx_ip_packet_checksum_compute        Compute checksum              */
 /*                                                                        */
@@ -229,8 +230,13 @@ UINT         queued_count;
             else
             {
 
-                /* Determine if fragmentation is needed before queue the packet on the ARP waiting queue.  */
-                if (packet_ptr -> nx_packet_length > packet_ptr -> nx_packet_address.nx_packet_interface_ptr -> nx_interface_ip_mtu_size)
+                /* Determine if fragmentation is needed before queue the packet on the ARP waiting queue.
+                   TCP super-segments are cut into segments when they are sent.  */
+                if ((packet_ptr -> nx_packet_length > packet_ptr -> nx_packet_address.nx_packet_interface_ptr -> nx_interface_ip_mtu_size)
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+                    && (packet_ptr -> nx_packet_tcp_segment_size == 0)
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+                   )
                 {
 
 #ifndef NX_DISABLE_FRAGMENTATION
@@ -477,6 +483,18 @@ UINT         queued_count;
     if (driver_request.nx_ip_driver_interface)
     {
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+        /* Determine if this is a TCP super-segment.  */
+        if (packet_ptr -> nx_packet_tcp_segment_size)
+        {
+
+            /* Yes, cut it into segments or let the driver do so.  */
+            _nx_ip_segment_packet(&driver_request);
+            return;
+        }
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
         /* Determine if fragmentation is needed.  */
         if (packet_ptr -> nx_packet_length > packet_ptr -> nx_packet_address.nx_packet_interface_ptr -> nx_interface_ip_mtu_size)
         {
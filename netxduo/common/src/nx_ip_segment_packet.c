@@ -0,0 +1,434 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Internet Protocol (IP)                                              */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_ip.h"
+#include "nx_tcp.h"
+#include "nx_packet.h"
+
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_ip_segment_packet                               PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function cuts the supplied TCP super-segment into segments of  */
+/*    nx_packet_tcp_segment_size bytes and sends them out through the     */
+/*    associated IP driver, like _nx_ip_fragment_packet does with the     */
+/*    fragments.  The IP and TCP headers of the super-segment are copied  */
+/*    into every segment, only the lengths, the IP identification, the    */
+/*    sequence number and the checksums differ.  PSH and FIN are kept on  */
+/*    the last segment only.                                              */
+/*                                                                        */
+/*    If the driver advertises NX_INTERFACE_CAPABILITY_TCP_SEGMENTATION,  */
+/*    the super-segment is passed to it unchanged.  The driver then       */
+/*    builds the segments in the same way and fills in the IP and TCP     */
+/*    checksums, since TCP does not compute one for a super-segment.      */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    driver_req_ptr                        Pointer to driver request     */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    _nx_ip_checksum_compute               Compute TCP checksum          */
+/*    _nx_packet_allocate                   Allocate packet for segment   */
+/*    _nx_packet_data_append                Copy segment payload          */
+/*    _nx_packet_release                    Release segment on error      */
+/*    _nx_packet_transmit_release           Transmit packet release       */
+/*    (ip_link_driver)                      User supplied link driver     */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_arp_queue_send                    Send queued packets           */
+/*    _nx_ip_driver_packet_send             Send an IP packet             */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_ip_segment_packet(struct NX_IP_DRIVER_STRUCT *driver_req_ptr)
+{
+
+#ifndef NX_DISABLE_IPV4
+UINT            status =  NX_SUCCESS;
+ULONG           checksum;
+ULONG           temp;
+ULONG           source_ip;
+ULONG           destination_ip;
+ULONG           ip_header_word_0;
+ULONG           ip_header_word_1;
+ULONG           ip_header_word_2;
+ULONG           tcp_header_length;
+ULONG           sequence_number;
+ULONG           segment_size;
+ULONG           segment_count =  0;
+ULONG           segment_offset =  0;
+UCHAR          *source_ptr;
+ULONG           remaining_bytes;
+ULONG           copy_size;
+ULONG           copy_remaining_size;
+NX_IP_DRIVER    driver_request;
+NX_PACKET      *source_packet;
+NX_PACKET      *segment_packet;
+NX_IPV4_HEADER *source_header_ptr;
+NX_IPV4_HEADER *segment_header_ptr;
+NX_TCP_HEADER  *source_tcp_header_ptr;
+NX_TCP_HEADER  *segment_tcp_header_ptr;
+NX_INTERFACE   *interface_ptr;
+NX_IP          *ip_ptr;
+#if defined(NX_DISABLE_IP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY)
+UINT            compute_ip_checksum = 1;
+#endif /* defined(NX_DISABLE_IP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) */
+#if defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY)
+UINT            compute_tcp_checksum = 1;
+#endif /* defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) */
+
+#ifdef NX_DISABLE_IP_TX_CHECKSUM
+    compute_ip_checksum = 0;
+#endif /* NX_DISABLE_IP_TX_CHECKSUM */
+
+#ifdef NX_DISABLE_TCP_TX_CHECKSUM
+    compute_tcp_checksum = 0;
+#endif /* NX_DISABLE_TCP_TX_CHECKSUM */
+
+    /* Setup the IP pointer.  */
+    ip_ptr =  driver_req_ptr -> nx_ip_driver_ptr;
+
+    /* Pickup the super-segment and its interface.  */
+    source_packet =  driver_req_ptr -> nx_ip_driver_packet;
+    interface_ptr =  source_packet -> nx_packet_address.nx_packet_interface_ptr;
+
+    /* Add debug information. */
+    NX_PACKET_DEBUG(__FILE__, __LINE__, source_packet);
+
+#ifdef NX_ENABLE_INTERFACE_CAPABILITY
+
+    /* Determine if the driver does the segmentation.  */
+    if (interface_ptr -> nx_interface_capability_flag & NX_INTERFACE_CAPABILITY_TCP_SEGMENTATION)
+    {
+
+#ifndef NX_DISABLE_IP_INFO
+
+        /* Increment the IP packet sent count.  */
+        ip_ptr -> nx_ip_total_packets_sent++;
+
+        /* Increment the IP bytes sent count.  */
+        ip_ptr -> nx_ip_total_bytes_sent +=  source_packet -> nx_packet_length - (ULONG)sizeof(NX_IPV4_HEADER);
+#endif
+
+        /* If trace is enabled, insert this event into the trace buffer.  */
+        NX_TRACE_IN_LINE_INSERT(NX_TRACE_INTERNAL_IO_DRIVER_PACKET_SEND, ip_ptr, source_packet, source_packet -> nx_packet_length, 0, NX_TRACE_INTERNAL_EVENTS, 0, 0);
+
+        /* Hand the whole super-segment to the driver.  */
+        (interface_ptr -> nx_interface_link_driver_entry)(driver_req_ptr);
+        return;
+    }
+
+    if (interface_ptr -> nx_interface_capability_flag & NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM)
+    {
+        compute_ip_checksum = 0;
+    }
+
+    if (interface_ptr -> nx_interface_capability_flag & NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM)
+    {
+        compute_tcp_checksum = 0;
+    }
+#endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+
+    /* Setup the local driver request that will be used for each segment.  */
+    driver_request =  *driver_req_ptr;
+
+    /* Pickup the IP header of the super-segment in host byte order. TCP does not
+       add IP options.  */
+    /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+    source_header_ptr =  (NX_IPV4_HEADER *)source_packet -> nx_packet_prepend_ptr;
+    ip_header_word_0 =  source_header_ptr -> nx_ip_header_word_0;
+    ip_header_word_1 =  source_header_ptr -> nx_ip_header_word_1;
+    ip_header_word_2 =  source_header_ptr -> nx_ip_header_word_2;
+    source_ip =  source_header_ptr -> nx_ip_header_source_ip;
+    destination_ip =  source_header_ptr -> nx_ip_header_destination_ip;
+    NX_CHANGE_ULONG_ENDIAN(ip_header_word_0);
+    NX_CHANGE_ULONG_ENDIAN(ip_header_word_1);
+    NX_CHANGE_ULONG_ENDIAN(ip_header_word_2);
+    NX_CHANGE_ULONG_ENDIAN(source_ip);
+    NX_CHANGE_ULONG_ENDIAN(destination_ip);
+
+    /* Pickup the TCP header, it stays in network byte order.  */
+    /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+    source_tcp_header_ptr =  (NX_TCP_HEADER *)(source_packet -> nx_packet_prepend_ptr + sizeof(NX_IPV4_HEADER));
+    temp =  source_tcp_header_ptr -> nx_tcp_header_word_3;
+    NX_CHANGE_ULONG_ENDIAN(temp);
+    tcp_header_length =  (temp >> NX_TCP_HEADER_SHIFT) * (ULONG)sizeof(ULONG);
+    sequence_number =  source_tcp_header_ptr -> nx_tcp_sequence_number;
+    NX_CHANGE_ULONG_ENDIAN(sequence_number);
+
+    /* Pickup the payload.  */
+    segment_size =  source_packet -> nx_packet_tcp_segment_size;
+    remaining_bytes =  source_packet -> nx_packet_length - (ULONG)sizeof(NX_IPV4_HEADER) - tcp_header_length;
+    source_ptr =  source_packet -> nx_packet_prepend_ptr + sizeof(NX_IPV4_HEADER) + tcp_header_length;
+
+    /* Loop to cut the payload into segments and send each out through the
+       associated driver.  */
+    while (remaining_bytes)
+    {
+
+        /* Allocate a packet with room for the headers from the default packet pool.  */
+        status =  _nx_packet_allocate(ip_ptr -> nx_ip_default_packet_pool, &segment_packet,
+                                      NX_PHYSICAL_HEADER + sizeof(NX_IPV4_HEADER) + tcp_header_length, NX_NO_WAIT);
+
+        /* Determine if there is a packet available.  */
+        if (status)
+        {
+            break;
+        }
+
+        /* Add debug information. */
+        NX_PACKET_DEBUG(__FILE__, __LINE__, segment_packet);
+
+        /* Set the proper interface. */
+        /*lint -e{644} suppress variable might not be initialized, since "segment_packet" was initialized in _nx_packet_allocate. */
+        segment_packet -> nx_packet_address.nx_packet_interface_ptr =  interface_ptr;
+        segment_packet -> nx_packet_ip_version =  NX_IP_VERSION_V4;
+
+        /* Calculate the payload size of this segment.  */
+        if (remaining_bytes > segment_size)
+        {
+            copy_remaining_size =  segment_size;
+        }
+        else
+        {
+            copy_remaining_size =  remaining_bytes;
+        }
+        remaining_bytes -=  copy_remaining_size;
+
+        /* Copy the payload.  */
+        while (copy_remaining_size)
+        {
+
+            /* Move past the exhausted buffers of the super-segment.  */
+            /*lint -e{946} -e{947} suppress pointer subtraction, since it is necessary. */
+            while ((source_ptr == source_packet -> nx_packet_append_ptr) && (source_packet -> nx_packet_next))
+            {
+                source_packet =  source_packet -> nx_packet_next;
+                source_ptr =  source_packet -> nx_packet_prepend_ptr;
+            }
+
+            /*lint -e{946} -e{947} suppress pointer subtraction, since it is necessary. */
+            copy_size =  (ULONG)(source_packet -> nx_packet_append_ptr - source_ptr);
+            if (copy_size == 0)
+            {
+
+                /* The super-segment is shorter than its length.  */
+                status =  NX_INVALID_PACKET;
+                break;
+            }
+
+            if (copy_size > copy_remaining_size)
+            {
+                copy_size =  copy_remaining_size;
+            }
+
+            status =  _nx_packet_data_append(segment_packet, source_ptr, copy_size,
+                                             ip_ptr -> nx_ip_default_packet_pool, NX_NO_WAIT);
+            if (status)
+            {
+                break;
+            }
+
+            source_ptr +=  copy_size;
+            copy_remaining_size -=  copy_size;
+        }
+
+        if (status)
+        {
+            _nx_packet_release(segment_packet);
+            break;
+        }
+
+        /* Copy the TCP header and set the sequence number of this segment.  */
+        segment_packet -> nx_packet_prepend_ptr =  segment_packet -> nx_packet_prepend_ptr - tcp_header_length;
+        segment_packet -> nx_packet_length =  segment_packet -> nx_packet_length + tcp_header_length;
+        memcpy(segment_packet -> nx_packet_prepend_ptr, source_tcp_header_ptr, tcp_header_length); /* Use case of memcpy is verified. */
+
+        /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+        segment_tcp_header_ptr =  (NX_TCP_HEADER *)segment_packet -> nx_packet_prepend_ptr;
+        segment_tcp_header_ptr -> nx_tcp_sequence_number =  sequence_number + segment_offset;
+        NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_sequence_number);
+        segment_offset +=  segment_packet -> nx_packet_length - tcp_header_length;
+
+        /* Only the last segment pushes or finishes.  */
+        if (remaining_bytes)
+        {
+            NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_header_word_3);
+            segment_tcp_header_ptr -> nx_tcp_header_word_3 &=  ~(NX_TCP_PSH_BIT | NX_TCP_FIN_BIT);
+            NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_header_word_3);
+        }
+
+        /* Clear the checksum, the urgent pointer is kept.  */
+        NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_header_word_4);
+        segment_tcp_header_ptr -> nx_tcp_header_word_4 &=  NX_LOWER_16_MASK;
+        NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_header_word_4);
+
+#if defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY)
+        if (compute_tcp_checksum)
+#endif /* defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) */
+        {
+
+            /* Calculate the TCP checksum of this segment.  */
+            checksum =  _nx_ip_checksum_compute(segment_packet, NX_PROTOCOL_TCP,
+                                                (UINT)segment_packet -> nx_packet_length,
+                                                &source_ip, &destination_ip);
+            checksum =  ~checksum & NX_LOWER_16_MASK;
+
+            /* Move the checksum into header.  */
+            NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_header_word_4);
+            segment_tcp_header_ptr -> nx_tcp_header_word_4 |=  (checksum << NX_SHIFT_BY_16);
+            NX_CHANGE_ULONG_ENDIAN(segment_tcp_header_ptr -> nx_tcp_header_word_4);
+        }
+#ifdef NX_ENABLE_INTERFACE_CAPABILITY
+        else
+        {
+            segment_packet -> nx_packet_interface_capability_flag |= NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM;
+        }
+#endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+
+        /* The first segment keeps the identification of the super-segment, the others
+           take new ones like any IP packet.  */
+        if (segment_count)
+        {
+#ifdef NX_ENABLE_IP_ID_RANDOMIZATION
+            ip_header_word_1 =  (((ULONG)NX_RAND()) << NX_SHIFT_BY_16) | (ip_header_word_1 & NX_LOWER_16_MASK);
+#else
+            ip_header_word_1 =  (ip_ptr -> nx_ip_packet_id++ << NX_SHIFT_BY_16) | (ip_header_word_1 & NX_LOWER_16_MASK);
+#endif /* NX_ENABLE_IP_ID_RANDOMIZATION */
+        }
+
+        /* Build the IP header of this segment.  */
+        segment_packet -> nx_packet_prepend_ptr =  segment_packet -> nx_packet_prepend_ptr - sizeof(NX_IPV4_HEADER);
+        segment_packet -> nx_packet_length =  segment_packet -> nx_packet_length + (ULONG)sizeof(NX_IPV4_HEADER);
+        segment_packet -> nx_packet_ip_header =  segment_packet -> nx_packet_prepend_ptr;
+        segment_packet -> nx_packet_ip_header_length =  (UCHAR)sizeof(NX_IPV4_HEADER);
+
+        /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+        segment_header_ptr =  (NX_IPV4_HEADER *)segment_packet -> nx_packet_prepend_ptr;
+        segment_header_ptr -> nx_ip_header_word_0 =          (ip_header_word_0 & ~NX_LOWER_16_MASK) | segment_packet -> nx_packet_length;
+        segment_header_ptr -> nx_ip_header_word_1 =          ip_header_word_1;
+        segment_header_ptr -> nx_ip_header_word_2 =          ip_header_word_2 & ~NX_LOWER_16_MASK;
+        segment_header_ptr -> nx_ip_header_source_ip =       source_ip;
+        segment_header_ptr -> nx_ip_header_destination_ip =  destination_ip;
+
+#if defined(NX_DISABLE_IP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY)
+        if (compute_ip_checksum)
+#endif /* defined(NX_DISABLE_IP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) */
+        {
+
+            /* Build the IP checksum for this segment.  */
+            temp =       segment_header_ptr -> nx_ip_header_word_0;
+            checksum =   (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+            temp =       segment_header_ptr -> nx_ip_header_word_1;
+            checksum +=  (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+            temp =       segment_header_ptr -> nx_ip_header_word_2;
+            checksum +=  (temp >> NX_SHIFT_BY_16);
+            temp =       segment_header_ptr -> nx_ip_header_source_ip;
+            checksum +=  (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+            temp =       segment_header_ptr -> nx_ip_header_destination_ip;
+            checksum +=  (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+
+            /* Add in the carry bits into the checksum.  */
+            checksum = (checksum >> NX_SHIFT_BY_16) + (checksum & NX_LOWER_16_MASK);
+
+            /* Do it again in case previous operation generates an overflow.  */
+            checksum = (checksum >> NX_SHIFT_BY_16) + (checksum & NX_LOWER_16_MASK);
+
+            /* Now store the checksum in the IP header.  */
+            segment_header_ptr -> nx_ip_header_word_2 =  segment_header_ptr -> nx_ip_header_word_2 | (NX_LOWER_16_MASK & (~checksum));
+        }
+#ifdef NX_ENABLE_INTERFACE_CAPABILITY
+        else
+        {
+            segment_packet -> nx_packet_interface_capability_flag |= NX_INTERFACE_CAPABILITY_IPV4_TX_CHECKSUM;
+        }
+#endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+
+        /* Endian swapping logic.  If NX_LITTLE_ENDIAN is specified, these macros will
+           swap the endian of the IP header.  */
+        NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_ip_header_word_0);
+        NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_ip_header_word_1);
+        NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_ip_header_word_2);
+        NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_ip_header_source_ip);
+        NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_ip_header_destination_ip);
+
+#ifndef NX_DISABLE_IP_INFO
+
+        /* Increment the IP packet sent count.  */
+        ip_ptr -> nx_ip_total_packets_sent++;
+
+        /* Increment the IP bytes sent count.  */
+        ip_ptr -> nx_ip_total_bytes_sent +=  segment_packet -> nx_packet_length - (ULONG)sizeof(NX_IPV4_HEADER);
+#endif
+
+        /* Send the segment to the associated driver for output.  */
+        driver_request.nx_ip_driver_packet =  segment_packet;
+
+        /* If trace is enabled, insert this event into the trace buffer.  */
+        NX_TRACE_IN_LINE_INSERT(NX_TRACE_INTERNAL_IO_DRIVER_PACKET_SEND, ip_ptr, segment_packet, segment_packet -> nx_packet_length, 0, NX_TRACE_INTERNAL_EVENTS, 0, 0);
+
+        /* Add debug information. */
+        NX_PACKET_DEBUG(__FILE__, __LINE__, segment_packet);
+
+        (interface_ptr -> nx_interface_link_driver_entry)(&driver_request);
+        segment_count++;
+    }
+
+#ifndef NX_DISABLE_IP_INFO
+    if (status)
+    {
+
+        /* Increment the IP send packets dropped count.  */
+        ip_ptr -> nx_ip_send_packets_dropped++;
+
+        /* Increment the IP transmit resource error count.  */
+        ip_ptr -> nx_ip_transmit_resource_errors++;
+    }
+#endif
+
+    /* The super-segment has been sent out in segments, TCP keeps it for
+       retransmission.  */
+    _nx_packet_transmit_release(driver_req_ptr -> nx_ip_driver_packet);
+#else
+    NX_PARAMETER_NOT_USED(driver_req_ptr);
+#endif /* NX_DISABLE_IPV4 */
+}
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
@@ -128,6 +128,9 @@ ULONG                  trace_timestamp;
 #ifdef NX_ENABLE_INTERFACE_CAPABILITY
         work_ptr -> nx_packet_interface_capability_flag = 0;
 #endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+        work_ptr -> nx_packet_tcp_segment_size = 0;
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
         /* Set the TCP queue to the value that indicates it has been allocated.  */
         /*lint -e{923} suppress cast of ULONG to pointer.  */
         work_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next =  (NX_PACKET *)NX_PACKET_ALLOCATED;
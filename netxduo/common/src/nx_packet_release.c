@@ -187,6 +187,9 @@ NX_PACKET      *next_packet;    /* Working block pointer   */
 #ifdef NX_ENABLE_INTERFACE_CAPABILITY
             packet_ptr -> nx_packet_interface_capability_flag = 0;
 #endif /* NX_ENABLE_INTERFACE_CAPABILITY */
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+            packet_ptr -> nx_packet_tcp_segment_size = 0;
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
             /* Set the TCP queue to the value that indicates it has been allocated.  */
             /*lint -e{923} suppress cast of ULONG to pointer.  */
             packet_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next =  (NX_PACKET *)NX_PACKET_ALLOCATED;
@@ -0,0 +1,429 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_tcp.h"
+
+#ifdef NX_ENABLE_TCP_CUBIC
+
+/* Define the CUBIC constants of RFC 8312 as fractions of 1024: the multiplicative
+   decrease factor beta = 0.7, the fast convergence factor (1 + beta) / 2 and the
+   TCP-friendly additive increase 3 * (1 - beta) / (1 + beta).  */
+
+#define NX_TCP_CUBIC_BETA               717
+#define NX_TCP_CUBIC_FAST_CONVERGENCE   870
+#define NX_TCP_CUBIC_ALPHA              542
+
+/* Time is measured in 1/64 seconds.  With C = 0.4, the window function is
+   W(t) = C * (t - K)^3 = (t - K)^3 / 40960 segments / 16, and the time to reach
+   W_max after a reduction of D segments is K = cbrt(D * 655360).  The time offset
+   and D are bounded so that the cubes fit in 32 bits.  */
+
+#define NX_TCP_CUBIC_TIME_SHIFT         6
+#define NX_TCP_CUBIC_TIME_MAX           1600
+#define NX_TCP_CUBIC_DELTA_DIVISOR      40960
+#define NX_TCP_CUBIC_K_FACTOR           655360
+#define NX_TCP_CUBIC_K_SEGMENTS_MAX     6500
+
+/* Multiply by a fraction of 1024 without overflowing 32 bits.  */
+
+#define NX_TCP_CUBIC_SCALE(v, f)        ((((v) >> 10) * (f)) + ((((v) & 1023) * (f)) >> 10))
+
+
+/* Define the CUBIC state, kept in the congestion control area of the socket.  */
+
+typedef struct NX_TCP_CUBIC_STRUCT
+{
+
+    /* Define the start of the current congestion avoidance epoch.  */
+    ULONG       nx_tcp_cubic_epoch_valid;
+    ULONG       nx_tcp_cubic_epoch_start;
+
+    /* Define the window before the last reduction, in bytes.  */
+    ULONG       nx_tcp_cubic_w_max;
+
+    /* Define the time to grow back to the origin point, in 1/64 seconds.  */
+    ULONG       nx_tcp_cubic_k;
+
+    /* Define the plateau of the window function of this epoch, in bytes.  */
+    ULONG       nx_tcp_cubic_origin;
+
+    /* Define the window Reno would have reached in this epoch, in bytes.  */
+    ULONG       nx_tcp_cubic_w_est;
+} NX_TCP_CUBIC;
+
+#if (NX_TCP_CONGESTION_STATE_SIZE < 6)
+#error "NX_TCP_CONGESTION_STATE_SIZE is too small for CUBIC"
+#endif
+
+static VOID  _nx_tcp_congestion_cubic_init(NX_TCP_SOCKET *socket_ptr);
+static VOID  _nx_tcp_congestion_cubic_ack(NX_TCP_SOCKET *socket_ptr, ULONG acked_bytes);
+static VOID  _nx_tcp_congestion_cubic_loss(NX_TCP_SOCKET *socket_ptr);
+static ULONG _nx_tcp_congestion_cubic_root(ULONG value);
+
+
+/* Define the CUBIC congestion control table.  */
+
+const NX_TCP_CONGESTION_CONTROL _nx_tcp_congestion_control_cubic =
+{
+    "CUBIC",
+    _nx_tcp_congestion_cubic_init,
+    _nx_tcp_congestion_cubic_ack,
+    _nx_tcp_congestion_cubic_loss,
+    _nx_tcp_congestion_cubic_loss,
+    _nx_tcp_congestion_reno_pacing_rate
+};
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_cubic_init                       PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function clears the CUBIC state of a new connection.           */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    memset                                Clear the state               */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_state_syn_received     Process SYN RECEIVED state    */
+/*    _nx_tcp_socket_state_syn_sent         Process SYN SENT state        */
+/*    _nx_tcp_socket_congestion_control_set Set congestion control        */
+/*                                                                        */
+/**************************************************************************/
+static VOID  _nx_tcp_congestion_cubic_init(NX_TCP_SOCKET *socket_ptr)
+{
+
+    memset(socket_ptr -> nx_tcp_socket_congestion_state, 0, sizeof(NX_TCP_CUBIC)); /* Use case of memset is verified. */
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_cubic_ack                        PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function grows the congestion window for an ACK of new data.   */
+/*    Below the slow start threshold it uses Reno slow start.  Above it   */
+/*    the window follows the cubic function of the time since the last    */
+/*    reduction, RFC 8312 Section 4.1, but never grows slower than Reno   */
+/*    would, Section 4.2.                                                 */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*    acked_bytes                           Number of bytes ACKed         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    _nx_tcp_congestion_reno_ack           Reno slow start               */
+/*    _nx_tcp_congestion_cubic_root         Integer cube root             */
+/*    tx_time_get                           Get system time               */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_state_ack_check       Process received ACK           */
+/*                                                                        */
+/**************************************************************************/
+static VOID  _nx_tcp_congestion_cubic_ack(NX_TCP_SOCKET *socket_ptr, ULONG acked_bytes)
+{
+
+NX_TCP_CUBIC *cubic_ptr = (NX_TCP_CUBIC *)socket_ptr -> nx_tcp_socket_congestion_state;
+ULONG         mss = socket_ptr -> nx_tcp_socket_connect_mss;
+ULONG         cwnd = socket_ptr -> nx_tcp_socket_tx_window_congestion;
+ULONG         now;
+ULONG         segments;
+ULONG         elapsed;
+ULONG         offset;
+ULONG         delta;
+ULONG         target;
+ULONG         increment;
+
+
+    /* Slow start is the same as Reno.  */
+    if (cwnd < socket_ptr -> nx_tcp_socket_tx_slow_start_threshold)
+    {
+        _nx_tcp_congestion_reno_ack(socket_ptr, acked_bytes);
+        return;
+    }
+
+    /* There is no point in growing a window the receiver does not let us use.  */
+    if ((cwnd >> 1) >= socket_ptr -> nx_tcp_socket_tx_window_advertised)
+    {
+        return;
+    }
+
+    now = tx_time_get();
+
+    /* Start a new epoch on the first ACK after a reduction.  */
+    if (!cubic_ptr -> nx_tcp_cubic_epoch_valid)
+    {
+        cubic_ptr -> nx_tcp_cubic_epoch_valid = NX_TRUE;
+        cubic_ptr -> nx_tcp_cubic_epoch_start = now;
+        cubic_ptr -> nx_tcp_cubic_w_est = cwnd;
+
+        if (cubic_ptr -> nx_tcp_cubic_w_max > cwnd)
+        {
+            segments = (cubic_ptr -> nx_tcp_cubic_w_max - cwnd) / mss;
+            if (segments > NX_TCP_CUBIC_K_SEGMENTS_MAX)
+            {
+                segments = NX_TCP_CUBIC_K_SEGMENTS_MAX;
+            }
+            cubic_ptr -> nx_tcp_cubic_k = _nx_tcp_congestion_cubic_root(segments * NX_TCP_CUBIC_K_FACTOR);
+            cubic_ptr -> nx_tcp_cubic_origin = cubic_ptr -> nx_tcp_cubic_w_max;
+        }
+        else
+        {
+            cubic_ptr -> nx_tcp_cubic_k = 0;
+            cubic_ptr -> nx_tcp_cubic_origin = cwnd;
+        }
+    }
+
+    /* Evaluate the window function one RTT ahead, in 1/64 seconds.  */
+    elapsed = now - cubic_ptr -> nx_tcp_cubic_epoch_start + (socket_ptr -> nx_tcp_socket_rtt_smoothed >> 3);
+    if (elapsed > (NX_TCP_CUBIC_TIME_MAX * NX_IP_PERIODIC_RATE) >> NX_TCP_CUBIC_TIME_SHIFT)
+    {
+        elapsed = NX_TCP_CUBIC_TIME_MAX + cubic_ptr -> nx_tcp_cubic_k;
+    }
+    else
+    {
+        elapsed = (elapsed << NX_TCP_CUBIC_TIME_SHIFT) / NX_IP_PERIODIC_RATE;
+    }
+
+    if (elapsed > cubic_ptr -> nx_tcp_cubic_k)
+    {
+        offset = elapsed - cubic_ptr -> nx_tcp_cubic_k;
+    }
+    else
+    {
+        offset = cubic_ptr -> nx_tcp_cubic_k - elapsed;
+    }
+    if (offset > NX_TCP_CUBIC_TIME_MAX)
+    {
+        offset = NX_TCP_CUBIC_TIME_MAX;
+    }
+
+    delta = ((offset * offset * offset) / NX_TCP_CUBIC_DELTA_DIVISOR) * mss >> 4;
+
+    if (elapsed > cubic_ptr -> nx_tcp_cubic_k)
+    {
+        target = cubic_ptr -> nx_tcp_cubic_origin + delta;
+    }
+    else if (cubic_ptr -> nx_tcp_cubic_origin > delta)
+    {
+        target = cubic_ptr -> nx_tcp_cubic_origin - delta;
+    }
+    else
+    {
+        target = 0;
+    }
+
+    /* Grow by at most half a window per RTT.  */
+    if (target > cwnd + (cwnd >> 1))
+    {
+        target = cwnd + (cwnd >> 1);
+    }
+
+    /* Track the window of a Reno flow that saw the same losses.  */
+    segments = acked_bytes / mss;
+    if (segments == 0)
+    {
+        segments = 1;
+    }
+    cubic_ptr -> nx_tcp_cubic_w_est += segments * (((mss * NX_TCP_CUBIC_ALPHA) >> 10) * mss / cwnd);
+    if (target < cubic_ptr -> nx_tcp_cubic_w_est)
+    {
+        target = cubic_ptr -> nx_tcp_cubic_w_est;
+    }
+
+    /* Close the gap to the target over one window of ACKs.  */
+    if (target > cwnd)
+    {
+        increment = segments * ((target - cwnd) / (cwnd / mss));
+        if (increment > target - cwnd)
+        {
+            increment = target - cwnd;
+        }
+    }
+    else
+    {
+
+        /* Probe slowly around the plateau, one segment per 100 RTTs.  */
+        increment = socket_ptr -> nx_tcp_socket_connect_mss2 / cwnd / 100;
+    }
+
+    if (increment == 0)
+    {
+        increment = 1;
+    }
+
+    socket_ptr -> nx_tcp_socket_tx_window_congestion = cwnd + increment;
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_cubic_loss                       PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function remembers the window at the time of a loss, with      */
+/*    fast convergence when it is below the previous one, and sets the    */
+/*    slow start threshold to beta times the window, RFC 8312 Section     */
+/*    4.5 and 4.6.  The window is capped by the flight size so a flow     */
+/*    limited by the application or receiver still backs off.             */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_retransmit             Retransmit packet             */
+/*                                                                        */
+/**************************************************************************/
+static VOID  _nx_tcp_congestion_cubic_loss(NX_TCP_SOCKET *socket_ptr)
+{
+
+NX_TCP_CUBIC *cubic_ptr = (NX_TCP_CUBIC *)socket_ptr -> nx_tcp_socket_congestion_state;
+ULONG         window;
+
+
+    window = socket_ptr -> nx_tcp_socket_tx_window_congestion;
+    if (window > socket_ptr -> nx_tcp_socket_tx_outstanding_bytes)
+    {
+        window = socket_ptr -> nx_tcp_socket_tx_outstanding_bytes;
+    }
+
+    /* Start a new epoch on the next ACK.  */
+    cubic_ptr -> nx_tcp_cubic_epoch_valid = NX_FALSE;
+
+    /* Release bandwidth to new flows when the window is still shrinking.  */
+    if (window < cubic_ptr -> nx_tcp_cubic_w_max)
+    {
+        cubic_ptr -> nx_tcp_cubic_w_max = NX_TCP_CUBIC_SCALE(window, NX_TCP_CUBIC_FAST_CONVERGENCE);
+    }
+    else
+    {
+        cubic_ptr -> nx_tcp_cubic_w_max = window;
+    }
+
+    window = NX_TCP_CUBIC_SCALE(window, NX_TCP_CUBIC_BETA);
+
+    /* Make sure we have at least 2 * MSS */
+    if (window < (socket_ptr -> nx_tcp_socket_connect_mss << 1))
+    {
+        window = socket_ptr -> nx_tcp_socket_connect_mss << 1;
+    }
+
+    socket_ptr -> nx_tcp_socket_tx_slow_start_threshold = window;
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_cubic_root                       PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function computes the integer cube root, one bit per round.    */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    value                                 Value to take the root of     */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    root                                  Floor of the cube root        */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_congestion_cubic_ack          CUBIC window growth           */
+/*                                                                        */
+/**************************************************************************/
+static ULONG  _nx_tcp_congestion_cubic_root(ULONG value)
+{
+
+ULONG root = 0;
+ULONG term;
+INT   shift;
+
+
+    for (shift = 30; shift >= 0; shift -= 3)
+    {
+        root <<= 1;
+        term = 3 * root * (root + 1) + 1;
+        if ((value >> shift) >= term)
+        {
+            value -= term << shift;
+            root++;
+        }
+    }
+
+    return(root);
+}
+#endif /* NX_ENABLE_TCP_CUBIC */
@@ -0,0 +1,273 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_tcp.h"
+
+
+/* Define the Reno congestion control table, the default of every TCP socket.  */
+
+const NX_TCP_CONGESTION_CONTROL _nx_tcp_congestion_control_reno =
+{
+    "Reno",
+    _nx_tcp_congestion_reno_init,
+    _nx_tcp_congestion_reno_ack,
+    _nx_tcp_congestion_reno_loss,
+    _nx_tcp_congestion_reno_loss,
+    _nx_tcp_congestion_reno_pacing_rate
+};
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_reno_init                        PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function starts Reno congestion control on a new connection.  */
+/*    Reno keeps no state besides the congestion window and the slow      */
+/*    start threshold, so there is nothing to do.                         */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_state_syn_received     Process SYN RECEIVED state    */
+/*    _nx_tcp_socket_state_syn_sent         Process SYN SENT state        */
+/*    _nx_tcp_socket_congestion_control_set Set congestion control        */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_tcp_congestion_reno_init(NX_TCP_SOCKET *socket_ptr)
+{
+
+    NX_PARAMETER_NOT_USED(socket_ptr);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_reno_ack                         PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function grows the congestion window for an ACK of new data,   */
+/*    by slow start below the slow start threshold and by congestion      */
+/*    avoidance above it.                                                 */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*    acked_bytes                           Number of bytes ACKed         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_state_ack_check       Process received ACK           */
+/*    _nx_tcp_congestion_cubic_ack          CUBIC slow start              */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_tcp_congestion_reno_ack(NX_TCP_SOCKET *socket_ptr, ULONG acked_bytes)
+{
+
+ULONG temp;
+
+
+    /* Adjust the transmit window.  In slow start phase, the transmit window is incremented for every ACK.
+       In Congestion Avoidance phase, the window is incremented for every RTT. Section 3.1, Page 4-7, RFC5681.  */
+    if (socket_ptr -> nx_tcp_socket_tx_window_congestion >= socket_ptr -> nx_tcp_socket_tx_slow_start_threshold)
+    {
+
+        /* In Congestion avoidance phase, for every ACK it receives, increase the window size using the
+           following approximation:
+           cwnd = cwnd + MSS * MSS / cwnd;  */
+        temp = socket_ptr -> nx_tcp_socket_connect_mss2 / socket_ptr -> nx_tcp_socket_tx_window_congestion;
+
+        /* If the above formula yields 0, the result SHOULD be rounded up to 1 byte.  */
+        if (temp == 0)
+        {
+            temp = 1;
+        }
+        socket_ptr -> nx_tcp_socket_tx_window_congestion = socket_ptr -> nx_tcp_socket_tx_window_congestion + temp;
+    }
+    else
+    {
+
+        /* In Slow start phase:
+           cwnd += min (N, SMSS),
+           where N is the number of ACKed bytes. */
+        if (acked_bytes < socket_ptr -> nx_tcp_socket_connect_mss)
+        {
+
+            /* In Slow start phase. Increase the cwnd by acked bytes.*/
+            socket_ptr -> nx_tcp_socket_tx_window_congestion += acked_bytes;
+        }
+        else
+        {
+
+            /* In Slow start phase. Increase the cwnd by full MSS for every ack.*/
+            socket_ptr -> nx_tcp_socket_tx_window_congestion += socket_ptr -> nx_tcp_socket_connect_mss;
+        }
+    }
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_reno_loss                        PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function sets the slow start threshold to half of the flight   */
+/*    size, but at least two segments, when a loss is detected by fast    */
+/*    retransmit or by a retransmission timeout.                          */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_retransmit             Retransmit packet             */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_tcp_congestion_reno_loss(NX_TCP_SOCKET *socket_ptr)
+{
+
+ULONG window;
+
+
+    /* Compute the flight size / 2 value. Equation 4, Section 3.1, RFC5681. */
+    window = socket_ptr -> nx_tcp_socket_tx_outstanding_bytes >> 1;
+
+    /* Make sure we have at least 2 * MSS */
+    if (window < (socket_ptr -> nx_tcp_socket_connect_mss << 1))
+    {
+        window = socket_ptr -> nx_tcp_socket_connect_mss << 1;
+    }
+
+    /* Set the slow_start_threshold */
+    socket_ptr -> nx_tcp_socket_tx_slow_start_threshold = window;
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_congestion_reno_pacing_rate                 PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function returns the pacing rate of the socket: one congestion */
+/*    window per smoothed round trip time, doubled in slow start and      */
+/*    raised by a quarter in congestion avoidance so the pacing does not  */
+/*    keep the window from growing.                                       */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to TCP socket         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    rate                                  Bytes per second, zero if     */
+/*                                            there is no RTT sample yet  */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_pacing_rate_get        Get pacing rate               */
+/*                                                                        */
+/**************************************************************************/
+ULONG  _nx_tcp_congestion_reno_pacing_rate(NX_TCP_SOCKET *socket_ptr)
+{
+
+ULONG cwnd;
+ULONG srtt;
+ULONG rate;
+
+
+    srtt = socket_ptr -> nx_tcp_socket_rtt_smoothed;
+    if (srtt == 0)
+    {
+        return(0);
+    }
+
+    /* The smoothed RTT is in ticks scaled by 8, split the division so that
+       cwnd * 8 * NX_IP_PERIODIC_RATE cannot overflow.  */
+    cwnd = socket_ptr -> nx_tcp_socket_tx_window_congestion;
+    rate = (cwnd / srtt) * (NX_IP_PERIODIC_RATE << 3) +
+        ((cwnd % srtt) * (NX_IP_PERIODIC_RATE << 3)) / srtt;
+
+    if (cwnd < socket_ptr -> nx_tcp_socket_tx_slow_start_threshold)
+    {
+        rate = (rate > (0xFFFFFFFF >> 1)) ? 0xFFFFFFFF : (rate << 1);
+    }
+    else
+    {
+        rate = (rate > (0xFFFFFFFF - (rate >> 2))) ? 0xFFFFFFFF : (rate + (rate >> 2));
+    }
+
+    return(rate);
+}
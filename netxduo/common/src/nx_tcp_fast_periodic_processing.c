@@ -173,6 +173,15 @@ ULONG          timer_rate;
                 /* Update the transmit sequence that entered fast transmit. */
                 socket_ptr -> nx_tcp_socket_tx_sequence_recover = socket_ptr -> nx_tcp_socket_tx_sequence - 1;
 
+#ifdef NX_ENABLE_TCP_SACK
+                /* The peer may discard the data it has selectively acknowledged, so
+                   start again from the head of the transmit queue.  */
+                socket_ptr -> nx_tcp_socket_sack_count = 0;
+                socket_ptr -> nx_tcp_socket_sack_unknown_end = socket_ptr -> nx_tcp_socket_sack_unknown_begin;
+                socket_ptr -> nx_tcp_socket_sack_high_retransmit = socket_ptr -> nx_tcp_socket_tx_sequence -
+                    socket_ptr -> nx_tcp_socket_tx_outstanding_bytes;
+#endif /* NX_ENABLE_TCP_SACK */
+
                 /* Retransmit the packet. */
                 _nx_tcp_socket_retransmit(ip_ptr, socket_ptr, NX_FALSE);
 
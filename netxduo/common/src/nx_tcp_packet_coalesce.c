@@ -0,0 +1,249 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_ip.h"
+#include "nx_packet.h"
+#include "nx_tcp.h"
+
+
+#ifdef NX_ENABLE_TCP_RECEIVE_COALESCING
+/* Sum the pseudo header and the TCP header of a queued IPv4 segment, the
+   TCP header is still in network byte order.  */
+static ULONG  _nx_tcp_packet_coalesce_header_sum(NX_IPV4_HEADER *ip_header_ptr, NX_TCP_HEADER *tcp_header_ptr, ULONG tcp_length)
+{
+
+ULONG  sum;
+ULONG  temp;
+ULONG *word_ptr;
+UINT   i;
+
+    /* The IP header is already in host byte order.  */
+    temp =  ip_header_ptr -> nx_ip_header_source_ip;
+    sum =  (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+    temp =  ip_header_ptr -> nx_ip_header_destination_ip;
+    sum +=  (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+    sum +=  NX_PROTOCOL_TCP + tcp_length;
+
+    /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+    word_ptr =  (ULONG *)tcp_header_ptr;
+    for (i = 0; i < sizeof(NX_TCP_HEADER) / sizeof(ULONG); i++)
+    {
+        temp =  word_ptr[i];
+        NX_CHANGE_ULONG_ENDIAN(temp);
+        sum +=  (temp >> NX_SHIFT_BY_16) + (temp & NX_LOWER_16_MASK);
+    }
+
+    /* Add in the carry bits, twice in case the first one overflows.  */
+    sum =  (sum >> NX_SHIFT_BY_16) + (sum & NX_LOWER_16_MASK);
+    sum =  (sum >> NX_SHIFT_BY_16) + (sum & NX_LOWER_16_MASK);
+
+    return(sum);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_packet_coalesce                             PORTABLE C      */
+/*                                                                        */
+/*                                                           6.1          */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function merges the segments that follow the supplied packet   */
+/*    on the TCP queue into it, as long as they continue its data on the  */
+/*    same IPv4 connection and carry nothing but ACK and PSH.  The TCP    */
+/*    header of each merged segment is dropped and its buffers are        */
+/*    chained behind the packet, so TCP processes the burst at once.      */
+/*                                                                        */
+/*    The checksum of the packet is adjusted from the headers alone, so   */
+/*    the packet verifies exactly when all merged segments do, and the    */
+/*    payload is still summed only once by _nx_tcp_packet_process.        */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    packet_ptr                            Packet to merge into          */
+/*    next_ptr                              Rest of the TCP queue         */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    next_ptr                              First packet not merged       */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_queue_process                 Process TCP packet queue      */
+/*                                                                        */
+/**************************************************************************/
+NX_PACKET  *_nx_tcp_packet_coalesce(NX_PACKET *packet_ptr, NX_PACKET *next_ptr)
+{
+
+ULONG           checksum;
+ULONG           packet_sum;
+ULONG           next_sum;
+ULONG           header_word_3;
+ULONG           next_header_word_3;
+ULONG           payload_length;
+ULONG           next_payload_length;
+ULONG           segment_count;
+ULONG           sequence;
+ULONG           next_sequence;
+NX_PACKET      *last_ptr;
+NX_IPV4_HEADER *ip_header_ptr;
+NX_IPV4_HEADER *next_ip_header_ptr;
+NX_TCP_HEADER  *tcp_header_ptr;
+NX_TCP_HEADER  *next_tcp_header_ptr;
+
+    /* Only IPv4 data segments without options are merged.  */
+    if ((packet_ptr -> nx_packet_ip_version != NX_IP_VERSION_V4) ||
+        ((ULONG)(packet_ptr -> nx_packet_append_ptr - packet_ptr -> nx_packet_prepend_ptr) < sizeof(NX_TCP_HEADER)))
+    {
+        return(next_ptr);
+    }
+
+    /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+    ip_header_ptr =  (NX_IPV4_HEADER *)packet_ptr -> nx_packet_ip_header;
+    /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+    tcp_header_ptr =  (NX_TCP_HEADER *)packet_ptr -> nx_packet_prepend_ptr;
+    header_word_3 =  tcp_header_ptr -> nx_tcp_header_word_3;
+    NX_CHANGE_ULONG_ENDIAN(header_word_3);
+    if ((header_word_3 & ~(NX_TCP_PSH_BIT | NX_LOWER_16_MASK)) != (NX_TCP_HEADER_SIZE | NX_TCP_ACK_BIT))
+    {
+        return(next_ptr);
+    }
+
+    payload_length =  packet_ptr -> nx_packet_length - (ULONG)sizeof(NX_TCP_HEADER);
+    segment_count =  1;
+
+    /* Find the last buffer of the packet.  */
+    last_ptr =  packet_ptr;
+    while (last_ptr -> nx_packet_next)
+    {
+        last_ptr =  last_ptr -> nx_packet_next;
+    }
+
+    /* Loop to merge the following segments.  */
+    while (next_ptr && (segment_count < NX_TCP_RECEIVE_COALESCING_SEGMENTS))
+    {
+
+        /* The payload must end on an even offset so the checksum of the next segment
+           adds up unchanged, and the packet must fit in an IP packet.  */
+        if ((payload_length == 0) || (payload_length & 1) ||
+            (payload_length + next_ptr -> nx_packet_length > NX_LOWER_16_MASK - sizeof(NX_IPV4_HEADER)))
+        {
+            break;
+        }
+
+        /* The next segment must be of the same connection, with data in its first buffer.  */
+        if ((next_ptr -> nx_packet_ip_version != NX_IP_VERSION_V4) ||
+            (next_ptr -> nx_packet_address.nx_packet_interface_ptr != packet_ptr -> nx_packet_address.nx_packet_interface_ptr) ||
+            ((ULONG)(next_ptr -> nx_packet_append_ptr - next_ptr -> nx_packet_prepend_ptr) <= sizeof(NX_TCP_HEADER)))
+        {
+            break;
+        }
+
+        /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+        next_ip_header_ptr =  (NX_IPV4_HEADER *)next_ptr -> nx_packet_ip_header;
+        /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+        next_tcp_header_ptr =  (NX_TCP_HEADER *)next_ptr -> nx_packet_prepend_ptr;
+        if ((next_ip_header_ptr -> nx_ip_header_source_ip != ip_header_ptr -> nx_ip_header_source_ip) ||
+            (next_ip_header_ptr -> nx_ip_header_destination_ip != ip_header_ptr -> nx_ip_header_destination_ip) ||
+            (next_tcp_header_ptr -> nx_tcp_header_word_0 != tcp_header_ptr -> nx_tcp_header_word_0) ||
+            (next_tcp_header_ptr -> nx_tcp_acknowledgment_number != tcp_header_ptr -> nx_tcp_acknowledgment_number))
+        {
+            break;
+        }
+
+        /* It must carry data only and continue the data of the packet.  */
+        next_header_word_3 =  next_tcp_header_ptr -> nx_tcp_header_word_3;
+        NX_CHANGE_ULONG_ENDIAN(next_header_word_3);
+        sequence =  tcp_header_ptr -> nx_tcp_sequence_number;
+        NX_CHANGE_ULONG_ENDIAN(sequence);
+        next_sequence =  next_tcp_header_ptr -> nx_tcp_sequence_number;
+        NX_CHANGE_ULONG_ENDIAN(next_sequence);
+        if (((next_header_word_3 & ~(NX_TCP_PSH_BIT | NX_LOWER_16_MASK)) != (NX_TCP_HEADER_SIZE | NX_TCP_ACK_BIT)) ||
+            ((sequence + payload_length) != next_sequence))
+        {
+            break;
+        }
+
+        next_payload_length =  next_ptr -> nx_packet_length - (ULONG)sizeof(NX_TCP_HEADER);
+
+        /* Sum both headers as they were received.  */
+        packet_sum =  _nx_tcp_packet_coalesce_header_sum(ip_header_ptr, tcp_header_ptr,
+                                                         payload_length + sizeof(NX_TCP_HEADER));
+        next_sum =  _nx_tcp_packet_coalesce_header_sum(ip_header_ptr, next_tcp_header_ptr,
+                                                       next_payload_length + sizeof(NX_TCP_HEADER));
+
+        /* The packet takes over the window and the PSH bit of the next segment.  */
+        header_word_3 =  (header_word_3 & ~(NX_TCP_PSH_BIT | NX_LOWER_16_MASK)) |
+                         (next_header_word_3 & (NX_TCP_PSH_BIT | NX_LOWER_16_MASK));
+        tcp_header_ptr -> nx_tcp_header_word_3 =  header_word_3;
+        NX_CHANGE_ULONG_ENDIAN(tcp_header_ptr -> nx_tcp_header_word_3);
+
+        /* Remove the header of the next segment and chain its buffers.  */
+        next_ptr -> nx_packet_prepend_ptr +=  sizeof(NX_TCP_HEADER);
+        last_ptr -> nx_packet_next =  next_ptr;
+        payload_length +=  next_payload_length;
+        packet_ptr -> nx_packet_length +=  next_payload_length;
+
+        /* Pickup the segment after the next one before the queue link is cleared.  */
+        last_ptr =  next_ptr;
+        next_ptr =  next_ptr -> nx_packet_queue_next;
+        last_ptr -> nx_packet_queue_next =  NX_NULL;
+        while (last_ptr -> nx_packet_next)
+        {
+            last_ptr =  last_ptr -> nx_packet_next;
+        }
+        packet_ptr -> nx_packet_last =  last_ptr;
+
+        /* Set the checksum to cancel the sums of the old headers. The packet then sums to the
+           sum of both segments, which is all ones only if both were intact.  */
+        NX_CHANGE_ULONG_ENDIAN(tcp_header_ptr -> nx_tcp_header_word_4);
+        tcp_header_ptr -> nx_tcp_header_word_4 &=  NX_LOWER_16_MASK;
+        NX_CHANGE_ULONG_ENDIAN(tcp_header_ptr -> nx_tcp_header_word_4);
+        checksum =  _nx_tcp_packet_coalesce_header_sum(ip_header_ptr, tcp_header_ptr,
+                                                       payload_length + sizeof(NX_TCP_HEADER));
+        checksum +=  (~packet_sum & NX_LOWER_16_MASK) + (~next_sum & NX_LOWER_16_MASK);
+        checksum =  (checksum >> NX_SHIFT_BY_16) + (checksum & NX_LOWER_16_MASK);
+        checksum =  (checksum >> NX_SHIFT_BY_16) + (checksum & NX_LOWER_16_MASK);
+        checksum =  ~checksum & NX_LOWER_16_MASK;
+        NX_CHANGE_ULONG_ENDIAN(tcp_header_ptr -> nx_tcp_header_word_4);
+        tcp_header_ptr -> nx_tcp_header_word_4 |=  checksum << NX_SHIFT_BY_16;
+        NX_CHANGE_ULONG_ENDIAN(tcp_header_ptr -> nx_tcp_header_word_4);
+
+        segment_count++;
+    }
+
+    return(next_ptr);
+}
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
+
@@ -74,6 +74,7 @@
 /*    _nx_ip_checksum_compute               Calculate TCP packet checksum */
 /*    _nx_tcp_mss_option_get                Get peer MSS option           */
 /*    _nx_tcp_no_connection_reset           Reset on no connection        */
+/*    _nx_tcp_sack_permitted_option_get     Get peer SACK permitted option*/
 /*    _nx_tcp_packet_send_syn               Send SYN message              */
 /*    _nx_tcp_socket_packet_process         Socket specific packet        */
 /*                                            processing routine          */
@@ -127,6 +128,9 @@ UINT                         status;
 #ifdef NX_ENABLE_TCP_WINDOW_SCALING
 ULONG                        rwin_scale = 0xFF;
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
+#ifdef NX_ENABLE_TCP_SACK
+ULONG                        sack_permitted = NX_FALSE;
+#endif /* NX_ENABLE_TCP_SACK */
 
 #ifdef NX_DISABLE_TCP_RX_CHECKSUM
     compute_checksum = 0;
@@ -316,6 +320,20 @@ ULONG                        rwin_scale = 0xFF;
             is_valid_option_flag = NX_FALSE;
         }
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
+
+#ifdef NX_ENABLE_TCP_SACK
+        /* Only a SYN can offer SACK, so skip the search for other segments.  */
+        if (tcp_header_ptr -> nx_tcp_header_word_3 & NX_TCP_SYN_BIT)
+        {
+            status = _nx_tcp_sack_permitted_option_get((packet_ptr -> nx_packet_prepend_ptr + sizeof(NX_TCP_HEADER)), option_words * (ULONG)sizeof(ULONG), &sack_permitted);
+
+            /* Check the status. if status is NX_FALSE, means Option Length is invalid.  */
+            if (status == NX_FALSE)
+            {
+                is_valid_option_flag = NX_FALSE;
+            }
+        }
+#endif /* NX_ENABLE_TCP_SACK */
     }
 
     /* Pickup the destination TCP port.  */
@@ -414,6 +432,11 @@ ULONG                        rwin_scale = 0xFF;
                          */
                         socket_ptr -> nx_tcp_snd_win_scale_value = rwin_scale;
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
+
+#ifdef NX_ENABLE_TCP_SACK
+                        /* Record whether the peer accepts SACK blocks.  */
+                        socket_ptr -> nx_tcp_socket_sack_permitted = sack_permitted;
+#endif /* NX_ENABLE_TCP_SACK */
                     }
 
                     /* Process the packet within an existing TCP connection.  */
@@ -707,6 +730,11 @@ ULONG                        rwin_scale = 0xFF;
                     socket_ptr -> nx_tcp_snd_win_scale_value = rwin_scale;
 #endif /* NX_ENABLE_TCP_WINDOW_SCALING */
 
+#ifdef NX_ENABLE_TCP_SACK
+                    /* Record whether the peer accepts SACK blocks.  */
+                    socket_ptr -> nx_tcp_socket_sack_permitted = sack_permitted;
+#endif /* NX_ENABLE_TCP_SACK */
+
                     /* Set the initial slow start threshold to be the advertised window size. */
                     socket_ptr -> nx_tcp_socket_tx_slow_start_threshold = socket_ptr -> nx_tcp_socket_tx_window_advertised;
 
@@ -106,8 +106,13 @@ TX_INTERRUPT_SAVE_AREA
     }
 #endif
 
+#ifndef NX_ENABLE_TCP_RECEIVE_COALESCING
     /* Determine if this routine is being called from an ISR.  */
     if ((TX_THREAD_GET_SYSTEM_STATE()) || (&(ip_ptr -> nx_ip_thread) != _tx_thread_current_ptr))
+#else
+    /* Always queue the packet, so that the segments of one receive batch can be
+       merged before they are processed.  */
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
     {
 
         /* If system state is non-zero, we are in an ISR. If the current thread is not the IP thread,
@@ -147,6 +152,7 @@ TX_INTERRUPT_SAVE_AREA
         /* Wakeup IP thread for processing one or more messages in the TCP queue.  */
         tx_event_flags_set(&(ip_ptr -> nx_ip_events), NX_IP_TCP_EVENT, TX_OR);
     }
+#ifndef NX_ENABLE_TCP_RECEIVE_COALESCING
     else
     {
 
@@ -154,5 +160,6 @@ TX_INTERRUPT_SAVE_AREA
            thread and thus may call the TCP processing directly.  */
         _nx_tcp_packet_process(ip_ptr, packet_ptr);
     }
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
 }
 
@@ -69,6 +69,7 @@
 /*    _nx_ip_checksum_compute               Calculate TCP checksum        */
 /*    _nx_ip_packet_send                    Send IPv4 packet              */
 /*    _nx_ipv6_packet_send                  Send IPv6 packet              */
+/*    _nx_tcp_sack_option_build             Build SACK option             */
 /*                                                                        */
 /*  CALLED BY                                                             */
 /*                                                                        */
@@ -102,6 +103,9 @@ UINT           compute_checksum = 1;
 #endif /* defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) || defined(NX_IPSEC_ENABLE) */
 ULONG          header_size;
 ULONG          window_size;
+#ifdef NX_ENABLE_TCP_SACK
+ULONG          option_size = 0;
+#endif /* NX_ENABLE_TCP_SACK */
 
 #ifdef NX_DISABLE_TCP_TX_CHECKSUM
     compute_checksum = 0;
@@ -116,6 +120,15 @@ ULONG          window_size;
         /* Set header size. */
         header_size = NX_TCP_SYN_HEADER;
         window_size = socket_ptr -> nx_tcp_socket_rx_window_current;
+
+#ifdef NX_ENABLE_TCP_SACK
+        /* Offer SACK in our SYN, and accept it in the SYN+ACK only if the peer offered it.  */
+        if ((!(control_bits & NX_TCP_ACK_BIT)) || (socket_ptr -> nx_tcp_socket_sack_permitted))
+        {
+            option_size = sizeof(ULONG);
+            header_size += (option_size << (NX_TCP_HEADER_SHIFT - 2));
+        }
+#endif /* NX_ENABLE_TCP_SACK */
     }
     else
     {
@@ -172,7 +185,11 @@ ULONG          window_size;
 #endif /* NX_ENABLE_DUAL_PACKET_POOL */
 
     /* Check to see if the packet has enough room to fill with the max TCP header (SYN + probe data).  */
+#ifdef NX_ENABLE_TCP_SACK
+    if ((UINT)(packet_ptr -> nx_packet_data_end - packet_ptr -> nx_packet_prepend_ptr) < (sizeof(NX_TCP_HEADER) + NX_TCP_SACK_OPTION_SIZE))
+#else
     if ((UINT)(packet_ptr -> nx_packet_data_end - packet_ptr -> nx_packet_prepend_ptr) < (NX_TCP_SYN_SIZE + 1))
+#endif /* NX_ENABLE_TCP_SACK */
     {
 
         /* Error getting packet, so just get out!  */
@@ -210,6 +227,17 @@ ULONG          window_size;
     /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
     tcp_header_ptr =  (NX_TCP_HEADER *)packet_ptr -> nx_packet_prepend_ptr;
 
+#ifdef NX_ENABLE_TCP_SACK
+    /* A pure ACK reports the out-of-order data held in the receive queue.  */
+    if ((control_bits == NX_TCP_ACK_BIT) && (data == NX_NULL) && (socket_ptr -> nx_tcp_socket_sack_permitted))
+    {
+        option_size = _nx_tcp_sack_option_build(socket_ptr, packet_ptr -> nx_packet_append_ptr);
+        header_size += (option_size << (NX_TCP_HEADER_SHIFT - 2));
+        packet_ptr -> nx_packet_append_ptr += option_size;
+        packet_ptr -> nx_packet_length += option_size;
+    }
+#endif /* NX_ENABLE_TCP_SACK */
+
     /* Build the control request in the TCP header.  */
     tcp_header_ptr -> nx_tcp_header_word_0 =        (((ULONG)(socket_ptr -> nx_tcp_socket_port)) << NX_SHIFT_BY_16) | (ULONG)socket_ptr -> nx_tcp_socket_connect_port;
     tcp_header_ptr -> nx_tcp_sequence_number =      tx_sequence;
@@ -250,10 +278,25 @@ ULONG          window_size;
         /* Set options. */
         /*lint --e{927} --e{826} suppress cast of pointer to pointer, since it is necessary  */
         *((ULONG *)packet_ptr -> nx_packet_append_ptr) = option_word_1;
-        *(((ULONG *)packet_ptr -> nx_packet_append_ptr) + 1) = option_word_2;
+        packet_ptr -> nx_packet_append_ptr += sizeof(ULONG);
+
+#ifdef NX_ENABLE_TCP_SACK
+        /* SACK permitted goes ahead of option word 2, which may end the list.  */
+        if (option_size)
+        {
+        ULONG sack_option = NX_TCP_SACK_PERMIT_OPTION;
+
+            NX_CHANGE_ULONG_ENDIAN(sack_option);
+            *((ULONG *)packet_ptr -> nx_packet_append_ptr) = sack_option;
+            packet_ptr -> nx_packet_append_ptr += sizeof(ULONG);
+            packet_ptr -> nx_packet_length += (ULONG)sizeof(ULONG);
+        }
+#endif /* NX_ENABLE_TCP_SACK */
+
+        *((ULONG *)packet_ptr -> nx_packet_append_ptr) = option_word_2;
 
         /* Adjust packet information. */
-        packet_ptr -> nx_packet_append_ptr += (sizeof(ULONG) << 1);
+        packet_ptr -> nx_packet_append_ptr += sizeof(ULONG);
         packet_ptr -> nx_packet_length += (ULONG)(sizeof(ULONG) << 1);
     }
 
@@ -53,6 +53,7 @@
 /*                                                                        */
 /*  CALLS                                                                 */
 /*                                                                        */
+/*    _nx_tcp_packet_coalesce               Merge segments of a flow      */
 /*    _nx_tcp_packet_process                Process TCP packet            */
 /*                                                                        */
 /*  CALLED BY                                                             */
@@ -103,6 +104,11 @@ NX_PACKET *packet_ptr;
         /* Add debug information. */
         NX_PACKET_DEBUG(__FILE__, __LINE__, packet_ptr);
 
+#ifdef NX_ENABLE_TCP_RECEIVE_COALESCING
+        /* Merge the following segments of the same flow into the packet.  */
+        queue_head =  _nx_tcp_packet_coalesce(packet_ptr, queue_head);
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
+
         /* Process the packet.  */
         _nx_tcp_packet_process(ip_ptr, packet_ptr);
     }
@@ -0,0 +1,200 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_packet.h"
+#include "nx_tcp.h"
+
+#ifdef NX_ENABLE_TCP_SACK
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_sack_option_build                           PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This internal function builds the SACK option for an outgoing ACK   */
+/*    from the out-of-order packets on the receive queue. Contiguous      */
+/*    packets are reported as one block, and the block that holds the     */
+/*    most recently received segment is reported first (RFC 2018 4).      */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to owning socket      */
+/*    option_ptr                            Pointer to option area, room  */
+/*                                            for 4 + 8 * blocks bytes    */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    Size of the option in bytes, 0 if there is nothing to report        */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_packet_send_control           Send TCP control packet       */
+/*                                                                        */
+/**************************************************************************/
+ULONG  _nx_tcp_sack_option_build(NX_TCP_SOCKET *socket_ptr, UCHAR *option_ptr)
+{
+
+NX_PACKET     *search_ptr;
+NX_TCP_HEADER *search_header_ptr;
+ULONG          header_length;
+ULONG          search_begin_sequence;
+ULONG          search_end_sequence;
+ULONG          block_begin[NX_TCP_SACK_MAX_BLOCKS];
+ULONG          block_end[NX_TCP_SACK_MAX_BLOCKS];
+ULONG          run_begin = 0;
+ULONG          run_end = 0;
+ULONG          recent;
+UINT           in_run = NX_FALSE;
+UINT           recent_found = NX_FALSE;
+UINT           others = 0;
+UINT           first;
+UINT           count;
+UINT           i;
+
+
+    /* All data on the receive queue is in order if the tail is ready.  */
+    search_ptr =  socket_ptr -> nx_tcp_socket_receive_queue_tail;
+    /*lint -e{923} suppress cast of ULONG to pointer.  */
+    if ((search_ptr == NX_NULL) || (search_ptr -> nx_packet_queue_next == (NX_PACKET *)NX_PACKET_READY))
+    {
+        return(0);
+    }
+
+    recent =  socket_ptr -> nx_tcp_socket_sack_recent;
+
+    /* Walk the queue, merging out-of-order packets into runs. Slot 0 is kept for
+       the run that holds the most recent segment, the others follow in order.  */
+    search_ptr =  socket_ptr -> nx_tcp_socket_receive_queue_head;
+    for (;;)
+    {
+
+        /*lint -e{923} suppress cast of ULONG to pointer.  */
+        if ((search_ptr == NX_NULL) || (search_ptr == (NX_PACKET *)NX_PACKET_ENQUEUED))
+        {
+            search_ptr = NX_NULL;
+        }
+        /*lint -e{923} suppress cast of ULONG to pointer.  */
+        else if (search_ptr -> nx_packet_queue_next == (NX_PACKET *)NX_PACKET_READY)
+        {
+
+            /* In order data, already covered by the cumulative ACK.  */
+            search_ptr =  search_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next;
+            continue;
+        }
+        else
+        {
+
+            /* Pickup the sequence range of this packet.  The header is in host byte order.  */
+            /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+            search_header_ptr =  (NX_TCP_HEADER *)search_ptr -> nx_packet_prepend_ptr;
+            header_length =  (search_header_ptr -> nx_tcp_header_word_3 >> NX_TCP_HEADER_SHIFT) * (ULONG)sizeof(ULONG);
+            search_begin_sequence =  search_header_ptr -> nx_tcp_sequence_number;
+            search_end_sequence =  search_begin_sequence + search_ptr -> nx_packet_length - header_length;
+
+            /* Move to the next packet.  */
+            search_ptr =  search_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next;
+
+            /* Extend the current run if this packet touches it.  */
+            if (in_run && ((INT)(search_begin_sequence - run_end) <= 0))
+            {
+                if ((INT)(search_end_sequence - run_end) > 0)
+                {
+                    run_end =  search_end_sequence;
+                }
+                continue;
+            }
+        }
+
+        /* The current run is complete, record it.  */
+        if (in_run)
+        {
+            if ((recent_found == NX_FALSE) &&
+                ((INT)(recent - run_begin) >= 0) && ((INT)(recent - run_end) < 0))
+            {
+                block_begin[0] =  run_begin;
+                block_end[0] =    run_end;
+                recent_found =    NX_TRUE;
+            }
+            else if (others < (NX_TCP_SACK_MAX_BLOCKS - 1))
+            {
+                others++;
+                block_begin[others] =  run_begin;
+                block_end[others] =    run_end;
+            }
+        }
+
+        if (search_ptr == NX_NULL)
+        {
+            break;
+        }
+
+        /* Start a new run with this packet.  */
+        run_begin =  search_begin_sequence;
+        run_end =    search_end_sequence;
+        in_run =     NX_TRUE;
+    }
+
+    /* Skip slot 0 if the most recent segment has already been delivered.  */
+    first =  (recent_found == NX_TRUE) ? 0 : 1;
+    count =  others + 1 - first;
+    if (count == 0)
+    {
+        return(0);
+    }
+
+    /* Build NOP, NOP, kind and length, then the blocks in network byte order.  */
+    *option_ptr++ =  NX_TCP_NOP_KIND;
+    *option_ptr++ =  NX_TCP_NOP_KIND;
+    *option_ptr++ =  NX_TCP_SACK_KIND;
+    *option_ptr++ =  (UCHAR)(2 + (count << 3));
+
+    for (i = first; i <= others; i++)
+    {
+        *option_ptr++ =  (UCHAR)(block_begin[i] >> 24);
+        *option_ptr++ =  (UCHAR)(block_begin[i] >> 16);
+        *option_ptr++ =  (UCHAR)(block_begin[i] >> 8);
+        *option_ptr++ =  (UCHAR)block_begin[i];
+        *option_ptr++ =  (UCHAR)(block_end[i] >> 24);
+        *option_ptr++ =  (UCHAR)(block_end[i] >> 16);
+        *option_ptr++ =  (UCHAR)(block_end[i] >> 8);
+        *option_ptr++ =  (UCHAR)block_end[i];
+    }
+
+    /* Return the option size.  */
+    return(4 + (count << 3));
+}
+#endif /* NX_ENABLE_TCP_SACK */
+
@@ -0,0 +1,149 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_tcp.h"
+
+#ifdef NX_ENABLE_TCP_SACK
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_sack_permitted_option_get                   PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This internal function searches for the SACK-permitted option.      */
+/*    If found, first check the option length, if option length is not    */
+/*    valid, it returns NX_FALSE to the caller, else it sets the SACK      */
+/*    permitted flag and returns NX_TRUE to the caller. Otherwise,        */
+/*    NX_TRUE is returned.                                                */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    option_ptr                            Pointer to option area        */
+/*    option_area_size                      Size of option area           */
+/*    sack_permitted                        SACK permitted flag           */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    NX_FALSE                              TCP option is invalid         */
+/*    NX_TRUE                               TCP option is valid           */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_packet_process                TCP packet processing         */
+/*    _nx_tcp_server_socket_relisten        Socket relisten processing    */
+/*                                                                        */
+/**************************************************************************/
+UINT  _nx_tcp_sack_permitted_option_get(UCHAR *option_ptr, ULONG option_area_size, ULONG *sack_permitted)
+{
+
+ULONG option_length;
+
+
+    /* Clear the flag, in case the SYN message does not offer SACK.  */
+    *sack_permitted = NX_FALSE;
+
+    /* Loop through the option area looking for the SACK-permitted option.  */
+    while (option_area_size >= 2)
+    {
+
+        /* Is the current character the SACK-permitted type?  */
+        if (*option_ptr == NX_TCP_SACK_PERMIT_KIND)
+        {
+
+            /* Yes, we found it!  */
+
+            /* Check the option length, if option length is not equal to 2, return NX_FALSE.  */
+            if (*(option_ptr + 1) != 2)
+            {
+                return(NX_FALSE);
+            }
+
+            /* The peer can accept SACK blocks.  */
+            *sack_permitted = NX_TRUE;
+
+            break;
+        }
+
+        /* Otherwise, process relative to the option type.  */
+
+        /* Check for end of list.  */
+        if (*option_ptr == NX_TCP_EOL_KIND)
+        {
+
+            /* Yes, end of list, get out!  */
+            break;
+        }
+
+        /* Check for NOP.  */
+        if (*option_ptr == NX_TCP_NOP_KIND)
+        {
+            /* One character option!  Skip this option and move to the next entry. */
+            option_ptr++;
+
+            option_area_size--;
+        }
+        else
+        {
+
+            /* Derive the option length.  */
+            option_length = *(option_ptr + 1);
+
+            if (option_length == 0)
+            {
+                /* Illegal option length. */
+                return(NX_FALSE);
+            }
+
+            /* Move the option pointer forward.  */
+            option_ptr =  option_ptr + option_length;
+
+            /* Determine if this is greater than the option area size.  */
+            if (option_length > option_area_size)
+            {
+                return(NX_FALSE);
+            }
+            else
+            {
+                option_area_size =  option_area_size - option_length;
+            }
+        }
+    }
+
+    /* Return.  */
+    return(NX_TRUE);
+}
+#endif /* NX_ENABLE_TCP_SACK */
+
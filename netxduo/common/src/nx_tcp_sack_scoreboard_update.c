@@ -0,0 +1,257 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_tcp.h"
+
+#ifdef NX_ENABLE_TCP_SACK
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_sack_scoreboard_update                      PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This internal function updates the sender scoreboard from an        */
+/*    incoming ACK. Ranges at or below the cumulative ACK are dropped,    */
+/*    and the SACK blocks of the segment, if any, are merged into the     */
+/*    scoreboard. Blocks outside the outstanding data are ignored. When   */
+/*    the scoreboard is full, the highest range is given up and the span  */
+/*    of the ranges given up is kept, so it is not taken for a hole.      */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to owning socket      */
+/*    option_ptr                            Pointer to option area        */
+/*    option_area_size                      Size of option area           */
+/*    ack_number                            Cumulative ACK of the segment */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_packet_process         Process socket packet         */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_tcp_sack_scoreboard_update(NX_TCP_SOCKET *socket_ptr, UCHAR *option_ptr,
+                                     ULONG option_area_size, ULONG ack_number)
+{
+
+ULONG option_length;
+ULONG block_begin;
+ULONG block_end;
+ULONG count;
+ULONG high;
+ULONG temp;
+ULONG i;
+
+
+    /* Forget the ranges that are now covered by the cumulative ACK.  */
+    count =  socket_ptr -> nx_tcp_socket_sack_count;
+    i = 0;
+    while (i < count)
+    {
+        if ((INT)(socket_ptr -> nx_tcp_socket_sack_end[i] - ack_number) <= 0)
+        {
+
+            /* Move the last entry into this slot.  */
+            count--;
+            socket_ptr -> nx_tcp_socket_sack_begin[i] =  socket_ptr -> nx_tcp_socket_sack_begin[count];
+            socket_ptr -> nx_tcp_socket_sack_end[i] =    socket_ptr -> nx_tcp_socket_sack_end[count];
+            continue;
+        }
+
+        if ((INT)(socket_ptr -> nx_tcp_socket_sack_begin[i] - ack_number) < 0)
+        {
+            socket_ptr -> nx_tcp_socket_sack_begin[i] =  ack_number;
+        }
+        i++;
+    }
+
+    /* Trim the span of the unrecorded ranges the same way.  */
+    if (socket_ptr -> nx_tcp_socket_sack_unknown_begin != socket_ptr -> nx_tcp_socket_sack_unknown_end)
+    {
+        if ((INT)(socket_ptr -> nx_tcp_socket_sack_unknown_end - ack_number) <= 0)
+        {
+            socket_ptr -> nx_tcp_socket_sack_unknown_begin =  ack_number;
+            socket_ptr -> nx_tcp_socket_sack_unknown_end =    ack_number;
+        }
+        else if ((INT)(socket_ptr -> nx_tcp_socket_sack_unknown_begin - ack_number) < 0)
+        {
+            socket_ptr -> nx_tcp_socket_sack_unknown_begin =  ack_number;
+        }
+    }
+
+    /* Loop through the option area looking for the SACK option.  */
+    while (option_area_size >= 2)
+    {
+
+        /* Check for end of list.  */
+        if (*option_ptr == NX_TCP_EOL_KIND)
+        {
+            break;
+        }
+
+        /* Check for NOP.  */
+        if (*option_ptr == NX_TCP_NOP_KIND)
+        {
+            option_ptr++;
+            option_area_size--;
+            continue;
+        }
+
+        option_length = *(option_ptr + 1);
+        if ((option_length < 2) || (option_length > option_area_size))
+        {
+
+            /* Illegal option length, it is handled by the caller.  */
+            break;
+        }
+
+        if ((*option_ptr == NX_TCP_SACK_KIND) && (((option_length - 2) & 7) == 0))
+        {
+
+            /* Skip kind and length.  */
+            option_ptr += 2;
+            option_length -= 2;
+
+            /* Merge every block in.  */
+            while (option_length)
+            {
+
+                block_begin =  ((ULONG)option_ptr[0] << 24) | ((ULONG)option_ptr[1] << 16) |
+                               ((ULONG)option_ptr[2] << 8) | (ULONG)option_ptr[3];
+                block_end =    ((ULONG)option_ptr[4] << 24) | ((ULONG)option_ptr[5] << 16) |
+                               ((ULONG)option_ptr[6] << 8) | (ULONG)option_ptr[7];
+                option_ptr += 8;
+                option_length -= 8;
+
+                /* Only data above the cumulative ACK and not beyond what has been sent
+                   can be selectively acknowledged (D-SACK blocks fall below the ACK).  */
+                if (((INT)(block_end - block_begin) <= 0) ||
+                    ((INT)(block_begin - ack_number) <= 0) ||
+                    ((INT)(block_end - socket_ptr -> nx_tcp_socket_tx_sequence) > 0))
+                {
+                    continue;
+                }
+
+                /* Absorb the entries this block overlaps or touches.  */
+                i = 0;
+                while (i < count)
+                {
+                    if (((INT)(block_begin - socket_ptr -> nx_tcp_socket_sack_end[i]) <= 0) &&
+                        ((INT)(socket_ptr -> nx_tcp_socket_sack_begin[i] - block_end) <= 0))
+                    {
+                        if ((INT)(socket_ptr -> nx_tcp_socket_sack_begin[i] - block_begin) < 0)
+                        {
+                            block_begin =  socket_ptr -> nx_tcp_socket_sack_begin[i];
+                        }
+                        if ((INT)(socket_ptr -> nx_tcp_socket_sack_end[i] - block_end) > 0)
+                        {
+                            block_end =  socket_ptr -> nx_tcp_socket_sack_end[i];
+                        }
+
+                        count--;
+                        socket_ptr -> nx_tcp_socket_sack_begin[i] =  socket_ptr -> nx_tcp_socket_sack_begin[count];
+                        socket_ptr -> nx_tcp_socket_sack_end[i] =    socket_ptr -> nx_tcp_socket_sack_end[count];
+                        continue;
+                    }
+                    i++;
+                }
+
+                /* Record the block if there is room.  */
+                if (count < NX_TCP_SACK_SCOREBOARD_SIZE)
+                {
+                    socket_ptr -> nx_tcp_socket_sack_begin[count] =  block_begin;
+                    socket_ptr -> nx_tcp_socket_sack_end[count] =    block_end;
+                    count++;
+                    continue;
+                }
+
+                /* The scoreboard is full, keep the lowest ranges since the holes are filled
+                   from the bottom, and give up the highest one.  */
+                high =  0;
+                for (i = 1; i < count; i++)
+                {
+                    if ((INT)(socket_ptr -> nx_tcp_socket_sack_begin[i] - socket_ptr -> nx_tcp_socket_sack_begin[high]) > 0)
+                    {
+                        high =  i;
+                    }
+                }
+
+                if ((INT)(block_begin - socket_ptr -> nx_tcp_socket_sack_begin[high]) < 0)
+                {
+                    temp =  block_begin;
+                    block_begin =  socket_ptr -> nx_tcp_socket_sack_begin[high];
+                    socket_ptr -> nx_tcp_socket_sack_begin[high] =  temp;
+                    temp =  block_end;
+                    block_end =  socket_ptr -> nx_tcp_socket_sack_end[high];
+                    socket_ptr -> nx_tcp_socket_sack_end[high] =  temp;
+                }
+
+                /* The peer may not report the range given up again before a higher one, which
+                   would make the data between them look lost. Remember where the scoreboard
+                   stops being complete.  */
+                if (socket_ptr -> nx_tcp_socket_sack_unknown_begin == socket_ptr -> nx_tcp_socket_sack_unknown_end)
+                {
+                    socket_ptr -> nx_tcp_socket_sack_unknown_begin =  block_begin;
+                    socket_ptr -> nx_tcp_socket_sack_unknown_end =    block_end;
+                }
+                else
+                {
+                    if ((INT)(block_begin - socket_ptr -> nx_tcp_socket_sack_unknown_begin) < 0)
+                    {
+                        socket_ptr -> nx_tcp_socket_sack_unknown_begin =  block_begin;
+                    }
+                    if ((INT)(block_end - socket_ptr -> nx_tcp_socket_sack_unknown_end) > 0)
+                    {
+                        socket_ptr -> nx_tcp_socket_sack_unknown_end =  block_end;
+                    }
+                }
+            }
+
+            break;
+        }
+
+        /* Move to the next option.  */
+        option_ptr =  option_ptr + option_length;
+        option_area_size =  option_area_size - option_length;
+    }
+
+    socket_ptr -> nx_tcp_socket_sack_count =  count;
+}
+#endif /* NX_ENABLE_TCP_SACK */
+
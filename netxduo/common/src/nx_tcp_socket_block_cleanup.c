@@ -106,6 +106,17 @@ VOID  _nx_tcp_socket_block_cleanup(NX_TCP_SOCKET *socket_ptr)
     /* Reset fast recovery stage. */
     socket_ptr -> nx_tcp_socket_fast_recovery = NX_FALSE;
 
+    /* Forget the round trip time of the previous connection. */
+    socket_ptr -> nx_tcp_socket_rtt_smoothed = 0;
+    socket_ptr -> nx_tcp_socket_rtt_timing = NX_FALSE;
+
+#ifdef NX_ENABLE_TCP_SACK
+    /* Reset the SACK state, it is negotiated again on the next connection. */
+    socket_ptr -> nx_tcp_socket_sack_permitted = NX_FALSE;
+    socket_ptr -> nx_tcp_socket_sack_count = 0;
+    socket_ptr -> nx_tcp_socket_sack_unknown_end = socket_ptr -> nx_tcp_socket_sack_unknown_begin;
+#endif /* NX_ENABLE_TCP_SACK */
+
     /* Connection needs to be closed down immediately.  */
     if (socket_ptr -> nx_tcp_socket_client_type)
     {
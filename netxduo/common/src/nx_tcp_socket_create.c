@@ -157,6 +157,8 @@ NX_TCP_SOCKET *tail_ptr;
     socket_ptr -> nx_tcp_socket_tx_window_advertised = 0;
     socket_ptr -> nx_tcp_socket_tx_window_congestion = 0;
 
+    /* Use Reno congestion control until the application selects another algorithm.  */
+    socket_ptr -> nx_tcp_socket_congestion_control = &_nx_tcp_congestion_control_reno;
 
     /* Initialize the ack_n_packet counter. */
     socket_ptr -> nx_tcp_socket_ack_n_packet_counter = 1;
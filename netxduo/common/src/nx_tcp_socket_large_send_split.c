@@ -0,0 +1,295 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_ip.h"
+#include "nx_packet.h"
+#include "nx_tcp.h"
+
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_socket_large_send_split                     PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function replaces the super-segments on the transmit queue of  */
+/*    the socket with the segments they were sent as.  Retransmission,    */
+/*    SACK and the congestion window all work on whole packets, so a lost */
+/*    segment must not resend the whole super-segment.  Only packets the  */
+/*    driver is done with are split.  A super-segment is kept if there    */
+/*    are not enough packets for its segments.                            */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to owning socket      */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    _nx_packet_allocate                   Allocate packet for segment   */
+/*    _nx_packet_data_append                Copy segment payload          */
+/*    _nx_packet_release                    Release packet                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_retransmit             Retransmit packet             */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_tcp_socket_large_send_split(NX_TCP_SOCKET *socket_ptr)
+{
+
+UINT            status;
+ULONG           temp;
+ULONG           header_length;
+ULONG           sequence_number;
+ULONG           segment_size;
+ULONG           segment_count;
+ULONG           segment_offset;
+ULONG           remaining_bytes;
+ULONG           copy_remaining_size;
+ULONG           copy_size;
+UCHAR          *source_ptr;
+NX_PACKET      *packet_ptr;
+NX_PACKET      *previous_ptr;
+NX_PACKET      *next_ptr;
+NX_PACKET      *source_packet;
+NX_PACKET      *segment_packet;
+NX_PACKET      *segment_head;
+NX_PACKET      *segment_tail;
+NX_PACKET_POOL *pool_ptr;
+NX_TCP_HEADER  *header_ptr;
+NX_TCP_HEADER  *segment_header_ptr;
+
+    /* Segments are taken from the default packet pool, like IP fragments.  */
+    pool_ptr =  socket_ptr -> nx_tcp_socket_ip_ptr -> nx_ip_default_packet_pool;
+
+    /* Loop through the packets on the transmit queue the driver is done with.  */
+    previous_ptr =  NX_NULL;
+    packet_ptr =  socket_ptr -> nx_tcp_socket_transmit_sent_head;
+    /*lint -e{923} suppress cast of ULONG to pointer.  */
+    while (packet_ptr && (packet_ptr -> nx_packet_queue_next == (NX_PACKET *)NX_DRIVER_TX_DONE))
+    {
+
+        /* Pickup the next packet.  */
+        next_ptr =  packet_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next;
+
+        /* Determine if this is a super-segment.  */
+        if (packet_ptr -> nx_packet_tcp_segment_size)
+        {
+
+            /* Pickup the TCP header, the IP header has been removed by the driver.  */
+            /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+            header_ptr =  (NX_TCP_HEADER *)packet_ptr -> nx_packet_prepend_ptr;
+            temp =  header_ptr -> nx_tcp_header_word_3;
+            NX_CHANGE_ULONG_ENDIAN(temp);
+            header_length =  (temp >> NX_TCP_HEADER_SHIFT) * (ULONG)sizeof(ULONG);
+            sequence_number =  header_ptr -> nx_tcp_sequence_number;
+            NX_CHANGE_ULONG_ENDIAN(sequence_number);
+
+            /* Pickup the payload.  */
+            segment_size =  packet_ptr -> nx_packet_tcp_segment_size;
+            remaining_bytes =  packet_ptr -> nx_packet_length - header_length;
+            source_packet =  packet_ptr;
+            source_ptr =  packet_ptr -> nx_packet_prepend_ptr + header_length;
+
+            segment_head =  NX_NULL;
+            segment_tail =  NX_NULL;
+            segment_count =  0;
+            segment_offset =  0;
+            status =  NX_SUCCESS;
+
+            /* Loop to copy the payload into segments.  */
+            while (remaining_bytes)
+            {
+
+                /* Allocate a packet with room for the headers.  */
+                status =  _nx_packet_allocate(pool_ptr, &segment_packet,
+                                              NX_PHYSICAL_HEADER + sizeof(NX_IPV4_HEADER) + header_length, NX_NO_WAIT);
+                if (status)
+                {
+                    break;
+                }
+
+                /* Link the segment behind the previous one.  */
+                /*lint -e{644} suppress variable might not be initialized, since "segment_packet" was initialized in _nx_packet_allocate. */
+                if (segment_tail)
+                {
+                    segment_tail -> nx_packet_union_next.nx_packet_tcp_queue_next =  segment_packet;
+                }
+                else
+                {
+                    segment_head =  segment_packet;
+                }
+                segment_tail =  segment_packet;
+                segment_count++;
+
+                /* Calculate the payload size of this segment.  */
+                if (remaining_bytes > segment_size)
+                {
+                    copy_remaining_size =  segment_size;
+                }
+                else
+                {
+                    copy_remaining_size =  remaining_bytes;
+                }
+                remaining_bytes -=  copy_remaining_size;
+
+                /* Copy the payload.  */
+                while (copy_remaining_size)
+                {
+
+                    /* Move past the exhausted buffers of the super-segment.  */
+                    while ((source_ptr == source_packet -> nx_packet_append_ptr) && (source_packet -> nx_packet_next))
+                    {
+                        source_packet =  source_packet -> nx_packet_next;
+                        source_ptr =  source_packet -> nx_packet_prepend_ptr;
+                    }
+
+                    /*lint -e{946} -e{947} suppress pointer subtraction, since it is necessary. */
+                    copy_size =  (ULONG)(source_packet -> nx_packet_append_ptr - source_ptr);
+                    if (copy_size == 0)
+                    {
+
+                        /* The super-segment is shorter than its length.  */
+                        status =  NX_INVALID_PACKET;
+                        break;
+                    }
+
+                    if (copy_size > copy_remaining_size)
+                    {
+                        copy_size =  copy_remaining_size;
+                    }
+
+                    status =  _nx_packet_data_append(segment_packet, source_ptr, copy_size, pool_ptr, NX_NO_WAIT);
+                    if (status)
+                    {
+                        break;
+                    }
+
+                    source_ptr +=  copy_size;
+                    copy_remaining_size -=  copy_size;
+                }
+
+                if (status)
+                {
+                    break;
+                }
+
+                /* Copy the TCP header and set the sequence number of this segment.  */
+                segment_packet -> nx_packet_prepend_ptr =  segment_packet -> nx_packet_prepend_ptr - header_length;
+                segment_packet -> nx_packet_length =  segment_packet -> nx_packet_length + header_length;
+                memcpy(segment_packet -> nx_packet_prepend_ptr, header_ptr, header_length); /* Use case of memcpy is verified. */
+
+                /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+                segment_header_ptr =  (NX_TCP_HEADER *)segment_packet -> nx_packet_prepend_ptr;
+                segment_header_ptr -> nx_tcp_sequence_number =  sequence_number + segment_offset;
+                NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_tcp_sequence_number);
+
+                /* Only the last segment pushes.  */
+                if (remaining_bytes)
+                {
+                    NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_tcp_header_word_3);
+                    segment_header_ptr -> nx_tcp_header_word_3 &=  ~NX_TCP_PSH_BIT;
+                    NX_CHANGE_ULONG_ENDIAN(segment_header_ptr -> nx_tcp_header_word_3);
+                }
+
+                /* The segment has been sent as part of the super-segment.  */
+                segment_packet -> nx_packet_ip_version =  packet_ptr -> nx_packet_ip_version;
+                segment_packet -> nx_packet_address =  packet_ptr -> nx_packet_address;
+                /*lint -e{923} suppress cast of ULONG to pointer.  */
+                segment_packet -> nx_packet_queue_next =  (NX_PACKET *)NX_DRIVER_TX_DONE;
+
+                segment_offset +=  segment_packet -> nx_packet_length - header_length;
+            }
+
+            if (status)
+            {
+
+                /* Not enough packets, release the segments and keep the super-segment.  */
+                while (segment_head)
+                {
+                    segment_packet =  segment_head;
+                    segment_head =  (segment_packet == segment_tail) ? NX_NULL :
+                                    segment_packet -> nx_packet_union_next.nx_packet_tcp_queue_next;
+
+                    /*lint -e{923} suppress cast of ULONG to pointer.  */
+                    segment_packet -> nx_packet_union_next.nx_packet_tcp_queue_next =  (NX_PACKET *)NX_PACKET_ALLOCATED;
+                    segment_packet -> nx_packet_queue_next =  NX_NULL;
+                    _nx_packet_release(segment_packet);
+                }
+                return;
+            }
+
+            /* Put the segments in place of the super-segment.  */
+            /*lint -e{613} suppress possible use of null pointer, since the super-segment has payload. */
+            segment_tail -> nx_packet_union_next.nx_packet_tcp_queue_next =  next_ptr;
+            if (previous_ptr)
+            {
+                previous_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next =  segment_head;
+            }
+            else
+            {
+                socket_ptr -> nx_tcp_socket_transmit_sent_head =  segment_head;
+            }
+
+            if (socket_ptr -> nx_tcp_socket_transmit_sent_tail == packet_ptr)
+            {
+                socket_ptr -> nx_tcp_socket_transmit_sent_tail =  segment_tail;
+            }
+
+            socket_ptr -> nx_tcp_socket_transmit_sent_count +=  segment_count - 1;
+
+            /* Release the super-segment.  */
+            /*lint -e{923} suppress cast of ULONG to pointer.  */
+            packet_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next =  (NX_PACKET *)NX_PACKET_ALLOCATED;
+            _nx_packet_release(packet_ptr);
+
+            packet_ptr =  segment_tail;
+        }
+
+        /* Determine if we are at the end of the TCP queue.  */
+        /*lint -e{923} suppress cast of ULONG to pointer.  */
+        if (next_ptr == (NX_PACKET *)NX_PACKET_ENQUEUED)
+        {
+            break;
+        }
+
+        /* Move to the next packet.  */
+        previous_ptr =  packet_ptr;
+        packet_ptr =  next_ptr;
+    }
+}
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
@@ -0,0 +1,178 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Transmission Control Protocol (TCP)                                 */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define NX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_packet.h"
+#include "nx_tcp.h"
+
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_tcp_socket_large_send_trim                      PORTABLE C      */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function removes the acknowledged front of a super-segment     */
+/*    that an ACK covers only in part, so the head of the transmit queue  */
+/*    always starts at the oldest unacknowledged byte.  The payload left  */
+/*    in the first buffer is moved up behind the TCP header, exhausted    */
+/*    buffers of the chain are released.  The transmit timeout restarts   */
+/*    since new data has been acknowledged.                               */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    socket_ptr                            Pointer to owning socket      */
+/*    packet_ptr                            Oldest packet not fully ACKed */
+/*    acknowledgment_number                 ACK number in host order      */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    trim_bytes                            Number of bytes removed       */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    _nx_packet_release                    Release packet                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _nx_tcp_socket_state_ack_check        Process ACK number            */
+/*                                                                        */
+/**************************************************************************/
+ULONG  _nx_tcp_socket_large_send_trim(NX_TCP_SOCKET *socket_ptr, NX_PACKET *packet_ptr, ULONG acknowledgment_number)
+{
+
+ULONG          temp;
+ULONG          header_length;
+ULONG          sequence_number;
+ULONG          trim_bytes;
+ULONG          remaining_bytes;
+ULONG          buffer_size;
+UCHAR         *payload_ptr;
+NX_PACKET     *buffer_ptr;
+NX_TCP_HEADER *header_ptr;
+
+    /* Only a super-segment the driver is done with can be trimmed.  */
+    /*lint -e{923} suppress cast of ULONG to pointer.  */
+    if ((packet_ptr == NX_NULL) || (packet_ptr -> nx_packet_tcp_segment_size == 0) ||
+        (packet_ptr -> nx_packet_queue_next != (NX_PACKET *)NX_DRIVER_TX_DONE))
+    {
+        return(0);
+    }
+
+    /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+    header_ptr =  (NX_TCP_HEADER *)packet_ptr -> nx_packet_prepend_ptr;
+    temp =  header_ptr -> nx_tcp_header_word_3;
+    NX_CHANGE_ULONG_ENDIAN(temp);
+    header_length =  (temp >> NX_TCP_HEADER_SHIFT) * (ULONG)sizeof(ULONG);
+    sequence_number =  header_ptr -> nx_tcp_sequence_number;
+    NX_CHANGE_ULONG_ENDIAN(sequence_number);
+
+    /* Determine if the ACK falls inside the payload.  */
+    trim_bytes =  acknowledgment_number - sequence_number;
+    if (((INT)trim_bytes <= 0) || (trim_bytes >= packet_ptr -> nx_packet_length - header_length))
+    {
+        return(0);
+    }
+
+    /* Remove the acknowledged payload from the first buffer.  */
+    payload_ptr =  packet_ptr -> nx_packet_prepend_ptr + header_length;
+    /*lint -e{946} -e{947} suppress pointer subtraction, since it is necessary. */
+    buffer_size =  (ULONG)(packet_ptr -> nx_packet_append_ptr - payload_ptr);
+    if (trim_bytes < buffer_size)
+    {
+
+        /* Keep the TCP header where it is, it must stay aligned.  */
+        memmove(payload_ptr, payload_ptr + trim_bytes, buffer_size - trim_bytes); /* Use case of memmove is verified. */
+        packet_ptr -> nx_packet_append_ptr -=  trim_bytes;
+        remaining_bytes =  0;
+    }
+    else
+    {
+        packet_ptr -> nx_packet_append_ptr =  payload_ptr;
+        remaining_bytes =  trim_bytes - buffer_size;
+    }
+
+    /* Remove the rest from the buffers of the chain.  */
+    while (remaining_bytes)
+    {
+
+        /* The ACK is inside the payload, so the chain is not exhausted.  */
+        buffer_ptr =  packet_ptr -> nx_packet_next;
+        NX_ASSERT(buffer_ptr != NX_NULL);
+
+        /*lint -e{946} -e{947} suppress pointer subtraction, since it is necessary. */
+        buffer_size =  (ULONG)(buffer_ptr -> nx_packet_append_ptr - buffer_ptr -> nx_packet_prepend_ptr);
+        if (remaining_bytes < buffer_size)
+        {
+            buffer_ptr -> nx_packet_prepend_ptr +=  remaining_bytes;
+            break;
+        }
+
+        /* This buffer is acknowledged as a whole, unlink and release it.  */
+        packet_ptr -> nx_packet_next =  buffer_ptr -> nx_packet_next;
+        if (packet_ptr -> nx_packet_last == buffer_ptr)
+        {
+            packet_ptr -> nx_packet_last =  NX_NULL;
+        }
+        buffer_ptr -> nx_packet_next =  NX_NULL;
+        remaining_bytes -=  buffer_size;
+        _nx_packet_release(buffer_ptr);
+    }
+
+    /* Update the length and the sequence number.  */
+    packet_ptr -> nx_packet_length -=  trim_bytes;
+    header_ptr -> nx_tcp_sequence_number =  acknowledgment_number;
+    NX_CHANGE_ULONG_ENDIAN(header_ptr -> nx_tcp_sequence_number);
+
+    /* A super-segment of at most one segment is a plain segment.  */
+    if (packet_ptr -> nx_packet_length - header_length <= packet_ptr -> nx_packet_tcp_segment_size)
+    {
+        packet_ptr -> nx_packet_tcp_segment_size =  0;
+    }
+
+    /* The acknowledged bytes are no longer outstanding.  */
+    if (socket_ptr -> nx_tcp_socket_tx_outstanding_bytes > trim_bytes)
+    {
+        socket_ptr -> nx_tcp_socket_tx_outstanding_bytes -=  trim_bytes;
+    }
+    else
+    {
+        socket_ptr -> nx_tcp_socket_tx_outstanding_bytes =  0;
+    }
+
+    /* Setup a new transmit timeout.  */
+    socket_ptr -> nx_tcp_socket_timeout =          socket_ptr -> nx_tcp_socket_timeout_rate;
+    socket_ptr -> nx_tcp_socket_timeout_retries =  0;
+
+    return(trim_bytes);
+}
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
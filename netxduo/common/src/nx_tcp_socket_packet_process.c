@@ -61,6 +61,7 @@
 /*  CALLS                                                                 */
 /*                                                                        */
 /*    _nx_packet_release                    Packet release function       */
+/*    _nx_tcp_sack_scoreboard_update        Record peer SACK blocks       */
 /*    _nx_tcp_socket_connection_reset       Reset connection              */
 /*    _nx_tcp_socket_state_ack_check        Process received ACKs         */
 /*    _nx_tcp_socket_state_closing          Process CLOSING state         */
@@ -286,6 +287,19 @@ ULONG         tcpip_offload;
         if (socket_ptr -> nx_tcp_socket_state != NX_TCP_SYN_RECEIVED)
         {
 
+#ifdef NX_ENABLE_TCP_SACK
+            /* Update the scoreboard first, so that a retransmission triggered by this ACK
+               can skip the data the peer already holds.  */
+            if ((socket_ptr -> nx_tcp_socket_sack_permitted) &&
+                (tcp_header_copy.nx_tcp_header_word_3 & NX_TCP_ACK_BIT) &&
+                ((socket_ptr -> nx_tcp_socket_sack_count) || (header_length > sizeof(NX_TCP_HEADER))))
+            {
+                _nx_tcp_sack_scoreboard_update(socket_ptr, packet_ptr -> nx_packet_prepend_ptr + sizeof(NX_TCP_HEADER),
+                                               header_length - (ULONG)sizeof(NX_TCP_HEADER),
+                                               tcp_header_copy.nx_tcp_acknowledgment_number);
+            }
+#endif /* NX_ENABLE_TCP_SACK */
+
             /* Check the ACK field.  */
             if (_nx_tcp_socket_state_ack_check(socket_ptr, &tcp_header_copy) == NX_FALSE)
             {
@@ -63,9 +63,12 @@
 /*  CALLS                                                                 */
 /*                                                                        */
 /*    _nx_tcp_packet_send_probe             Send zero window probe        */
+/*    _nx_tcp_socket_large_send_split       Split super-segments          */
 /*    _nx_ip_checksum_compute               Calculate TCP checksum        */
 /*    _nx_ip_packet_send                    Resend the transmit packet    */
 /*    _nx_ipv6_packet_send                  Resend the transmit packet    */
+/*    (nx_tcp_congestion_control_on_loss)   Set slow start threshold      */
+/*    (nx_tcp_congestion_control_on_rto)    Set slow start threshold      */
 /*                                                                        */
 /*  CALLED BY                                                             */
 /*                                                                        */
@@ -84,12 +87,22 @@
 VOID  _nx_tcp_socket_retransmit(NX_IP *ip_ptr, NX_TCP_SOCKET *socket_ptr, UINT need_fast_retransmit)
 {
 NX_PACKET *packet_ptr;
-ULONG      window;
 ULONG      original_acknowledgment_number;
 ULONG      original_header_word_3;
 ULONG      original_header_word_4;
 ULONG      available;
 ULONG      window_size;
+#ifdef NX_ENABLE_TCP_SACK
+ULONG      sequence;
+ULONG      sack_high;
+UINT       i;
+#endif /* NX_ENABLE_TCP_SACK */
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+    /* Retransmission works on whole packets, cut the super-segments back into segments.  */
+    _nx_tcp_socket_large_send_split(socket_ptr);
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
 
     /* If the receiver winodw is zero, we enter the zero window probe phase
        RFC 793 Sec 3.7, p42: keep send new data.
@@ -154,41 +167,63 @@ ULONG      window_size;
         socket_ptr -> nx_tcp_socket_zero_window_probe_has_data = NX_FALSE;
     }
 
+#ifdef NX_ENABLE_TCP_SACK
+    /* Filling a hole reported by SACK during fast recovery is driven by the ACK clock
+       rather than a timeout, so it is not counted as a retry.  */
+    if ((need_fast_retransmit == NX_TRUE) || (socket_ptr -> nx_tcp_socket_fast_recovery == NX_FALSE) ||
+        (socket_ptr -> nx_tcp_socket_sack_count == 0))
+    {
+        socket_ptr -> nx_tcp_socket_timeout_retries++;
+    }
+#else
     /* Increment the retry counter only if the receiver window is open. */
     /* Increment the retry counter.  */
     socket_ptr -> nx_tcp_socket_timeout_retries++;
+#endif /* NX_ENABLE_TCP_SACK */
+
+    /* A retransmitted segment gives no valid round trip time sample. Section 3, RFC6298.  */
+    socket_ptr -> nx_tcp_socket_rtt_timing = NX_FALSE;
 
     if ((need_fast_retransmit == NX_TRUE) || (socket_ptr -> nx_tcp_socket_fast_recovery == NX_FALSE))
     {
 
-        /* Timed out on an outgoing packet.  Enter slow start mode. */
-        /* Compute the flight size / 2 value. */
-        window = socket_ptr -> nx_tcp_socket_tx_outstanding_bytes >> 1;
-
-        /* Make sure we have at least 2 * MSS */
-        if (window < (socket_ptr -> nx_tcp_socket_connect_mss << 1))
+        /* Determine if this socket needs fast retransmit.  */
+        if (need_fast_retransmit == NX_TRUE)
         {
-            window = socket_ptr -> nx_tcp_socket_connect_mss << 1;
-        }
 
-        /* Set the slow_start_threshold */
-        socket_ptr -> nx_tcp_socket_tx_slow_start_threshold = window;
+            /* The window is reduced once per recovery. A fast retransmit inside the
+               recovery only resends the packet. Section 3.2, RFC6582.  */
+            if (socket_ptr -> nx_tcp_socket_fast_recovery == NX_FALSE)
+            {
 
-        /* Set the current window to be MSS size. */
-        socket_ptr -> nx_tcp_socket_tx_window_congestion = socket_ptr -> nx_tcp_socket_connect_mss;
+                /* Let the congestion control algorithm set the slow start threshold.  */
+                socket_ptr -> nx_tcp_socket_congestion_control -> nx_tcp_congestion_control_on_loss(socket_ptr);
 
-        /* Determine if this socket needs fast retransmit.  */
-        if (need_fast_retransmit == NX_TRUE)
-        {
+                /* Update cwnd to ssthreshold plus 3 * MSS.  */
+                socket_ptr -> nx_tcp_socket_tx_window_congestion = socket_ptr -> nx_tcp_socket_tx_slow_start_threshold +
+                    (socket_ptr -> nx_tcp_socket_connect_mss * 3);
+
+                /* Now TCP is in fast recovery procedure. */
+                socket_ptr -> nx_tcp_socket_fast_recovery = NX_TRUE;
+
+                /* Update the transmit sequence that enters fast transmit. */
+                socket_ptr -> nx_tcp_socket_tx_sequence_recover = socket_ptr -> nx_tcp_socket_tx_sequence - 1;
 
-            /* Update cwnd to ssthreshold plus 3 * MSS.  */
-            socket_ptr -> nx_tcp_socket_tx_window_congestion += window + (socket_ptr -> nx_tcp_socket_connect_mss << 1);
+#ifdef NX_ENABLE_TCP_SACK
+                /* Nothing has been retransmitted in this recovery yet.  */
+                socket_ptr -> nx_tcp_socket_sack_high_retransmit = socket_ptr -> nx_tcp_socket_tx_sequence -
+                    socket_ptr -> nx_tcp_socket_tx_outstanding_bytes;
+#endif /* NX_ENABLE_TCP_SACK */
+            }
+        }
+        else
+        {
 
-            /* Now TCP is in fast recovery procedure. */
-            socket_ptr -> nx_tcp_socket_fast_recovery = NX_TRUE;
+            /* Timed out on an outgoing packet.  Enter slow start mode. */
+            socket_ptr -> nx_tcp_socket_congestion_control -> nx_tcp_congestion_control_on_rto(socket_ptr);
 
-            /* Update the transmit sequence that enters fast transmit. */
-            socket_ptr -> nx_tcp_socket_tx_sequence_recover = socket_ptr -> nx_tcp_socket_tx_sequence - 1;
+            /* Set the current window to be MSS size. */
+            socket_ptr -> nx_tcp_socket_tx_window_congestion = socket_ptr -> nx_tcp_socket_connect_mss;
         }
     }
 
@@ -202,6 +237,84 @@ ULONG      window_size;
     /* Pickup the head of the transmit queue.  */
     packet_ptr =  socket_ptr -> nx_tcp_socket_transmit_sent_head;
 
+#ifdef NX_ENABLE_TCP_SACK
+    /* In fast recovery with a SACK capable peer, retransmit the first hole.  */
+    if ((socket_ptr -> nx_tcp_socket_fast_recovery == NX_TRUE) && (socket_ptr -> nx_tcp_socket_sack_permitted))
+    {
+
+        /* Find the start of the highest range the peer holds. Only the data below it
+           is known to be missing, the rest may still be in flight.  */
+        sack_high = socket_ptr -> nx_tcp_socket_sack_high_retransmit;
+        for (i = 0; i < socket_ptr -> nx_tcp_socket_sack_count; i++)
+        {
+            if ((INT)(socket_ptr -> nx_tcp_socket_sack_begin[i] - sack_high) > 0)
+            {
+                sack_high = socket_ptr -> nx_tcp_socket_sack_begin[i];
+            }
+        }
+
+        /* Nothing is known about the data from the ranges the scoreboard gave up.  */
+        if ((socket_ptr -> nx_tcp_socket_sack_unknown_begin != socket_ptr -> nx_tcp_socket_sack_unknown_end) &&
+            ((INT)(socket_ptr -> nx_tcp_socket_sack_unknown_begin - sack_high) < 0))
+        {
+            sack_high = socket_ptr -> nx_tcp_socket_sack_unknown_begin;
+        }
+
+        /* Skip the packets already retransmitted in this recovery or held by the peer.  */
+        /*lint -e{923} suppress cast of ULONG to pointer.  */
+        while (packet_ptr && (packet_ptr -> nx_packet_queue_next == (NX_PACKET *)NX_DRIVER_TX_DONE))
+        {
+
+            /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+            sequence = ((NX_TCP_HEADER *)packet_ptr -> nx_packet_prepend_ptr) -> nx_tcp_sequence_number;
+            NX_CHANGE_ULONG_ENDIAN(sequence);
+
+            /* Stop at the highest range the peer holds. With an empty scoreboard only
+               the head can be known to be missing, and the cumulative ACK always
+               reports the head as missing.  */
+            if (((socket_ptr -> nx_tcp_socket_sack_count) ||
+                 (socket_ptr -> nx_tcp_socket_sack_unknown_begin != socket_ptr -> nx_tcp_socket_sack_unknown_end)) &&
+                ((INT)(sequence - sack_high) >= 0) &&
+                (packet_ptr != socket_ptr -> nx_tcp_socket_transmit_sent_head))
+            {
+                packet_ptr = NX_NULL;
+                break;
+            }
+
+            if ((INT)(sequence - socket_ptr -> nx_tcp_socket_sack_high_retransmit) >= 0)
+            {
+                for (i = 0; i < socket_ptr -> nx_tcp_socket_sack_count; i++)
+                {
+                    if (((INT)(sequence - socket_ptr -> nx_tcp_socket_sack_begin[i]) >= 0) &&
+                        ((INT)(socket_ptr -> nx_tcp_socket_sack_end[i] -
+                               (sequence + packet_ptr -> nx_packet_length - (ULONG)sizeof(NX_TCP_HEADER))) >= 0))
+                    {
+                        break;
+                    }
+                }
+
+                if (i == socket_ptr -> nx_tcp_socket_sack_count)
+                {
+
+                    /* This is a hole, retransmit it.  */
+                    socket_ptr -> nx_tcp_socket_sack_high_retransmit = sequence + packet_ptr -> nx_packet_length -
+                        (ULONG)sizeof(NX_TCP_HEADER);
+                    break;
+                }
+            }
+
+            /*lint -e{923} suppress cast of ULONG to pointer.  */
+            if (packet_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next == (NX_PACKET *)NX_PACKET_ENQUEUED)
+            {
+                packet_ptr = NX_NULL;
+                break;
+            }
+
+            packet_ptr = packet_ptr -> nx_packet_union_next.nx_packet_tcp_queue_next;
+        }
+    }
+#endif /* NX_ENABLE_TCP_SACK */
+
     /* Determine if the packet has been released by the
        application I/O driver.  */
     /*lint -e{923} suppress cast of ULONG to pointer.  */
@@ -234,6 +234,7 @@ NX_TCP_HEADER  *header_ptr;
 /*    _nx_tcp_socket_thread_suspend         Suspend calling thread        */
 /*    tx_mutex_get                          Get protection mutex          */
 /*    tx_mutex_put                          Put protection mutex          */
+/*    tx_time_get                           Get system time               */
 /*    _nx_tcp_socket_driver_send            TCP/IP offload send function  */
 /*                                                                        */
 /*  CALLED BY                                                             */
@@ -292,6 +293,9 @@ UCHAR           preempted = NX_FALSE;
 UCHAR           adjust_packet;
 UINT            old_threshold = 0;
 ULONG           window_size;
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+ULONG           large_send_size;
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
 #ifdef NX_ENABLE_TCPIP_OFFLOAD
 UINT            status;
 NX_INTERFACE   *interface_ptr;
@@ -476,6 +480,31 @@ UINT            compute_checksum = 1;
             tx_window_current = 0;
         }
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+        /* An IPv4 packet larger than the MSS is sent as one super-segment of whole segments,
+           up to NX_TCP_LARGE_SEND_SIZE bytes. It is cut into segments on its way out.  */
+        if ((socket_ptr -> nx_tcp_socket_connect_ip.nxd_ip_version == NX_IP_VERSION_V4) &&
+            (packet_ptr -> nx_packet_length > send_mss) && (tx_window_current > send_mss))
+        {
+
+            /* The payload must fit in one IP packet.  */
+            large_send_size = NX_TCP_LARGE_SEND_SIZE;
+            if (large_send_size > NX_LOWER_16_MASK - sizeof(NX_IPV4_HEADER) - sizeof(NX_TCP_HEADER))
+            {
+                large_send_size = NX_LOWER_16_MASK - sizeof(NX_IPV4_HEADER) - sizeof(NX_TCP_HEADER);
+            }
+
+            /* Pick up the min(tx_window, large_send_size), in whole segments. */
+            if (tx_window_current > large_send_size)
+            {
+                tx_window_current = large_send_size;
+            }
+            tx_window_current -= tx_window_current % send_mss;
+        }
+        else
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
         /* Pick up the min(tx_window, send_mss). */
         if (tx_window_current > send_mss)
         {
@@ -791,6 +820,15 @@ UINT            compute_checksum = 1;
             }
 #endif /* NX_IPSEC_ENABLE */
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+            if (send_packet -> nx_packet_length - sizeof(NX_TCP_HEADER) > send_mss)
+            {
+
+                /* The checksum of a super-segment is computed for each segment it is cut into.  */
+                send_packet -> nx_packet_interface_capability_flag |= NX_INTERFACE_CAPABILITY_TCP_TX_CHECKSUM;
+            }
+            else
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
 #if defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) || defined(NX_IPSEC_ENABLE)
             if (compute_checksum)
 #endif /* defined(NX_DISABLE_TCP_TX_CHECKSUM) || defined(NX_ENABLE_INTERFACE_CAPABILITY) || defined(NX_IPSEC_ENABLE) */
@@ -868,6 +906,14 @@ UINT            compute_checksum = 1;
             /* Restore interrupts.  */
             TX_RESTORE
 
+            /* Time this segment if no other one is being timed.  */
+            if (!socket_ptr -> nx_tcp_socket_rtt_timing)
+            {
+                socket_ptr -> nx_tcp_socket_rtt_timing = NX_TRUE;
+                socket_ptr -> nx_tcp_socket_rtt_sequence = socket_ptr -> nx_tcp_socket_tx_sequence;
+                socket_ptr -> nx_tcp_socket_rtt_time = tx_time_get();
+            }
+
             /* Reset zero window probe flag. */
             socket_ptr -> nx_tcp_socket_zero_window_probe_has_data = NX_FALSE;
 
@@ -876,6 +922,19 @@ UINT            compute_checksum = 1;
             header_ptr -> nx_tcp_header_word_4 =  (checksum << NX_SHIFT_BY_16);
             NX_CHANGE_ULONG_ENDIAN(header_ptr -> nx_tcp_header_word_4);
 
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+            /* Mark a super-segment with the size of the segments it is cut into.  */
+            if (send_packet -> nx_packet_length - sizeof(NX_TCP_HEADER) > send_mss)
+            {
+                send_packet -> nx_packet_tcp_segment_size = send_mss;
+            }
+            else
+            {
+                send_packet -> nx_packet_tcp_segment_size = 0;
+            }
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
             /* Place the packet on the sent list.  */
             data_left -= (send_packet -> nx_packet_length - (ULONG)sizeof(NX_TCP_HEADER));
             if (socket_ptr -> nx_tcp_socket_transmit_sent_head)
@@ -67,6 +67,9 @@
 /*    _nx_tcp_packet_send_ack               Send ACK message              */
 /*    _nx_packet_release                    Packet release function       */
 /*    _nx_tcp_socket_retransmit             Retransmit packet             */
+/*    _nx_tcp_socket_large_send_trim        Trim partly ACKed packet      */
+/*    tx_time_get                           Get system time               */
+/*    (nx_tcp_congestion_control_on_ack)    Grow congestion window        */
 /*                                                                        */
 /*  CALLED BY                                                             */
 /*                                                                        */
@@ -112,7 +115,11 @@ ULONG          starting_tx_sequence;
 ULONG          ending_tx_sequence;
 ULONG          ending_rx_sequence;
 ULONG          acked_bytes;
+ULONG          rtt;
 ULONG          tcp_payload_length;
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+ULONG          trimmed_bytes =  0;
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
 UINT           wrapped_flag = NX_FALSE;
 
 
@@ -278,7 +285,22 @@ UINT           wrapped_flag = NX_FALSE;
 
                         /* CWND += MSS  */
                         socket_ptr -> nx_tcp_socket_tx_window_congestion += socket_ptr -> nx_tcp_socket_connect_mss;
+
+#ifdef NX_ENABLE_TCP_SACK
+                        /* The SACK blocks tell which data is still missing, so fill the
+                           next hole now instead of waiting for a partial ACK.  */
+                        if (socket_ptr -> nx_tcp_socket_sack_count)
+                        {
+                            _nx_tcp_socket_retransmit(socket_ptr -> nx_tcp_socket_ip_ptr, socket_ptr, NX_FALSE);
+                        }
+#endif /* NX_ENABLE_TCP_SACK */
                     }
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+                    /* The retransmission may have split the super-segment at the head.  */
+                    search_ptr =  socket_ptr -> nx_tcp_socket_transmit_sent_head;
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
                 }
 
                 /* Determine if the transmit queue has wrapped.  */
@@ -427,10 +449,20 @@ UINT           wrapped_flag = NX_FALSE;
                     search_ptr =  NX_NULL;
                 }
             }
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+
+            /* The ACK may end inside a super-segment, trim the acknowledged part.  */
+            trimmed_bytes =  _nx_tcp_socket_large_send_trim(socket_ptr, search_ptr, tcp_header_ptr -> nx_tcp_acknowledgment_number);
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
         }
 
         /* Determine if anything needs to be released.  */
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+        if ((!packet_release_count) && (!trimmed_bytes))
+#else
         if (!packet_release_count)
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
         {
 
             /* No, check and see if the ACK is valid.  */
@@ -460,6 +492,25 @@ UINT           wrapped_flag = NX_FALSE;
         else
         {
 
+            /* Take the round trip time sample once the timed segment is acknowledged.  */
+            if ((socket_ptr -> nx_tcp_socket_rtt_timing) &&
+                ((INT)(tcp_header_ptr -> nx_tcp_acknowledgment_number - socket_ptr -> nx_tcp_socket_rtt_sequence) >= 0))
+            {
+                socket_ptr -> nx_tcp_socket_rtt_timing = NX_FALSE;
+                rtt = tx_time_get() - socket_ptr -> nx_tcp_socket_rtt_time;
+
+                /* SRTT = 7/8 SRTT + 1/8 R, kept scaled by 8. Section 2, RFC6298.
+                   A sample below one tick still counts, zero is reserved for no sample.  */
+                if (socket_ptr -> nx_tcp_socket_rtt_smoothed == 0)
+                {
+                    socket_ptr -> nx_tcp_socket_rtt_smoothed = (rtt << 3) + 1;
+                }
+                else
+                {
+                    socket_ptr -> nx_tcp_socket_rtt_smoothed += rtt - (socket_ptr -> nx_tcp_socket_rtt_smoothed >> 3);
+                }
+            }
+
             /* Congestion window adjustment during slow start and congestion avoidance is executed
                on every incoming ACK that acknowledges new data. RFC5681, Section3.1, Page4-8.  */
 
@@ -509,42 +560,8 @@ UINT           wrapped_flag = NX_FALSE;
             else
             {
 
-                /* Adjust the transmit window.  In slow start phase, the transmit window is incremented for every ACK.
-                   In Congestion Avoidance phase, the window is incremented for every RTT. Section 3.1, Page 4-7, RFC5681.  */
-                if (socket_ptr -> nx_tcp_socket_tx_window_congestion >= socket_ptr -> nx_tcp_socket_tx_slow_start_threshold)
-                {
-
-                    /* In Congestion avoidance phase, for every ACK it receives, increase the window size using the
-                       following approximation:
-                       cwnd = cwnd + MSS * MSS / cwnd;  */
-                    temp = socket_ptr -> nx_tcp_socket_connect_mss2 / socket_ptr -> nx_tcp_socket_tx_window_congestion;
-
-                    /* If the above formula yields 0, the result SHOULD be rounded up to 1 byte.  */
-                    if (temp == 0)
-                    {
-                        temp = 1;
-                    }
-                    socket_ptr -> nx_tcp_socket_tx_window_congestion = socket_ptr -> nx_tcp_socket_tx_window_congestion + temp;
-                }
-                else
-                {
-
-                    /* In Slow start phase:
-                       cwnd += min (N, SMSS),
-                       where N is the number of ACKed bytes. */
-                    if (acked_bytes < socket_ptr -> nx_tcp_socket_connect_mss)
-                    {
-
-                        /* In Slow start phase. Increase the cwnd by acked bytes.*/
-                        socket_ptr -> nx_tcp_socket_tx_window_congestion += acked_bytes;
-                    }
-                    else
-                    {
-
-                        /* In Slow start phase. Increase the cwnd by full MSS for every ack.*/
-                        socket_ptr -> nx_tcp_socket_tx_window_congestion += socket_ptr -> nx_tcp_socket_connect_mss;
-                    }
-                }
+                /* Grow the window by slow start or congestion avoidance. Section 3.1, Page 4-7, RFC5681.  */
+                socket_ptr -> nx_tcp_socket_congestion_control -> nx_tcp_congestion_control_on_ack(socket_ptr, acked_bytes);
             }
         }
 
@@ -579,6 +596,16 @@ UINT           wrapped_flag = NX_FALSE;
 
         if (!packet_release_count)
         {
+
+#ifdef NX_ENABLE_TCP_LARGE_SEND
+            if ((trimmed_bytes) && (socket_ptr -> nx_tcp_socket_fast_recovery == NX_TRUE))
+            {
+
+                /* Only partial data are ACKed. Retransmit packet immediately. */
+                _nx_tcp_socket_retransmit(socket_ptr -> nx_tcp_socket_ip_ptr, socket_ptr, NX_FALSE);
+            }
+#endif /* NX_ENABLE_TCP_LARGE_SEND */
+
             /* Done, return to caller. */
             return(NX_TRUE);
         }
@@ -358,6 +358,9 @@ ULONG          trim_data_length;
 TX_THREAD     *thread_ptr;
 ULONG          acked_packets = 0;
 UINT           need_ack = NX_FALSE;
+#ifdef NX_ENABLE_TCP_RECEIVE_COALESCING
+ULONG          duplicate_acks;
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
 #ifdef NX_ENABLE_TCPIP_OFFLOAD
 ULONG          tcpip_offload;
 #endif /* NX_ENABLE_TCPIP_OFFLOAD */
@@ -625,7 +628,13 @@ NX_IP         *ip_ptr;
 #endif /* NX_ENABLE_LOW_WATERMARK */
 
             /* Packet data begins to the right of the expected sequence (out of sequence data). Force an ACK. */
+#ifdef NX_ENABLE_TCP_SACK
+            /* Send it once the packet is queued so that it is reported in the SACK option.  */
+            socket_ptr -> nx_tcp_socket_sack_recent = packet_begin_sequence;
+            need_ack = NX_TRUE;
+#else
             _nx_tcp_packet_send_ack(socket_ptr, socket_ptr -> nx_tcp_socket_tx_sequence);
+#endif /* NX_ENABLE_TCP_SACK */
 
             /* Add debug information. */
             NX_PACKET_DEBUG(NX_PACKET_TCP_RECEIVE_QUEUE, __LINE__, packet_ptr);
@@ -676,7 +685,13 @@ NX_IP         *ip_ptr;
         /* Packet data begins to the right of the expected sequence (out of sequence data). Force an ACK. */
         if (((INT)(packet_begin_sequence - socket_ptr -> nx_tcp_socket_rx_sequence)) > 0)
         {
+#ifdef NX_ENABLE_TCP_SACK
+            /* Send it once the packet is queued so that it is reported in the SACK option.  */
+            socket_ptr -> nx_tcp_socket_sack_recent = packet_begin_sequence;
+            need_ack = NX_TRUE;
+#else
             _nx_tcp_packet_send_ack(socket_ptr, socket_ptr -> nx_tcp_socket_tx_sequence);
+#endif /* NX_ENABLE_TCP_SACK */
         }
 
         /* At this point, it is guaranteed that the receive queue contains packets. */
@@ -1227,6 +1242,20 @@ NX_IP         *ip_ptr;
             }
         }
 #endif
+
+#ifdef NX_ENABLE_TCP_RECEIVE_COALESCING
+        /* A merged packet may carry several full-sized segments. Acknowledge it at once,
+           as at least every second full-sized segment is acknowledged. RFC1122, Section 4.2.3.2.  */
+        if ((socket_ptr -> nx_tcp_socket_rx_sequence - original_rx_sequence) > socket_ptr -> nx_tcp_socket_connect_mss)
+        {
+#ifdef NX_TCP_ACK_EVERY_N_PACKETS
+            socket_ptr -> nx_tcp_socket_ack_n_packet_counter = 1;
+#endif
+
+            /* Need to send an immediate ACK.  */
+            need_ack = NX_TRUE;
+        }
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
     }
 
     if (need_ack == NX_TRUE)
@@ -1236,6 +1265,19 @@ NX_IP         *ip_ptr;
         _nx_tcp_packet_send_ack(socket_ptr, socket_ptr -> nx_tcp_socket_tx_sequence);
     }
 
+#ifdef NX_ENABLE_TCP_RECEIVE_COALESCING
+    /* A merged packet beyond a hole stands for several segments, each of which would have been
+       answered by a duplicate ACK. Send the missing ones, so the sender still detects the loss.  */
+    if ((((INT)(packet_begin_sequence - socket_ptr -> nx_tcp_socket_rx_sequence)) > 0) &&
+        (packet_data_length > socket_ptr -> nx_tcp_socket_connect_mss))
+    {
+        for (duplicate_acks = (packet_data_length - 1) / socket_ptr -> nx_tcp_socket_connect_mss; duplicate_acks; duplicate_acks--)
+        {
+            _nx_tcp_packet_send_ack(socket_ptr, socket_ptr -> nx_tcp_socket_tx_sequence);
+        }
+    }
+#endif /* NX_ENABLE_TCP_RECEIVE_COALESCING */
+
     /* Return true since the packet was queued.  */
     return(NX_TRUE);
 }
@@ -143,6 +143,9 @@ VOID  _nx_tcp_socket_state_syn_received(NX_TCP_SOCKET *socket_ptr, NX_TCP_HEADER
                 }
             }
 
+            /* Start the congestion control algorithm from the initial window.  */
+            socket_ptr -> nx_tcp_socket_congestion_control -> nx_tcp_congestion_control_init(socket_ptr);
+
             /* Move into the ESTABLISHED state.  */
             socket_ptr -> nx_tcp_socket_state =  NX_TCP_ESTABLISHED;
 #ifndef NX_DISABLE_EXTENDED_NOTIFY_SUPPORT
@@ -180,6 +180,9 @@ VOID  _nx_tcp_socket_state_syn_sent(NX_TCP_SOCKET *socket_ptr, NX_TCP_HEADER *tc
             }
         }
 
+        /* Start the congestion control algorithm from the initial window.  */
+        socket_ptr -> nx_tcp_socket_congestion_control -> nx_tcp_congestion_control_init(socket_ptr);
+
         /* Send the ACK.  */
         _nx_tcp_packet_send_ack(socket_ptr, socket_ptr -> nx_tcp_socket_tx_sequence);
 
@@ -267,6 +270,9 @@ VOID  _nx_tcp_socket_state_syn_sent(NX_TCP_SOCKET *socket_ptr, NX_TCP_HEADER *tc
             socket_ptr -> nx_tcp_socket_tx_window_congestion -= socket_ptr -> nx_tcp_socket_connect_mss;
         }
 
+        /* Start the congestion control algorithm from the initial window.  */
+        socket_ptr -> nx_tcp_socket_congestion_control -> nx_tcp_congestion_control_init(socket_ptr);
+
         /* Set the Initial transmit outstanding byte count. */
         socket_ptr -> nx_tcp_socket_tx_outstanding_bytes = 0;
 
@@ -0,0 +1,99 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Linux Network Driver                                                */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  PORT SPECIFIC C INFORMATION                            RELEASE        */
+/*                                                                        */
+/*    nx_linux_network_driver.h                           Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This file defines the Ethernet driver that exchanges frames with    */
+/*    the host, either through a TAP device or through an AF_UNIX         */
+/*    socketpair "virtual wire" between two driver instances.             */
+/*                                                                        */
+/*    The device must be opened before the IP instance is created, the    */
+/*    interfaces are bound to the opened instances in the attach order:   */
+/*                                                                        */
+/*      _nx_linux_network_driver_wire_create(0, 1);                       */
+/*      nx_ip_create(&ip_0, ..., _nx_linux_network_driver, ...);          */
+/*      nx_ip_create(&ip_1, ..., _nx_linux_network_driver, ...);          */
+/*                                                                        */
+/*    Each instance runs a receive and a transmit host thread, which      */
+/*    enter ThreadX like the simulated timer interrupt. Frames are moved  */
+/*    in batches of NX_LINUX_DRIVER_BATCH with recvmmsg/sendmmsg (or      */
+/*    read/writev for TAP) directly from/to the NX_PACKET buffers, so     */
+/*    the payload of the default packet pool must hold the link MTU plus  */
+/*    2 bytes.                                                            */
+/*                                                                        */
+/**************************************************************************/
+
+#ifndef NX_LINUX_NETWORK_DRIVER_H
+#define NX_LINUX_NETWORK_DRIVER_H
+
+
+#ifdef   __cplusplus
+
+/* Yes, C++ compiler is present.  Use standard C.  */
+extern   "C" {
+
+#endif
+
+#include "nx_api.h"
+
+
+/* Define the number of driver instances.  */
+
+#ifndef NX_LINUX_DRIVER_MAX_INSTANCES
+#define NX_LINUX_DRIVER_MAX_INSTANCES       4
+#endif
+
+
+/* Define the number of frames moved by one system call.  */
+
+#ifndef NX_LINUX_DRIVER_BATCH
+#define NX_LINUX_DRIVER_BATCH               32
+#endif
+
+
+/* Define the IP MTU of the link.  */
+
+#ifndef NX_LINUX_DRIVER_IP_MTU
+#define NX_LINUX_DRIVER_IP_MTU              1500
+#endif
+
+
+/* Define driver prototypes.  */
+
+VOID    _nx_linux_network_driver(NX_IP_DRIVER *driver_req_ptr);
+UINT    _nx_linux_network_driver_tap_open(UINT instance, CHAR *name);
+UINT    _nx_linux_network_driver_wire_create(UINT instance_0, UINT instance_1);
+
+
+#ifdef   __cplusplus
+}
+#endif
+
+#endif /* NX_LINUX_NETWORK_DRIVER_H */
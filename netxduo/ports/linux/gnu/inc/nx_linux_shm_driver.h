@@ -0,0 +1,100 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Linux Shared Memory Driver                                          */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  PORT SPECIFIC C INFORMATION                            RELEASE        */
+/*                                                                        */
+/*    nx_linux_shm_driver.h                               Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This file defines the Ethernet driver that connects simulator       */
+/*    processes through the ring pair of a /dev/shm segment, see          */
+/*    nx_linux_shm_ring.h. The two sides of a segment are either two      */
+/*    nodes (point to point), or a node and a port of the host switch     */
+/*    nx_linux_shm_switch, which connects any number of nodes:            */
+/*                                                                        */
+/*      nx_linux_shm_switch.elf node0 node1 node2 &                       */
+/*                                                                        */
+/*      _nx_linux_shm_driver_open(0, "node0", 0);                         */
+/*      nx_ip_create(&ip_0, ..., _nx_linux_shm_driver, ...);              */
+/*                                                                        */
+/*    The segment is created by the first side that opens it, stale       */
+/*    segments of a previous run must be removed with shm_unlink.         */
+/*                                                                        */
+/*    A frame is copied once from the packet chain into the transmit      */
+/*    ring, and once from the receive ring into the payload of a packet   */
+/*    of the default pool, in batches of NX_LINUX_SHM_BATCH per           */
+/*    simulated interrupt. The payload of the default packet pool must    */
+/*    hold the link MTU plus 16 bytes.                                    */
+/*                                                                        */
+/**************************************************************************/
+
+#ifndef NX_LINUX_SHM_DRIVER_H
+#define NX_LINUX_SHM_DRIVER_H
+
+
+#ifdef   __cplusplus
+
+/* Yes, C++ compiler is present.  Use standard C.  */
+extern   "C" {
+
+#endif
+
+#include "nx_api.h"
+
+
+/* Define the number of driver instances.  */
+
+#ifndef NX_LINUX_SHM_MAX_INSTANCES
+#define NX_LINUX_SHM_MAX_INSTANCES          4
+#endif
+
+
+/* Define the number of frames received in one simulated interrupt.  */
+
+#ifndef NX_LINUX_SHM_BATCH
+#define NX_LINUX_SHM_BATCH                  32
+#endif
+
+
+/* Define the IP MTU of the link.  */
+
+#ifndef NX_LINUX_SHM_IP_MTU
+#define NX_LINUX_SHM_IP_MTU                 1500
+#endif
+
+
+/* Define driver prototypes.  */
+
+VOID    _nx_linux_shm_driver(NX_IP_DRIVER *driver_req_ptr);
+UINT    _nx_linux_shm_driver_open(UINT instance, CHAR *name, UINT side);
+
+
+#ifdef   __cplusplus
+}
+#endif
+
+#endif /* NX_LINUX_SHM_DRIVER_H */
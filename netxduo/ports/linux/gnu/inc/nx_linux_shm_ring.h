@@ -0,0 +1,271 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Linux Shared Memory Ring                                            */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  PORT SPECIFIC C INFORMATION                            RELEASE        */
+/*                                                                        */
+/*    nx_linux_shm_ring.h                                 Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This file defines the frame ring pair shared by the processes of    */
+/*    a shared memory link, it is used by nx_linux_shm_driver.c and by    */
+/*    the host switch nx_linux_shm_switch.c, so it doesn't depend on the  */
+/*    NetX headers.                                                       */
+/*                                                                        */
+/*    A segment in /dev/shm holds two single producer/single consumer     */
+/*    rings of fixed size frame slots, ring 0 is written by side 0 and    */
+/*    ring 1 by side 1. Only offsets are stored in the segment, so it     */
+/*    can be mapped at any address.                                       */
+/*                                                                        */
+/*    Like the zero copy API of rte_ring_peek_zc.h, the slots are         */
+/*    accessed in place between a start and a finish call:                */
+/*                                                                        */
+/*      n = _nx_linux_shm_ring_dequeue_start(ring, max, &index);          */
+/*      for (i = 0; i < n; i++)                                           */
+/*          use _nx_linux_shm_ring_slot(ring, index + i);                 */
+/*      _nx_linux_shm_ring_dequeue_finish(ring, n);                       */
+/*                                                                        */
+/*    The consumer sleeps on a process-shared futex of the producer       */
+/*    index, the producer makes the system call only if the consumer is   */
+/*    sleeping.                                                           */
+/*                                                                        */
+/**************************************************************************/
+
+#ifndef NX_LINUX_SHM_RING_H
+#define NX_LINUX_SHM_RING_H
+
+
+#ifdef   __cplusplus
+
+/* Yes, C++ compiler is present.  Use standard C.  */
+extern   "C" {
+
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+
+/* Define the segment layout.  */
+
+#define NX_LINUX_SHM_MAGIC              0x4E58534DUL    /* "NXSM" */
+#define NX_LINUX_SHM_VERSION            1
+
+
+/* Define the number of slots of a ring, it must be a power of 2.  */
+
+#ifndef NX_LINUX_SHM_SLOTS
+#define NX_LINUX_SHM_SLOTS              512
+#endif
+
+
+/* Define the size of a slot, the slot header and the largest frame must
+   fit in it.  */
+
+#ifndef NX_LINUX_SHM_SLOT_SIZE
+#define NX_LINUX_SHM_SLOT_SIZE          2048
+#endif
+
+
+/* Define the frame slot.  */
+
+typedef struct NX_LINUX_SHM_SLOT_STRUCT
+{
+    uint32_t    nx_linux_shm_slot_length;
+    uint32_t    nx_linux_shm_slot_reserved;
+    uint8_t     nx_linux_shm_slot_data[];
+} NX_LINUX_SHM_SLOT;
+
+#define NX_LINUX_SHM_FRAME_MAX          (NX_LINUX_SHM_SLOT_SIZE - sizeof(NX_LINUX_SHM_SLOT))
+
+
+/* Define the ring. The producer and the consumer indexes are free running
+   and on their own cache lines.  */
+
+typedef struct NX_LINUX_SHM_RING_STRUCT
+{
+    volatile uint32_t   nx_linux_shm_ring_head __attribute__((aligned(64)));
+
+    volatile uint32_t   nx_linux_shm_ring_tail __attribute__((aligned(64)));
+
+    volatile uint32_t   nx_linux_shm_ring_waiting;
+
+    uint32_t            nx_linux_shm_ring_mask __attribute__((aligned(64)));
+
+    uint32_t            nx_linux_shm_ring_slot_size;
+
+    uint64_t            nx_linux_shm_ring_slot_offset;
+} NX_LINUX_SHM_RING;
+
+
+/* Define the segment header, the slots of the rings follow it.  */
+
+typedef struct NX_LINUX_SHM_SEGMENT_STRUCT
+{
+    volatile uint32_t   nx_linux_shm_segment_magic;
+
+    uint32_t            nx_linux_shm_segment_version;
+
+    uint32_t            nx_linux_shm_segment_slots;
+
+    uint32_t            nx_linux_shm_segment_slot_size;
+
+    NX_LINUX_SHM_RING   nx_linux_shm_segment_ring[2];
+} NX_LINUX_SHM_SEGMENT;
+
+#define NX_LINUX_SHM_SEGMENT_SIZE       (sizeof(NX_LINUX_SHM_SEGMENT) + \
+                                         2 * (size_t)NX_LINUX_SHM_SLOTS * NX_LINUX_SHM_SLOT_SIZE)
+
+
+/* Initialize the segment, the caller must own it exclusively.  */
+
+static inline void  _nx_linux_shm_segment_initialize(NX_LINUX_SHM_SEGMENT *segment)
+{
+
+uint32_t i;
+
+    memset(segment, 0, sizeof(NX_LINUX_SHM_SEGMENT));
+    segment -> nx_linux_shm_segment_version =  NX_LINUX_SHM_VERSION;
+    segment -> nx_linux_shm_segment_slots =  NX_LINUX_SHM_SLOTS;
+    segment -> nx_linux_shm_segment_slot_size =  NX_LINUX_SHM_SLOT_SIZE;
+    for (i = 0; i < 2; i++)
+    {
+        segment -> nx_linux_shm_segment_ring[i].nx_linux_shm_ring_mask =  NX_LINUX_SHM_SLOTS - 1;
+        segment -> nx_linux_shm_segment_ring[i].nx_linux_shm_ring_slot_size =  NX_LINUX_SHM_SLOT_SIZE;
+        segment -> nx_linux_shm_segment_ring[i].nx_linux_shm_ring_slot_offset =
+            (uint64_t)((uint8_t *)(segment + 1) - (uint8_t *)&segment -> nx_linux_shm_segment_ring[i]) +
+            (uint64_t)i * NX_LINUX_SHM_SLOTS * NX_LINUX_SHM_SLOT_SIZE;
+    }
+
+    /* Publish the segment.  */
+    __atomic_store_n(&segment -> nx_linux_shm_segment_magic, NX_LINUX_SHM_MAGIC, __ATOMIC_RELEASE);
+}
+
+
+/* Return non-zero if the segment is initialized with this layout.  */
+
+static inline int  _nx_linux_shm_segment_valid(NX_LINUX_SHM_SEGMENT *segment)
+{
+    return((__atomic_load_n(&segment -> nx_linux_shm_segment_magic, __ATOMIC_ACQUIRE) == NX_LINUX_SHM_MAGIC) &&
+           (segment -> nx_linux_shm_segment_version == NX_LINUX_SHM_VERSION) &&
+           (segment -> nx_linux_shm_segment_slots == NX_LINUX_SHM_SLOTS) &&
+           (segment -> nx_linux_shm_segment_slot_size == NX_LINUX_SHM_SLOT_SIZE));
+}
+
+
+/* Return the slot of the free running index.  */
+
+static inline NX_LINUX_SHM_SLOT  *_nx_linux_shm_ring_slot(NX_LINUX_SHM_RING *ring, uint32_t index)
+{
+    return((NX_LINUX_SHM_SLOT *)((uint8_t *)ring + ring -> nx_linux_shm_ring_slot_offset +
+                                 (size_t)(index & ring -> nx_linux_shm_ring_mask) * ring -> nx_linux_shm_ring_slot_size));
+}
+
+
+/* Reserve up to n free slots for the producer, return the number of slots
+   and the index of the first one.  */
+
+static inline uint32_t  _nx_linux_shm_ring_enqueue_start(NX_LINUX_SHM_RING *ring, uint32_t n, uint32_t *index)
+{
+
+uint32_t head =  ring -> nx_linux_shm_ring_head;
+uint32_t free_slots;
+
+    free_slots =  ring -> nx_linux_shm_ring_mask + 1 -
+                  (head - __atomic_load_n(&ring -> nx_linux_shm_ring_tail, __ATOMIC_ACQUIRE));
+    *index =  head;
+    return((n < free_slots) ? n : free_slots);
+}
+
+
+/* Publish n slots filled by the producer and wake up the consumer.  */
+
+static inline void  _nx_linux_shm_ring_enqueue_finish(NX_LINUX_SHM_RING *ring, uint32_t n)
+{
+
+    __atomic_store_n(&ring -> nx_linux_shm_ring_head, ring -> nx_linux_shm_ring_head + n, __ATOMIC_RELEASE);
+
+    /* Pairs with the fence of _nx_linux_shm_ring_wait, either the consumer
+       sees the new head or the producer sees the waiting flag.  */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring -> nx_linux_shm_ring_waiting, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&ring -> nx_linux_shm_ring_waiting, 0, __ATOMIC_RELAXED);
+        syscall(SYS_futex, &ring -> nx_linux_shm_ring_head, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+
+/* Return the number of filled slots for the consumer, up to n, and the index
+   of the first one.  */
+
+static inline uint32_t  _nx_linux_shm_ring_dequeue_start(NX_LINUX_SHM_RING *ring, uint32_t n, uint32_t *index)
+{
+
+uint32_t tail =  ring -> nx_linux_shm_ring_tail;
+uint32_t used;
+
+    used =  __atomic_load_n(&ring -> nx_linux_shm_ring_head, __ATOMIC_ACQUIRE) - tail;
+    *index =  tail;
+    return((n < used) ? n : used);
+}
+
+
+/* Release n slots processed by the consumer.  */
+
+static inline void  _nx_linux_shm_ring_dequeue_finish(NX_LINUX_SHM_RING *ring, uint32_t n)
+{
+    __atomic_store_n(&ring -> nx_linux_shm_ring_tail, ring -> nx_linux_shm_ring_tail + n, __ATOMIC_RELEASE);
+}
+
+
+/* Sleep until the ring is not empty or the timeout expires.  */
+
+static inline void  _nx_linux_shm_ring_wait(NX_LINUX_SHM_RING *ring, long timeout_ns)
+{
+
+uint32_t        tail =  ring -> nx_linux_shm_ring_tail;
+struct timespec ts;
+
+    __atomic_store_n(&ring -> nx_linux_shm_ring_waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    /* The futex returns at once if the head is moved from the tail.  */
+    ts.tv_sec =  timeout_ns / 1000000000L;
+    ts.tv_nsec =  timeout_ns % 1000000000L;
+    syscall(SYS_futex, &ring -> nx_linux_shm_ring_head, FUTEX_WAIT, tail, &ts, NULL, 0);
+}
+
+
+#ifdef   __cplusplus
+}
+#endif
+
+#endif /* NX_LINUX_SHM_RING_H */
@@ -146,6 +146,17 @@
 #endif
 
 
+/* Pass the control block pointers to the thread and timer entries through the
+   ThreadX extension pointers, since ULONG is 32-bit on x86_64.  */
+
+#ifdef TX_64_BIT
+#define NX_THREAD_EXTENSION_PTR_SET(a, b)       TX_THREAD_EXTENSION_PTR_SET(a, b)
+#define NX_THREAD_EXTENSION_PTR_GET(a, b, c)    TX_THREAD_EXTENSION_PTR_GET(a, b, c)
+#define NX_TIMER_EXTENSION_PTR_SET(a, b)        TX_TIMER_EXTENSION_PTR_SET(a, b)
+#define NX_TIMER_EXTENSION_PTR_GET(a, b, c)     TX_TIMER_EXTENSION_PTR_GET(a, b, c)
+#endif /* TX_64_BIT */
+
+
 /* Define several macros for the error checking shell in NetX.  */
 
 #ifndef TX_TIMER_PROCESS_IN_ISR
@@ -0,0 +1,1068 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Linux Network Driver                                                */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "nx_linux_network_driver.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+
+/* Define the Ethernet frame format, see nx_ram_network_driver.c.  */
+
+#define NX_ETHERNET_IP   0x0800
+#define NX_ETHERNET_ARP  0x0806
+#define NX_ETHERNET_RARP 0x8035
+#define NX_ETHERNET_IPV6 0x86DD
+#define NX_ETHERNET_SIZE 14
+
+
+/* The received frame is placed 2 bytes after the start of the packet, so that
+   the IP header behind the Ethernet header is 32-bit aligned.  */
+
+#define NX_LINUX_DRIVER_RX_OFFSET   2
+
+
+/* Define the maximum number of buffers of a transmitted packet chain.  */
+
+#define NX_LINUX_DRIVER_TX_IOV      8
+
+
+/* Define the socket buffer size of the virtual wire.  */
+
+#define NX_LINUX_DRIVER_WIRE_BUFFER (4 * 1024 * 1024)
+
+
+/* Define the driver instance. The transmit queue and the counters are protected
+   by TX_DISABLE in the ThreadX threads, the host threads access them only in
+   the simulated interrupt context.  */
+
+typedef struct NX_LINUX_DRIVER_INSTANCE_STRUCT
+{
+    UINT          nx_linux_driver_opened;
+
+    UINT          nx_linux_driver_in_use;
+
+    UINT          nx_linux_driver_is_socket;
+
+    INT           nx_linux_driver_fd;
+
+    INT           nx_linux_driver_event_fd;
+
+    NX_INTERFACE *nx_linux_driver_interface_ptr;
+
+    NX_IP        *nx_linux_driver_ip_ptr;
+
+    ULONG         nx_linux_driver_mac_msw;
+
+    ULONG         nx_linux_driver_mac_lsw;
+
+    /* Host threads.  */
+    pthread_t     nx_linux_driver_rx_thread;
+
+    pthread_t     nx_linux_driver_tx_thread;
+
+    UINT          nx_linux_driver_started;
+
+    volatile UINT nx_linux_driver_stop;
+
+    /* Transmit queue, linked by nx_packet_queue_next.  */
+    sem_t         nx_linux_driver_tx_semaphore;
+
+    NX_PACKET    *nx_linux_driver_tx_head;
+
+    NX_PACKET    *nx_linux_driver_tx_tail;
+
+    UINT          nx_linux_driver_tx_idle;
+
+    /* Statistics.  */
+    ULONG         nx_linux_driver_rx_packets;
+
+    ULONG         nx_linux_driver_tx_packets;
+
+    ULONG         nx_linux_driver_rx_dropped;
+
+    ULONG         nx_linux_driver_tx_dropped;
+
+    ULONG         nx_linux_driver_alloc_errors;
+} NX_LINUX_DRIVER_INSTANCE;
+
+
+static NX_LINUX_DRIVER_INSTANCE nx_linux_driver[NX_LINUX_DRIVER_MAX_INSTANCES];
+
+
+static VOID  _nx_linux_network_driver_transmit(NX_LINUX_DRIVER_INSTANCE *driver_ptr, NX_PACKET *packet_ptr);
+static UINT  _nx_linux_network_driver_start(NX_LINUX_DRIVER_INSTANCE *driver_ptr);
+static VOID  _nx_linux_network_driver_stop(NX_LINUX_DRIVER_INSTANCE *driver_ptr);
+static VOID *_nx_linux_network_driver_rx_entry(VOID *arg);
+static VOID *_nx_linux_network_driver_tx_entry(VOID *arg);
+
+
+/* Open one driver instance on the file descriptor.  */
+
+static UINT  _nx_linux_network_driver_open(UINT instance, INT fd, UINT is_socket)
+{
+
+NX_LINUX_DRIVER_INSTANCE *driver_ptr;
+
+    if ((instance >= NX_LINUX_DRIVER_MAX_INSTANCES) || (nx_linux_driver[instance].nx_linux_driver_opened))
+    {
+        return(NX_INVALID_INTERFACE);
+    }
+
+    driver_ptr =  &nx_linux_driver[instance];
+    memset(driver_ptr, 0, sizeof(NX_LINUX_DRIVER_INSTANCE));
+    driver_ptr -> nx_linux_driver_event_fd =  eventfd(0, EFD_CLOEXEC);
+    if (driver_ptr -> nx_linux_driver_event_fd < 0)
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    sem_init(&driver_ptr -> nx_linux_driver_tx_semaphore, 0, 0);
+    driver_ptr -> nx_linux_driver_fd =  fd;
+    driver_ptr -> nx_linux_driver_is_socket =  is_socket;
+    driver_ptr -> nx_linux_driver_tx_idle =  NX_TRUE;
+
+    /* Locally administered unicast address 02:00:00:00:00:xx.  */
+    driver_ptr -> nx_linux_driver_mac_msw =  0x0200;
+    driver_ptr -> nx_linux_driver_mac_lsw =  instance + 1;
+    driver_ptr -> nx_linux_driver_opened =  NX_TRUE;
+
+    return(NX_SUCCESS);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_network_driver_tap_open                   Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function attaches the driver instance to a TAP device. The     */
+/*    device is created if it does not exist (CAP_NET_ADMIN is required)  */
+/*    and it must be brought up on the host side.                         */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    instance                              Driver instance               */
+/*    name                                  TAP device name, such as tap0 */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    status                                Completion status             */
+/*                                                                        */
+/**************************************************************************/
+UINT  _nx_linux_network_driver_tap_open(UINT instance, CHAR *name)
+{
+
+struct ifreq ifr;
+INT          fd;
+UINT         status;
+
+    fd =  open("/dev/net/tun", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags =  IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0)
+    {
+        close(fd);
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    status =  _nx_linux_network_driver_open(instance, fd, NX_FALSE);
+    if (status)
+    {
+        close(fd);
+    }
+
+    return(status);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_network_driver_wire_create                Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function connects two driver instances with an AF_UNIX         */
+/*    SOCK_SEQPACKET socketpair, every frame sent on one end is received  */
+/*    on the other end.                                                   */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    instance_0                            Driver instance of one end    */
+/*    instance_1                            Driver instance of other end  */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    status                                Completion status             */
+/*                                                                        */
+/**************************************************************************/
+UINT  _nx_linux_network_driver_wire_create(UINT instance_0, UINT instance_1)
+{
+
+INT  fds[2];
+INT  size =  NX_LINUX_DRIVER_WIRE_BUFFER;
+UINT i;
+
+    if ((instance_0 == instance_1) ||
+        (instance_0 >= NX_LINUX_DRIVER_MAX_INSTANCES) || (instance_1 >= NX_LINUX_DRIVER_MAX_INSTANCES) ||
+        (nx_linux_driver[instance_0].nx_linux_driver_opened) || (nx_linux_driver[instance_1].nx_linux_driver_opened))
+    {
+        return(NX_INVALID_INTERFACE);
+    }
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0)
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    /* AF_UNIX queues the frames on the sender side. The size is capped by
+       net.core.wmem_max, so the failure is ignored.  */
+    for (i = 0; i < 2; i++)
+    {
+        setsockopt(fds[i], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        setsockopt(fds[i], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    if (_nx_linux_network_driver_open(instance_0, fds[0], NX_TRUE))
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    if (_nx_linux_network_driver_open(instance_1, fds[1], NX_TRUE))
+    {
+        close(nx_linux_driver[instance_0].nx_linux_driver_event_fd);
+        sem_destroy(&nx_linux_driver[instance_0].nx_linux_driver_tx_semaphore);
+        memset(&nx_linux_driver[instance_0], 0, sizeof(NX_LINUX_DRIVER_INSTANCE));
+        close(fds[0]);
+        close(fds[1]);
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    return(NX_SUCCESS);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_network_driver                            Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is the Ethernet driver entry of the Linux simulator.  */
+/*    The requests are handled like nx_ram_network_driver.c, except that  */
+/*    the frames are queued to the transmit thread of the instance.       */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    driver_req_ptr                        Pointer to driver request     */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    _nx_linux_network_driver_transmit     Queue packet for transmission */
+/*    _nx_linux_network_driver_start        Start host threads            */
+/*    _nx_linux_network_driver_stop         Stop host threads             */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    NetX IP processing                                                  */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_linux_network_driver(NX_IP_DRIVER *driver_req_ptr)
+{
+
+UINT                      i = 0;
+NX_IP                    *ip_ptr;
+NX_PACKET                *packet_ptr;
+ULONG                    *ethernet_frame_ptr;
+NX_INTERFACE             *interface_ptr;
+UINT                      interface_index;
+NX_LINUX_DRIVER_INSTANCE *driver_ptr = NX_NULL;
+
+    /* Setup the IP pointer from the driver request.  */
+    ip_ptr =  driver_req_ptr -> nx_ip_driver_ptr;
+
+    /* Default to successful return.  */
+    driver_req_ptr -> nx_ip_driver_status =  NX_SUCCESS;
+
+    /* Setup interface pointer.  */
+    interface_ptr =  driver_req_ptr -> nx_ip_driver_interface;
+    interface_index =  interface_ptr -> nx_interface_index;
+
+    /* Find out the driver instance if the driver command is not ATTACH.  */
+    if (driver_req_ptr -> nx_ip_driver_command != NX_LINK_INTERFACE_ATTACH)
+    {
+        for (i = 0; i < NX_LINUX_DRIVER_MAX_INSTANCES; i++)
+        {
+            if ((nx_linux_driver[i].nx_linux_driver_in_use) &&
+                (nx_linux_driver[i].nx_linux_driver_ip_ptr == ip_ptr) &&
+                (nx_linux_driver[i].nx_linux_driver_interface_ptr == interface_ptr))
+            {
+                break;
+            }
+        }
+
+        if (i == NX_LINUX_DRIVER_MAX_INSTANCES)
+        {
+
+            /* The packet must be released even if the interface is unknown.  */
+            if ((driver_req_ptr -> nx_ip_driver_command == NX_LINK_PACKET_SEND) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_PACKET_BROADCAST) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_SEND) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_RESPONSE_SEND) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_RARP_SEND))
+            {
+                nx_packet_transmit_release(driver_req_ptr -> nx_ip_driver_packet);
+            }
+
+            driver_req_ptr -> nx_ip_driver_status =  NX_INVALID_INTERFACE;
+            return;
+        }
+
+        driver_ptr =  &nx_linux_driver[i];
+    }
+
+    switch (driver_req_ptr -> nx_ip_driver_command)
+    {
+
+    case NX_LINK_INTERFACE_ATTACH:
+    {
+
+        /* Bind the interface to the first opened instance.  */
+        for (i = 0; i < NX_LINUX_DRIVER_MAX_INSTANCES; i++)
+        {
+            if ((nx_linux_driver[i].nx_linux_driver_opened) && (nx_linux_driver[i].nx_linux_driver_in_use == 0))
+            {
+                break;
+            }
+        }
+
+        if (i < NX_LINUX_DRIVER_MAX_INSTANCES)
+        {
+            nx_linux_driver[i].nx_linux_driver_in_use =  NX_TRUE;
+            nx_linux_driver[i].nx_linux_driver_interface_ptr =  interface_ptr;
+            nx_linux_driver[i].nx_linux_driver_ip_ptr =  ip_ptr;
+        }
+        else
+        {
+            driver_req_ptr -> nx_ip_driver_status =  NX_INVALID_INTERFACE;
+        }
+
+        break;
+    }
+
+    case NX_LINK_INITIALIZE:
+    {
+
+        nx_ip_interface_mtu_set(ip_ptr, interface_index, NX_LINUX_DRIVER_IP_MTU);
+        nx_ip_interface_physical_address_set(ip_ptr, interface_index,
+                                             driver_ptr -> nx_linux_driver_mac_msw,
+                                             driver_ptr -> nx_linux_driver_mac_lsw, NX_FALSE);
+        nx_ip_interface_address_mapping_configure(ip_ptr, interface_index, NX_TRUE);
+
+        /* Start the host threads, the frames are dropped until the link is enabled.  */
+        if (_nx_linux_network_driver_start(driver_ptr))
+        {
+            driver_req_ptr -> nx_ip_driver_status =  NX_NOT_SUCCESSFUL;
+        }
+
+        break;
+    }
+
+    case NX_LINK_INTERFACE_DETACH:
+    case NX_LINK_UNINITIALIZE:
+    {
+
+        interface_ptr -> nx_interface_link_up =  NX_FALSE;
+        _nx_linux_network_driver_stop(driver_ptr);
+        break;
+    }
+
+    case NX_LINK_ENABLE:
+    {
+
+        interface_ptr -> nx_interface_link_up =  NX_TRUE;
+        break;
+    }
+
+    case NX_LINK_DISABLE:
+    {
+
+        interface_ptr -> nx_interface_link_up =  NX_FALSE;
+        break;
+    }
+
+    case NX_LINK_PACKET_SEND:
+    case NX_LINK_PACKET_BROADCAST:
+    case NX_LINK_ARP_SEND:
+    case NX_LINK_ARP_RESPONSE_SEND:
+    case NX_LINK_RARP_SEND:
+    {
+
+        /* Place the ethernet frame at the front of the packet.  */
+        packet_ptr =  driver_req_ptr -> nx_ip_driver_packet;
+        packet_ptr -> nx_packet_prepend_ptr =  packet_ptr -> nx_packet_prepend_ptr - NX_ETHERNET_SIZE;
+        packet_ptr -> nx_packet_length =  packet_ptr -> nx_packet_length + NX_ETHERNET_SIZE;
+
+        /* Setup the ethernet frame pointer to build the ethernet frame.  Backup another 2
+           bytes to get 32-bit word alignment.  */
+        /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+        ethernet_frame_ptr =  (ULONG *)(packet_ptr -> nx_packet_prepend_ptr - 2);
+
+        /* Build the ethernet frame.  */
+        *ethernet_frame_ptr       =  driver_req_ptr -> nx_ip_driver_physical_address_msw;
+        *(ethernet_frame_ptr + 1) =  driver_req_ptr -> nx_ip_driver_physical_address_lsw;
+        *(ethernet_frame_ptr + 2) =  (interface_ptr -> nx_interface_physical_address_msw << 16) |
+            (interface_ptr -> nx_interface_physical_address_lsw >> 16);
+        *(ethernet_frame_ptr + 3) =  (interface_ptr -> nx_interface_physical_address_lsw << 16);
+
+        if ((driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_SEND) ||
+            (driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_RESPONSE_SEND))
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_ARP;
+        }
+        else if (driver_req_ptr -> nx_ip_driver_command == NX_LINK_RARP_SEND)
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_RARP;
+        }
+        else if (packet_ptr -> nx_packet_ip_version == 4)
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_IP;
+        }
+        else
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_IPV6;
+        }
+
+        /* Endian swapping if NX_LITTLE_ENDIAN is defined.  */
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr));
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr + 1));
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr + 2));
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr + 3));
+
+        _nx_linux_network_driver_transmit(driver_ptr, packet_ptr);
+        break;
+    }
+
+    case NX_LINK_MULTICAST_JOIN:
+    case NX_LINK_MULTICAST_LEAVE:
+    {
+
+        /* All the multicast frames are accepted.  */
+        break;
+    }
+
+    case NX_LINK_GET_STATUS:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  interface_ptr -> nx_interface_link_up;
+        break;
+    }
+
+    case NX_LINK_GET_SPEED:
+    case NX_LINK_GET_DUPLEX_TYPE:
+    {
+
+        /* Unsupported feature.  */
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  0;
+        break;
+    }
+
+    case NX_LINK_GET_ERROR_COUNT:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_driver_rx_dropped +
+                                                        driver_ptr -> nx_linux_driver_tx_dropped;
+        break;
+    }
+
+    case NX_LINK_GET_RX_COUNT:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_driver_rx_packets;
+        break;
+    }
+
+    case NX_LINK_GET_TX_COUNT:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_driver_tx_packets;
+        break;
+    }
+
+    case NX_LINK_GET_ALLOC_ERRORS:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_driver_alloc_errors;
+        break;
+    }
+
+    case NX_LINK_GET_INTERFACE_TYPE:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  NX_INTERFACE_TYPE_ETHERNET;
+        break;
+    }
+
+    case NX_LINK_DEFERRED_PROCESSING:
+    {
+
+        /* The frames are received by the host thread.  */
+        break;
+    }
+
+    case NX_LINK_SET_PHYSICAL_ADDRESS:
+    {
+
+        driver_ptr -> nx_linux_driver_mac_msw =  driver_req_ptr -> nx_ip_driver_physical_address_msw;
+        driver_ptr -> nx_linux_driver_mac_lsw =  driver_req_ptr -> nx_ip_driver_physical_address_lsw;
+        break;
+    }
+
+#ifdef NX_ENABLE_INTERFACE_CAPABILITY
+    case NX_INTERFACE_CAPABILITY_GET:
+    {
+
+        /* No hardware offload.  */
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  0;
+        break;
+    }
+
+    case NX_INTERFACE_CAPABILITY_SET:
+    {
+
+        break;
+    }
+#endif /* NX_ENABLE_INTERFACE_CAPABILITY  */
+
+    default:
+
+        /* Return the unhandled command status.  */
+        driver_req_ptr -> nx_ip_driver_status =  NX_UNHANDLED_COMMAND;
+        break;
+    }
+}
+
+
+/* Queue the frame to the transmit thread.  */
+
+static VOID  _nx_linux_network_driver_transmit(NX_LINUX_DRIVER_INSTANCE *driver_ptr, NX_PACKET *packet_ptr)
+{
+
+TX_INTERRUPT_SAVE_AREA
+UINT    wakeup;
+
+    TX_DISABLE
+
+    if (driver_ptr -> nx_linux_driver_started == 0)
+    {
+        driver_ptr -> nx_linux_driver_tx_dropped++;
+        TX_RESTORE
+
+        /* Remove the Ethernet header and release the packet.  */
+        packet_ptr -> nx_packet_prepend_ptr =  packet_ptr -> nx_packet_prepend_ptr + NX_ETHERNET_SIZE;
+        packet_ptr -> nx_packet_length =  packet_ptr -> nx_packet_length - NX_ETHERNET_SIZE;
+        nx_packet_transmit_release(packet_ptr);
+        return;
+    }
+
+    packet_ptr -> nx_packet_queue_next =  NX_NULL;
+    if (driver_ptr -> nx_linux_driver_tx_tail)
+    {
+        driver_ptr -> nx_linux_driver_tx_tail -> nx_packet_queue_next =  packet_ptr;
+    }
+    else
+    {
+        driver_ptr -> nx_linux_driver_tx_head =  packet_ptr;
+    }
+    driver_ptr -> nx_linux_driver_tx_tail =  packet_ptr;
+
+    /* Only an idle transmit thread is woken up, a busy one picks up the
+       packet with the current batch.  */
+    wakeup =  driver_ptr -> nx_linux_driver_tx_idle;
+    driver_ptr -> nx_linux_driver_tx_idle =  NX_FALSE;
+
+    TX_RESTORE
+
+    if (wakeup)
+    {
+        sem_post(&driver_ptr -> nx_linux_driver_tx_semaphore);
+    }
+}
+
+
+static UINT  _nx_linux_network_driver_start(NX_LINUX_DRIVER_INSTANCE *driver_ptr)
+{
+
+    if (driver_ptr -> nx_linux_driver_started)
+    {
+        return(NX_SUCCESS);
+    }
+
+    driver_ptr -> nx_linux_driver_stop =  NX_FALSE;
+    if (pthread_create(&driver_ptr -> nx_linux_driver_rx_thread, NX_NULL,
+                       _nx_linux_network_driver_rx_entry, driver_ptr))
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    if (pthread_create(&driver_ptr -> nx_linux_driver_tx_thread, NX_NULL,
+                       _nx_linux_network_driver_tx_entry, driver_ptr))
+    {
+        driver_ptr -> nx_linux_driver_stop =  NX_TRUE;
+        eventfd_write(driver_ptr -> nx_linux_driver_event_fd, 1);
+        pthread_join(driver_ptr -> nx_linux_driver_rx_thread, NX_NULL);
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    driver_ptr -> nx_linux_driver_started =  NX_TRUE;
+    return(NX_SUCCESS);
+}
+
+
+/* Stop the host threads and close the instance.  */
+
+static VOID  _nx_linux_network_driver_stop(NX_LINUX_DRIVER_INSTANCE *driver_ptr)
+{
+
+TX_INTERRUPT_SAVE_AREA
+
+    if (driver_ptr -> nx_linux_driver_started)
+    {
+        TX_DISABLE
+        driver_ptr -> nx_linux_driver_started =  NX_FALSE;
+        driver_ptr -> nx_linux_driver_stop =  NX_TRUE;
+        TX_RESTORE
+
+        /* Unblock the threads.  */
+        if (driver_ptr -> nx_linux_driver_is_socket)
+        {
+            shutdown(driver_ptr -> nx_linux_driver_fd, SHUT_RDWR);
+        }
+        eventfd_write(driver_ptr -> nx_linux_driver_event_fd, 1);
+        sem_post(&driver_ptr -> nx_linux_driver_tx_semaphore);
+
+        pthread_join(driver_ptr -> nx_linux_driver_rx_thread, NX_NULL);
+        pthread_join(driver_ptr -> nx_linux_driver_tx_thread, NX_NULL);
+    }
+
+    close(driver_ptr -> nx_linux_driver_fd);
+    close(driver_ptr -> nx_linux_driver_event_fd);
+    sem_destroy(&driver_ptr -> nx_linux_driver_tx_semaphore);
+    memset(driver_ptr, 0, sizeof(NX_LINUX_DRIVER_INSTANCE));
+}
+
+
+/* Read up to count frames without blocking. A TAP device is not a socket, so it
+   is read frame by frame until it is empty.  */
+
+static INT  _nx_linux_network_driver_read(NX_LINUX_DRIVER_INSTANCE *driver_ptr,
+                                          struct mmsghdr *msg, UINT count)
+{
+
+ssize_t n;
+UINT    i;
+
+    if (driver_ptr -> nx_linux_driver_is_socket)
+    {
+        return(recvmmsg(driver_ptr -> nx_linux_driver_fd, msg, count, MSG_DONTWAIT, NX_NULL));
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        n =  readv(driver_ptr -> nx_linux_driver_fd, msg[i].msg_hdr.msg_iov, 1);
+        if (n < 0)
+        {
+            break;
+        }
+        msg[i].msg_len =  (unsigned int)n;
+        msg[i].msg_hdr.msg_flags =  0;
+    }
+
+    return((i > 0) ? (INT)i : -1);
+}
+
+
+/* Deliver one received frame to the IP instance, it is called in the
+   simulated interrupt context. Return NX_FALSE if the packet is not consumed.  */
+
+static UINT  _nx_linux_network_driver_receive(NX_LINUX_DRIVER_INSTANCE *driver_ptr, NX_PACKET *packet_ptr,
+                                              UINT length, INT flags)
+{
+
+UCHAR  *frame_ptr;
+NX_IP  *ip_ptr =  driver_ptr -> nx_linux_driver_ip_ptr;
+ULONG   destination_address_msw;
+ULONG   destination_address_lsw;
+UINT    packet_type;
+
+    frame_ptr =  packet_ptr -> nx_packet_data_start + NX_LINUX_DRIVER_RX_OFFSET;
+    if ((flags & MSG_TRUNC) || (length < NX_ETHERNET_SIZE) ||
+        (driver_ptr -> nx_linux_driver_interface_ptr -> nx_interface_link_up == NX_FALSE))
+    {
+        driver_ptr -> nx_linux_driver_rx_dropped++;
+        return(NX_FALSE);
+    }
+
+    /* Accept the frame to this interface, and broadcast and multicast frames.  */
+    destination_address_msw =  ((ULONG)frame_ptr[0] << 8) | (ULONG)frame_ptr[1];
+    destination_address_lsw =  ((ULONG)frame_ptr[2] << 24) | ((ULONG)frame_ptr[3] << 16) |
+                               ((ULONG)frame_ptr[4] << 8) | (ULONG)frame_ptr[5];
+    if (((frame_ptr[0] & 1) == 0) &&
+        ((destination_address_msw != driver_ptr -> nx_linux_driver_mac_msw) ||
+         (destination_address_lsw != driver_ptr -> nx_linux_driver_mac_lsw)))
+    {
+        return(NX_FALSE);
+    }
+
+    packet_type =  ((UINT)frame_ptr[12] << 8) | (UINT)frame_ptr[13];
+
+    /* Clean off the Ethernet header.  */
+    packet_ptr -> nx_packet_prepend_ptr =  frame_ptr + NX_ETHERNET_SIZE;
+    packet_ptr -> nx_packet_append_ptr =  frame_ptr + length;
+    packet_ptr -> nx_packet_length =  length - NX_ETHERNET_SIZE;
+    packet_ptr -> nx_packet_address.nx_packet_interface_ptr =  driver_ptr -> nx_linux_driver_interface_ptr;
+
+    if ((packet_type == NX_ETHERNET_IP) || (packet_type == NX_ETHERNET_IPV6))
+    {
+        _nx_ip_packet_deferred_receive(ip_ptr, packet_ptr);
+    }
+#ifndef NX_DISABLE_IPV4
+    else if (packet_type == NX_ETHERNET_ARP)
+    {
+        _nx_arp_packet_deferred_receive(ip_ptr, packet_ptr);
+    }
+    else if (packet_type == NX_ETHERNET_RARP)
+    {
+        _nx_rarp_packet_deferred_receive(ip_ptr, packet_ptr);
+    }
+#endif /* !NX_DISABLE_IPV4  */
+    else
+    {
+        driver_ptr -> nx_linux_driver_rx_dropped++;
+        return(NX_FALSE);
+    }
+
+    driver_ptr -> nx_linux_driver_rx_packets++;
+    return(NX_TRUE);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_network_driver_rx_entry                   Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is the receive host thread. A batch of packets is     */
+/*    allocated from the default packet pool and the frames are received  */
+/*    directly into them. The received batch is delivered and the         */
+/*    consumed packets are replaced in one simulated interrupt, so the    */
+/*    IP thread processes the whole batch after the interrupt returns.    */
+/*                                                                        */
+/**************************************************************************/
+static VOID  *_nx_linux_network_driver_rx_entry(VOID *arg)
+{
+
+NX_LINUX_DRIVER_INSTANCE *driver_ptr =  (NX_LINUX_DRIVER_INSTANCE *)arg;
+NX_PACKET_POOL           *pool_ptr =  driver_ptr -> nx_linux_driver_ip_ptr -> nx_ip_default_packet_pool;
+NX_PACKET                *packet[NX_LINUX_DRIVER_BATCH];
+struct mmsghdr            msg[NX_LINUX_DRIVER_BATCH];
+struct iovec              iov[NX_LINUX_DRIVER_BATCH];
+struct pollfd             fds[2];
+UINT                      count =  0;
+UINT                      kept;
+INT                       received =  0;
+INT                       i;
+
+    memset(msg, 0, sizeof(msg));
+    fds[0].fd =  driver_ptr -> nx_linux_driver_fd;
+    fds[0].events =  POLLIN;
+    fds[1].fd =  driver_ptr -> nx_linux_driver_event_fd;
+    fds[1].events =  POLLIN;
+
+    while (!driver_ptr -> nx_linux_driver_stop)
+    {
+
+        /* Enter ThreadX like an interrupt.  */
+        _tx_thread_context_save();
+
+        /* Deliver the received frames, the others are reused.  */
+        kept =  0;
+        for (i = 0; i < (INT)count; i++)
+        {
+            if ((i >= received) ||
+                (!_nx_linux_network_driver_receive(driver_ptr, packet[i], msg[i].msg_len, msg[i].msg_hdr.msg_flags)))
+            {
+                packet[kept++] =  packet[i];
+            }
+        }
+        count =  kept;
+
+        /* Refill the batch.  */
+        while (count < NX_LINUX_DRIVER_BATCH)
+        {
+            if (nx_packet_allocate(pool_ptr, &packet[count], NX_RECEIVE_PACKET, NX_NO_WAIT))
+            {
+                driver_ptr -> nx_linux_driver_alloc_errors++;
+                break;
+            }
+            count++;
+        }
+
+        _tx_thread_context_restore();
+
+        if (count == 0)
+        {
+
+            /* The packet pool is exhausted, retry later.  */
+            received =  0;
+            usleep(1000);
+            continue;
+        }
+
+        for (i = 0; i < (INT)count; i++)
+        {
+            iov[i].iov_base =  packet[i] -> nx_packet_data_start + NX_LINUX_DRIVER_RX_OFFSET;
+            iov[i].iov_len =  (size_t)(packet[i] -> nx_packet_data_end - packet[i] -> nx_packet_data_start) -
+                              NX_LINUX_DRIVER_RX_OFFSET;
+            msg[i].msg_hdr.msg_iov =  &iov[i];
+            msg[i].msg_hdr.msg_iovlen =  1;
+        }
+
+        /* Wait only if there is nothing to read.  */
+        received =  _nx_linux_network_driver_read(driver_ptr, msg, count);
+        while ((received < 0) && (!driver_ptr -> nx_linux_driver_stop) &&
+               ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+        {
+            poll(fds, 2, -1);
+            received =  _nx_linux_network_driver_read(driver_ptr, msg, count);
+        }
+        if (received < 0)
+        {
+            received =  0;
+        }
+        else if ((received == 0) && (driver_ptr -> nx_linux_driver_is_socket))
+        {
+
+            /* The peer is closed.  */
+            break;
+        }
+    }
+
+    /* Release the packets.  */
+    _tx_thread_context_save();
+    for (i = 0; i < (INT)count; i++)
+    {
+        nx_packet_release(packet[i]);
+    }
+    _tx_thread_context_restore();
+
+    return(NX_NULL);
+}
+
+
+/* Remove the Ethernet header and release the transmitted packets, and take the
+   transmit queue if the local one is empty. It is done in one simulated
+   interrupt, since TX_DISABLE can't be used in a host thread.  */
+
+static VOID  _nx_linux_network_driver_tx_complete(NX_LINUX_DRIVER_INSTANCE *driver_ptr,
+                                                  NX_PACKET **packet, UINT count, NX_PACKET **queue_ptr)
+{
+
+UINT    i;
+
+    _tx_thread_context_save();
+
+    for (i = 0; i < count; i++)
+    {
+        packet[i] -> nx_packet_prepend_ptr =  packet[i] -> nx_packet_prepend_ptr + NX_ETHERNET_SIZE;
+        packet[i] -> nx_packet_length =  packet[i] -> nx_packet_length - NX_ETHERNET_SIZE;
+        nx_packet_transmit_release(packet[i]);
+    }
+
+    if (*queue_ptr == NX_NULL)
+    {
+        *queue_ptr =  driver_ptr -> nx_linux_driver_tx_head;
+        driver_ptr -> nx_linux_driver_tx_head =  NX_NULL;
+        driver_ptr -> nx_linux_driver_tx_tail =  NX_NULL;
+        if (*queue_ptr == NX_NULL)
+        {
+            driver_ptr -> nx_linux_driver_tx_idle =  NX_TRUE;
+        }
+    }
+
+    _tx_thread_context_restore();
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_network_driver_tx_entry                   Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is the transmit host thread. It takes the whole       */
+/*    transmit queue at once and sends it in batches, the buffers of the  */
+/*    packet chains are sent in place. The sent batch is released in one  */
+/*    simulated interrupt.                                                */
+/*                                                                        */
+/**************************************************************************/
+static VOID  *_nx_linux_network_driver_tx_entry(VOID *arg)
+{
+
+NX_LINUX_DRIVER_INSTANCE *driver_ptr =  (NX_LINUX_DRIVER_INSTANCE *)arg;
+NX_PACKET                *packet[NX_LINUX_DRIVER_BATCH];
+NX_PACKET                *queue_ptr;
+NX_PACKET                *current_ptr;
+struct mmsghdr            msg[NX_LINUX_DRIVER_BATCH];
+struct iovec              iov[NX_LINUX_DRIVER_BATCH][NX_LINUX_DRIVER_TX_IOV];
+UINT                      count;
+UINT                      sent;
+UINT                      iovcnt;
+INT                       n;
+
+    memset(msg, 0, sizeof(msg));
+    queue_ptr =  NX_NULL;
+    count =  0;
+
+    for (;;)
+    {
+
+        /* Release the sent batch and take the transmit queue.  */
+        _nx_linux_network_driver_tx_complete(driver_ptr, packet, count, &queue_ptr);
+        count =  0;
+        if (queue_ptr == NX_NULL)
+        {
+            if (driver_ptr -> nx_linux_driver_stop)
+            {
+                break;
+            }
+            while (sem_wait(&driver_ptr -> nx_linux_driver_tx_semaphore) != 0)
+            {
+            }
+            continue;
+        }
+
+        /* Build the next batch.  */
+        for (count = 0; (count < NX_LINUX_DRIVER_BATCH) && (queue_ptr); count++)
+        {
+            packet[count] =  queue_ptr;
+            queue_ptr =  queue_ptr -> nx_packet_queue_next;
+
+            iovcnt =  0;
+            for (current_ptr = packet[count]; current_ptr && (iovcnt < NX_LINUX_DRIVER_TX_IOV);
+                 current_ptr = current_ptr -> nx_packet_next)
+            {
+                iov[count][iovcnt].iov_base =  current_ptr -> nx_packet_prepend_ptr;
+                iov[count][iovcnt].iov_len =  (size_t)(current_ptr -> nx_packet_append_ptr - current_ptr -> nx_packet_prepend_ptr);
+                iovcnt++;
+            }
+
+            /* A chain that is too long is sent truncated, count it as dropped.  */
+            if (current_ptr)
+            {
+                driver_ptr -> nx_linux_driver_tx_dropped++;
+            }
+            msg[count].msg_hdr.msg_iov =  iov[count];
+            msg[count].msg_hdr.msg_iovlen =  iovcnt;
+        }
+
+        /* Send the batch.  */
+        for (sent = 0; (sent < count) && (!driver_ptr -> nx_linux_driver_stop); )
+        {
+            if (driver_ptr -> nx_linux_driver_is_socket)
+            {
+                n =  sendmmsg(driver_ptr -> nx_linux_driver_fd, &msg[sent], count - sent, 0);
+            }
+            else
+            {
+                n =  (writev(driver_ptr -> nx_linux_driver_fd, msg[sent].msg_hdr.msg_iov,
+                             (INT)msg[sent].msg_hdr.msg_iovlen) < 0) ? -1 : 1;
+            }
+
+            if (n > 0)
+            {
+                sent +=  (UINT)n;
+                driver_ptr -> nx_linux_driver_tx_packets +=  (ULONG)n;
+            }
+            else if ((n < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            else
+            {
+
+                /* Drop the frame that can't be sent.  */
+                driver_ptr -> nx_linux_driver_tx_dropped++;
+                sent++;
+            }
+        }
+    }
+
+    return(NX_NULL);
+}
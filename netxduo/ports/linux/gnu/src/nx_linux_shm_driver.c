@@ -0,0 +1,769 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Linux Shared Memory Driver                                          */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+
+/* Include necessary system files.  */
+
+#include "nx_api.h"
+#include "tx_thread.h"
+#include "nx_linux_shm_driver.h"
+#include "nx_linux_shm_ring.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/* Define the Ethernet frame format, see nx_ram_network_driver.c.  */
+
+#define NX_ETHERNET_IP   0x0800
+#define NX_ETHERNET_ARP  0x0806
+#define NX_ETHERNET_RARP 0x8035
+#define NX_ETHERNET_IPV6 0x86DD
+#define NX_ETHERNET_SIZE 14
+
+
+/* The received frame is placed 2 bytes after the start of the packet, so that
+   the IP header behind the Ethernet header is 32-bit aligned.  */
+
+#define NX_LINUX_SHM_RX_OFFSET      2
+
+
+/* Define how long the receive thread sleeps before it checks the stop flag.  */
+
+#define NX_LINUX_SHM_WAIT_NS        100000000L
+
+
+/* Define how many times a thread yields the host CPU while the transmit ring
+   is full.  */
+
+#define NX_LINUX_SHM_TX_RETRY       1000
+
+
+/* Define the driver instance. The transmit ring is protected by TX_DISABLE,
+   it has a single producer.  */
+
+typedef struct NX_LINUX_SHM_INSTANCE_STRUCT
+{
+    UINT                  nx_linux_shm_opened;
+
+    UINT                  nx_linux_shm_in_use;
+
+    NX_LINUX_SHM_SEGMENT *nx_linux_shm_segment;
+
+    NX_LINUX_SHM_RING    *nx_linux_shm_tx_ring;
+
+    NX_LINUX_SHM_RING    *nx_linux_shm_rx_ring;
+
+    NX_INTERFACE         *nx_linux_shm_interface_ptr;
+
+    NX_IP                *nx_linux_shm_ip_ptr;
+
+    ULONG                 nx_linux_shm_mac_msw;
+
+    ULONG                 nx_linux_shm_mac_lsw;
+
+    /* Receive host thread.  */
+    pthread_t             nx_linux_shm_rx_thread;
+
+    UINT                  nx_linux_shm_started;
+
+    volatile UINT         nx_linux_shm_stop;
+
+    /* Statistics.  */
+    ULONG                 nx_linux_shm_rx_packets;
+
+    ULONG                 nx_linux_shm_tx_packets;
+
+    ULONG                 nx_linux_shm_rx_dropped;
+
+    ULONG                 nx_linux_shm_tx_dropped;
+
+    ULONG                 nx_linux_shm_alloc_errors;
+} NX_LINUX_SHM_INSTANCE;
+
+
+static NX_LINUX_SHM_INSTANCE nx_linux_shm[NX_LINUX_SHM_MAX_INSTANCES];
+
+
+static VOID  _nx_linux_shm_driver_transmit(NX_LINUX_SHM_INSTANCE *driver_ptr, NX_PACKET *packet_ptr);
+static UINT  _nx_linux_shm_driver_start(NX_LINUX_SHM_INSTANCE *driver_ptr);
+static VOID  _nx_linux_shm_driver_stop(NX_LINUX_SHM_INSTANCE *driver_ptr);
+static VOID *_nx_linux_shm_driver_rx_entry(VOID *arg);
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_shm_driver_open                           Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function maps the shared memory segment of the link to the     */
+/*    driver instance, the segment is created and initialized if it does  */
+/*    not exist. The instance transmits on the ring of its side and       */
+/*    receives on the other one.                                          */
+/*                                                                        */
+/*    The MAC address is derived from the segment name and the side, so   */
+/*    it is unique in the simulation and stable across runs.              */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    instance                              Driver instance               */
+/*    name                                  Segment name in /dev/shm      */
+/*    side                                  Side of the link, 0 or 1      */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    status                                Completion status             */
+/*                                                                        */
+/**************************************************************************/
+UINT  _nx_linux_shm_driver_open(UINT instance, CHAR *name, UINT side)
+{
+
+NX_LINUX_SHM_INSTANCE *driver_ptr;
+NX_LINUX_SHM_SEGMENT  *segment;
+CHAR                   path[256];
+struct stat            st;
+ULONG                  hash =  2166136261UL;
+CHAR                  *name_ptr;
+INT                    fd;
+
+    if ((instance >= NX_LINUX_SHM_MAX_INSTANCES) || (nx_linux_shm[instance].nx_linux_shm_opened) || (side > 1))
+    {
+        return(NX_INVALID_INTERFACE);
+    }
+
+    snprintf(path, sizeof(path), "/%s", name);
+    fd =  shm_open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    /* The lock serializes the initialization with the other processes.  */
+    flock(fd, LOCK_EX);
+    segment =  MAP_FAILED;
+    if ((fstat(fd, &st) == 0) &&
+        ((st.st_size >= (off_t)NX_LINUX_SHM_SEGMENT_SIZE) || (ftruncate(fd, (off_t)NX_LINUX_SHM_SEGMENT_SIZE) == 0)))
+    {
+        segment =  mmap(NX_NULL, NX_LINUX_SHM_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if ((segment != MAP_FAILED) && (!_nx_linux_shm_segment_valid(segment)))
+    {
+        _nx_linux_shm_segment_initialize(segment);
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+
+    if (segment == MAP_FAILED)
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    driver_ptr =  &nx_linux_shm[instance];
+    memset(driver_ptr, 0, sizeof(NX_LINUX_SHM_INSTANCE));
+    driver_ptr -> nx_linux_shm_segment =  segment;
+    driver_ptr -> nx_linux_shm_tx_ring =  &segment -> nx_linux_shm_segment_ring[side];
+    driver_ptr -> nx_linux_shm_rx_ring =  &segment -> nx_linux_shm_segment_ring[side ^ 1];
+
+    /* Locally administered unicast address 02:hh:hh:hh:hh:0s from the FNV-1a
+       hash of the name.  */
+    for (name_ptr = name; *name_ptr; name_ptr++)
+    {
+        hash =  ((hash ^ (UCHAR)*name_ptr) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    driver_ptr -> nx_linux_shm_mac_msw =  0x0200 | (hash >> 24);
+    driver_ptr -> nx_linux_shm_mac_lsw =  ((hash << 8) & 0xFFFFFF00UL) | side;
+    driver_ptr -> nx_linux_shm_opened =  NX_TRUE;
+
+    return(NX_SUCCESS);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_shm_driver                                Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is the Ethernet driver entry of the shared memory     */
+/*    link. The requests are handled like nx_ram_network_driver.c, the    */
+/*    frames are copied to the transmit ring at once.                     */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    driver_req_ptr                        Pointer to driver request     */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLS                                                                 */
+/*                                                                        */
+/*    _nx_linux_shm_driver_transmit         Copy packet to the ring       */
+/*    _nx_linux_shm_driver_start            Start host thread             */
+/*    _nx_linux_shm_driver_stop             Stop host thread              */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    NetX IP processing                                                  */
+/*                                                                        */
+/**************************************************************************/
+VOID  _nx_linux_shm_driver(NX_IP_DRIVER *driver_req_ptr)
+{
+
+UINT                   i = 0;
+NX_IP                 *ip_ptr;
+NX_PACKET             *packet_ptr;
+ULONG                 *ethernet_frame_ptr;
+NX_INTERFACE          *interface_ptr;
+UINT                   interface_index;
+NX_LINUX_SHM_INSTANCE *driver_ptr = NX_NULL;
+
+    /* Setup the IP pointer from the driver request.  */
+    ip_ptr =  driver_req_ptr -> nx_ip_driver_ptr;
+
+    /* Default to successful return.  */
+    driver_req_ptr -> nx_ip_driver_status =  NX_SUCCESS;
+
+    /* Setup interface pointer.  */
+    interface_ptr =  driver_req_ptr -> nx_ip_driver_interface;
+    interface_index =  interface_ptr -> nx_interface_index;
+
+    /* Find out the driver instance if the driver command is not ATTACH.  */
+    if (driver_req_ptr -> nx_ip_driver_command != NX_LINK_INTERFACE_ATTACH)
+    {
+        for (i = 0; i < NX_LINUX_SHM_MAX_INSTANCES; i++)
+        {
+            if ((nx_linux_shm[i].nx_linux_shm_in_use) &&
+                (nx_linux_shm[i].nx_linux_shm_ip_ptr == ip_ptr) &&
+                (nx_linux_shm[i].nx_linux_shm_interface_ptr == interface_ptr))
+            {
+                break;
+            }
+        }
+
+        if (i == NX_LINUX_SHM_MAX_INSTANCES)
+        {
+
+            /* The packet must be released even if the interface is unknown.  */
+            if ((driver_req_ptr -> nx_ip_driver_command == NX_LINK_PACKET_SEND) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_PACKET_BROADCAST) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_SEND) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_RESPONSE_SEND) ||
+                (driver_req_ptr -> nx_ip_driver_command == NX_LINK_RARP_SEND))
+            {
+                nx_packet_transmit_release(driver_req_ptr -> nx_ip_driver_packet);
+            }
+
+            driver_req_ptr -> nx_ip_driver_status =  NX_INVALID_INTERFACE;
+            return;
+        }
+
+        driver_ptr =  &nx_linux_shm[i];
+    }
+
+    switch (driver_req_ptr -> nx_ip_driver_command)
+    {
+
+    case NX_LINK_INTERFACE_ATTACH:
+    {
+
+        /* Bind the interface to the first opened instance.  */
+        for (i = 0; i < NX_LINUX_SHM_MAX_INSTANCES; i++)
+        {
+            if ((nx_linux_shm[i].nx_linux_shm_opened) && (nx_linux_shm[i].nx_linux_shm_in_use == 0))
+            {
+                break;
+            }
+        }
+
+        if (i < NX_LINUX_SHM_MAX_INSTANCES)
+        {
+            nx_linux_shm[i].nx_linux_shm_in_use =  NX_TRUE;
+            nx_linux_shm[i].nx_linux_shm_interface_ptr =  interface_ptr;
+            nx_linux_shm[i].nx_linux_shm_ip_ptr =  ip_ptr;
+        }
+        else
+        {
+            driver_req_ptr -> nx_ip_driver_status =  NX_INVALID_INTERFACE;
+        }
+
+        break;
+    }
+
+    case NX_LINK_INITIALIZE:
+    {
+
+        nx_ip_interface_mtu_set(ip_ptr, interface_index, NX_LINUX_SHM_IP_MTU);
+        nx_ip_interface_physical_address_set(ip_ptr, interface_index,
+                                             driver_ptr -> nx_linux_shm_mac_msw,
+                                             driver_ptr -> nx_linux_shm_mac_lsw, NX_FALSE);
+        nx_ip_interface_address_mapping_configure(ip_ptr, interface_index, NX_TRUE);
+
+        /* Start the host thread, the frames are dropped until the link is enabled.  */
+        if (_nx_linux_shm_driver_start(driver_ptr))
+        {
+            driver_req_ptr -> nx_ip_driver_status =  NX_NOT_SUCCESSFUL;
+        }
+
+        break;
+    }
+
+    case NX_LINK_INTERFACE_DETACH:
+    case NX_LINK_UNINITIALIZE:
+    {
+
+        interface_ptr -> nx_interface_link_up =  NX_FALSE;
+        _nx_linux_shm_driver_stop(driver_ptr);
+        break;
+    }
+
+    case NX_LINK_ENABLE:
+    {
+
+        interface_ptr -> nx_interface_link_up =  NX_TRUE;
+        break;
+    }
+
+    case NX_LINK_DISABLE:
+    {
+
+        interface_ptr -> nx_interface_link_up =  NX_FALSE;
+        break;
+    }
+
+    case NX_LINK_PACKET_SEND:
+    case NX_LINK_PACKET_BROADCAST:
+    case NX_LINK_ARP_SEND:
+    case NX_LINK_ARP_RESPONSE_SEND:
+    case NX_LINK_RARP_SEND:
+    {
+
+        /* Place the ethernet frame at the front of the packet.  */
+        packet_ptr =  driver_req_ptr -> nx_ip_driver_packet;
+        packet_ptr -> nx_packet_prepend_ptr =  packet_ptr -> nx_packet_prepend_ptr - NX_ETHERNET_SIZE;
+        packet_ptr -> nx_packet_length =  packet_ptr -> nx_packet_length + NX_ETHERNET_SIZE;
+
+        /* Setup the ethernet frame pointer to build the ethernet frame.  Backup another 2
+           bytes to get 32-bit word alignment.  */
+        /*lint -e{927} -e{826} suppress cast of pointer to pointer, since it is necessary  */
+        ethernet_frame_ptr =  (ULONG *)(packet_ptr -> nx_packet_prepend_ptr - 2);
+
+        /* Build the ethernet frame.  */
+        *ethernet_frame_ptr       =  driver_req_ptr -> nx_ip_driver_physical_address_msw;
+        *(ethernet_frame_ptr + 1) =  driver_req_ptr -> nx_ip_driver_physical_address_lsw;
+        *(ethernet_frame_ptr + 2) =  (interface_ptr -> nx_interface_physical_address_msw << 16) |
+            (interface_ptr -> nx_interface_physical_address_lsw >> 16);
+        *(ethernet_frame_ptr + 3) =  (interface_ptr -> nx_interface_physical_address_lsw << 16);
+
+        if ((driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_SEND) ||
+            (driver_req_ptr -> nx_ip_driver_command == NX_LINK_ARP_RESPONSE_SEND))
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_ARP;
+        }
+        else if (driver_req_ptr -> nx_ip_driver_command == NX_LINK_RARP_SEND)
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_RARP;
+        }
+        else if (packet_ptr -> nx_packet_ip_version == 4)
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_IP;
+        }
+        else
+        {
+            *(ethernet_frame_ptr + 3) |= NX_ETHERNET_IPV6;
+        }
+
+        /* Endian swapping if NX_LITTLE_ENDIAN is defined.  */
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr));
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr + 1));
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr + 2));
+        NX_CHANGE_ULONG_ENDIAN(*(ethernet_frame_ptr + 3));
+
+        _nx_linux_shm_driver_transmit(driver_ptr, packet_ptr);
+        break;
+    }
+
+    case NX_LINK_MULTICAST_JOIN:
+    case NX_LINK_MULTICAST_LEAVE:
+    {
+
+        /* All the multicast frames are accepted.  */
+        break;
+    }
+
+    case NX_LINK_GET_STATUS:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  interface_ptr -> nx_interface_link_up;
+        break;
+    }
+
+    case NX_LINK_GET_SPEED:
+    case NX_LINK_GET_DUPLEX_TYPE:
+    {
+
+        /* Unsupported feature.  */
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  0;
+        break;
+    }
+
+    case NX_LINK_GET_ERROR_COUNT:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_shm_rx_dropped +
+                                                        driver_ptr -> nx_linux_shm_tx_dropped;
+        break;
+    }
+
+    case NX_LINK_GET_RX_COUNT:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_shm_rx_packets;
+        break;
+    }
+
+    case NX_LINK_GET_TX_COUNT:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_shm_tx_packets;
+        break;
+    }
+
+    case NX_LINK_GET_ALLOC_ERRORS:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  driver_ptr -> nx_linux_shm_alloc_errors;
+        break;
+    }
+
+    case NX_LINK_GET_INTERFACE_TYPE:
+    {
+
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  NX_INTERFACE_TYPE_ETHERNET;
+        break;
+    }
+
+    case NX_LINK_DEFERRED_PROCESSING:
+    {
+
+        /* The frames are received by the host thread.  */
+        break;
+    }
+
+    case NX_LINK_SET_PHYSICAL_ADDRESS:
+    {
+
+        driver_ptr -> nx_linux_shm_mac_msw =  driver_req_ptr -> nx_ip_driver_physical_address_msw;
+        driver_ptr -> nx_linux_shm_mac_lsw =  driver_req_ptr -> nx_ip_driver_physical_address_lsw;
+        break;
+    }
+
+#ifdef NX_ENABLE_INTERFACE_CAPABILITY
+    case NX_INTERFACE_CAPABILITY_GET:
+    {
+
+        /* No hardware offload.  */
+        *(driver_req_ptr -> nx_ip_driver_return_ptr) =  0;
+        break;
+    }
+
+    case NX_INTERFACE_CAPABILITY_SET:
+    {
+
+        break;
+    }
+#endif /* NX_ENABLE_INTERFACE_CAPABILITY  */
+
+    default:
+
+        /* Return the unhandled command status.  */
+        driver_req_ptr -> nx_ip_driver_status =  NX_UNHANDLED_COMMAND;
+        break;
+    }
+}
+
+
+/* Copy the frame to the transmit ring and release the packet. A thread waits
+   a while for the consumer if the ring is full, then the frame is dropped like
+   on a NIC without free descriptors.  */
+
+static VOID  _nx_linux_shm_driver_transmit(NX_LINUX_SHM_INSTANCE *driver_ptr, NX_PACKET *packet_ptr)
+{
+
+TX_INTERRUPT_SAVE_AREA
+NX_LINUX_SHM_SLOT *slot;
+NX_PACKET         *current_ptr;
+UCHAR             *data_ptr;
+uint32_t           index;
+uint32_t           count;
+ULONG              size;
+UINT               retry =  0;
+
+    for (;;)
+    {
+        TX_DISABLE
+
+        count =  0;
+        if ((driver_ptr -> nx_linux_shm_started) && (packet_ptr -> nx_packet_length <= NX_LINUX_SHM_FRAME_MAX))
+        {
+            count =  _nx_linux_shm_ring_enqueue_start(driver_ptr -> nx_linux_shm_tx_ring, 1, &index);
+        }
+
+        /* The host CPU is yielded outside of the critical section, so that the
+           receive thread of a peer in this process can run.  */
+        if ((count) || (!driver_ptr -> nx_linux_shm_started) ||
+            (packet_ptr -> nx_packet_length > NX_LINUX_SHM_FRAME_MAX) ||
+            (TX_THREAD_GET_SYSTEM_STATE() != 0) || (retry++ >= NX_LINUX_SHM_TX_RETRY))
+        {
+            break;
+        }
+
+        TX_RESTORE
+        sched_yield();
+    }
+
+    if (count == 0)
+    {
+        driver_ptr -> nx_linux_shm_tx_dropped++;
+    }
+    else
+    {
+        slot =  _nx_linux_shm_ring_slot(driver_ptr -> nx_linux_shm_tx_ring, index);
+        data_ptr =  slot -> nx_linux_shm_slot_data;
+        for (current_ptr = packet_ptr; current_ptr; current_ptr = current_ptr -> nx_packet_next)
+        {
+            size =  (ULONG)(current_ptr -> nx_packet_append_ptr - current_ptr -> nx_packet_prepend_ptr);
+            memcpy(data_ptr, current_ptr -> nx_packet_prepend_ptr, size); /* Use case of memcpy is verified. */
+            data_ptr +=  size;
+        }
+        slot -> nx_linux_shm_slot_length =  packet_ptr -> nx_packet_length;
+        _nx_linux_shm_ring_enqueue_finish(driver_ptr -> nx_linux_shm_tx_ring, 1);
+        driver_ptr -> nx_linux_shm_tx_packets++;
+    }
+
+    TX_RESTORE
+
+    /* Remove the Ethernet header and release the packet.  */
+    packet_ptr -> nx_packet_prepend_ptr =  packet_ptr -> nx_packet_prepend_ptr + NX_ETHERNET_SIZE;
+    packet_ptr -> nx_packet_length =  packet_ptr -> nx_packet_length - NX_ETHERNET_SIZE;
+    nx_packet_transmit_release(packet_ptr);
+}
+
+
+static UINT  _nx_linux_shm_driver_start(NX_LINUX_SHM_INSTANCE *driver_ptr)
+{
+
+    if (driver_ptr -> nx_linux_shm_started)
+    {
+        return(NX_SUCCESS);
+    }
+
+    driver_ptr -> nx_linux_shm_stop =  NX_FALSE;
+    if (pthread_create(&driver_ptr -> nx_linux_shm_rx_thread, NX_NULL,
+                       _nx_linux_shm_driver_rx_entry, driver_ptr))
+    {
+        return(NX_NOT_SUCCESSFUL);
+    }
+
+    driver_ptr -> nx_linux_shm_started =  NX_TRUE;
+    return(NX_SUCCESS);
+}
+
+
+/* Stop the host thread and unmap the segment.  */
+
+static VOID  _nx_linux_shm_driver_stop(NX_LINUX_SHM_INSTANCE *driver_ptr)
+{
+
+TX_INTERRUPT_SAVE_AREA
+
+    if (driver_ptr -> nx_linux_shm_started)
+    {
+        TX_DISABLE
+        driver_ptr -> nx_linux_shm_started =  NX_FALSE;
+        driver_ptr -> nx_linux_shm_stop =  NX_TRUE;
+        TX_RESTORE
+
+        /* The thread checks the stop flag at least every NX_LINUX_SHM_WAIT_NS.  */
+        pthread_join(driver_ptr -> nx_linux_shm_rx_thread, NX_NULL);
+    }
+
+    munmap(driver_ptr -> nx_linux_shm_segment, NX_LINUX_SHM_SEGMENT_SIZE);
+    memset(driver_ptr, 0, sizeof(NX_LINUX_SHM_INSTANCE));
+}
+
+
+/* Deliver one received frame to the IP instance, it is called in the
+   simulated interrupt context. Return NX_FALSE if the packet is not consumed.  */
+
+static UINT  _nx_linux_shm_driver_receive(NX_LINUX_SHM_INSTANCE *driver_ptr, NX_PACKET *packet_ptr, UINT length)
+{
+
+UCHAR  *frame_ptr;
+NX_IP  *ip_ptr =  driver_ptr -> nx_linux_shm_ip_ptr;
+ULONG   destination_address_msw;
+ULONG   destination_address_lsw;
+UINT    packet_type;
+
+    frame_ptr =  packet_ptr -> nx_packet_data_start + NX_LINUX_SHM_RX_OFFSET;
+
+    /* Accept the frame to this interface, and broadcast and multicast frames.  */
+    destination_address_msw =  ((ULONG)frame_ptr[0] << 8) | (ULONG)frame_ptr[1];
+    destination_address_lsw =  ((ULONG)frame_ptr[2] << 24) | ((ULONG)frame_ptr[3] << 16) |
+                               ((ULONG)frame_ptr[4] << 8) | (ULONG)frame_ptr[5];
+    if (((frame_ptr[0] & 1) == 0) &&
+        ((destination_address_msw != driver_ptr -> nx_linux_shm_mac_msw) ||
+         (destination_address_lsw != driver_ptr -> nx_linux_shm_mac_lsw)))
+    {
+        return(NX_FALSE);
+    }
+
+    packet_type =  ((UINT)frame_ptr[12] << 8) | (UINT)frame_ptr[13];
+
+    /* Clean off the Ethernet header.  */
+    packet_ptr -> nx_packet_prepend_ptr =  frame_ptr + NX_ETHERNET_SIZE;
+    packet_ptr -> nx_packet_append_ptr =  frame_ptr + length;
+    packet_ptr -> nx_packet_length =  length - NX_ETHERNET_SIZE;
+    packet_ptr -> nx_packet_address.nx_packet_interface_ptr =  driver_ptr -> nx_linux_shm_interface_ptr;
+
+    if ((packet_type == NX_ETHERNET_IP) || (packet_type == NX_ETHERNET_IPV6))
+    {
+        _nx_ip_packet_deferred_receive(ip_ptr, packet_ptr);
+    }
+#ifndef NX_DISABLE_IPV4
+    else if (packet_type == NX_ETHERNET_ARP)
+    {
+        _nx_arp_packet_deferred_receive(ip_ptr, packet_ptr);
+    }
+    else if (packet_type == NX_ETHERNET_RARP)
+    {
+        _nx_rarp_packet_deferred_receive(ip_ptr, packet_ptr);
+    }
+#endif /* !NX_DISABLE_IPV4  */
+    else
+    {
+        driver_ptr -> nx_linux_shm_rx_dropped++;
+        return(NX_FALSE);
+    }
+
+    driver_ptr -> nx_linux_shm_rx_packets++;
+    return(NX_TRUE);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _nx_linux_shm_driver_rx_entry                       Linux/GNU       */
+/*                                                           6.1          */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function is the receive host thread. The filled slots of the   */
+/*    receive ring are peeked in place, and each frame is copied once     */
+/*    into a packet of the default pool. A batch is delivered in one      */
+/*    simulated interrupt, then the slots are returned to the producer.   */
+/*                                                                        */
+/**************************************************************************/
+static VOID  *_nx_linux_shm_driver_rx_entry(VOID *arg)
+{
+
+NX_LINUX_SHM_INSTANCE *driver_ptr =  (NX_LINUX_SHM_INSTANCE *)arg;
+NX_LINUX_SHM_RING     *ring_ptr =  driver_ptr -> nx_linux_shm_rx_ring;
+NX_PACKET_POOL        *pool_ptr =  driver_ptr -> nx_linux_shm_ip_ptr -> nx_ip_default_packet_pool;
+NX_LINUX_SHM_SLOT     *slot;
+NX_PACKET             *packet_ptr;
+uint32_t               index;
+uint32_t               count;
+uint32_t               i;
+ULONG                  length;
+
+    while (!driver_ptr -> nx_linux_shm_stop)
+    {
+
+        count =  _nx_linux_shm_ring_dequeue_start(ring_ptr, NX_LINUX_SHM_BATCH, &index);
+        if (count == 0)
+        {
+            _nx_linux_shm_ring_wait(ring_ptr, NX_LINUX_SHM_WAIT_NS);
+            continue;
+        }
+
+        /* Enter ThreadX like an interrupt.  */
+        _tx_thread_context_save();
+
+        for (i = 0; i < count; i++)
+        {
+            slot =  _nx_linux_shm_ring_slot(ring_ptr, index + i);
+            length =  slot -> nx_linux_shm_slot_length;
+            if ((length < NX_ETHERNET_SIZE) ||
+                (driver_ptr -> nx_linux_shm_interface_ptr -> nx_interface_link_up == NX_FALSE))
+            {
+                driver_ptr -> nx_linux_shm_rx_dropped++;
+                continue;
+            }
+
+            if (nx_packet_allocate(pool_ptr, &packet_ptr, NX_RECEIVE_PACKET, NX_NO_WAIT))
+            {
+                driver_ptr -> nx_linux_shm_alloc_errors++;
+                continue;
+            }
+
+            if (length + NX_LINUX_SHM_RX_OFFSET > (ULONG)(packet_ptr -> nx_packet_data_end - packet_ptr -> nx_packet_data_start))
+            {
+                driver_ptr -> nx_linux_shm_rx_dropped++;
+                nx_packet_release(packet_ptr);
+                continue;
+            }
+
+            memcpy(packet_ptr -> nx_packet_data_start + NX_LINUX_SHM_RX_OFFSET,  /* Use case of memcpy is verified. */
+                   slot -> nx_linux_shm_slot_data, length);
+            if (!_nx_linux_shm_driver_receive(driver_ptr, packet_ptr, (UINT)length))
+            {
+                nx_packet_release(packet_ptr);
+            }
+        }
+
+        _tx_thread_context_restore();
+
+        _nx_linux_shm_ring_dequeue_finish(ring_ptr, count);
+    }
+
+    return(NX_NULL);
+}
@@ -0,0 +1,400 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** NetX Component                                                        */
+/**                                                                       */
+/**   Linux Shared Memory Switch                                          */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+/* Host process that connects the nodes of nx_linux_shm_driver.c. Each
+   argument is the segment name of a port, the node opens the segment as
+   side 0 and the switch as side 1:
+
+     nx_linux_shm_switch.elf node0 node1 node2
+
+   The stale segments are removed at start. The source addresses are learned,
+   frames to broadcast, multicast and unknown addresses are flooded to all
+   the other ports. A unicast frame stays in the input ring while the ring of
+   the output port is full, like a link paused by flow control, and a flooded
+   frame is dropped on the full ports.
+
+   The switch sleeps on the futexes of all the input rings at once with
+   futex_waitv (Linux 5.16), so a node wakes it the same way as the receive
+   thread of the driver. The consumer of an output ring doesn't wake anyone,
+   so while a frame waits for a full output ring the switch sleeps for
+   SWITCH_BLOCKED_NS at a time.
+
+   The threads of a ThreadX process are SCHED_FIFO when it is allowed, and a
+   node that yields the CPU while its transmit ring is full would never let
+   a normal process run. The switch takes the SCHED_FIFO priority of the
+   simulated interrupts (TX_LINUX_PRIORITY_ISR) when it can, like the DMA
+   engine of a NIC. For the same reason it must never spin on a full ring.  */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "nx_linux_shm_ring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+
+#define SWITCH_MAX_PORTS        32
+#define SWITCH_TABLE_SIZE       256     /* Must be a power of 2.  */
+#define SWITCH_BATCH            32
+#define SWITCH_PRIORITY         2       /* TX_LINUX_PRIORITY_ISR  */
+#define SWITCH_WAIT_NS          100000000L
+#define SWITCH_BLOCKED_NS       50000L
+
+
+typedef struct SWITCH_PORT_STRUCT
+{
+    NX_LINUX_SHM_SEGMENT   *segment;
+    NX_LINUX_SHM_RING      *rx_ring;
+    NX_LINUX_SHM_RING      *tx_ring;
+    unsigned long           rx_frames;
+    unsigned long           tx_frames;
+    unsigned long           tx_dropped;
+    uint32_t                tx_pending;
+    int                     blocked;
+} SWITCH_PORT;
+
+
+typedef struct SWITCH_ENTRY_STRUCT
+{
+    uint8_t                 mac[6];
+    uint8_t                 valid;
+    uint8_t                 port;
+} SWITCH_ENTRY;
+
+
+static SWITCH_PORT      switch_port[SWITCH_MAX_PORTS];
+static SWITCH_ENTRY     switch_table[SWITCH_TABLE_SIZE];
+static unsigned int     switch_ports;
+static volatile int     switch_stop;
+
+
+static void  switch_signal(int sig)
+{
+    (void)sig;
+    switch_stop =  1;
+}
+
+
+static uint32_t  switch_hash(const uint8_t *mac)
+{
+
+uint32_t hash =  2166136261UL;
+int      i;
+
+    for (i = 0; i < 6; i++)
+    {
+        hash =  (hash ^ mac[i]) * 16777619UL;
+    }
+    return(hash & (SWITCH_TABLE_SIZE - 1));
+}
+
+
+/* Learn the source address, return the port of the destination address or
+   -1 to flood the frame.  */
+
+static int  switch_lookup(const uint8_t *frame, unsigned int port)
+{
+
+SWITCH_ENTRY *entry;
+
+    if ((frame[6] & 1) == 0)
+    {
+        entry =  &switch_table[switch_hash(frame + 6)];
+        if ((!entry -> valid) || (entry -> port != port) || (memcmp(entry -> mac, frame + 6, 6)))
+        {
+            memcpy(entry -> mac, frame + 6, 6);
+            entry -> port =  (uint8_t)port;
+            entry -> valid =  1;
+        }
+    }
+
+    if (frame[0] & 1)
+    {
+        return(-1);
+    }
+
+    entry =  &switch_table[switch_hash(frame)];
+    if ((entry -> valid) && (memcmp(entry -> mac, frame, 6) == 0))
+    {
+        return(entry -> port);
+    }
+
+    return(-1);
+}
+
+
+/* Copy the frame to the output port, return 0 if the ring is full. The
+   frame is published by switch_flush.  */
+
+static int  switch_output(unsigned int port, NX_LINUX_SHM_SLOT *slot)
+{
+
+NX_LINUX_SHM_SLOT *out;
+uint32_t           pending =  switch_port[port].tx_pending;
+uint32_t           index;
+
+    if (_nx_linux_shm_ring_enqueue_start(switch_port[port].tx_ring, pending + 1, &index) <= pending)
+    {
+        return(0);
+    }
+
+    out =  _nx_linux_shm_ring_slot(switch_port[port].tx_ring, index + pending);
+    memcpy(out -> nx_linux_shm_slot_data, slot -> nx_linux_shm_slot_data, slot -> nx_linux_shm_slot_length);
+    out -> nx_linux_shm_slot_length =  slot -> nx_linux_shm_slot_length;
+    switch_port[port].tx_pending =  pending + 1;
+    return(1);
+}
+
+
+/* Publish the frames copied to the output rings, a sleeping consumer is
+   woken once for the batch.  */
+
+static void  switch_flush(void)
+{
+
+unsigned int port;
+
+    for (port = 0; port < switch_ports; port++)
+    {
+        if (switch_port[port].tx_pending)
+        {
+            _nx_linux_shm_ring_enqueue_finish(switch_port[port].tx_ring, switch_port[port].tx_pending);
+            switch_port[port].tx_frames +=  switch_port[port].tx_pending;
+            switch_port[port].tx_pending =  0;
+        }
+    }
+}
+
+
+/* Forward up to SWITCH_BATCH frames of the port, return the number of frames.  */
+
+static uint32_t  switch_forward(unsigned int port)
+{
+
+NX_LINUX_SHM_RING *ring =  switch_port[port].rx_ring;
+NX_LINUX_SHM_SLOT *slot;
+uint32_t           index;
+uint32_t           count;
+uint32_t           i;
+unsigned int       j;
+int                destination;
+
+    switch_port[port].blocked =  0;
+    count =  _nx_linux_shm_ring_dequeue_start(ring, SWITCH_BATCH, &index);
+    for (i = 0; i < count; i++)
+    {
+        slot =  _nx_linux_shm_ring_slot(ring, index + i);
+        if ((slot -> nx_linux_shm_slot_length < 14) || (slot -> nx_linux_shm_slot_length > NX_LINUX_SHM_FRAME_MAX))
+        {
+            continue;
+        }
+
+        destination =  switch_lookup(slot -> nx_linux_shm_slot_data, port);
+        if (destination >= 0)
+        {
+            if (((unsigned int)destination != port) && (!switch_output((unsigned int)destination, slot)))
+            {
+                switch_port[port].blocked =  1;
+                break;
+            }
+            continue;
+        }
+
+        for (j = 0; j < switch_ports; j++)
+        {
+            if ((j != port) && (!switch_output(j, slot)))
+            {
+                switch_port[j].tx_dropped++;
+            }
+        }
+    }
+
+    if (i)
+    {
+        _nx_linux_shm_ring_dequeue_finish(ring, i);
+        switch_port[port].rx_frames +=  i;
+    }
+
+    return(i);
+}
+
+
+/* Sleep until a frame arrives on a port, or for timeout_ns at most. The
+   blocked ports already hold frames, they only wake the switch for new ones.  */
+
+static void  switch_wait(long timeout_ns)
+{
+
+#ifdef SYS_futex_waitv
+struct futex_waitv  waiter[SWITCH_MAX_PORTS];
+NX_LINUX_SHM_RING  *ring;
+unsigned int        port;
+#endif
+struct timespec     ts;
+
+#ifdef SYS_futex_waitv
+    for (port = 0; port < switch_ports; port++)
+    {
+        __atomic_store_n(&switch_port[port].rx_ring -> nx_linux_shm_ring_waiting, 1, __ATOMIC_RELAXED);
+    }
+
+    /* Pairs with the fence of _nx_linux_shm_ring_enqueue_finish.  */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for (port = 0; port < switch_ports; port++)
+    {
+        ring =  switch_port[port].rx_ring;
+        waiter[port].val =  ring -> nx_linux_shm_ring_tail;
+        if (switch_port[port].blocked)
+        {
+            waiter[port].val =  __atomic_load_n(&ring -> nx_linux_shm_ring_head, __ATOMIC_RELAXED);
+        }
+        else if (__atomic_load_n(&ring -> nx_linux_shm_ring_head, __ATOMIC_RELAXED) != waiter[port].val)
+        {
+            return;
+        }
+        waiter[port].uaddr =  (uintptr_t)&ring -> nx_linux_shm_ring_head;
+        waiter[port].flags =  FUTEX_32;
+        waiter[port].__reserved =  0;
+    }
+
+    /* The timeout of futex_waitv is absolute.  */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_nsec +=  timeout_ns;
+    ts.tv_sec +=  ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %=  1000000000L;
+    if ((syscall(SYS_futex_waitv, waiter, switch_ports, 0, &ts, CLOCK_MONOTONIC) == 0) || (errno != ENOSYS))
+    {
+        return;
+    }
+#endif
+
+    /* No futex_waitv, poll the ports.  */
+    ts.tv_sec =  0;
+    ts.tv_nsec =  (timeout_ns < SWITCH_BLOCKED_NS) ? timeout_ns : SWITCH_BLOCKED_NS;
+    nanosleep(&ts, NULL);
+}
+
+
+static int  switch_attach(unsigned int port, const char *name)
+{
+
+NX_LINUX_SHM_SEGMENT *segment;
+char                  path[256];
+int                   fd;
+
+    snprintf(path, sizeof(path), "/%s", name);
+    shm_unlink(path);
+    fd =  shm_open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return(-1);
+    }
+
+    if (ftruncate(fd, (off_t)NX_LINUX_SHM_SEGMENT_SIZE))
+    {
+        close(fd);
+        return(-1);
+    }
+
+    segment =  mmap(NULL, NX_LINUX_SHM_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED)
+    {
+        return(-1);
+    }
+
+    _nx_linux_shm_segment_initialize(segment);
+    switch_port[port].segment =  segment;
+    switch_port[port].rx_ring =  &segment -> nx_linux_shm_segment_ring[0];
+    switch_port[port].tx_ring =  &segment -> nx_linux_shm_segment_ring[1];
+    return(0);
+}
+
+
+int main(int argc, char **argv)
+{
+
+struct sched_param sp;
+char            path[256];
+unsigned int    port;
+uint32_t        count;
+int             blocked;
+
+    if ((argc < 2) || (argc - 1 > SWITCH_MAX_PORTS))
+    {
+        fprintf(stderr, "usage: %s name... (up to %d ports)\n", argv[0], SWITCH_MAX_PORTS);
+        return(1);
+    }
+
+    for (port = 0; port < (unsigned int)argc - 1; port++)
+    {
+        if (switch_attach(port, argv[port + 1]))
+        {
+            fprintf(stderr, "can't create segment %s\n", argv[port + 1]);
+            return(1);
+        }
+    }
+    switch_ports =  (unsigned int)argc - 1;
+
+    signal(SIGINT, switch_signal);
+    signal(SIGTERM, switch_signal);
+
+    /* Run like a simulated interrupt, this fails without the privilege.  */
+    sp.sched_priority =  SWITCH_PRIORITY;
+    sched_setscheduler(0, SCHED_FIFO, &sp);
+
+    /* Forward until no input ring moves, then sleep.  */
+    while (!switch_stop)
+    {
+        count =  0;
+        blocked =  0;
+        for (port = 0; port < switch_ports; port++)
+        {
+            count +=  switch_forward(port);
+            blocked |=  switch_port[port].blocked;
+        }
+        switch_flush();
+
+        if (count == 0)
+        {
+            switch_wait(blocked ? SWITCH_BLOCKED_NS : SWITCH_WAIT_NS);
+        }
+    }
+
+    for (port = 0; port < switch_ports; port++)
+    {
+        printf("%s: rx %lu, tx %lu, dropped %lu\n", argv[port + 1], switch_port[port].rx_frames,
+               switch_port[port].tx_frames, switch_port[port].tx_dropped);
+        munmap(switch_port[port].segment, NX_LINUX_SHM_SEGMENT_SIZE);
+        snprintf(path, sizeof(path), "/%s", argv[port + 1]);
+        shm_unlink(path);
+    }
+
+    return(0);
+}
@@ -0,0 +1,283 @@
+/* Packet rate benchmark for the NetX Duo Linux shared memory driver.
+
+   Two IP instances are connected by the ring pair of a /dev/shm segment, see
+   nx_linux_shm_driver.c. With the "switch" argument the instances are connected
+   through the ports bench0 and bench1 of the host switch instead, which must be
+   started first:
+
+     nx_linux_shm_switch.elf bench0 bench1 &
+     nx_linux_shm_benchmark.elf switch
+
+   The phases are:
+     1. UDP flood of small datagrams from ip_0 to ip_1, reports the sent and received
+        packet rate.
+     2. TCP bulk transfer from ip_0 to ip_1, reports the throughput.
+
+   Build with -DCONFIG_TX_BENCHMARK=1 -DCONFIG_NET=1.  */
+
+#include   "tx_api.h"
+#include   "nx_api.h"
+#include   "nx_linux_shm_driver.h"
+#include   <stdio.h>
+#include   <stdlib.h>
+#include   <string.h>
+#include   <time.h>
+#include   <sys/mman.h>
+
+#define     BENCH_STACK_SIZE        8192
+#define     BENCH_PACKET_SIZE       1536
+#define     BENCH_POOL_PACKETS      1024
+#define     BENCH_POOL_SIZE         ((sizeof(NX_PACKET) + BENCH_PACKET_SIZE) * BENCH_POOL_PACKETS)
+#define     BENCH_UDP_PACKETS       1000000
+#define     BENCH_UDP_PAYLOAD       18
+#define     BENCH_UDP_PORT          5001
+#define     BENCH_TCP_BYTES         (256 * 1024 * 1024)
+#define     BENCH_TCP_PORT          5002
+#ifdef NX_ENABLE_TCP_WINDOW_SCALING
+#define     BENCH_TCP_WINDOW        (512 * 1024)
+#else
+#define     BENCH_TCP_WINDOW        65535
+#endif
+#define     BENCH_TCP_MSS           1460
+#define     BENCH_TCP_QUEUE         (BENCH_TCP_WINDOW / BENCH_TCP_MSS + 8)
+#define     BENCH_SEGMENT           "nx_shm_bench"
+
+
+/* Define the ThreadX and NetX object control blocks...  */
+
+static TX_THREAD        sender_thread;
+static TX_THREAD        receiver_thread;
+static TX_SEMAPHORE     start_semaphore;
+static TX_SEMAPHORE     done_semaphore;
+static NX_PACKET_POOL   pool_0;
+static NX_PACKET_POOL   pool_1;
+static NX_IP            ip_0;
+static NX_IP            ip_1;
+static NX_UDP_SOCKET    udp_0;
+static NX_UDP_SOCKET    udp_1;
+static NX_TCP_SOCKET    tcp_0;
+static NX_TCP_SOCKET    tcp_1;
+
+static ULONG            sender_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            receiver_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ip_0_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ip_1_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            arp_0_cache[256];
+static ULONG            arp_1_cache[256];
+static ULONG            pool_0_area[BENCH_POOL_SIZE / sizeof(ULONG) + 1];
+static ULONG            pool_1_area[BENCH_POOL_SIZE / sizeof(ULONG) + 1];
+static UCHAR            bench_data[BENCH_TCP_MSS];
+
+
+/* Define the benchmark counters...  */
+
+static volatile UINT    udp_sending;
+static ULONG            udp_sent;
+static ULONG            udp_received;
+static ULONG            tcp_received;
+static struct timespec  bench_start;
+static struct timespec  bench_end;
+static int              bench_switch;
+
+
+static double  bench_elapsed_s(struct timespec *start, struct timespec *end)
+{
+    return (double)(end -> tv_sec - start -> tv_sec) + (double)(end -> tv_nsec - start -> tv_nsec) / 1e9;
+}
+
+
+static void  bench_check(UINT status, const char *what)
+{
+    if (status)
+    {
+        printf("%s failed: 0x%x\n", what, status);
+        exit(1);
+    }
+}
+
+
+static void  sender_entry(ULONG input)
+{
+NX_PACKET  *packet_ptr;
+ULONG       i;
+ULONG       sent;
+ULONG       msw;
+ULONG       lsw;
+UINT        status;
+
+    (void)input;
+
+    /* The links are initialized by the IP threads.  */
+    bench_check(nx_ip_interface_status_check(&ip_0, 0, NX_IP_LINK_ENABLED, &i, NX_IP_PERIODIC_RATE), "Link");
+    bench_check(nx_ip_interface_status_check(&ip_1, 0, NX_IP_LINK_ENABLED, &i, NX_IP_PERIODIC_RATE), "Link");
+
+    /* Let the switch learn the addresses, so the flood is not broadcast.  */
+    bench_check(nx_arp_gratuitous_send(&ip_0, NX_NULL), "Gratuitous ARP");
+    bench_check(nx_arp_gratuitous_send(&ip_1, NX_NULL), "Gratuitous ARP");
+
+    /* The addresses are derived from the segment names.  */
+    bench_check(nx_ip_interface_info_get(&ip_0, 0, NX_NULL, NX_NULL, NX_NULL, NX_NULL, &msw, &lsw), "Interface");
+    bench_check(nx_arp_static_entry_create(&ip_1, IP_ADDRESS(10, 0, 0, 1), msw, lsw), "ARP entry");
+    bench_check(nx_ip_interface_info_get(&ip_1, 0, NX_NULL, NX_NULL, NX_NULL, NX_NULL, &msw, &lsw), "Interface");
+    bench_check(nx_arp_static_entry_create(&ip_0, IP_ADDRESS(10, 0, 0, 2), msw, lsw), "ARP entry");
+
+    /* UDP flood.  */
+    bench_check(nx_udp_socket_create(&ip_0, &udp_0, "udp 0", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80, 8), "UDP create");
+    bench_check(nx_udp_socket_bind(&udp_0, BENCH_UDP_PORT, TX_WAIT_FOREVER), "UDP bind");
+    tx_semaphore_get(&start_semaphore, TX_WAIT_FOREVER);
+
+    clock_gettime(CLOCK_MONOTONIC, &bench_start);
+    for (i = 0; i < BENCH_UDP_PACKETS; i++)
+    {
+        if (nx_packet_allocate(&pool_0, &packet_ptr, NX_UDP_PACKET, NX_WAIT_FOREVER))
+        {
+            break;
+        }
+        nx_packet_data_append(packet_ptr, bench_data, BENCH_UDP_PAYLOAD, &pool_0, NX_WAIT_FOREVER);
+        if (nx_udp_socket_send(&udp_0, packet_ptr, IP_ADDRESS(10, 0, 0, 2), BENCH_UDP_PORT))
+        {
+            nx_packet_release(packet_ptr);
+        }
+        else
+        {
+            udp_sent++;
+        }
+    }
+    udp_sending =  NX_FALSE;
+    tx_semaphore_get(&done_semaphore, TX_WAIT_FOREVER);
+
+    printf("UDP %d bytes:    sent %lu, received %lu, %.0f kpps\n", BENCH_UDP_PAYLOAD,
+           (unsigned long)udp_sent, (unsigned long)udp_received, udp_received / bench_elapsed_s(&bench_start, &bench_end) / 1000);
+    nx_ip_driver_direct_command(&ip_0, NX_LINK_GET_ERROR_COUNT, &msw);
+    nx_ip_driver_direct_command(&ip_1, NX_LINK_GET_ALLOC_ERRORS, &lsw);
+    printf("                 link dropped %lu, receive allocation errors %lu\n", (unsigned long)msw, (unsigned long)lsw);
+
+    /* TCP bulk transfer.  */
+    bench_check(nx_tcp_socket_create(&ip_0, &tcp_0, "tcp 0", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80,
+                                     BENCH_TCP_WINDOW, NX_NULL, NX_NULL), "TCP create");
+    bench_check(nx_tcp_socket_transmit_configure(&tcp_0, BENCH_TCP_QUEUE, NX_IP_PERIODIC_RATE, 10, 0), "TCP configure");
+    bench_check(nx_tcp_client_socket_bind(&tcp_0, NX_ANY_PORT, TX_WAIT_FOREVER), "TCP bind");
+    bench_check(nx_tcp_client_socket_connect(&tcp_0, IP_ADDRESS(10, 0, 0, 2), BENCH_TCP_PORT, 5 * NX_IP_PERIODIC_RATE), "TCP connect");
+
+    clock_gettime(CLOCK_MONOTONIC, &bench_start);
+    for (sent = 0; sent < BENCH_TCP_BYTES; sent += BENCH_TCP_MSS)
+    {
+        bench_check(nx_packet_allocate(&pool_0, &packet_ptr, NX_TCP_PACKET, NX_WAIT_FOREVER), "TCP allocate");
+        nx_packet_data_append(packet_ptr, bench_data, BENCH_TCP_MSS, &pool_0, NX_WAIT_FOREVER);
+        status =  nx_tcp_socket_send(&tcp_0, packet_ptr, 5 * NX_IP_PERIODIC_RATE);
+        if (status)
+        {
+            nx_packet_release(packet_ptr);
+            printf("TCP send failed: 0x%x\n", status);
+            break;
+        }
+    }
+    nx_tcp_socket_disconnect(&tcp_0, 5 * NX_IP_PERIODIC_RATE);
+    tx_semaphore_get(&done_semaphore, TX_WAIT_FOREVER);
+
+    printf("TCP bulk:        received %lu bytes, %.1f MB/s\n", (unsigned long)tcp_received,
+           tcp_received / bench_elapsed_s(&bench_start, &bench_end) / 1e6);
+    if (!bench_switch)
+    {
+        shm_unlink("/" BENCH_SEGMENT);
+    }
+    exit(0);
+}
+
+
+static void  receiver_entry(ULONG input)
+{
+NX_PACKET  *packet_ptr;
+ULONG       length;
+
+    (void)input;
+
+    /* UDP flood.  */
+    bench_check(nx_udp_socket_create(&ip_1, &udp_1, "udp 1", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80, BENCH_POOL_PACKETS / 2), "UDP create");
+    bench_check(nx_udp_socket_bind(&udp_1, BENCH_UDP_PORT, TX_WAIT_FOREVER), "UDP bind");
+    tx_semaphore_put(&start_semaphore);
+
+    for (;;)
+    {
+        if (nx_udp_socket_receive(&udp_1, &packet_ptr, NX_IP_PERIODIC_RATE / 10))
+        {
+            if (!udp_sending)
+            {
+                break;
+            }
+            continue;
+        }
+        udp_received++;
+        clock_gettime(CLOCK_MONOTONIC, &bench_end);
+        nx_packet_release(packet_ptr);
+    }
+    tx_semaphore_put(&done_semaphore);
+
+    /* TCP bulk transfer.  */
+    bench_check(nx_tcp_socket_create(&ip_1, &tcp_1, "tcp 1", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80,
+                                     BENCH_TCP_WINDOW, NX_NULL, NX_NULL), "TCP create");
+    bench_check(nx_tcp_server_socket_listen(&ip_1, BENCH_TCP_PORT, &tcp_1, 1, NX_NULL), "TCP listen");
+    bench_check(nx_tcp_server_socket_accept(&tcp_1, NX_WAIT_FOREVER), "TCP accept");
+
+    while (nx_tcp_socket_receive(&tcp_1, &packet_ptr, 5 * NX_IP_PERIODIC_RATE) == NX_SUCCESS)
+    {
+        nx_packet_length_get(packet_ptr, &length);
+        tcp_received +=  length;
+        clock_gettime(CLOCK_MONOTONIC, &bench_end);
+        nx_packet_release(packet_ptr);
+    }
+    tx_semaphore_put(&done_semaphore);
+}
+
+
+int main(int argc, char **argv)
+{
+
+    bench_switch =  (argc > 1) && (strcmp(argv[1], "switch") == 0);
+
+    /* Enter the ThreadX kernel.  */
+    tx_kernel_enter();
+    return(0);
+}
+
+
+void    tx_application_define(void *first_unused_memory)
+{
+
+    (void)first_unused_memory;
+
+    nx_system_initialize();
+    memset(bench_data, 'x', sizeof(bench_data));
+    udp_sending =  NX_TRUE;
+
+    if (bench_switch)
+    {
+        bench_check(_nx_linux_shm_driver_open(0, "bench0", 0), "Open");
+        bench_check(_nx_linux_shm_driver_open(1, "bench1", 0), "Open");
+    }
+    else
+    {
+        shm_unlink("/" BENCH_SEGMENT);
+        bench_check(_nx_linux_shm_driver_open(0, BENCH_SEGMENT, 0), "Open");
+        bench_check(_nx_linux_shm_driver_open(1, BENCH_SEGMENT, 1), "Open");
+    }
+    bench_check(nx_packet_pool_create(&pool_0, "pool 0", BENCH_PACKET_SIZE, pool_0_area, BENCH_POOL_SIZE), "Pool create");
+    bench_check(nx_packet_pool_create(&pool_1, "pool 1", BENCH_PACKET_SIZE, pool_1_area, BENCH_POOL_SIZE), "Pool create");
+    bench_check(nx_ip_create(&ip_0, "ip 0", IP_ADDRESS(10, 0, 0, 1), 0xFFFFFF00UL, &pool_0,
+                             _nx_linux_shm_driver, ip_0_stack, sizeof(ip_0_stack), 1), "IP create");
+    bench_check(nx_ip_create(&ip_1, "ip 1", IP_ADDRESS(10, 0, 0, 2), 0xFFFFFF00UL, &pool_1,
+                             _nx_linux_shm_driver, ip_1_stack, sizeof(ip_1_stack), 1), "IP create");
+    bench_check(nx_arp_enable(&ip_0, arp_0_cache, sizeof(arp_0_cache)), "ARP enable");
+    bench_check(nx_arp_enable(&ip_1, arp_1_cache, sizeof(arp_1_cache)), "ARP enable");
+    bench_check(nx_udp_enable(&ip_0), "UDP enable");
+    bench_check(nx_udp_enable(&ip_1), "UDP enable");
+    bench_check(nx_tcp_enable(&ip_0), "TCP enable");
+    bench_check(nx_tcp_enable(&ip_1), "TCP enable");
+
+    tx_semaphore_create(&start_semaphore, "start", 0);
+    tx_semaphore_create(&done_semaphore, "done", 0);
+    tx_thread_create(&receiver_thread, "receiver", receiver_entry, 0, receiver_stack, sizeof(receiver_stack),
+                     3, 3, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&sender_thread, "sender", sender_entry, 0, sender_stack, sizeof(sender_stack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
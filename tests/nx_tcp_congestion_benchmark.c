@@ -0,0 +1,433 @@
+/* Congestion control benchmark for NetX Duo TCP over a simulated long fat link.
+
+   Two IP instances are connected by the RAM driver. The driver is wrapped by a
+   link model: data from ip_0 to ip_1 goes through a bottleneck of
+   BENCH_LINK_RATE bytes per tick with a drop-tail queue of BENCH_LINK_QUEUE
+   packets and a small random loss, and both directions are delayed by
+   BENCH_LINK_DELAY ticks. The defaults describe an LTE upload to a distant
+   server: 40 Mbit/s, 100 ms round trip time.
+
+   A bulk transfer runs for BENCH_SECONDS with each congestion control
+   algorithm and reports the goodput, the retransmissions and the pacing rate
+   suggested at the end of the run.
+
+   Build with -DCONFIG_TX_BENCHMARK=1 -DCONFIG_NET=1. The window needs
+   NX_ENABLE_TCP_WINDOW_SCALING to cover the bandwidth-delay product and the
+   CUBIC run needs NX_ENABLE_TCP_CUBIC, both come with the netxduo_tcp_ext
+   library it links.  */
+
+#include   "tx_api.h"
+#include   "nx_api.h"
+#include   <stdio.h>
+#include   <stdlib.h>
+#include   <string.h>
+
+#define     BENCH_STACK_SIZE        8192
+#define     BENCH_PACKET_SIZE       1536
+#define     BENCH_POOL_PACKETS      2048
+#define     BENCH_POOL_SIZE         ((sizeof(NX_PACKET) + BENCH_PACKET_SIZE) * BENCH_POOL_PACKETS)
+#define     BENCH_LINK_PACKETS      4096
+#define     BENCH_LINK_POOL_SIZE    ((sizeof(NX_PACKET) + BENCH_PACKET_SIZE) * BENCH_LINK_PACKETS)
+#define     BENCH_LINK_RATE         (40000000 / 8 / NX_IP_PERIODIC_RATE)
+#define     BENCH_LINK_DELAY        (NX_IP_PERIODIC_RATE / 20)
+#define     BENCH_LINK_QUEUE        96
+#define     BENCH_LINK_LOSS         50000
+#define     BENCH_LINK_SLOTS        2048
+#define     BENCH_SECONDS           20
+#ifdef NX_ENABLE_TCP_WINDOW_SCALING
+#define     BENCH_TCP_WINDOW        (4 * 1024 * 1024)
+#else
+#define     BENCH_TCP_WINDOW        65535
+#endif /* NX_ENABLE_TCP_WINDOW_SCALING */
+#define     BENCH_TCP_MSS           1460
+#define     BENCH_TCP_QUEUE         (BENCH_POOL_PACKETS - 64)
+#define     BENCH_TCP_PORT          5010
+
+
+/* Define a packet on the simulated link.  */
+
+typedef struct BENCH_LINK_ENTRY_STRUCT
+{
+    NX_IP_DRIVER    request;
+    ULONG           due;
+} BENCH_LINK_ENTRY;
+
+typedef struct BENCH_LINK_RING_STRUCT
+{
+    BENCH_LINK_ENTRY    entries[BENCH_LINK_SLOTS];
+    ULONG               head;
+    ULONG               tail;
+} BENCH_LINK_RING;
+
+
+/* Define the congestion control algorithms to compare.  */
+
+typedef struct BENCH_RUN_STRUCT
+{
+    const char                          *name;
+    const NX_TCP_CONGESTION_CONTROL     *control;
+} BENCH_RUN;
+
+static const BENCH_RUN  bench_runs[] =
+{
+    {"Reno",  NX_NULL},
+#ifdef NX_ENABLE_TCP_CUBIC
+    {"CUBIC", &_nx_tcp_congestion_control_cubic},
+#endif /* NX_ENABLE_TCP_CUBIC */
+};
+
+#define     BENCH_RUNS              (sizeof(bench_runs) / sizeof(bench_runs[0]))
+
+
+/* Define the ThreadX and NetX object control blocks...  */
+
+static TX_THREAD        sender_thread;
+static TX_THREAD        receiver_thread;
+static TX_THREAD        link_thread;
+static TX_SEMAPHORE     start_semaphore;
+static TX_SEMAPHORE     done_semaphore;
+static NX_PACKET_POOL   pool_0;
+static NX_PACKET_POOL   pool_1;
+static NX_PACKET_POOL   link_pool;
+static NX_IP            ip_0;
+static NX_IP            ip_1;
+static NX_TCP_SOCKET    tcp_0;
+static NX_TCP_SOCKET    tcp_1;
+static ULONG            sender_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            receiver_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            link_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ip_0_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ip_1_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            arp_0_cache[256];
+static ULONG            arp_1_cache[256];
+static ULONG            pool_0_area[BENCH_POOL_SIZE / sizeof(ULONG) + 1];
+static ULONG            pool_1_area[BENCH_POOL_SIZE / sizeof(ULONG) + 1];
+static ULONG            link_pool_area[BENCH_LINK_POOL_SIZE / sizeof(ULONG) + 1];
+static UCHAR            bench_data[BENCH_TCP_MSS];
+
+
+/* Define the link state: the bottleneck queue and the delay lines of both directions.  */
+
+static BENCH_LINK_RING  link_bottleneck;
+static BENCH_LINK_RING  link_forward;
+static BENCH_LINK_RING  link_reverse;
+static ULONG            link_random =  1;
+static ULONG            link_queue_drops;
+static ULONG            link_random_drops;
+
+
+/* Define the benchmark counters...  */
+
+static volatile ULONG   tcp_received;
+
+
+void    _nx_ram_network_driver(NX_IP_DRIVER *driver_req_ptr);
+
+
+static void  bench_check(UINT status, const char *what)
+{
+    if (status)
+    {
+        printf("%s failed: 0x%x\n", what, status);
+        exit(1);
+    }
+}
+
+
+static ULONG  bench_ring_count(BENCH_LINK_RING *ring)
+{
+    return(ring -> tail - ring -> head);
+}
+
+
+static void  bench_ring_put(BENCH_LINK_RING *ring, NX_IP_DRIVER *request, ULONG due)
+{
+BENCH_LINK_ENTRY   *entry;
+
+    entry =  &ring -> entries[ring -> tail % BENCH_LINK_SLOTS];
+    entry -> request =  *request;
+    entry -> due =  due;
+    ring -> tail++;
+}
+
+
+/* RAM driver of both instances with the link model in front of the send path.  */
+
+static VOID  bench_link_driver(NX_IP_DRIVER *driver_req_ptr)
+{
+TX_INTERRUPT_SAVE_AREA
+NX_PACKET  *packet_ptr;
+NX_IP_DRIVER request;
+UINT        forward;
+
+    if (driver_req_ptr -> nx_ip_driver_command != NX_LINK_PACKET_SEND)
+    {
+        _nx_ram_network_driver(driver_req_ptr);
+        return;
+    }
+
+    /* The wire owns a copy, so the stack sees the transmit completed at once.  */
+    if (nx_packet_copy(driver_req_ptr -> nx_ip_driver_packet, &packet_ptr, &link_pool, NX_NO_WAIT))
+    {
+        packet_ptr =  NX_NULL;
+    }
+    nx_packet_transmit_release(driver_req_ptr -> nx_ip_driver_packet);
+    driver_req_ptr -> nx_ip_driver_status =  NX_SUCCESS;
+
+    if (packet_ptr == NX_NULL)
+    {
+        link_queue_drops++;
+        return;
+    }
+
+    request =  *driver_req_ptr;
+    request.nx_ip_driver_packet =  packet_ptr;
+    forward =  (driver_req_ptr -> nx_ip_driver_ptr == &ip_0);
+
+    TX_DISABLE
+
+    if (forward)
+    {
+
+        /* Random loss, then drop-tail at the bottleneck.  */
+        link_random =  link_random * 1103515245 + 12345;
+        if (((link_random >> 8) % BENCH_LINK_LOSS) == 0)
+        {
+            link_random_drops++;
+            packet_ptr =  NX_NULL;
+        }
+        else if (bench_ring_count(&link_bottleneck) >= BENCH_LINK_QUEUE)
+        {
+            link_queue_drops++;
+            packet_ptr =  NX_NULL;
+        }
+        else
+        {
+            bench_ring_put(&link_bottleneck, &request, 0);
+        }
+    }
+    else if (bench_ring_count(&link_reverse) < BENCH_LINK_SLOTS)
+    {
+        bench_ring_put(&link_reverse, &request, tx_time_get() + BENCH_LINK_DELAY);
+    }
+    else
+    {
+        packet_ptr =  NX_NULL;
+    }
+
+    TX_RESTORE
+
+    if ((packet_ptr == NX_NULL) && (request.nx_ip_driver_packet))
+    {
+        nx_packet_release(request.nx_ip_driver_packet);
+    }
+}
+
+
+/* Deliver the packets whose delay has expired.  */
+
+static void  bench_link_deliver(BENCH_LINK_RING *ring, ULONG now)
+{
+TX_INTERRUPT_SAVE_AREA
+NX_IP_DRIVER    request;
+
+    for (;;)
+    {
+        TX_DISABLE
+        if ((bench_ring_count(ring) == 0) ||
+            ((LONG)(ring -> entries[ring -> head % BENCH_LINK_SLOTS].due - now) > 0))
+        {
+            TX_RESTORE
+            return;
+        }
+        request =  ring -> entries[ring -> head % BENCH_LINK_SLOTS].request;
+        ring -> head++;
+        TX_RESTORE
+
+        _nx_ram_network_driver(&request);
+    }
+}
+
+
+static void  link_entry(ULONG input)
+{
+TX_INTERRUPT_SAVE_AREA
+BENCH_LINK_ENTRY   *entry;
+ULONG               budget =  0;
+ULONG               length;
+ULONG               now;
+
+    (void)input;
+
+    for (;;)
+    {
+        tx_thread_sleep(1);
+        now =  tx_time_get();
+
+        /* Serialize the bottleneck queue at the link rate.  */
+        budget +=  BENCH_LINK_RATE;
+
+        TX_DISABLE
+        while (bench_ring_count(&link_bottleneck))
+        {
+            entry =  &link_bottleneck.entries[link_bottleneck.head % BENCH_LINK_SLOTS];
+            length =  entry -> request.nx_ip_driver_packet -> nx_packet_length;
+            if (length > budget)
+            {
+                break;
+            }
+            budget -=  length;
+            bench_ring_put(&link_forward, &entry -> request, now + BENCH_LINK_DELAY);
+            link_bottleneck.head++;
+        }
+
+        /* An idle link does not save up capacity.  */
+        if (bench_ring_count(&link_bottleneck) == 0)
+        {
+            budget =  0;
+        }
+        TX_RESTORE
+
+        bench_link_deliver(&link_forward, now);
+        bench_link_deliver(&link_reverse, now);
+    }
+}
+
+
+static void  sender_entry(ULONG input)
+{
+NX_PACKET  *packet_ptr;
+ULONG       run;
+ULONG       start;
+ULONG       received;
+ULONG       retransmits;
+ULONG       pacing_rate;
+ULONG       queue_drops;
+ULONG       random_drops;
+UINT        status;
+
+    (void)input;
+
+    printf("Link: %lu Mbit/s, %lu ms RTT, %d packet queue, 1/%d random loss, %d s per run\n",
+           (unsigned long)(BENCH_LINK_RATE * NX_IP_PERIODIC_RATE * 8 / 1000000),
+           (unsigned long)(BENCH_LINK_DELAY * 2 * 1000 / NX_IP_PERIODIC_RATE),
+           BENCH_LINK_QUEUE, BENCH_LINK_LOSS, BENCH_SECONDS);
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        tx_semaphore_get(&start_semaphore, TX_WAIT_FOREVER);
+
+        bench_check(nx_tcp_socket_create(&ip_0, &tcp_0, "tcp 0", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80,
+                                         BENCH_TCP_WINDOW, NX_NULL, NX_NULL), "TCP create");
+        bench_check(nx_tcp_socket_transmit_configure(&tcp_0, BENCH_TCP_QUEUE, NX_IP_PERIODIC_RATE, 10, 0), "TCP configure");
+        bench_check(nx_tcp_socket_congestion_control_set(&tcp_0, bench_runs[run].control), "TCP congestion control");
+        bench_check(nx_tcp_client_socket_bind(&tcp_0, NX_ANY_PORT, TX_WAIT_FOREVER), "TCP bind");
+        bench_check(nx_tcp_client_socket_connect(&tcp_0, IP_ADDRESS(10, 0, 0, 2), BENCH_TCP_PORT + run,
+                                                 5 * NX_IP_PERIODIC_RATE), "TCP connect");
+
+        queue_drops =  link_queue_drops;
+        random_drops =  link_random_drops;
+        tcp_received =  0;
+        start =  tx_time_get();
+        while (tx_time_get() - start < BENCH_SECONDS * NX_IP_PERIODIC_RATE)
+        {
+            bench_check(nx_packet_allocate(&pool_0, &packet_ptr, NX_TCP_PACKET, NX_WAIT_FOREVER), "TCP allocate");
+            nx_packet_data_append(packet_ptr, bench_data, BENCH_TCP_MSS, &pool_0, NX_WAIT_FOREVER);
+            status =  nx_tcp_socket_send(&tcp_0, packet_ptr, 5 * NX_IP_PERIODIC_RATE);
+            if (status)
+            {
+                nx_packet_release(packet_ptr);
+                printf("TCP send failed: 0x%x\n", status);
+                break;
+            }
+        }
+        received =  tcp_received;
+
+        bench_check(nx_tcp_socket_info_get(&tcp_0, NX_NULL, NX_NULL, NX_NULL, NX_NULL, &retransmits,
+                                           NX_NULL, NX_NULL, NX_NULL, NX_NULL, NX_NULL, NX_NULL), "TCP info");
+        bench_check(nx_tcp_socket_pacing_rate_get(&tcp_0, &pacing_rate), "TCP pacing rate");
+
+        printf("%-6s %6.1f Mbit/s goodput, %5lu retransmitted, %4lu queue drops, %2lu random drops, "
+               "cwnd %lu, pacing %.1f Mbit/s\n",
+               bench_runs[run].name, (double)received * 8 / BENCH_SECONDS / 1e6,
+               (unsigned long)retransmits, (unsigned long)(link_queue_drops - queue_drops),
+               (unsigned long)(link_random_drops - random_drops),
+               (unsigned long)tcp_0.nx_tcp_socket_tx_window_congestion, (double)pacing_rate * 8 / 1e6);
+
+        nx_tcp_socket_disconnect(&tcp_0, 10 * NX_IP_PERIODIC_RATE);
+        tx_semaphore_get(&done_semaphore, TX_WAIT_FOREVER);
+        nx_tcp_client_socket_unbind(&tcp_0);
+        nx_tcp_socket_delete(&tcp_0);
+    }
+
+    exit(0);
+}
+
+
+static void  receiver_entry(ULONG input)
+{
+NX_PACKET  *packet_ptr;
+ULONG       run;
+
+    (void)input;
+
+    for (run = 0; run < BENCH_RUNS; run++)
+    {
+        bench_check(nx_tcp_socket_create(&ip_1, &tcp_1, "tcp 1", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80,
+                                         BENCH_TCP_WINDOW, NX_NULL, NX_NULL), "TCP create");
+        bench_check(nx_tcp_server_socket_listen(&ip_1, BENCH_TCP_PORT + run, &tcp_1, 1, NX_NULL), "TCP listen");
+        tx_semaphore_put(&start_semaphore);
+        bench_check(nx_tcp_server_socket_accept(&tcp_1, NX_WAIT_FOREVER), "TCP accept");
+
+        while (nx_tcp_socket_receive(&tcp_1, &packet_ptr, 10 * NX_IP_PERIODIC_RATE) == NX_SUCCESS)
+        {
+            tcp_received +=  packet_ptr -> nx_packet_length;
+            nx_packet_release(packet_ptr);
+        }
+
+        nx_tcp_socket_disconnect(&tcp_1, NX_NO_WAIT);
+        nx_tcp_server_socket_unaccept(&tcp_1);
+        nx_tcp_server_socket_unlisten(&ip_1, BENCH_TCP_PORT + run);
+        nx_tcp_socket_delete(&tcp_1);
+        tx_semaphore_put(&done_semaphore);
+    }
+}
+
+
+int main()
+{
+
+    /* Enter the ThreadX kernel.  */
+    tx_kernel_enter();
+    return(0);
+}
+
+
+void    tx_application_define(void *first_unused_memory)
+{
+
+    (void)first_unused_memory;
+
+    nx_system_initialize();
+
+    bench_check(nx_packet_pool_create(&pool_0, "pool 0", BENCH_PACKET_SIZE, pool_0_area, BENCH_POOL_SIZE), "Pool create");
+    bench_check(nx_packet_pool_create(&pool_1, "pool 1", BENCH_PACKET_SIZE, pool_1_area, BENCH_POOL_SIZE), "Pool create");
+    bench_check(nx_packet_pool_create(&link_pool, "link", BENCH_PACKET_SIZE, link_pool_area, BENCH_LINK_POOL_SIZE), "Pool create");
+    bench_check(nx_ip_create(&ip_0, "ip 0", IP_ADDRESS(10, 0, 0, 1), 0xFFFFFF00UL, &pool_0,
+                             bench_link_driver, ip_0_stack, sizeof(ip_0_stack), 1), "IP create");
+    bench_check(nx_ip_create(&ip_1, "ip 1", IP_ADDRESS(10, 0, 0, 2), 0xFFFFFF00UL, &pool_1,
+                             bench_link_driver, ip_1_stack, sizeof(ip_1_stack), 1), "IP create");
+    bench_check(nx_arp_enable(&ip_0, arp_0_cache, sizeof(arp_0_cache)), "ARP enable");
+    bench_check(nx_arp_enable(&ip_1, arp_1_cache, sizeof(arp_1_cache)), "ARP enable");
+    bench_check(nx_tcp_enable(&ip_0), "TCP enable");
+    bench_check(nx_tcp_enable(&ip_1), "TCP enable");
+
+    tx_semaphore_create(&start_semaphore, "start", 0);
+    tx_semaphore_create(&done_semaphore, "done", 0);
+    tx_thread_create(&link_thread, "link", link_entry, 0, link_stack, sizeof(link_stack),
+                     2, 2, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&receiver_thread, "receiver", receiver_entry, 0, receiver_stack, sizeof(receiver_stack),
+                     3, 3, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&sender_thread, "sender", sender_entry, 0, sender_stack, sizeof(sender_stack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
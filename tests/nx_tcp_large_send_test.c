@@ -0,0 +1,303 @@
+/* Lossy link test for the NetX Duo TCP large send and receive coalescing.
+
+   Two IP instances are connected by the RAM driver. ip_0 sends
+   NX_LARGE_SEND_TEST_BYTES of a known pattern to ip_1 in chained packets of
+   NX_LARGE_SEND_TEST_CHUNK bytes, which TCP hands down as super-segments that
+   are cut into MSS segments in front of the driver. The driver of ip_0 is
+   wrapped so that it drops one out of every NX_LARGE_SEND_TEST_DROP_PERIOD TCP
+   data segments, so super-segments are split again for retransmission and
+   trimmed by partial acknowledgements.
+
+   ip_1 runs at a lower priority than the sender, so a whole burst of segments
+   is queued before its IP thread runs and is merged by receive coalescing.
+
+   The test checks that:
+     1. The sender queued super-segments and the driver only got MSS segments.
+     2. The receiver got merged packets larger than one MSS.
+     3. Every byte arrives in order and intact.
+     4. The sender retransmitted about as many segments as were dropped.
+
+   Built with NX_ENABLE_TCP_LARGE_SEND and NX_ENABLE_TCP_RECEIVE_COALESCING
+   through the netxduo_tcp_offload library.  */
+
+#include   "tx_api.h"
+#include   "nx_api.h"
+#include   <stdio.h>
+#include   <stdlib.h>
+#include   <string.h>
+
+#define     NX_LARGE_SEND_TEST_STACK_SIZE   8192
+#define     NX_LARGE_SEND_TEST_PACKET_SIZE  1536
+#define     NX_LARGE_SEND_TEST_POOL_PACKETS 256
+#define     NX_LARGE_SEND_TEST_POOL_SIZE    ((sizeof(NX_PACKET) + NX_LARGE_SEND_TEST_PACKET_SIZE) * NX_LARGE_SEND_TEST_POOL_PACKETS)
+#define     NX_LARGE_SEND_TEST_BYTES        (4 * 1024 * 1024)
+#define     NX_LARGE_SEND_TEST_CHUNK        (16 * 1024)
+#define     NX_LARGE_SEND_TEST_MSS          1460
+#define     NX_LARGE_SEND_TEST_WINDOW       65535
+#define     NX_LARGE_SEND_TEST_QUEUE        8
+#define     NX_LARGE_SEND_TEST_PORT         5004
+#define     NX_LARGE_SEND_TEST_DROP_PERIOD  97
+
+
+/* Define the ThreadX and NetX object control blocks...  */
+
+static TX_THREAD        sender_thread;
+static TX_THREAD        receiver_thread;
+static TX_SEMAPHORE     done_semaphore;
+static NX_PACKET_POOL   pool_0;
+static NX_PACKET_POOL   pool_1;
+static NX_IP            ip_0;
+static NX_IP            ip_1;
+static NX_TCP_SOCKET    tcp_0;
+static NX_TCP_SOCKET    tcp_1;
+static ULONG            sender_stack[NX_LARGE_SEND_TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG            receiver_stack[NX_LARGE_SEND_TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ip_0_stack[NX_LARGE_SEND_TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ip_1_stack[NX_LARGE_SEND_TEST_STACK_SIZE / sizeof(ULONG)];
+static ULONG            arp_0_cache[256];
+static ULONG            arp_1_cache[256];
+static ULONG            pool_0_area[NX_LARGE_SEND_TEST_POOL_SIZE / sizeof(ULONG) + 1];
+static ULONG            pool_1_area[NX_LARGE_SEND_TEST_POOL_SIZE / sizeof(ULONG) + 1];
+static UCHAR            chunk[NX_LARGE_SEND_TEST_CHUNK];
+static UCHAR            received[NX_LARGE_SEND_TEST_CHUNK + NX_LARGE_SEND_TEST_WINDOW];
+
+
+/* Define the test counters...  */
+
+static ULONG            data_segments;
+static ULONG            dropped_segments;
+static ULONG            large_sends;
+static ULONG            received_packets;
+static ULONG            merged_packets;
+static ULONG            received_bytes;
+static ULONG            corrupted_bytes;
+
+
+void    _nx_ram_network_driver(NX_IP_DRIVER *driver_req_ptr);
+
+
+static void  large_send_test_check(UINT status, const char *what)
+{
+    if (status)
+    {
+        printf("%s failed: 0x%x\n", what, status);
+        exit(1);
+    }
+}
+
+
+static UCHAR  large_send_test_pattern(ULONG offset)
+{
+    return((UCHAR)((offset % 251) ^ (offset >> 12)));
+}
+
+
+/* RAM driver of ip_0 that loses TCP data segments.  */
+
+static VOID  lossy_network_driver(NX_IP_DRIVER *driver_req_ptr)
+{
+NX_PACKET  *packet_ptr;
+UCHAR      *ip_header;
+ULONG       ip_header_length;
+ULONG       tcp_header_length;
+
+    if (driver_req_ptr -> nx_ip_driver_command == NX_LINK_PACKET_SEND)
+    {
+
+        /* The prepend pointer is at the IPv4 header.  */
+        packet_ptr =  driver_req_ptr -> nx_ip_driver_packet;
+        ip_header =  packet_ptr -> nx_packet_prepend_ptr;
+        ip_header_length =  (ULONG)(ip_header[0] & 0x0F) << 2;
+        tcp_header_length =  (ULONG)(ip_header[ip_header_length + 12] >> 4) << 2;
+
+        if ((ip_header[9] == NX_PROTOCOL_TCP) &&
+            (packet_ptr -> nx_packet_length > ip_header_length + tcp_header_length))
+        {
+
+            /* The segments must have been cut to the MTU before the driver.  */
+            if (packet_ptr -> nx_packet_length > NX_LARGE_SEND_TEST_MSS + ip_header_length + tcp_header_length)
+            {
+                printf("FAIL: driver got a %lu byte packet\n", (unsigned long)packet_ptr -> nx_packet_length);
+                exit(1);
+            }
+
+            if ((data_segments++ % NX_LARGE_SEND_TEST_DROP_PERIOD) == NX_LARGE_SEND_TEST_DROP_PERIOD - 1)
+            {
+                dropped_segments++;
+                nx_packet_transmit_release(packet_ptr);
+                driver_req_ptr -> nx_ip_driver_status =  NX_SUCCESS;
+                return;
+            }
+        }
+    }
+
+    _nx_ram_network_driver(driver_req_ptr);
+}
+
+
+static void  sender_entry(ULONG input)
+{
+NX_PACKET  *packet_ptr;
+ULONG       sent;
+ULONG       length;
+ULONG       i;
+ULONG       retransmits;
+ULONG       start_time;
+ULONG       elapsed;
+ULONG       status;
+
+    (void)input;
+
+    large_send_test_check(nx_tcp_socket_create(&ip_0, &tcp_0, "tcp 0", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80,
+                                               NX_LARGE_SEND_TEST_WINDOW, NX_NULL, NX_NULL), "TCP create");
+    large_send_test_check(nx_tcp_socket_transmit_configure(&tcp_0, NX_LARGE_SEND_TEST_QUEUE, NX_IP_PERIODIC_RATE, 10, 0),
+                          "TCP configure");
+    large_send_test_check(nx_tcp_client_socket_bind(&tcp_0, NX_ANY_PORT, TX_WAIT_FOREVER), "TCP bind");
+
+    /* ip_1 enables its link when its thread first runs.  */
+    large_send_test_check(nx_ip_status_check(&ip_1, NX_IP_LINK_ENABLED, &status, NX_IP_PERIODIC_RATE), "IP status");
+    large_send_test_check(nx_tcp_client_socket_connect(&tcp_0, IP_ADDRESS(10, 0, 0, 2), NX_LARGE_SEND_TEST_PORT,
+                                                       5 * NX_IP_PERIODIC_RATE), "TCP connect");
+
+    /* Only count the drops of the transfer itself.  */
+    data_segments =  0;
+    dropped_segments =  0;
+    start_time =  tx_time_get();
+
+    for (sent = 0; sent < NX_LARGE_SEND_TEST_BYTES; sent += length)
+    {
+        length =  NX_LARGE_SEND_TEST_BYTES - sent;
+        if (length > NX_LARGE_SEND_TEST_CHUNK)
+        {
+            length =  NX_LARGE_SEND_TEST_CHUNK;
+        }
+
+        for (i = 0; i < length; i++)
+        {
+            chunk[i] =  large_send_test_pattern(sent + i);
+        }
+
+        large_send_test_check(nx_packet_allocate(&pool_0, &packet_ptr, NX_TCP_PACKET, NX_WAIT_FOREVER), "TCP allocate");
+        large_send_test_check(nx_packet_data_append(packet_ptr, chunk, length, &pool_0, NX_WAIT_FOREVER), "TCP append");
+        large_send_test_check(nx_tcp_socket_send(&tcp_0, packet_ptr, 10 * NX_IP_PERIODIC_RATE), "TCP send");
+
+        /* ip_1 does not run before the sender blocks, so the last packet sent is still queued.  */
+        if ((tcp_0.nx_tcp_socket_transmit_sent_tail) &&
+            (tcp_0.nx_tcp_socket_transmit_sent_tail -> nx_packet_tcp_segment_size))
+        {
+            large_sends++;
+        }
+    }
+
+    nx_tcp_socket_disconnect(&tcp_0, 10 * NX_IP_PERIODIC_RATE);
+    tx_semaphore_get(&done_semaphore, TX_WAIT_FOREVER);
+    elapsed =  tx_time_get() - start_time;
+
+    large_send_test_check(nx_tcp_socket_info_get(&tcp_0, NX_NULL, NX_NULL, NX_NULL, NX_NULL, &retransmits,
+                                                 NX_NULL, NX_NULL, NX_NULL, NX_NULL, NX_NULL, NX_NULL), "TCP info");
+
+    printf("TCP large send: %lu bytes received, %lu corrupted, %lu super-segments, %lu of %lu packets merged, "
+           "%lu of %lu segments dropped, %lu retransmitted, %lu ticks\n",
+           (unsigned long)received_bytes, (unsigned long)corrupted_bytes, (unsigned long)large_sends,
+           (unsigned long)merged_packets, (unsigned long)received_packets, (unsigned long)dropped_segments,
+           (unsigned long)data_segments, (unsigned long)retransmits, (unsigned long)elapsed);
+
+    if ((received_bytes != NX_LARGE_SEND_TEST_BYTES) || corrupted_bytes)
+    {
+        printf("FAIL: data was lost or corrupted\n");
+        exit(1);
+    }
+
+    if ((large_sends == 0) || (merged_packets == 0) || (dropped_segments == 0))
+    {
+        printf("FAIL: large send or receive coalescing was not used\n");
+        exit(1);
+    }
+
+    /* Super-segments are split before they are retransmitted, so only the lost segments are sent again.  */
+    if (retransmits > dropped_segments + dropped_segments / 8)
+    {
+        printf("FAIL: expected about %lu retransmissions\n", (unsigned long)dropped_segments);
+        exit(1);
+    }
+
+    printf("PASS\n");
+    exit(0);
+}
+
+
+static void  receiver_entry(ULONG input)
+{
+NX_PACKET  *packet_ptr;
+ULONG       length;
+ULONG       i;
+
+    (void)input;
+
+    large_send_test_check(nx_tcp_socket_create(&ip_1, &tcp_1, "tcp 1", NX_IP_NORMAL, NX_FRAGMENT_OKAY, 0x80,
+                                               NX_LARGE_SEND_TEST_WINDOW, NX_NULL, NX_NULL), "TCP create");
+    large_send_test_check(nx_tcp_server_socket_listen(&ip_1, NX_LARGE_SEND_TEST_PORT, &tcp_1, 1, NX_NULL), "TCP listen");
+    large_send_test_check(nx_tcp_server_socket_accept(&tcp_1, NX_WAIT_FOREVER), "TCP accept");
+
+    while (nx_tcp_socket_receive(&tcp_1, &packet_ptr, 10 * NX_IP_PERIODIC_RATE) == NX_SUCCESS)
+    {
+        received_packets++;
+        if (packet_ptr -> nx_packet_length > NX_LARGE_SEND_TEST_MSS)
+        {
+            merged_packets++;
+        }
+
+        large_send_test_check(nx_packet_data_extract_offset(packet_ptr, 0, received, sizeof(received), &length),
+                              "TCP extract");
+        for (i = 0; i < length; i++)
+        {
+            if (received[i] != large_send_test_pattern(received_bytes + i))
+            {
+                corrupted_bytes++;
+            }
+        }
+        received_bytes +=  length;
+        nx_packet_release(packet_ptr);
+    }
+
+    tx_semaphore_put(&done_semaphore);
+}
+
+
+int main()
+{
+
+    /* Enter the ThreadX kernel.  */
+    tx_kernel_enter();
+    return(0);
+}
+
+
+void    tx_application_define(void *first_unused_memory)
+{
+
+    (void)first_unused_memory;
+
+    nx_system_initialize();
+
+    large_send_test_check(nx_packet_pool_create(&pool_0, "pool 0", NX_LARGE_SEND_TEST_PACKET_SIZE, pool_0_area,
+                                                NX_LARGE_SEND_TEST_POOL_SIZE), "Pool create");
+    large_send_test_check(nx_packet_pool_create(&pool_1, "pool 1", NX_LARGE_SEND_TEST_PACKET_SIZE, pool_1_area,
+                                                NX_LARGE_SEND_TEST_POOL_SIZE), "Pool create");
+
+    /* ip_1 runs below the sender, so received segments queue up in batches.  */
+    large_send_test_check(nx_ip_create(&ip_0, "ip 0", IP_ADDRESS(10, 0, 0, 1), 0xFFFFFF00UL, &pool_0,
+                                       lossy_network_driver, ip_0_stack, sizeof(ip_0_stack), 1), "IP create");
+    large_send_test_check(nx_ip_create(&ip_1, "ip 1", IP_ADDRESS(10, 0, 0, 2), 0xFFFFFF00UL, &pool_1,
+                                       _nx_ram_network_driver, ip_1_stack, sizeof(ip_1_stack), 5), "IP create");
+    large_send_test_check(nx_arp_enable(&ip_0, arp_0_cache, sizeof(arp_0_cache)), "ARP enable");
+    large_send_test_check(nx_arp_enable(&ip_1, arp_1_cache, sizeof(arp_1_cache)), "ARP enable");
+    large_send_test_check(nx_tcp_enable(&ip_0), "TCP enable");
+    large_send_test_check(nx_tcp_enable(&ip_1), "TCP enable");
+
+    tx_semaphore_create(&done_semaphore, "done", 0);
+    tx_thread_create(&receiver_thread, "receiver", receiver_entry, 0, receiver_stack, sizeof(receiver_stack),
+                     3, 3, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&sender_thread, "sender", sender_entry, 0, sender_stack, sizeof(sender_stack),
+                     4, 4, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
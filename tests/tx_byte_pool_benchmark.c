@@ -0,0 +1,189 @@
+/* Byte pool fragmentation benchmark for the ThreadX Linux simulator.
+
+   It reports the tx_byte_allocate time for:
+     1. Random allocate/release churn with mixed block sizes.
+     2. A checkerboard pool (every other small block free) and a request that fits none
+        of the small holes, which is the worst case of the first-fit search.
+
+   Build with -DCONFIG_TX_BENCHMARK=1 and compare the results with the Linux port option
+   TX_BYTE_POOL_TLSF=ON/OFF.  */
+
+#include   "tx_api.h"
+#include   <stdio.h>
+#include   <stdlib.h>
+#include   <string.h>
+#include   <time.h>
+
+#define     BENCH_STACK_SIZE        8192
+#define     BENCH_POOL_SIZE         (256 * 1024)
+#define     BENCH_SLOTS             1024
+#define     BENCH_CHURN_OPS         200000
+#define     BENCH_HOLE_SIZE         32
+#define     BENCH_HOLE_ROUNDS       200
+
+
+/* Define the ThreadX object control blocks...  */
+
+static TX_THREAD        bench_thread;
+static TX_BYTE_POOL     bench_pool;
+
+static ULONG            bench_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            bench_pool_area[BENCH_POOL_SIZE / sizeof(ULONG)];
+
+
+/* Define the benchmark samples...  */
+
+static VOID             *slots[BENCH_SLOTS];
+static VOID             *holes[BENCH_POOL_SIZE / BENCH_HOLE_SIZE];
+static long             samples[BENCH_CHURN_OPS];
+static unsigned int     seed =  1;
+
+
+static unsigned int  bench_rand(void)
+{
+
+    seed =  seed * 1103515245u + 12345u;
+    return (seed >> 8);
+}
+
+static long  bench_now_ns(void)
+{
+struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int  bench_compare(const void *a, const void *b)
+{
+long    x =  *(const long *)a;
+long    y =  *(const long *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void  bench_report(const char *name, long *data, int n, int failed)
+{
+long    sum;
+int     i;
+
+    qsort(data, n, sizeof(data[0]), bench_compare);
+    for (sum = 0, i = 0; i < n; i++)
+        sum +=  data[i];
+    printf("%-12s %d allocs (%d failed): avg %ld ns, p99 %ld ns, p99.9 %ld ns, max %ld ns\n",
+        name, n, failed, n ? sum / n : 0, data[n * 99 / 100], data[n * 999 / 1000], data[n - 1]);
+}
+
+
+static ULONG  bench_size(void)
+{
+unsigned int    r =  bench_rand();
+
+    /* Mostly small objects with an occasional large buffer.  */
+    if ((r & 15) == 0)
+        return 1024 + (r >> 4) % 4096;
+    return 8 + (r >> 4) % 256;
+}
+
+static VOID  bench_entry(ULONG input)
+{
+CHAR    *name;
+ULONG   available;
+ULONG   fragments;
+VOID    *ptr;
+long    start;
+int     count;
+int     failed;
+int     nholes;
+int     i;
+
+    (VOID)input;
+
+    /* 1. Random churn.  */
+    count =  0;
+    failed =  0;
+    for (i = 0; i < BENCH_CHURN_OPS; i++)
+    {
+        int slot =  bench_rand() % BENCH_SLOTS;
+
+        if (slots[slot])
+        {
+            tx_byte_release(slots[slot]);
+            slots[slot] =  NULL;
+            continue;
+        }
+        start =  bench_now_ns();
+        if (tx_byte_allocate(&bench_pool, &slots[slot], bench_size(), TX_NO_WAIT) != TX_SUCCESS)
+        {
+            slots[slot] =  NULL;
+            failed++;
+        }
+        samples[count++] =  bench_now_ns() - start;
+    }
+    tx_byte_pool_info_get(&bench_pool, &name, &available, &fragments, NULL, NULL, NULL);
+    bench_report("Churn:", samples, count, failed);
+    printf("             %lu bytes available in %lu fragments\n",
+        (unsigned long)available, (unsigned long)fragments);
+    for (i = 0; i < BENCH_SLOTS; i++)
+    {
+        if (slots[i])
+            tx_byte_release(slots[i]);
+        slots[i] =  NULL;
+    }
+
+    /* 2. Checkerboard.  */
+    for (nholes = 0; nholes < (int)(sizeof(holes) / sizeof(holes[0])); nholes++)
+    {
+        if (tx_byte_allocate(&bench_pool, &holes[nholes], BENCH_HOLE_SIZE, TX_NO_WAIT) != TX_SUCCESS)
+            break;
+    }
+
+    /* Free every other block, and a run at the end of the pool where the request fits.  */
+    for (i = 0; i < nholes; i++)
+    {
+        if ((i & 1) == 0 || i >= nholes - 8)
+        {
+            tx_byte_release(holes[i]);
+            holes[i] =  NULL;
+        }
+    }
+    count =  0;
+    failed =  0;
+    for (i = 0; i < BENCH_HOLE_ROUNDS; i++)
+    {
+        start =  bench_now_ns();
+        if (tx_byte_allocate(&bench_pool, &ptr, BENCH_HOLE_SIZE * 4, TX_NO_WAIT) != TX_SUCCESS)
+            ptr =  NULL;
+        samples[count++] =  bench_now_ns() - start;
+        if (ptr)
+            tx_byte_release(ptr);
+        else
+            failed++;
+    }
+    tx_byte_pool_info_get(&bench_pool, &name, &available, &fragments, NULL, NULL, NULL);
+    bench_report("Checkerboard:", samples, count, failed);
+    printf("             %lu bytes available in %lu fragments\n",
+        (unsigned long)available, (unsigned long)fragments);
+
+    exit(0);
+}
+
+
+int main()
+{
+
+    /* Enter the ThreadX kernel.  */
+    tx_kernel_enter();
+    return 0;
+}
+
+
+void    tx_application_define(void *first_unused_memory)
+{
+
+    (VOID)first_unused_memory;
+
+    tx_byte_pool_create(&bench_pool, "bench", bench_pool_area, sizeof(bench_pool_area));
+    tx_thread_create(&bench_thread, "bench", bench_entry, 0,
+        bench_stack, sizeof(bench_stack), 1, 1, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
@@ -0,0 +1,235 @@
+/* Thread-Metric style scheduling benchmark for the ThreadX Linux simulator.
+
+   It reports:
+     1. Cooperative context switch time between two threads of the same priority.
+     2. Wakeup latency from a simulated ISR to the readied thread while the system is idle.
+     3. Host CPU time consumed by the simulator when all threads are sleeping.
+     4. Accuracy of tx_thread_sleep and tx_time_get after a long idle period.
+
+   Build with -DCONFIG_TX_BENCHMARK=1 and compare the results with the Linux port options
+   TX_LINUX_EVENT_IDLE=ON/OFF and TX_LINUX_TICKLESS=ON/OFF.  */
+
+#include   "tx_api.h"
+#include   <stdio.h>
+#include   <stdlib.h>
+#include   <time.h>
+#include   <pthread.h>
+#include   <sys/resource.h>
+
+#define     BENCH_STACK_SIZE        4096
+#define     BENCH_SWITCH_SECONDS    2
+#define     BENCH_IDLE_SECONDS      2
+#define     BENCH_ISR_SAMPLES       2000
+#define     BENCH_ISR_PERIOD_NS     500000
+
+
+/* Define the simulated interrupt interface of the port.  */
+
+VOID        _tx_thread_context_save(VOID);
+VOID        _tx_thread_context_restore(VOID);
+
+
+/* Define the ThreadX object control blocks...  */
+
+static TX_THREAD        report_thread;
+static TX_THREAD        ping_thread;
+static TX_THREAD        pong_thread;
+static TX_THREAD        wakeup_thread;
+static TX_SEMAPHORE     ping_semaphore;
+static TX_SEMAPHORE     pong_semaphore;
+static TX_SEMAPHORE     isr_semaphore;
+static TX_SEMAPHORE     done_semaphore;
+
+static ULONG            report_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            ping_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            pong_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+static ULONG            wakeup_stack[BENCH_STACK_SIZE / sizeof(ULONG)];
+
+
+/* Define the benchmark counters...  */
+
+static volatile ULONG   pingpong_counter;
+static volatile UINT    pingpong_stop;
+static struct timespec  isr_timestamp;
+static long             isr_latency[BENCH_ISR_SAMPLES];
+
+
+static long  bench_elapsed_ns(struct timespec *start, struct timespec *end)
+{
+    return (end -> tv_sec - start -> tv_sec) * 1000000000L + (end -> tv_nsec - start -> tv_nsec);
+}
+
+static long  bench_cpu_us(void)
+{
+struct rusage   usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static int  bench_compare(const void *a, const void *b)
+{
+long    x =  *(const long *)a;
+long    y =  *(const long *)b;
+
+    return (x > y) - (x < y);
+}
+
+
+static VOID  ping_entry(ULONG input)
+{
+
+    (VOID)input;
+    while (!pingpong_stop)
+    {
+        tx_semaphore_put(&pong_semaphore);
+        tx_semaphore_get(&ping_semaphore, TX_WAIT_FOREVER);
+        pingpong_counter++;
+    }
+}
+
+static VOID  pong_entry(ULONG input)
+{
+
+    (VOID)input;
+    while (1)
+    {
+        tx_semaphore_get(&pong_semaphore, TX_WAIT_FOREVER);
+        tx_semaphore_put(&ping_semaphore);
+    }
+}
+
+static VOID  wakeup_entry(ULONG input)
+{
+struct timespec now;
+int             i;
+
+    (VOID)input;
+    for (i = 0; i < BENCH_ISR_SAMPLES; i++)
+    {
+        tx_semaphore_get(&isr_semaphore, TX_WAIT_FOREVER);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        isr_latency[i] =  bench_elapsed_ns(&isr_timestamp, &now);
+    }
+    tx_semaphore_put(&done_semaphore);
+}
+
+
+/* Define the simulated interrupt that readies the wakeup thread.  */
+
+static void  *bench_isr_entry(void *p)
+{
+struct timespec ts;
+int             i;
+
+    (VOID)p;
+    for (i = 0; i < BENCH_ISR_SAMPLES; i++)
+    {
+        ts.tv_sec =  0;
+        ts.tv_nsec = BENCH_ISR_PERIOD_NS;
+        while (nanosleep(&ts, &ts));
+
+        _tx_thread_context_save();
+        clock_gettime(CLOCK_MONOTONIC, &isr_timestamp);
+        tx_semaphore_put(&isr_semaphore);
+        _tx_thread_context_restore();
+    }
+    return NULL;
+}
+
+
+static VOID  report_entry(ULONG input)
+{
+struct timespec     start;
+struct timespec     end;
+struct sched_param  sp;
+pthread_t           isr_thread;
+ULONG               count;
+ULONG               ticks;
+long                cpu;
+long                sum;
+int                 i;
+
+    (VOID)input;
+
+    /* 1. Cooperative context switch.  */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    tx_thread_resume(&ping_thread);
+    tx_thread_sleep(BENCH_SWITCH_SECONDS * TX_TIMER_TICKS_PER_SECOND);
+    count =  pingpong_counter;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    pingpong_stop =  1;
+    printf("Context switch:  %lu round trips, %ld ns/switch\n", (unsigned long)count,
+        count ? bench_elapsed_ns(&start, &end) / (long)(count * 2) : 0);
+
+    /* 2. Idle host CPU usage.  */
+    tx_thread_sleep(TX_TIMER_TICKS_PER_SECOND / 10);
+    cpu =  bench_cpu_us();
+    tx_thread_sleep(BENCH_IDLE_SECONDS * TX_TIMER_TICKS_PER_SECOND);
+    cpu =  bench_cpu_us() - cpu;
+    printf("Idle CPU usage:  %ld us/s (%ld.%ld%%)\n", cpu / BENCH_IDLE_SECONDS,
+        cpu / (BENCH_IDLE_SECONDS * 10000), (cpu / (BENCH_IDLE_SECONDS * 1000)) % 10);
+
+    /* 3. Wakeup latency from simulated ISR.  */
+    if (pthread_create(&isr_thread, NULL, bench_isr_entry, NULL))
+    {
+        printf("Create simulated ISR failed!\n");
+        exit(1);
+    }
+    sp.sched_priority =  TX_LINUX_PRIORITY_ISR;
+    pthread_setschedparam(isr_thread, SCHED_FIFO, &sp);
+    tx_semaphore_get(&done_semaphore, TX_WAIT_FOREVER);
+    pthread_join(isr_thread, NULL);
+
+    qsort(isr_latency, BENCH_ISR_SAMPLES, sizeof(isr_latency[0]), bench_compare);
+    for (sum = 0, i = 0; i < BENCH_ISR_SAMPLES; i++)
+        sum +=  isr_latency[i];
+    printf("ISR wakeup:      avg %ld ns, p50 %ld ns, p99 %ld ns, max %ld ns\n",
+        sum / BENCH_ISR_SAMPLES,
+        isr_latency[BENCH_ISR_SAMPLES / 2],
+        isr_latency[BENCH_ISR_SAMPLES * 99 / 100],
+        isr_latency[BENCH_ISR_SAMPLES - 1]);
+
+    /* 4. Sleep accuracy.  */
+    ticks =  tx_time_get();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    tx_thread_sleep(BENCH_IDLE_SECONDS * TX_TIMER_TICKS_PER_SECOND);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ticks =  tx_time_get() - ticks;
+    printf("Sleep %d ticks:  %ld us elapsed, %lu ticks counted\n",
+        (int)(BENCH_IDLE_SECONDS * TX_TIMER_TICKS_PER_SECOND),
+        bench_elapsed_ns(&start, &end) / 1000, (unsigned long)ticks);
+
+    exit(0);
+}
+
+
+int main()
+{
+
+    /* Enter the ThreadX kernel.  */
+    tx_kernel_enter();
+    return 0;
+}
+
+
+void    tx_application_define(void *first_unused_memory)
+{
+
+    (VOID)first_unused_memory;
+
+    tx_semaphore_create(&ping_semaphore, "ping", 0);
+    tx_semaphore_create(&pong_semaphore, "pong", 0);
+    tx_semaphore_create(&isr_semaphore, "isr", 0);
+    tx_semaphore_create(&done_semaphore, "done", 0);
+
+    tx_thread_create(&report_thread, "report", report_entry, 0,
+        report_stack, sizeof(report_stack), 1, 1, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&wakeup_thread, "wakeup", wakeup_entry, 0,
+        wakeup_stack, sizeof(wakeup_stack), 2, 2, TX_NO_TIME_SLICE, TX_AUTO_START);
+    tx_thread_create(&ping_thread, "ping", ping_entry, 0,
+        ping_stack, sizeof(ping_stack), 10, 10, TX_NO_TIME_SLICE, TX_DONT_START);
+    tx_thread_create(&pong_thread, "pong", pong_entry, 0,
+        pong_stack, sizeof(pong_stack), 10, 10, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
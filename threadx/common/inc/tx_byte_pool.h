@@ -68,6 +68,76 @@
 #endif
 
 
+/* Define the size of the header in front of each block, which contains the "next" block pointer
+   and either TX_BYTE_BLOCK_FREE or the owning pool pointer.  */
+
+#define TX_BYTE_BLOCK_HEADER_SIZE               ((sizeof(UCHAR *)) + (sizeof(ALIGN_TYPE)))
+
+
+#ifdef TX_BYTE_POOL_ENABLE_TLSF
+
+/* Define the two-level segregated fit (TLSF) byte pool engine.  Free blocks are kept in
+   TX_BYTE_POOL_TLSF_SL_COUNT size classes for each power of two, and two bitmaps select a
+   non-empty class that satisfies a request, so both allocation and release take constant
+   time regardless of fragmentation.  Adjacent free blocks are merged on release.
+
+   A free block carries the links of its size class list after the header and a pointer
+   to its own header in the last word (footer).  Bit 0 of the "next" block pointer marks
+   that the physically previous block is free and its footer is valid.
+
+   Unlike first-fit, a request is served from the next class up (good fit), and released
+   blocks are not kept in address order, so a fragmented pool can fail requests that the
+   first-fit search would still satisfy.  A block in the request's own class is only used
+   when no larger class has one, and then only its first TX_BYTE_POOL_TLSF_SEARCH_LIMIT
+   blocks are checked.  More classes
+   per power of two (TX_BYTE_POOL_TLSF_SL_LOG2) waste less to rounding, for a larger control
+   structure.  */
+
+#ifndef TX_BYTE_POOL_TLSF_SL_LOG2
+#define TX_BYTE_POOL_TLSF_SL_LOG2               ((UINT) 4)
+#endif
+
+#define TX_BYTE_POOL_TLSF_SL_COUNT              (((UINT) 1) << TX_BYTE_POOL_TLSF_SL_LOG2)
+
+/* Define how many blocks of the request's own class are checked when no larger class
+   has a free block.  */
+
+#ifndef TX_BYTE_POOL_TLSF_SEARCH_LIMIT
+#define TX_BYTE_POOL_TLSF_SEARCH_LIMIT          ((ULONG) 4)
+#endif
+#define TX_BYTE_POOL_TLSF_SMALL_SIZE            (((ULONG) TX_BYTE_POOL_TLSF_SL_COUNT) * (sizeof(ALIGN_TYPE)))
+#define TX_BYTE_BLOCK_PREV_FREE                 ((ALIGN_TYPE) 1)
+
+/* The smallest block holds the header, the two list links and the footer.  */
+
+#define TX_BYTE_POOL_TLSF_BLOCK_MIN             ((((TX_BYTE_BLOCK_HEADER_SIZE + ((sizeof(UCHAR *)) * 3)) + ((sizeof(ALIGN_TYPE)) - 1)) \
+                                                    / (sizeof(ALIGN_TYPE))) * (sizeof(ALIGN_TYPE)))
+
+
+/* Define the TLSF control structure, which is placed at the start of the pool memory and is
+   referenced by the pool's search pointer.  The second-level bitmaps and the free list heads
+   follow the structure.  */
+
+typedef struct TX_BYTE_POOL_TLSF_STRUCT
+{
+
+    /* Define the bitmap of first-level classes that have a free block.  */
+    ULONG               tx_byte_pool_tlsf_fl_bitmap;
+
+    /* Define the number of first-level classes of this pool.  */
+    UINT                tx_byte_pool_tlsf_fl_count;
+
+    /* Define the bitmaps of second-level classes that have a free block.  */
+    ULONG               *tx_byte_pool_tlsf_sl_bitmap;
+
+    /* Define the free list heads, indexed by first-level * TX_BYTE_POOL_TLSF_SL_COUNT + second-level.  */
+    UCHAR               **tx_byte_pool_tlsf_free_list;
+
+} TX_BYTE_POOL_TLSF;
+
+#endif
+
+
 /* Determine if in-line component initialization is supported by the
    caller.  */
 
@@ -104,6 +174,10 @@ VOID        _tx_byte_pool_initialize(VOID);
 
 UCHAR       *_tx_byte_pool_search(TX_BYTE_POOL *pool_ptr, ULONG memory_size);
 VOID        _tx_byte_pool_cleanup(TX_THREAD *thread_ptr, ULONG suspension_sequence);
+#ifdef TX_BYTE_POOL_ENABLE_TLSF
+UINT        _tx_byte_pool_tlsf_initialize(TX_BYTE_POOL *pool_ptr);
+VOID        _tx_byte_pool_tlsf_release(TX_BYTE_POOL *pool_ptr, UCHAR *block_ptr);
+#endif
 
 
 /* Byte pool management component data declarations follow.  */
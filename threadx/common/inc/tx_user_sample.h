@@ -260,6 +260,15 @@
 #define TX_BYTE_POOL_ENABLE_PERFORMANCE_INFO
 */
 
+/* Determine if byte pools use the two-level segregated fit allocator. When the following is defined,
+   tx_byte_allocate and tx_byte_release take constant time regardless of fragmentation, at the cost
+   of a control structure at the start of each pool's memory. Blocks are chosen by size class rather
+   than by address, so a heavily fragmented pool may fail a request that first-fit would satisfy.  */
+
+/*
+#define TX_BYTE_POOL_ENABLE_TLSF
+*/
+
 /* Determine if event flags performance gathering is required by the application. When the following is
    defined, ThreadX gathers various event flags performance information. */
 
@@ -55,10 +55,11 @@
 /*  OUTPUT                                                                */
 /*                                                                        */
 /*    TX_SUCCESS                        Successful completion status      */
+/*    TX_SIZE_ERROR                     Pool too small for TLSF control   */
 /*                                                                        */
 /*  CALLS                                                                 */
 /*                                                                        */
-/*    None                                                                */
+/*    _tx_byte_pool_tlsf_initialize     Build TLSF control structure      */
 /*                                                                        */
 /*  CALLED BY                                                             */
 /*                                                                        */
@@ -79,11 +80,13 @@ UINT  _tx_byte_pool_create(TX_BYTE_POOL *pool_ptr, CHAR *name_ptr, VOID *pool_st
 TX_INTERRUPT_SAVE_AREA
 
 UCHAR               *block_ptr;
+#ifndef TX_BYTE_POOL_ENABLE_TLSF
 UCHAR               **block_indirect_ptr;
 UCHAR               *temp_ptr;
+ALIGN_TYPE          *free_ptr;
+#endif
 TX_BYTE_POOL        *next_pool;
 TX_BYTE_POOL        *previous_pool;
-ALIGN_TYPE          *free_ptr;
 
 
     /* Initialize the byte pool control block to all zeros.  */
@@ -100,6 +103,21 @@ ALIGN_TYPE          *free_ptr;
     pool_ptr -> tx_byte_pool_start =   TX_VOID_TO_UCHAR_POINTER_CONVERT(pool_start);
     pool_ptr -> tx_byte_pool_size =    pool_size;
 
+#ifdef TX_BYTE_POOL_ENABLE_TLSF
+
+    /* Build the TLSF control structure and the initial blocks.  */
+    if (_tx_byte_pool_tlsf_initialize(pool_ptr) != TX_SUCCESS)
+    {
+
+        /* The pool is too small for the control structure.  */
+        return(TX_SIZE_ERROR);
+    }
+
+    /* The block pointer is only referenced by the trace event.  */
+    block_ptr =  pool_ptr -> tx_byte_pool_list;
+    TX_PARAMETER_NOT_USED(block_ptr);
+#else
+
     /* Setup memory list to the beginning as well as the search pointer.  */
     pool_ptr -> tx_byte_pool_list =    TX_VOID_TO_UCHAR_POINTER_CONVERT(pool_start);
     pool_ptr -> tx_byte_pool_search =  TX_VOID_TO_UCHAR_POINTER_CONVERT(pool_start);
@@ -139,6 +157,7 @@ ALIGN_TYPE          *free_ptr;
     block_ptr =            TX_UCHAR_POINTER_ADD(block_ptr, (sizeof(UCHAR *)));
     free_ptr =             TX_UCHAR_TO_ALIGN_TYPE_POINTER_CONVERT(block_ptr);
     *free_ptr =            TX_BYTE_BLOCK_FREE;
+#endif
 
     /* Clear the owner id.  */
     pool_ptr -> tx_byte_pool_owner =  TX_NULL;
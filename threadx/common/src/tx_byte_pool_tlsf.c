@@ -0,0 +1,571 @@
+/**************************************************************************/
+/*                                                                        */
+/*       Copyright (c) Microsoft Corporation. All rights reserved.        */
+/*                                                                        */
+/*       This software is licensed under the Microsoft Software License   */
+/*       Terms for Microsoft Azure RTOS. Full text of the license can be  */
+/*       found in the LICENSE file at https://aka.ms/AzureRTOS_EULA       */
+/*       and in the root directory of this software.                      */
+/*                                                                        */
+/**************************************************************************/
+
+
+/**************************************************************************/
+/**************************************************************************/
+/**                                                                       */
+/** ThreadX Component                                                     */
+/**                                                                       */
+/**   Byte Pool                                                           */
+/**                                                                       */
+/**************************************************************************/
+/**************************************************************************/
+
+#define TX_SOURCE_CODE
+
+
+/* Include necessary system files.  */
+
+#include "tx_api.h"
+#include "tx_thread.h"
+#include "tx_byte_pool.h"
+
+
+#ifdef TX_BYTE_POOL_ENABLE_TLSF
+
+/* Define the internal block field access.  */
+
+#define TX_BYTE_POOL_TLSF_CONTROL(p)        ((TX_BYTE_POOL_TLSF *) ((VOID *) ((p) -> tx_byte_pool_search)))
+#define TX_BYTE_BLOCK_TAG(b)                TX_UCHAR_TO_ALIGN_TYPE_POINTER_CONVERT(TX_UCHAR_POINTER_ADD((b), (sizeof(UCHAR *))))
+#define TX_BYTE_BLOCK_NEXT_FREE(b)          TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(TX_UCHAR_POINTER_ADD((b), TX_BYTE_BLOCK_HEADER_SIZE))
+#define TX_BYTE_BLOCK_PREVIOUS_FREE(b)      TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(TX_UCHAR_POINTER_ADD((b), (TX_BYTE_BLOCK_HEADER_SIZE + (sizeof(UCHAR *)))))
+#define TX_BYTE_BLOCK_FOOTER(n)             TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(TX_UCHAR_POINTER_SUB((n), (sizeof(UCHAR *))))
+
+
+static UCHAR  *_tx_byte_pool_tlsf_next_get(UCHAR *block_ptr)
+{
+
+UCHAR       **block_link_ptr;
+ALIGN_TYPE  next_block;
+
+
+    /* Pickup the next block pointer without the previous free flag.  */
+    block_link_ptr =  TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(block_ptr);
+    next_block =      TX_POINTER_TO_ALIGN_TYPE_CONVERT(*block_link_ptr) & (~TX_BYTE_BLOCK_PREV_FREE);
+    return(TX_VOID_TO_UCHAR_POINTER_CONVERT(TX_ALIGN_TYPE_TO_POINTER_CONVERT(next_block)));
+}
+
+
+static ALIGN_TYPE  _tx_byte_pool_tlsf_prev_free_get(UCHAR *block_ptr)
+{
+
+UCHAR       **block_link_ptr;
+
+
+    block_link_ptr =  TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(block_ptr);
+    return(TX_POINTER_TO_ALIGN_TYPE_CONVERT(*block_link_ptr) & TX_BYTE_BLOCK_PREV_FREE);
+}
+
+
+static VOID  _tx_byte_pool_tlsf_next_set(UCHAR *block_ptr, UCHAR *next_ptr, ALIGN_TYPE prev_free)
+{
+
+UCHAR       **block_link_ptr;
+
+
+    block_link_ptr =   TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(block_ptr);
+    *block_link_ptr =  TX_VOID_TO_UCHAR_POINTER_CONVERT(TX_ALIGN_TYPE_TO_POINTER_CONVERT(TX_POINTER_TO_ALIGN_TYPE_CONVERT(next_ptr) | prev_free));
+}
+
+
+static UINT  _tx_byte_pool_tlsf_msb(ULONG value)
+{
+
+#ifdef __GNUC__
+
+    /* Use the count leading zeros builtin.  */
+    return((UINT) ((((sizeof(unsigned long)) * ((UINT) 8)) - ((UINT) 1)) - ((UINT) __builtin_clzl((unsigned long) value))));
+#else
+
+UINT        bit;
+
+
+    /* Shift down to the most significant bit.  */
+    bit =  ((UINT) 0);
+    while (value > ((ULONG) 1))
+    {
+        value =  value >> 1;
+        bit++;
+    }
+    return(bit);
+#endif
+}
+
+
+/* Map a block size to its first-level (power of two) and second-level (linear subdivision)
+   class.  Sizes below TX_BYTE_POOL_TLSF_SMALL_SIZE are all in the first class.  */
+
+static VOID  _tx_byte_pool_tlsf_mapping(ULONG size, UINT *fl, UINT *sl)
+{
+
+UINT        msb;
+
+
+    if (size < TX_BYTE_POOL_TLSF_SMALL_SIZE)
+    {
+
+        *fl =  ((UINT) 0);
+        *sl =  (UINT) (size / (sizeof(ALIGN_TYPE)));
+    }
+    else
+    {
+
+        msb =  _tx_byte_pool_tlsf_msb(size);
+        *sl =  ((UINT) (size >> (msb - TX_BYTE_POOL_TLSF_SL_LOG2))) - TX_BYTE_POOL_TLSF_SL_COUNT;
+        *fl =  (msb - _tx_byte_pool_tlsf_msb(TX_BYTE_POOL_TLSF_SMALL_SIZE)) + ((UINT) 1);
+    }
+}
+
+
+static VOID  _tx_byte_pool_tlsf_insert(TX_BYTE_POOL_TLSF *control_ptr, UCHAR *block_ptr, ULONG block_size)
+{
+
+UCHAR       **list_ptr;
+UCHAR       *head_ptr;
+UINT        fl;
+UINT        sl;
+
+
+    /* Push the block on the head of its class list.  */
+    _tx_byte_pool_tlsf_mapping(block_size, &fl, &sl);
+    list_ptr =  &control_ptr -> tx_byte_pool_tlsf_free_list[(fl * TX_BYTE_POOL_TLSF_SL_COUNT) + sl];
+    head_ptr =  *list_ptr;
+    *TX_BYTE_BLOCK_NEXT_FREE(block_ptr) =      head_ptr;
+    *TX_BYTE_BLOCK_PREVIOUS_FREE(block_ptr) =  TX_NULL;
+    if (head_ptr != TX_NULL)
+    {
+        *TX_BYTE_BLOCK_PREVIOUS_FREE(head_ptr) =  block_ptr;
+    }
+    *list_ptr =  block_ptr;
+
+    /* Mark the class as non-empty.  */
+    control_ptr -> tx_byte_pool_tlsf_fl_bitmap =      control_ptr -> tx_byte_pool_tlsf_fl_bitmap | (((ULONG) 1) << fl);
+    control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl] =  control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl] | (((ULONG) 1) << sl);
+}
+
+
+static VOID  _tx_byte_pool_tlsf_remove(TX_BYTE_POOL_TLSF *control_ptr, UCHAR *block_ptr, ULONG block_size)
+{
+
+UCHAR       **list_ptr;
+UCHAR       *next_ptr;
+UCHAR       *previous_ptr;
+UINT        fl;
+UINT        sl;
+
+
+    /* Unlink the block from its class list.  */
+    _tx_byte_pool_tlsf_mapping(block_size, &fl, &sl);
+    next_ptr =      *TX_BYTE_BLOCK_NEXT_FREE(block_ptr);
+    previous_ptr =  *TX_BYTE_BLOCK_PREVIOUS_FREE(block_ptr);
+    if (next_ptr != TX_NULL)
+    {
+        *TX_BYTE_BLOCK_PREVIOUS_FREE(next_ptr) =  previous_ptr;
+    }
+    if (previous_ptr != TX_NULL)
+    {
+        *TX_BYTE_BLOCK_NEXT_FREE(previous_ptr) =  next_ptr;
+    }
+    else
+    {
+
+        /* The block was the head, update the list and the bitmaps.  */
+        list_ptr =   &control_ptr -> tx_byte_pool_tlsf_free_list[(fl * TX_BYTE_POOL_TLSF_SL_COUNT) + sl];
+        *list_ptr =  next_ptr;
+        if (next_ptr == TX_NULL)
+        {
+            control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl] =  control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl] & (~(((ULONG) 1) << sl));
+            if (control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl] == ((ULONG) 0))
+            {
+                control_ptr -> tx_byte_pool_tlsf_fl_bitmap =  control_ptr -> tx_byte_pool_tlsf_fl_bitmap & (~(((ULONG) 1) << fl));
+            }
+        }
+    }
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_byte_pool_tlsf_initialize                       PORTABLE C      */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function places the TLSF control structure at the start of    */
+/*    the byte pool memory and builds the initial free block followed by  */
+/*    the allocated block at the end of the pool.                         */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    pool_ptr                          Pointer to pool control block     */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    TX_SUCCESS                        Successful initialization         */
+/*    TX_SIZE_ERROR                     Pool is too small for the control */
+/*                                        structure                       */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _tx_byte_pool_create              Create byte pool                  */
+/*                                                                        */
+/**************************************************************************/
+UINT  _tx_byte_pool_tlsf_initialize(TX_BYTE_POOL *pool_ptr)
+{
+
+TX_BYTE_POOL_TLSF   *control_ptr;
+UCHAR               *block_ptr;
+UCHAR               *end_ptr;
+UCHAR               **block_indirect_ptr;
+ULONG               control_size;
+ULONG               block_size;
+UINT                fl;
+UINT                sl;
+
+
+    /* Determine the number of first-level classes from the pool size.  */
+    _tx_byte_pool_tlsf_mapping(pool_ptr -> tx_byte_pool_size, &fl, &sl);
+    fl++;
+
+    /* Calculate the size of the control structure, the free list heads and the second-level bitmaps.  */
+    control_size =  (sizeof(TX_BYTE_POOL_TLSF)) + ((((ULONG) fl) * TX_BYTE_POOL_TLSF_SL_COUNT) * (sizeof(UCHAR *))) + (((ULONG) fl) * (sizeof(ULONG)));
+    control_size =  (((control_size + (sizeof(ALIGN_TYPE))) - ((ULONG) 1)) / (sizeof(ALIGN_TYPE))) * (sizeof(ALIGN_TYPE));
+
+    /* Make sure there is room for one free block and the allocated block at the end.  */
+    if (pool_ptr -> tx_byte_pool_size < (control_size + TX_BYTE_POOL_TLSF_BLOCK_MIN + TX_BYTE_BLOCK_HEADER_SIZE))
+    {
+        return(TX_SIZE_ERROR);
+    }
+
+    /* Setup the control structure.  */
+    control_ptr =  (TX_BYTE_POOL_TLSF *) ((VOID *) pool_ptr -> tx_byte_pool_start);
+    TX_MEMSET(control_ptr, 0, control_size);
+    control_ptr -> tx_byte_pool_tlsf_fl_count =   fl;
+    control_ptr -> tx_byte_pool_tlsf_free_list =  TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(TX_UCHAR_POINTER_ADD(control_ptr, (sizeof(TX_BYTE_POOL_TLSF))));
+    control_ptr -> tx_byte_pool_tlsf_sl_bitmap =  (ULONG *) ((VOID *) (&control_ptr -> tx_byte_pool_tlsf_free_list[fl * TX_BYTE_POOL_TLSF_SL_COUNT]));
+
+    /* Build the allocated block at the end of the pool.  Its "next" pointer goes back to the first block.  */
+    block_ptr =   TX_UCHAR_POINTER_ADD(pool_ptr -> tx_byte_pool_start, control_size);
+    block_size =  (pool_ptr -> tx_byte_pool_size - control_size) - TX_BYTE_BLOCK_HEADER_SIZE;
+    end_ptr =     TX_UCHAR_POINTER_ADD(block_ptr, block_size);
+    _tx_byte_pool_tlsf_next_set(end_ptr, block_ptr, TX_BYTE_BLOCK_PREV_FREE);
+    block_indirect_ptr =   TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(TX_UCHAR_POINTER_ADD(end_ptr, (sizeof(UCHAR *))));
+    *block_indirect_ptr =  TX_BYTE_POOL_TO_UCHAR_POINTER_CONVERT(pool_ptr);
+
+    /* Now setup the large available block in the pool.  */
+    _tx_byte_pool_tlsf_next_set(block_ptr, end_ptr, ((ALIGN_TYPE) 0));
+    *TX_BYTE_BLOCK_TAG(block_ptr) =   TX_BYTE_BLOCK_FREE;
+    *TX_BYTE_BLOCK_FOOTER(end_ptr) =  block_ptr;
+    _tx_byte_pool_tlsf_insert(control_ptr, block_ptr, block_size);
+
+    /* The search pointer references the control structure.  */
+    pool_ptr -> tx_byte_pool_list =       block_ptr;
+    pool_ptr -> tx_byte_pool_search =     TX_VOID_TO_UCHAR_POINTER_CONVERT(control_ptr);
+    pool_ptr -> tx_byte_pool_available =  block_size;
+    pool_ptr -> tx_byte_pool_fragments =  ((UINT) 2);
+
+    return(TX_SUCCESS);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_byte_pool_search                                PORTABLE C      */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function allocates a memory block from the smallest non-empty  */
+/*    size class that satisfies the requested number of bytes, and splits */
+/*    the remainder off as a new free block.  The allocation takes        */
+/*    constant time, so it is done with interrupts disabled.              */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    pool_ptr                          Pointer to pool control block     */
+/*    memory_size                       Number of bytes required          */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    UCHAR *                           Pointer to the allocated memory,  */
+/*                                        if successful.  Otherwise, a    */
+/*                                        NULL is returned                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _tx_byte_allocate                 Allocate bytes of memory          */
+/*    _tx_byte_release                  Release bytes of memory           */
+/*                                                                        */
+/**************************************************************************/
+UCHAR  *_tx_byte_pool_search(TX_BYTE_POOL *pool_ptr, ULONG memory_size)
+{
+
+TX_INTERRUPT_SAVE_AREA
+
+TX_BYTE_POOL_TLSF   *control_ptr;
+TX_THREAD           *thread_ptr;
+UCHAR               *block_ptr;
+UCHAR               *next_ptr;
+UCHAR               *split_ptr;
+UCHAR               **block_indirect_ptr;
+ULONG               request_size;
+ULONG               block_size;
+ULONG               fl_map;
+ULONG               sl_map;
+ULONG               bit;
+UINT                fl;
+UINT                sl;
+
+
+    /* Calculate the block size needed, including the header.  */
+    block_ptr =     TX_NULL;
+    request_size =  memory_size + TX_BYTE_BLOCK_HEADER_SIZE;
+    if (request_size < TX_BYTE_POOL_TLSF_BLOCK_MIN)
+    {
+        request_size =  TX_BYTE_POOL_TLSF_BLOCK_MIN;
+    }
+
+    /* Round the size up to the next class boundary, so any block in the class is large enough.  */
+    block_size =  request_size;
+    if (block_size >= TX_BYTE_POOL_TLSF_SMALL_SIZE)
+    {
+        block_size =  block_size + ((((ULONG) 1) << (_tx_byte_pool_tlsf_msb(block_size) - TX_BYTE_POOL_TLSF_SL_LOG2)) - ((ULONG) 1));
+    }
+    _tx_byte_pool_tlsf_mapping(block_size, &fl, &sl);
+
+    /* Disable interrupts.  */
+    TX_DISABLE
+
+    /* Pickup thread pointer.  */
+    TX_THREAD_GET_CURRENT(thread_ptr)
+
+    /* Setup ownership of the byte pool.  */
+    pool_ptr -> tx_byte_pool_owner =  thread_ptr;
+
+#ifdef TX_BYTE_POOL_ENABLE_PERFORMANCE_INFO
+
+    /* Increment the total fragment search counter.  */
+    _tx_byte_pool_performance_search_count++;
+
+    /* Increment the number of fragments searched on this pool.  */
+    pool_ptr -> tx_byte_pool_performance_search_count++;
+#endif
+
+    control_ptr =  TX_BYTE_POOL_TLSF_CONTROL(pool_ptr);
+    if ((memory_size < pool_ptr -> tx_byte_pool_size) && (fl < control_ptr -> tx_byte_pool_tlsf_fl_count))
+    {
+
+        /* Find a non-empty class at or above the requested one.  */
+        sl_map =  control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl] & (((ULONG) ~((ULONG) 0)) << sl);
+        if (sl_map == ((ULONG) 0))
+        {
+
+            fl_map =  control_ptr -> tx_byte_pool_tlsf_fl_bitmap & (((ULONG) ~((ULONG) 0)) << (fl + ((UINT) 1)));
+            if (fl_map != ((ULONG) 0))
+            {
+                TX_LOWEST_SET_BIT_CALCULATE(fl_map, bit)
+                fl =      (UINT) bit;
+                sl_map =  control_ptr -> tx_byte_pool_tlsf_sl_bitmap[fl];
+            }
+        }
+        if (sl_map != ((ULONG) 0))
+        {
+            TX_LOWEST_SET_BIT_CALCULATE(sl_map, bit)
+            sl =         (UINT) bit;
+            block_ptr =  control_ptr -> tx_byte_pool_tlsf_free_list[(fl * TX_BYTE_POOL_TLSF_SL_COUNT) + sl];
+        }
+    }
+
+    /* Otherwise, one of the first TX_BYTE_POOL_TLSF_SEARCH_LIMIT blocks in the class the
+       request size itself maps to may still be large enough.  The walk is bounded, so the
+       search stays constant time with interrupts disabled.  */
+    if ((block_ptr == TX_NULL) && (memory_size < pool_ptr -> tx_byte_pool_size))
+    {
+
+        _tx_byte_pool_tlsf_mapping(request_size, &fl, &sl);
+        if (fl < control_ptr -> tx_byte_pool_tlsf_fl_count)
+        {
+            block_ptr =  control_ptr -> tx_byte_pool_tlsf_free_list[(fl * TX_BYTE_POOL_TLSF_SL_COUNT) + sl];
+            for (bit = ((ULONG) 0); (block_ptr != TX_NULL) && (bit < TX_BYTE_POOL_TLSF_SEARCH_LIMIT); bit++)
+            {
+                if (TX_UCHAR_POINTER_DIF(_tx_byte_pool_tlsf_next_get(block_ptr), block_ptr) >= request_size)
+                {
+                    break;
+                }
+                block_ptr =  *TX_BYTE_BLOCK_NEXT_FREE(block_ptr);
+            }
+            if (bit == TX_BYTE_POOL_TLSF_SEARCH_LIMIT)
+            {
+                block_ptr =  TX_NULL;
+            }
+        }
+    }
+
+    /* Determine if a block was found.  */
+    if (block_ptr != TX_NULL)
+    {
+
+        next_ptr =    _tx_byte_pool_tlsf_next_get(block_ptr);
+        block_size =  TX_UCHAR_POINTER_DIF(next_ptr, block_ptr);
+        _tx_byte_pool_tlsf_remove(control_ptr, block_ptr, block_size);
+
+        /* Determine if we need to split this block.  */
+        if ((block_size - request_size) >= TX_BYTE_POOL_TLSF_BLOCK_MIN)
+        {
+
+            /* Setup the new free block.  Its previous block is allocated.  */
+            split_ptr =  TX_UCHAR_POINTER_ADD(block_ptr, request_size);
+            _tx_byte_pool_tlsf_next_set(split_ptr, next_ptr, ((ALIGN_TYPE) 0));
+            *TX_BYTE_BLOCK_TAG(split_ptr) =   TX_BYTE_BLOCK_FREE;
+            *TX_BYTE_BLOCK_FOOTER(next_ptr) =  split_ptr;
+            _tx_byte_pool_tlsf_insert(control_ptr, split_ptr, block_size - request_size);
+            _tx_byte_pool_tlsf_next_set(block_ptr, split_ptr, _tx_byte_pool_tlsf_prev_free_get(block_ptr));
+            block_size =  request_size;
+
+            /* Increase the total fragment counter.  */
+            pool_ptr -> tx_byte_pool_fragments++;
+
+#ifdef TX_BYTE_POOL_ENABLE_PERFORMANCE_INFO
+
+            /* Increment the total split counter.  */
+            _tx_byte_pool_performance_split_count++;
+
+            /* Increment the number of blocks split on this pool.  */
+            pool_ptr -> tx_byte_pool_performance_split_count++;
+#endif
+        }
+        else
+        {
+
+            /* The whole block is used, the next block's previous block is no longer free.  */
+            _tx_byte_pool_tlsf_next_set(next_ptr, _tx_byte_pool_tlsf_next_get(next_ptr), ((ALIGN_TYPE) 0));
+        }
+
+        /* In any case, mark the current block as allocated.  */
+        block_indirect_ptr =   TX_UCHAR_TO_INDIRECT_UCHAR_POINTER_CONVERT(TX_UCHAR_POINTER_ADD(block_ptr, (sizeof(UCHAR *))));
+        *block_indirect_ptr =  TX_BYTE_POOL_TO_UCHAR_POINTER_CONVERT(pool_ptr);
+
+        /* Reduce the number of available bytes in the pool.  */
+        pool_ptr -> tx_byte_pool_available =  pool_ptr -> tx_byte_pool_available - block_size;
+
+        /* Adjust the pointer for the application.  */
+        block_ptr =  TX_UCHAR_POINTER_ADD(block_ptr, TX_BYTE_BLOCK_HEADER_SIZE);
+    }
+
+    /* Restore interrupts.  */
+    TX_RESTORE
+
+    /* Return the block pointer.  */
+    return(block_ptr);
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*  FUNCTION                                               RELEASE        */
+/*                                                                        */
+/*    _tx_byte_pool_tlsf_release                          PORTABLE C      */
+/*                                                                        */
+/*  DESCRIPTION                                                           */
+/*                                                                        */
+/*    This function returns a block to the free lists of the byte pool,   */
+/*    merging it with the adjacent free blocks.                           */
+/*                                                                        */
+/*    It is assumed that this function is called with interrupts          */
+/*    disabled.                                                           */
+/*                                                                        */
+/*  INPUT                                                                 */
+/*                                                                        */
+/*    pool_ptr                          Pointer to pool control block     */
+/*    block_ptr                         Pointer to the block header       */
+/*                                                                        */
+/*  OUTPUT                                                                */
+/*                                                                        */
+/*    None                                                                */
+/*                                                                        */
+/*  CALLED BY                                                             */
+/*                                                                        */
+/*    _tx_byte_release                  Release bytes of memory           */
+/*                                                                        */
+/**************************************************************************/
+VOID  _tx_byte_pool_tlsf_release(TX_BYTE_POOL *pool_ptr, UCHAR *block_ptr)
+{
+
+TX_BYTE_POOL_TLSF   *control_ptr;
+UCHAR               *next_ptr;
+UCHAR               *after_ptr;
+UCHAR               *previous_ptr;
+ALIGN_TYPE          prev_free;
+
+
+    control_ptr =  TX_BYTE_POOL_TLSF_CONTROL(pool_ptr);
+    next_ptr =     _tx_byte_pool_tlsf_next_get(block_ptr);
+    prev_free =    _tx_byte_pool_tlsf_prev_free_get(block_ptr);
+
+    /* Update the number of available bytes in the pool.  */
+    pool_ptr -> tx_byte_pool_available =
+        pool_ptr -> tx_byte_pool_available + TX_UCHAR_POINTER_DIF(next_ptr, block_ptr);
+
+    /* Merge with the next block if it is free.  The block at the end of the pool is never free.  */
+    if ((*TX_BYTE_BLOCK_TAG(next_ptr)) == TX_BYTE_BLOCK_FREE)
+    {
+
+        after_ptr =  _tx_byte_pool_tlsf_next_get(next_ptr);
+        _tx_byte_pool_tlsf_remove(control_ptr, next_ptr, TX_UCHAR_POINTER_DIF(after_ptr, next_ptr));
+        next_ptr =   after_ptr;
+
+        /* Reduce the fragment total.  */
+        pool_ptr -> tx_byte_pool_fragments--;
+
+#ifdef TX_BYTE_POOL_ENABLE_PERFORMANCE_INFO
+
+        /* Increment the total merge counter.  */
+        _tx_byte_pool_performance_merge_count++;
+
+        /* Increment the number of blocks merged on this pool.  */
+        pool_ptr -> tx_byte_pool_performance_merge_count++;
+#endif
+    }
+
+    /* Merge with the previous block if it is free.  */
+    if (prev_free != ((ALIGN_TYPE) 0))
+    {
+
+        previous_ptr =  *TX_BYTE_BLOCK_FOOTER(block_ptr);
+        _tx_byte_pool_tlsf_remove(control_ptr, previous_ptr, TX_UCHAR_POINTER_DIF(block_ptr, previous_ptr));
+        prev_free =     _tx_byte_pool_tlsf_prev_free_get(previous_ptr);
+        block_ptr =     previous_ptr;
+
+        /* Reduce the fragment total.  */
+        pool_ptr -> tx_byte_pool_fragments--;
+
+#ifdef TX_BYTE_POOL_ENABLE_PERFORMANCE_INFO
+
+        /* Increment the total merge counter.  */
+        _tx_byte_pool_performance_merge_count++;
+
+        /* Increment the number of blocks merged on this pool.  */
+        pool_ptr -> tx_byte_pool_performance_merge_count++;
+#endif
+    }
+
+    /* Mark the block free and put it on its class list.  */
+    _tx_byte_pool_tlsf_next_set(block_ptr, next_ptr, prev_free);
+    *TX_BYTE_BLOCK_TAG(block_ptr) =   TX_BYTE_BLOCK_FREE;
+    *TX_BYTE_BLOCK_FOOTER(next_ptr) =  block_ptr;
+    _tx_byte_pool_tlsf_next_set(next_ptr, _tx_byte_pool_tlsf_next_get(next_ptr), TX_BYTE_BLOCK_PREV_FREE);
+    _tx_byte_pool_tlsf_insert(control_ptr, block_ptr, TX_UCHAR_POINTER_DIF(next_ptr, block_ptr));
+}
+
+#endif